@@ -239,6 +239,103 @@
  */
 #define OS_INTEGER_RTOS_ALLOC_TIMER_POOL_SIZE
 
+/**
+ * @brief Install a slab as the default application memory resource.
+ *
+ * @details
+ * This option instructs the startup code to create an
+ * `os::memory::slab`, with `OS_INTEGER_MEMORY_SLAB_CLASSES`
+ * block pools of this number of blocks each, and to set it as the
+ * `estd::pmr` default resource, used by `operator new` and `malloc()`.
+ *
+ * Small requests are served by the pools, in constant time and
+ * without fragmentation; larger requests, or requests that find
+ * the pools empty, go to the application free store.
+ *
+ * The slab arena is dynamically allocated on the application
+ * free store, and never deallocated.
+ *
+ * @see OS_INTEGER_MEMORY_SLAB_CLASSES
+ * @see OS_INTEGER_MEMORY_SLAB_MIN_BLOCK_SIZE_BYTES
+ *
+ * @par Default
+ *   Do not create the slab.
+ */
+#define OS_INTEGER_MEMORY_SLAB_BLOCKS
+
+/**
+ * @brief Define the number of slab size classes.
+ *
+ * @details
+ * Each class has blocks twice as large as the previous one.
+ *
+ * @par Default
+ *  4.
+ */
+#define OS_INTEGER_MEMORY_SLAB_CLASSES (4)
+
+/**
+ * @brief Define the block size of the smallest slab class.
+ *
+ * @par Default
+ *  16.
+ */
+#define OS_INTEGER_MEMORY_SLAB_MIN_BLOCK_SIZE_BYTES (16)
+
+/**
+ * @brief Profile the allocations of the default memory resources.
+ *
+ * @details
+ * This option instructs the startup code to decorate the
+ * `estd::pmr` and the `rtos::memory` default resources with
+ * `os::memory::alloc_profiler` objects, which record the call
+ * site and the size of each live allocation, and for each call
+ * site the name of the thread which did the last allocation.
+ * If both default resources are the same, a single profiler is used.
+ *
+ * `malloc()` and `operator new` pass their return address as
+ * the call site; call `dump()` on the profiler, obtained with
+ * `estd::pmr::get_default_resource()`, to print the top call sites.
+ *
+ * The tables are dynamically allocated on the application
+ * free store, and never deallocated.
+ *
+ * @see OS_INTEGER_MEMORY_ALLOC_PROFILER_LIVE
+ * @see OS_INTEGER_MEMORY_ALLOC_PROFILER_SITES
+ *
+ * @par Default
+ *   Do not profile the allocations.
+ */
+#define OS_USE_MEMORY_ALLOCATION_PROFILER
+
+/**
+ * @brief Define the max number of live allocations recorded by the profiler.
+ *
+ * @details
+ * The table is kept at most 7/8 full; further allocations
+ * are counted as untracked.
+ *
+ * @par Default
+ *  256.
+ */
+#define OS_INTEGER_MEMORY_ALLOC_PROFILER_LIVE (256)
+
+/**
+ * @brief Define the max number of call sites recorded by the profiler.
+ *
+ * @par Default
+ *  64.
+ */
+#define OS_INTEGER_MEMORY_ALLOC_PROFILER_SITES (64)
+
+/**
+ * @brief Define the default number of call sites printed by the profiler.
+ *
+ * @par Default
+ *  10.
+ */
+#define OS_INTEGER_MEMORY_ALLOC_PROFILER_TOP (10)
+
 /**
  * @brief The type of the memory manager to be used for
  *  the RTOS system area.
@@ -406,6 +503,105 @@
  */
 #define OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES
 
+/**
+ * @brief Include the CPU load statistics.
+ *
+ * @details
+ * Add support to compute, over windows of time, the CPU load of each
+ * thread, the system CPU and idle loads, and, if
+ * @ref OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES is also
+ * defined, the context switch rates.
+ *
+ * The windows are delimited by calls to
+ * `os::rtos::scheduler::statistics::update_load()`, usually
+ * from a monitoring thread, and a `top` like report can be sent
+ * to the trace channel with `os::rtos::scheduler::statistics::top()`.
+ *
+ * Requires @ref OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES;
+ * ignored otherwise.
+ *
+ * The RAM overhead is two uint64_t variables for each thread (four with
+ * context switches) and the windows history.
+ *
+ * @par Default
+ * Disable. Do not include load statistics.
+ */
+#define OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD
+
+/**
+ * @brief Define the number of load windows to keep.
+ *
+ * @details
+ * The system loads can be averaged over up to this number of the
+ * most recent windows.
+ *
+ * @par Default
+ * 8 windows.
+ */
+#define OS_INTEGER_RTOS_STATISTICS_LOAD_WINDOWS
+
+/**
+ * @brief Define the maximum number of threads listed by `top()`.
+ *
+ * @details
+ * The thread statistics are copied in a local array, with the
+ * scheduler locked, and printed afterwards; each row takes
+ * about 32 bytes of the caller stack.
+ *
+ * @par Default
+ * 16 threads.
+ */
+#define OS_INTEGER_RTOS_STATISTICS_TOP_THREADS
+
+/**
+ * @brief Include the sampling CPU profiler.
+ *
+ * @details
+ * Add support to periodically sample the interrupted program counter
+ * and the current thread, and count the samples in a RAM histogram,
+ * to find where the time goes inside threads.
+ *
+ * The samples are taken from `os_systick_handler()`, after
+ * `os::rtos::profiler::start()` is called. The histogram is sent
+ * to the trace channel with `os::rtos::profiler::dump()` and
+ * converted to a flame graph on the host by
+ * `scripts/profiler-flamegraph.py`.
+ *
+ * The RAM overhead is 16 bytes (on 32-bit platforms) for each
+ * histogram bucket.
+ *
+ * @see os::rtos::profiler
+ *
+ * @par Default
+ * Disable. Do not include the profiler.
+ */
+#define OS_USE_RTOS_PROFILER
+
+/**
+ * @brief Define the number of profiler histogram buckets.
+ *
+ * @details
+ * Each distinct location (program counter, link register, thread)
+ * uses one bucket; samples that do not find a free bucket are
+ * counted as dropped. Must be a power of 2.
+ *
+ * @par Default
+ * 128 buckets.
+ */
+#define OS_INTEGER_RTOS_PROFILER_BUCKETS
+
+/**
+ * @brief Define the number of SysTick ticks between profiler samples.
+ *
+ * @details
+ * Increase it to reduce the profiler overhead, at the expense of
+ * a lower resolution.
+ *
+ * @par Default
+ * 1, sample at each tick.
+ */
+#define OS_INTEGER_RTOS_PROFILER_TICKS_PER_SAMPLE
+
 /**
  * @brief Add a user defined storage to each thread.
  */
@@ -489,6 +685,215 @@
  */
 #define OS_EXCLUDE_RTOS_IDLE_SLEEP
 
+/**
+ * @brief Suppress the periodic tick when the idle thread sleeps.
+ *
+ * @details
+ * Normally the SysTick interrupt fires at each tick, even when
+ * there is nothing to run, waking up the device only to find
+ * that no timestamp expired.
+ *
+ * With this option, the idle thread computes the distance to the
+ * earliest pending clock timestamp (thread timeouts, timers), asks
+ * the port to stop the periodic tick and to arm a one-shot wake-up
+ * for that moment, and, after the device is back to life, adds the
+ * lost ticks to the clocks.
+ *
+ * The port must implement `port::clock_systick::sleep_tickless()`.
+ *
+ * @see OS_INTEGER_RTOS_TICKLESS_IDLE_MIN_TICKS
+ *
+ * @par Default
+ *  Disabled (the tick is periodic).
+ */
+#define OS_USE_RTOS_TICKLESS_IDLE
+
+/**
+ * @brief Define the minimum number of ticks to enter tickless idle.
+ *
+ * @details
+ * If the next deadline is closer, the overhead of reprogramming
+ * the timer is not worth it, and the idle thread enters the
+ * usual shallow sleep.
+ *
+ * @par Default
+ *  2.
+ */
+#define OS_INTEGER_RTOS_TICKLESS_IDLE_MIN_TICKS (2)
+
+/**
+ * @brief Recycle the stacks of dynamically allocated threads.
+ *
+ * @details
+ * When a thread created with the default allocator terminates,
+ * its stack is repainted and kept in a small per size class cache,
+ * instead of being returned to the heap. New threads with a stack
+ * of the same class reuse it, without calling the allocator and
+ * without filling it again with the magic word.
+ *
+ * Stacks are allocated with the requested size, and only stacks
+ * with the exact size of a class are cached; a request smaller
+ * than its class may receive a larger cached stack. To benefit
+ * from the cache, use the class sizes for the dynamic stacks, or
+ * pre-allocate them with `thread::stack::cache_reserve()`.
+ *
+ * @see OS_INTEGER_RTOS_THREAD_STACK_CACHE_CLASSES
+ * @see OS_INTEGER_RTOS_THREAD_STACK_CACHE_MIN_SIZE_BYTES
+ * @see OS_INTEGER_RTOS_THREAD_STACK_CACHE_DEPTH
+ *
+ * @par Default
+ *  Disabled (stacks are deallocated).
+ */
+#define OS_USE_RTOS_THREAD_STACK_CACHE
+
+/**
+ * @brief Define the number of stack cache size classes.
+ *
+ * @details
+ * Each class is twice the size of the previous one; larger
+ * stacks are not cached.
+ *
+ * @par Default
+ *  4.
+ */
+#define OS_INTEGER_RTOS_THREAD_STACK_CACHE_CLASSES (4)
+
+/**
+ * @brief Define the size of the smallest stack cache class.
+ *
+ * @par Default
+ *  1024.
+ */
+#define OS_INTEGER_RTOS_THREAD_STACK_CACHE_MIN_SIZE_BYTES (1024)
+
+/**
+ * @brief Define the maximum number of cached stacks per class.
+ *
+ * @par Default
+ *  2.
+ */
+#define OS_INTEGER_RTOS_THREAD_STACK_CACHE_DEPTH (2)
+
+/**
+ * @brief Paint only the guard band of new thread stacks.
+ *
+ * @details
+ * By default the entire stack is filled with the magic word when
+ * the thread is created, which, for large stacks, adds to the
+ * creation time. With this option, only the bottom
+ * `OS_INTEGER_RTOS_THREAD_STACK_GUARD_SIZE_BYTES` and the top magic
+ * word are painted.
+ *
+ * The stack usage can then be measured only inside the guard band;
+ * `thread::stack::available()` returns at most the guard band size.
+ *
+ * @see OS_INTEGER_RTOS_THREAD_STACK_GUARD_SIZE_BYTES
+ *
+ * @par Default
+ *  Disabled (the entire stack is painted).
+ */
+#define OS_USE_RTOS_THREAD_STACK_LAZY_PAINT
+
+/**
+ * @brief Define the size of the painted stack guard band.
+ *
+ * @par Default
+ *  256.
+ */
+#define OS_INTEGER_RTOS_THREAD_STACK_GUARD_SIZE_BYTES (256)
+
+/**
+ * @brief Track the thread stacks high-water marks in the idle thread.
+ *
+ * @details
+ * On each iteration, the idle thread scans a few words of each
+ * thread stack, continuing from where it stopped the previous time,
+ * and lowers the high-water mark when it finds used words.
+ * The result is available via `thread::stack::high_water_mark()`,
+ * without the cost of a full scan.
+ *
+ * If set with `thread::stack::proximity_callback()`, a user
+ * function is called when a stack is close to overflow.
+ *
+ * @see OS_INTEGER_RTOS_THREAD_STACK_WATERMARK_STEP_WORDS
+ *
+ * @par Default
+ *  Disabled.
+ */
+#define OS_USE_RTOS_THREAD_STACK_WATERMARK
+
+/**
+ * @brief Define the number of stack words scanned per thread, per idle loop.
+ *
+ * @par Default
+ *  32.
+ */
+#define OS_INTEGER_RTOS_THREAD_STACK_WATERMARK_STEP_WORDS (32)
+
+/**
+ * @brief Use a lock-free free list in memory pools.
+ *
+ * @details
+ * The free blocks are kept in a lock-free stack, with the head
+ * stored as a block index plus a change counter, updated with a
+ * single compare-and-swap. `try_alloc()` and `free()` then
+ * do not disable interrupts, and `free()` touches the waiting list
+ * only when there are waiting threads.
+ *
+ * Requires atomic compare-and-swap instructions
+ * (for example ARMv7-M LDREX/STREX), and pools with less than
+ * 65535 blocks. On cores without them, like ARMv6-M, the
+ * definition is ignored and the critical sections are used.
+ *
+ * @par Default
+ *  Disabled (the free list is protected by critical sections).
+ */
+#define OS_USE_RTOS_MEMORY_POOL_LOCK_FREE
+
+/**
+ * @brief Construct the `lazy<T>` static objects after startup.
+ *
+ * @details
+ * The static objects defined as `os::rtos::lazy<T>` only register
+ * themselves before `main()`; they are constructed later, by the
+ * main thread before `os_main()`, by a low priority background
+ * thread while `os_main()` runs, or at the first use, depending
+ * on their stage.
+ *
+ * @see OS_INTEGER_RTOS_LAZY_INIT_STACK_SIZE_BYTES
+ * @see OS_INTEGER_RTOS_LAZY_INIT_PRIORITY
+ *
+ * @par Default
+ *  Disabled (`lazy<T>` is not available).
+ */
+#define OS_USE_RTOS_LAZY_INIT
+
+/**
+ * @brief Define the stack size of the lazy initialisation thread.
+ *
+ * @details
+ * The thread which runs the background stages; its stack must
+ * fit the largest constructor. The thread is created only if
+ * there are objects in the background stages.
+ *
+ * @par Default
+ *  0 (the default stack size).
+ */
+#define OS_INTEGER_RTOS_LAZY_INIT_STACK_SIZE_BYTES (0)
+
+/**
+ * @brief Define the priority of the lazy initialisation thread.
+ *
+ * @details
+ * Lower than the application threads, so the background stages
+ * use only the spare time; a thread which needs an object not
+ * yet constructed raises it by priority inheritance.
+ *
+ * @par Default
+ *  `os::rtos::thread::priority::below_normal`.
+ */
+#define OS_INTEGER_RTOS_LAZY_INIT_PRIORITY (os::rtos::thread::priority::below_normal)
+
 /**
  * @}
  */
@@ -525,6 +930,69 @@
  */
 #define OS_INCLUDE_STARTUP_INIT_FP
 
+/**
+ * @brief Decompress the initialised data at startup.
+ *
+ * @details
+ * The initialisation values of each data region are stored
+ * in flash as an LZ4 block, which is decompressed directly
+ * in the RAM region, instead of copied.
+ *
+ * The ELF file must be processed after linking with
+ * `scripts/startup-compress-data.py`.
+ *
+ * @par Default
+ *  Disabled (the initialisation values are copied).
+ */
+#define OS_INCLUDE_STARTUP_COMPRESSED_DATA
+
+/**
+ * @brief Clear the large buffers after startup.
+ *
+ * @details
+ * The objects placed in the `.bss_deferred` section (with
+ * `OS_ATTRIBUTE_BSS_DEFERRED`) are not cleared by the startup
+ * code, but later, in chunks, by the idle thread, or by the
+ * application, with `os_startup_initialize_bss_deferred()`.
+ * They must not be used before it returns `true`.
+ *
+ * The linker script must define the section and the
+ * `__bss_deferred_start__` and `__bss_deferred_end__` symbols.
+ *
+ * @par Default
+ *  Disabled (the section is not used).
+ */
+#define OS_INCLUDE_STARTUP_DEFERRED_BSS
+
+/**
+ * @brief Define the size of the deferred .bss chunks.
+ *
+ * @details
+ * The number of bytes cleared by the idle thread at once; larger
+ * chunks finish sooner, smaller ones delay less the threads
+ * which become ready meanwhile.
+ *
+ * Used only if `OS_INCLUDE_STARTUP_DEFERRED_BSS` is defined.
+ *
+ * @par Default
+ *  1024 bytes.
+ */
+#define OS_INTEGER_STARTUP_DEFERRED_BSS_CHUNK_BYTES (1024)
+
+/**
+ * @brief Measure the duration of the startup phases.
+ *
+ * @details
+ * The duration of each startup phase is measured with the DWT
+ * cycle counter and stored in `os_startup_timestamps`.
+ *
+ * Requires a Cortex-M3 or higher core.
+ *
+ * @par Default
+ *  Disabled.
+ */
+#define OS_INCLUDE_STARTUP_TIMESTAMPS
+
 /**
  * @brief Make the application a fully semihosted application.
  *
@@ -560,6 +1028,67 @@
  */
 #define OS_INTEGER_SEMIHOSTING_MAX_OPEN_FILES (20)
 
+/**
+ * @brief Buffer the semihosting input and output.
+ *
+ * @details
+ * Each semihosting operation stops the core until the debugger
+ * services it, so many small writes are very slow. With this
+ * option, the semihosting standard input, output and error, and
+ * the semihosting trace channels, use `os::semihosting::buffer`
+ * objects, which pass the output to the host in larger blocks
+ * and read the input in blocks.
+ *
+ * The output is written when the buffer is full, when it is older
+ * than `OS_INTEGER_SEMIHOSTING_FLUSH_TICKS`, before reads, and
+ * on close, seek, fstat and exit.
+ *
+ * @see OS_INTEGER_SEMIHOSTING_BUFFER_SIZE
+ * @see OS_INTEGER_SEMIHOSTING_FLUSH_TICKS
+ * @see OS_BOOL_SEMIHOSTING_FLUSH_ON_NEWLINE
+ *
+ * @par Default
+ *  Disabled (each call is passed to the host).
+ */
+#define OS_INCLUDE_SEMIHOSTING_BUFFERS
+
+/**
+ * @brief Define the size of the semihosting buffers, in bytes.
+ *
+ * @details
+ * The size of each statically allocated buffer; the output
+ * is passed to the host in blocks of at most this size.
+ *
+ * @par Default
+ *  256.
+ */
+#define OS_INTEGER_SEMIHOSTING_BUFFER_SIZE (256)
+
+/**
+ * @brief Define the maximum age of the buffered output.
+ *
+ * @details
+ * In system clock ticks. The age is checked on each write and
+ * by the idle thread, so the output of a thread which stopped
+ * writing is displayed soon.
+ *
+ * @par Default
+ *  10.
+ */
+#define OS_INTEGER_SEMIHOSTING_FLUSH_TICKS (10)
+
+/**
+ * @brief Write the buffered output after each new line.
+ *
+ * @details
+ * Useful for interactive applications, at the cost of one
+ * host operation per line.
+ *
+ * @par Default
+ *  False (only full or old output is written).
+ */
+#define OS_BOOL_SEMIHOSTING_FLUSH_ON_NEWLINE (false)
+
 /**
  * @brief Include definitions for the standard POSIX system calls.
  *
@@ -598,6 +1127,59 @@
  */
 #define OS_INTEGER_DIRENT_NAME_MAX  (256)
 
+/**
+ * @brief Define the number of blocks in the shared states pool.
+ *
+ * @details
+ * The shared states used by `estd::promise`, `estd::packaged_task`,
+ * `estd::async()` and the thread pools are allocated from a dedicated
+ * pool of fixed size blocks, avoiding the general purpose
+ * allocator for short lived objects. When the pool is exhausted,
+ * the shared states are allocated from the default memory resource.
+ *
+ * If zero, there is no dedicated pool and the shared states are
+ * allocated with the global `operator new`.
+ *
+ * @par Default
+ *  8.
+ */
+#define OS_INTEGER_ESTD_FUTURE_POOL_BLOCKS (8)
+
+/**
+ * @brief Define the size of the blocks in the shared states pool.
+ *
+ * @details
+ * The size must accommodate the state overhead (an event flags
+ * object and a few counters), the result and, for `async()` and
+ * thread pool tasks, the callable object and the arguments.
+ * Larger states are allocated from the default resource.
+ *
+ * @par Default
+ *  128.
+ */
+#define OS_INTEGER_ESTD_FUTURE_POOL_BLOCK_SIZE_BYTES (128)
+
+/**
+ * @brief Define the number of workers in the `estd::async()` pool.
+ *
+ * @details
+ * The pool is created on the first call to `estd::async()` with
+ * `launch::async`, unless the application installs its own pool
+ * with `estd::set_async_pool()`.
+ *
+ * @par Default
+ *  2.
+ */
+#define OS_INTEGER_ESTD_ASYNC_POOL_WORKERS (2)
+
+/**
+ * @brief Define the stack size of the `estd::async()` pool workers.
+ *
+ * @par Default
+ *  The port default stack size.
+ */
+#define OS_INTEGER_ESTD_ASYNC_POOL_STACK_SIZE_BYTES (2048)
+
 /**
  * @}
  */
@@ -798,6 +1380,11 @@
  */
 #define OS_TRACE_RTOS_MQUEUE
 
+/**
+ * @brief Enable trace messages for RTOS message buffers functions.
+ */
+#define OS_TRACE_RTOS_MBUFFER
+
 /**
  * @brief Enable trace messages for RTOS mutex functions.
  */
@@ -848,6 +1435,11 @@
  */
 #define OS_TRACE_RTOS_TIMER
 
+/**
+ * @brief Enable trace messages for the lazy initialisation stages.
+ */
+#define OS_TRACE_RTOS_LAZY_INIT
+
 /**
  * @brief Enable trace messages for RTOS list functions.
  *
@@ -878,6 +1470,11 @@
  */
 #define OS_TRACE_LIBCPP_MEMORY_RESOURCE
 
+/**
+ * @brief Enable trace messages for thread pools.
+ */
+#define OS_TRACE_LIBCPP_THREAD_POOL
+
 /**
  * @brief Define the ITM stimulus port used for the trace messages.
  *
@@ -901,6 +1498,82 @@
  */
 #define OS_INTEGER_TRACE_SEMIHOSTING_BUFF_ARRAY_SIZE (16)
 
+/**
+ * @brief Buffer the trace output in a lock-free multi-producer buffer.
+ *
+ * @details
+ * Normally `trace::write()` writes directly to the physical trace
+ * channel, and some channels (like SEGGER RTT) need to disable
+ * interrupts for the entire copy, which increases the interrupt
+ * latency.
+ *
+ * With this option, `trace::write()` reserves space in a ring buffer
+ * with an atomic operation and copies the data with interrupts
+ * enabled. The idle thread (or `trace::flush()`) moves the buffered
+ * data to the physical channel.
+ *
+ * If the buffer is full, the output is dropped.
+ *
+ * On cores without atomic compare-and-swap, like ARMv6-M, the
+ * space is reserved in a short interrupts critical section.
+ *
+ * @see OS_INTEGER_TRACE_BUFFER_SIZE_BYTES
+ */
+#define OS_USE_TRACE_BUFFER
+
+/**
+ * @brief Define the trace buffer size, in bytes.
+ *
+ * @details
+ * Must be a power of 2.
+ *
+ * @par Default
+ *  1024.
+ */
+#define OS_INTEGER_TRACE_BUFFER_SIZE_BYTES (1024)
+
+/**
+ * @brief Include the deferred (binary) trace functions.
+ *
+ * @details
+ * The `os::trace::deferred::printf()` function does not format
+ * the message, but only stores the address of the format string
+ * and the raw arguments in a lock-free ring buffer, to be later sent
+ * to the trace channel with `os::trace::deferred::drain()` and
+ * decoded on the host with `scripts/trace-deferred-decode.py`.
+ *
+ * As for `OS_USE_TRACE_BUFFER`, on cores without atomic
+ * compare-and-swap the ring uses short critical sections.
+ *
+ * @see OS_INTEGER_TRACE_DEFERRED_BUFFER_SIZE_WORDS
+ * @see OS_INTEGER_TRACE_DEFERRED_MAX_ARGS_WORDS
+ */
+#define OS_USE_TRACE_DEFERRED
+
+/**
+ * @brief Define the deferred trace ring buffer size, in 32-bit words.
+ *
+ * @details
+ * Must be a power of 2.
+ *
+ * @par Default
+ *  256.
+ */
+#define OS_INTEGER_TRACE_DEFERRED_BUFFER_SIZE_WORDS (256)
+
+/**
+ * @brief Define the maximum number of argument words per deferred message.
+ *
+ * @details
+ * Each integer or pointer argument takes one word, 64-bit integers and
+ * floating point arguments take two words. Further arguments are
+ * ignored.
+ *
+ * @par Default
+ *  8.
+ */
+#define OS_INTEGER_TRACE_DEFERRED_MAX_ARGS_WORDS (8)
+
 /**
  * @}
  */
@@ -0,0 +1,386 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CMSIS_PLUS_ARM_SEMIHOSTING_BUFFER_H_
+#define CMSIS_PLUS_ARM_SEMIHOSTING_BUFFER_H_
+
+#if defined(__cplusplus)
+
+// ----------------------------------------------------------------------------
+
+#include <cmsis-plus/os-app-config.h>
+#include <cmsis-plus/rtos/os.h>
+
+#include <cstddef>
+#include <sys/types.h>
+
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Size of the semihosting buffers.
+ */
+#if !defined(OS_INTEGER_SEMIHOSTING_BUFFER_SIZE)
+#define OS_INTEGER_SEMIHOSTING_BUFFER_SIZE (256)
+#endif
+
+/**
+ * @brief Maximum age of the buffered output, in system clock ticks.
+ */
+#if !defined(OS_INTEGER_SEMIHOSTING_FLUSH_TICKS)
+#define OS_INTEGER_SEMIHOSTING_FLUSH_TICKS (10)
+#endif
+
+/**
+ * @brief Write the buffered output also after each new line.
+ */
+#if !defined(OS_BOOL_SEMIHOSTING_FLUSH_ON_NEWLINE)
+#define OS_BOOL_SEMIHOSTING_FLUSH_ON_NEWLINE (false)
+#endif
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+namespace os
+{
+  namespace semihosting
+  {
+    // ------------------------------------------------------------------------
+
+    /**
+     * @brief Semihosting buffer.
+     * @headerfile semihosting-buffer.h <cmsis-plus/arm/semihosting-buffer.h>
+     *
+     * @details
+     * Each semihosting operation is a trap, which stops the core
+     * until the debugger services it; the cost is the same for
+     * one byte or for one hundred, so small writes are very slow.
+     *
+     * The buffer collects the bytes written to a host handle, and
+     * passes them to the host with a single `SYS_WRITE` (or
+     * `SYS_WRITE0`, for the debug channel) when the buffer is full,
+     * after a new line (if enabled), when the oldest byte is older
+     * than `OS_INTEGER_SEMIHOSTING_FLUSH_TICKS` (checked on each
+     * write and by the idle thread), or when explicitly flushed.
+     * Write errors detected while flushing are reported by the
+     * next call.
+     *
+     * Reads are done in blocks of the buffer size, and the
+     * following reads are served from the buffer. Before reading,
+     * the output of all buffers is written, so prompts are
+     * displayed. The buffer is used either for writing or for
+     * reading; the owner must move the host position back over the
+     * unread bytes (see `unread()`) before writing or seeking.
+     *
+     * The host operations are done with interrupts enabled, by
+     * one context at a time; only the buffer bookkeeping uses short
+     * interrupts critical sections, so interrupt handlers can write
+     * too. While one context passes the buffered bytes to the host,
+     * the others append after them; if the buffer is full, the
+     * threads wait for the transfer to complete, while the interrupt
+     * handlers and the idle thread get `EWOULDBLOCK`.
+     */
+    class buffer
+    {
+    public:
+
+      /**
+       * @brief Handle of the debug channel, written with `SYS_WRITE0`.
+       */
+      static constexpr int debug_channel = -2;
+
+      /**
+       * @brief Value of an unbound handle.
+       */
+      static constexpr int no_handle = -1;
+
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+
+      /**
+       * @brief Construct a buffer, initially not bound to a handle.
+       * @param [in] storage Pointer to the buffer storage.
+       * @param [in] size_bytes Size of the storage.
+       * @param [in] flush_on_newline Write also after each new line.
+       */
+      constexpr
+      buffer (char* storage, std::size_t size_bytes, bool flush_on_newline =
+                  OS_BOOL_SEMIHOSTING_FLUSH_ON_NEWLINE);
+
+      /**
+       * @cond ignore
+       */
+
+      buffer (const buffer&) = delete;
+      buffer (buffer&&) = delete;
+      buffer&
+      operator= (const buffer&) = delete;
+      buffer&
+      operator= (buffer&&) = delete;
+
+      /**
+       * @endcond
+       */
+
+      ~buffer () = default;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+
+      /**
+       * @brief Bind the buffer to a host handle.
+       * @param [in] handle The host handle, `debug_channel`,
+       *  or `no_handle`.
+       * @par Returns
+       *  Nothing.
+       *
+       * @details
+       * The content of the buffer is written or dropped before.
+       */
+      void
+      bind (int handle);
+
+      /**
+       * @brief Get the host handle.
+       * @par Parameters
+       *  None.
+       * @return The host handle.
+       */
+      int
+      handle (void) const;
+
+      /**
+       * @brief Buffer bytes to be written to the host.
+       * @param [in] buf Pointer to the bytes.
+       * @param [in] nbyte Number of bytes.
+       * @return The number of bytes accepted, or -1 if error.
+       */
+      ssize_t
+      write (const void* buf, std::size_t nbyte);
+
+      /**
+       * @brief Read bytes from the host, in blocks.
+       * @param [out] buf Pointer to the destination.
+       * @param [in] nbyte Number of bytes.
+       * @return The number of bytes read, 0 at end of file,
+       *  or -1 if error.
+       */
+      ssize_t
+      read (void* buf, std::size_t nbyte);
+
+      /**
+       * @brief Write the buffered output to the host.
+       * @par Parameters
+       *  None.
+       * @retval 0 The output was written.
+       * @retval -1 The host failed to write all bytes.
+       */
+      int
+      flush (void);
+
+      /**
+       * @brief Get the number of bytes read ahead, not yet returned.
+       * @par Parameters
+       *  None.
+       * @return The number of bytes.
+       */
+      std::size_t
+      unread (void) const;
+
+      /**
+       * @brief Drop the bytes read ahead.
+       * @par Parameters
+       *  None.
+       * @par Returns
+       *  Nothing.
+       */
+      void
+      discard (void);
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Static Member Functions
+       * @{
+       */
+
+    public:
+
+      /**
+       * @brief Write the output of all buffers.
+       * @param [in] expired_only Only the buffers with output older
+       *  than `OS_INTEGER_SEMIHOSTING_FLUSH_TICKS`.
+       * @param [in] except Pointer to a buffer to skip, or null.
+       * @par Returns
+       *  Nothing.
+       *
+       * @details
+       * Called with `expired_only` from the idle thread.
+       */
+      static void
+      flush_all (bool expired_only = false, buffer* except = nullptr);
+
+      /**
+       * @}
+       */
+
+    protected:
+
+      /**
+       * @cond ignore
+       */
+
+      bool
+      internal_acquire_ (bool wait);
+
+      void
+      internal_release_ (void);
+
+      int
+      internal_flush_ (void);
+
+      std::size_t
+      internal_detach_ (void);
+
+      int
+      internal_send_ (void);
+
+      void
+      internal_complete_ (void);
+
+      ssize_t
+      internal_call_ (int reason, void* buf, std::size_t nbyte);
+
+      bool
+      internal_is_expired_ (rtos::clock::timestamp_t now) const;
+
+      static bool
+      internal_can_wait_ (void);
+
+      /**
+       * @endcond
+       */
+
+    private:
+
+      /**
+       * @cond ignore
+       */
+
+      static buffer* list__;
+
+      buffer* next_ = nullptr;
+
+      char* storage_;
+      std::size_t size_;
+
+      // Output: bytes in the buffer; input: end of the valid bytes.
+      std::size_t length_ = 0;
+      // Input: the next byte to return.
+      std::size_t position_ = 0;
+      // Output: bytes at the beginning being written to the host.
+      std::size_t sending_ = 0;
+
+      // The time when the first buffered byte was written.
+      rtos::clock::timestamp_t since_ = 0;
+
+      int handle_ = no_handle;
+
+      bool flush_on_newline_;
+      bool is_input_ = false;
+      bool is_listed_ = false;
+      bool has_error_ = false;
+      // A context passes the buffer to the host.
+      bool busy_ = false;
+
+      /**
+       * @endcond
+       */
+    };
+
+  } /* namespace semihosting */
+} /* namespace os */
+
+#pragma GCC diagnostic pop
+
+// ===== Inline & template implementations ====================================
+
+namespace os
+{
+  namespace semihosting
+  {
+    // ------------------------------------------------------------------------
+
+    constexpr
+    buffer::buffer (char* storage, std::size_t size_bytes,
+                    bool flush_on_newline) :
+        storage_ (storage), //
+        size_ (size_bytes), //
+        flush_on_newline_ (flush_on_newline)
+    {
+      ;
+    }
+
+    inline int
+    buffer::handle (void) const
+    {
+      return handle_;
+    }
+
+    inline std::size_t
+    buffer::unread (void) const
+    {
+      return is_input_ ? (length_ - position_) : 0;
+    }
+
+  } /* namespace semihosting */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
+
+#endif /* __cplusplus */
+
+#endif /* CMSIS_PLUS_ARM_SEMIHOSTING_BUFFER_H_ */
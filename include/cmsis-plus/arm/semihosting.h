@@ -28,6 +28,8 @@
 #ifndef CMSIS_PLUS_ARM_SEMIHOSTING_H_
 #define CMSIS_PLUS_ARM_SEMIHOSTING_H_
 
+#include <stdint.h>
+
 // ----------------------------------------------------------------------------
 
 // Semihosting operations.
@@ -67,6 +69,8 @@ enum OperationNumber
 
 // ----------------------------------------------------------------------------
 
+#if defined(__ARM_EABI__)
+
 // SWI numbers and reason codes for RDI (Angel) monitors.
 #define AngelSWI_ARM                    0x123456
 #ifdef __thumb__
@@ -124,6 +128,35 @@ call_host (int reason, void* arg)
   return value;
 }
 
+#else
+
+// On other architectures (like when testing or benchmarking on
+// Linux or macOS) there is no debugger to service the operations,
+// so they are forwarded to a function, with the same parameters;
+// the parameter blocks have pointer size fields.
+// A stand-in that implements them with POSIX calls on the
+// host is available in `src/semihosting/semihosting-host.cpp`;
+// being weak, it can be replaced by the application.
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+  int
+  call_host (int reason, void* arg);
+
+  // Counter of the operations serviced by the host stand-in, and
+  // the duration of each one, in microseconds (default 0).
+  extern unsigned long os_semihosting_host_calls;
+  extern unsigned long os_semihosting_host_call_us;
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* defined(__ARM_EABI__) */
+
 // ----------------------------------------------------------------------------
 
 // Function used in _exit() to return the status code as Angel exception.
@@ -131,7 +164,7 @@ static inline void
 __attribute__ ((always_inline,noreturn))
 report_exception (int reason)
 {
-  call_host (SEMIHOSTING_ReportException, (void*) reason);
+  call_host (SEMIHOSTING_ReportException, (void*) (intptr_t) reason);
 
   for (;;)
     ;
@@ -0,0 +1,228 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CMSIS_PLUS_DIAG_TRACE_DEFERRED_H_
+#define CMSIS_PLUS_DIAG_TRACE_DEFERRED_H_
+
+// ----------------------------------------------------------------------------
+
+#include <cmsis-plus/os-app-config.h>
+#include <cmsis-plus/diag/trace.h>
+
+// ----------------------------------------------------------------------------
+
+#if defined(TRACE) && defined(OS_USE_TRACE_DEFERRED)
+
+#if defined(__cplusplus)
+
+namespace os
+{
+  namespace trace
+  {
+    /**
+     * @brief Deferred (binary) trace namespace.
+     * @ingroup cmsis-plus-diag
+     * @details
+     * Formatting a message with `vsnprintf()` is expensive, both in
+     * time and in stack space, and the cost is paid on the caller
+     * thread, possibly in a hot path.
+     *
+     * The deferred functions do not format anything; they store the
+     * address of the format string and the raw argument values in a
+     * lock-free ring buffer, which can be used from both threads
+     * and interrupt handlers.
+     *
+     * The records are later sent, in binary form, to the trace
+     * channel with `drain()`, usually from a low priority context,
+     * like the idle thread, and decoded on the host by the
+     * `scripts/trace-deferred-decode.py` script, which reads the
+     * format strings from the application ELF file.
+     *
+     * Since the format strings and `%s` arguments are referred only by
+     * address, they must be string literals or other read-only
+     * strings stored in flash.
+     */
+    namespace deferred
+    {
+      // ----------------------------------------------------------------------
+
+      /**
+       * @brief Record a formatted message, without formatting it.
+       * @param [in] format A null terminated string literal with the format.
+       * @return The number of argument words recorded, or -1 if the
+       *  ring buffer is full and the message was dropped.
+       *
+       * @note Can be invoked from Interrupt Service Routines.
+       */
+      int
+      printf (const char* format, ...);
+
+      /**
+       * @brief Record a formatted variable arguments list,
+       *  without formatting it.
+       * @param [in] format A null terminated string literal with the format.
+       * @param [in] args A variable arguments list.
+       * @return The number of argument words recorded, or -1 if the
+       *  ring buffer is full and the message was dropped.
+       *
+       * @note Can be invoked from Interrupt Service Routines.
+       */
+      int
+      vprintf (const char* format, std::va_list args);
+
+      /**
+       * @brief Send the committed records to the trace channel.
+       * @par Parameters
+       *  None.
+       * @return The number of bytes sent.
+       *
+       * @warning Not reentrant, there must be a single consumer.
+       */
+      std::size_t
+      drain (void);
+
+      /**
+       * @brief Write binary records to the trace channel.
+       * @param [in] buf Pointer to the records.
+       * @param [in] nbyte Number of bytes.
+       * @return The number of bytes actually written, or -1 if error.
+       *
+       * @details
+       * The weak default forwards to `trace::write()`; redefine it
+       * to use a separate channel, if the text output is also in use.
+       */
+      ssize_t
+      write (const void* buf, std::size_t nbyte);
+
+      /**
+       * @brief Tell how many messages were dropped.
+       * @par Parameters
+       *  None.
+       * @return The number of messages dropped since startup.
+       */
+      std::size_t
+      dropped (void);
+
+    } /* namespace deferred */
+  } /* namespace trace */
+} /* namespace os */
+
+#endif /* defined(__cplusplus) */
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+  int
+  trace_deferred_printf (const char* format, ...);
+
+  int
+  trace_deferred_vprintf (const char* format, va_list args);
+
+  size_t
+  trace_deferred_drain (void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#else /* !(defined(TRACE) && defined(OS_USE_TRACE_DEFERRED)) */
+
+// Empty definitions when deferred trace is not enabled.
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+
+#if defined(__cplusplus)
+
+namespace os
+  {
+    namespace trace
+      {
+        namespace deferred
+          {
+            // ------------------------------------------------------------
+
+            inline int __attribute__((always_inline))
+            printf (const char* format, ...)
+              {
+                return 0;
+              }
+
+            inline int __attribute__((always_inline))
+            vprintf (const char* format, std::va_list args)
+              {
+                return 0;
+              }
+
+            inline std::size_t __attribute__((always_inline))
+            drain (void)
+              {
+                return 0;
+              }
+
+            inline std::size_t __attribute__((always_inline))
+            dropped (void)
+              {
+                return 0;
+              }
+
+          } /* namespace deferred */
+      } /* namespace trace */
+  } /* namespace os */
+
+#endif /* defined(__cplusplus) */
+
+inline int
+__attribute__((always_inline))
+trace_deferred_printf (const char* format, ...)
+  {
+    return 0;
+  }
+
+inline int
+__attribute__((always_inline))
+trace_deferred_vprintf (const char* format, va_list args)
+  {
+    return 0;
+  }
+
+inline size_t
+__attribute__((always_inline))
+trace_deferred_drain (void)
+  {
+    return 0;
+  }
+
+#pragma GCC diagnostic pop
+
+#endif /* defined(TRACE) && defined(OS_USE_TRACE_DEFERRED) */
+
+// ----------------------------------------------------------------------------
+
+#endif /* CMSIS_PLUS_DIAG_TRACE_DEFERRED_H_ */
@@ -0,0 +1,358 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CMSIS_PLUS_DIAG_TRACE_RING_H_
+#define CMSIS_PLUS_DIAG_TRACE_RING_H_
+
+#if defined(__cplusplus)
+
+// ----------------------------------------------------------------------------
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+
+// Cores without atomic read-modify-write instructions (like ARMv6-M)
+// have no lock-free compare-and-swap; the compiler would call the
+// `__atomic_*` library functions, not available on bare metal. There,
+// short interrupts critical sections are used instead.
+#if defined(__ARM_ARCH_6M__) || (__GCC_ATOMIC_INT_LOCK_FREE < 2)
+#define OS_INTERNAL_TRACE_RING_CRITICAL_SECTIONS
+#include <cmsis-plus/rtos/os.h>
+#endif
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace trace
+  {
+    namespace internal
+    {
+      // ----------------------------------------------------------------------
+
+      /**
+       * @cond ignore
+       */
+
+      /**
+       * @brief Lock-free ring of words, with multiple producers
+       *  and a single consumer.
+       *
+       * @details
+       * Used by the trace buffer and by the deferred trace.
+       *
+       * Each record starts with a header word, which is written last
+       * and must not be 0; a header equal to 0 means the record was
+       * reserved but not yet committed. The producers (threads or
+       * interrupt handlers) reserve space with a compare-and-swap
+       * on the head index, so they get separate areas without
+       * disabling interrupts (on cores without compare-and-swap,
+       * in a short interrupts critical section); if there is not
+       * enough space, the reservation fails and the record must
+       * be dropped.
+       *
+       * The consumer releases the space by clearing it and advancing
+       * the tail index.
+       *
+       * @tparam N Number of words, a power of 2.
+       */
+      template<std::size_t N>
+        class ring
+        {
+        public:
+
+          using word_t = std::uint32_t;
+
+          static constexpr std::size_t size = N;
+          static constexpr std::size_t mask = N - 1;
+
+          static_assert((N & (N - 1)) == 0, "The ring size must be a power of 2");
+
+          constexpr
+          ring () = default;
+
+          ring (const ring&) = delete;
+          ring (ring&&) = delete;
+          ring&
+          operator= (const ring&) = delete;
+          ring&
+          operator= (ring&&) = delete;
+
+          ~ring () = default;
+
+          // Reserve `len` words; return false if there is not enough space.
+          bool
+          reserve (std::size_t len, std::size_t& index);
+
+          // Store a payload word, before commit.
+          void
+          store (std::size_t index, word_t word);
+
+          // Copy payload bytes starting at a word index, possibly
+          // wrapping around.
+          void
+          store_bytes (std::size_t index, const void* src, std::size_t nbyte);
+
+          // Publish the record reserved at index.
+          void
+          commit (std::size_t index, word_t header);
+
+          // Get the index and the header of the first record;
+          // return 0 if the ring is empty, or the record is not
+          // yet committed.
+          word_t
+          front (std::size_t& index) const;
+
+          // Get a word of a committed record.
+          word_t
+          load (std::size_t index) const;
+
+          // Get the contiguous part of a committed payload starting at
+          // a word index; the rest, if any, is at the ring beginning.
+          const std::uint8_t*
+          bytes (std::size_t index, std::size_t nbyte,
+                 std::size_t& first) const;
+
+          const std::uint8_t*
+          begin (void) const;
+
+          // Release the first record, with `len` words.
+          void
+          pop (std::size_t index, std::size_t len);
+
+        private:
+
+          word_t words_[N]
+            { };
+
+          // Free running word indices; the producers advance
+          // the head, the consumer advances the tail.
+          std::atomic<std::size_t> head_
+            { 0 };
+          std::atomic<std::size_t> tail_
+            { 0 };
+        };
+
+      // Set the flag and return its previous value.
+      bool
+      test_and_set (std::atomic<bool>& flag);
+
+      // Add 1 to a counter.
+      void
+      increment (std::atomic<std::size_t>& counter);
+
+      /**
+       * @endcond
+       */
+
+    // ------------------------------------------------------------------------
+    } /* namespace internal */
+  } /* namespace trace */
+} /* namespace os */
+
+// ===== Inline & template implementations ====================================
+
+namespace os
+{
+  namespace trace
+  {
+    namespace internal
+    {
+      // ----------------------------------------------------------------------
+
+      /**
+       * @cond ignore
+       */
+
+      template<std::size_t N>
+        bool
+        ring<N>::reserve (std::size_t len, std::size_t& index)
+        {
+#if defined(OS_INTERNAL_TRACE_RING_CRITICAL_SECTIONS)
+          // ----- Enter critical section -------------------------------------
+          rtos::interrupts::critical_section ics;
+
+          std::size_t head = head_.load (std::memory_order_relaxed);
+          if (head + len - tail_.load (std::memory_order_acquire) > N)
+            {
+              return false;
+            }
+          head_.store (head + len, std::memory_order_release);
+          // ----- Exit critical section --------------------------------------
+#else
+          std::size_t head = head_.load (std::memory_order_relaxed);
+          do
+            {
+              if (head + len - tail_.load (std::memory_order_acquire) > N)
+                {
+                  return false;
+                }
+            }
+          while (!head_.compare_exchange_weak (head, head + len,
+                                               std::memory_order_acq_rel,
+                                               std::memory_order_relaxed));
+#endif /* defined(OS_INTERNAL_TRACE_RING_CRITICAL_SECTIONS) */
+          index = head;
+          return true;
+        }
+
+      template<std::size_t N>
+        inline void
+        ring<N>::store (std::size_t index, word_t word)
+        {
+          words_[index & mask] = word;
+        }
+
+      template<std::size_t N>
+        void
+        ring<N>::store_bytes (std::size_t index, const void* src,
+                              std::size_t nbyte)
+        {
+          const std::uint8_t* p = static_cast<const std::uint8_t*> (src);
+          std::size_t offset = (index & mask) * sizeof(word_t);
+          std::size_t first = sizeof(words_) - offset;
+          if (first > nbyte)
+            {
+              first = nbyte;
+            }
+          std::memcpy (reinterpret_cast<std::uint8_t*> (words_) + offset, p,
+                       first);
+          if (first < nbyte)
+            {
+              std::memcpy (words_, p + first, nbyte - first);
+            }
+        }
+
+      template<std::size_t N>
+        inline void
+        ring<N>::commit (std::size_t index, word_t header)
+        {
+          __atomic_store_n (&words_[index & mask], header, __ATOMIC_RELEASE);
+        }
+
+      template<std::size_t N>
+        inline typename ring<N>::word_t
+        ring<N>::front (std::size_t& index) const
+        {
+          index = tail_.load (std::memory_order_relaxed);
+          if (index == head_.load (std::memory_order_acquire))
+            {
+              return 0;
+            }
+          return __atomic_load_n (&words_[index & mask], __ATOMIC_ACQUIRE);
+        }
+
+      template<std::size_t N>
+        inline typename ring<N>::word_t
+        ring<N>::load (std::size_t index) const
+        {
+          return words_[index & mask];
+        }
+
+      template<std::size_t N>
+        const std::uint8_t*
+        ring<N>::bytes (std::size_t index, std::size_t nbyte,
+                        std::size_t& first) const
+        {
+          std::size_t offset = (index & mask) * sizeof(word_t);
+          first = sizeof(words_) - offset;
+          if (first > nbyte)
+            {
+              first = nbyte;
+            }
+          return reinterpret_cast<const std::uint8_t*> (words_) + offset;
+        }
+
+      template<std::size_t N>
+        inline const std::uint8_t*
+        ring<N>::begin (void) const
+        {
+          return reinterpret_cast<const std::uint8_t*> (words_);
+        }
+
+      template<std::size_t N>
+        void
+        ring<N>::pop (std::size_t index, std::size_t len)
+        {
+          // Any word may become the header of a future record,
+          // so clear all of them before releasing the space.
+          for (std::size_t i = 0; i < len; ++i)
+            {
+              words_[(index + i) & mask] = 0;
+            }
+          tail_.store (index + len, std::memory_order_release);
+        }
+
+      inline bool
+      test_and_set (std::atomic<bool>& flag)
+      {
+#if defined(OS_INTERNAL_TRACE_RING_CRITICAL_SECTIONS)
+        // ----- Enter critical section ---------------------------------------
+        rtos::interrupts::critical_section ics;
+
+        bool ret = flag.load (std::memory_order_relaxed);
+        flag.store (true, std::memory_order_relaxed);
+        return ret;
+        // ----- Exit critical section ----------------------------------------
+#else
+        return flag.exchange (true, std::memory_order_acquire);
+#endif /* defined(OS_INTERNAL_TRACE_RING_CRITICAL_SECTIONS) */
+      }
+
+      inline void
+      increment (std::atomic<std::size_t>& counter)
+      {
+#if defined(OS_INTERNAL_TRACE_RING_CRITICAL_SECTIONS)
+        // ----- Enter critical section ---------------------------------------
+        rtos::interrupts::critical_section ics;
+
+        counter.store (counter.load (std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+        // ----- Exit critical section ----------------------------------------
+#else
+        counter.fetch_add (1, std::memory_order_relaxed);
+#endif /* defined(OS_INTERNAL_TRACE_RING_CRITICAL_SECTIONS) */
+      }
+
+      /**
+       * @endcond
+       */
+
+    // ------------------------------------------------------------------------
+    } /* namespace internal */
+  } /* namespace trace */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
+
+#endif /* __cplusplus */
+
+#endif /* CMSIS_PLUS_DIAG_TRACE_RING_H_ */
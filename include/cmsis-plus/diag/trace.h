@@ -91,11 +91,17 @@ namespace os
    *
    * The implementation is done in:
    * - os::trace::initialize()
-   * - os::trace::write()
+   * - os::trace::channel_write()
+   * - os::trace::channel_flush()
    *
    * If these functions are not defined in another place, there are
    * weak definitions that simply discard the trace output.
    *
+   * By default os::trace::write() forwards to os::trace::channel_write().
+   * When `OS_USE_TRACE_BUFFER` is defined, os::trace::write() only
+   * copies the data into a lock-free buffer, and os::trace::drain(),
+   * usually called from the idle thread, moves it to the channel.
+   *
    * Trace support is enabled by adding the `TRACE` macro definition.
    *
    * When `TRACE` is not defined, all functions are inlined to empty bodies.
@@ -113,6 +119,34 @@ namespace os
     ssize_t
     write (const void* buf, std::size_t nbyte);
 
+    /**
+     * @brief Write the given bytes to the physical trace channel.
+     * @param [in] buf Pointer to the bytes.
+     * @param [in] nbyte Number of bytes.
+     * @return The number of bytes actually written, or -1 if error.
+     */
+    ssize_t
+    channel_write (const void* buf, std::size_t nbyte);
+
+    /**
+     * @brief Flush the physical trace channel.
+     * @par Parameters
+     *  None.
+     * @par Returns
+     *  Nothing.
+     */
+    void
+    channel_flush (void);
+
+    /**
+     * @brief Move the buffered bytes to the physical trace channel.
+     * @par Parameters
+     *  None.
+     * @return The number of bytes moved.
+     */
+    std::size_t
+    drain (void);
+
     // ----------------------------------------------------------------------
 
     /**
@@ -291,6 +325,12 @@ namespace os
             ;
           }
 
+        inline std::size_t __attribute__((always_inline))
+        drain (void)
+          {
+            return 0;
+          }
+
         inline int __attribute__((always_inline))
         printf (const char* format, ...)
           {
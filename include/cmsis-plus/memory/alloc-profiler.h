@@ -0,0 +1,485 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CMSIS_PLUS_MEMORY_ALLOC_PROFILER_H_
+#define CMSIS_PLUS_MEMORY_ALLOC_PROFILER_H_
+
+// ----------------------------------------------------------------------------
+
+#if defined(__cplusplus)
+
+#include <cmsis-plus/rtos/os.h>
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace memory
+  {
+
+    // ========================================================================
+
+    /**
+     * @brief Memory resource recording the call sites of the
+     *  allocations passed to an upstream memory resource.
+     * @ingroup cmsis-plus-rtos-memres
+     * @headerfile alloc-profiler.h <cmsis-plus/memory/alloc-profiler.h>
+     *
+     * @details
+     * This class is a decorator; all requests are passed to the
+     * upstream memory resource, and for each live allocation the
+     * profiler records the caller address, the size and the
+     * allocation time, in a compact open addressing hash table.
+     * For each call site, a copy of the name of the thread which
+     * did the last allocation is kept, so the threads may be
+     * destroyed before the dump.
+     *
+     * The allocations are also aggregated per call site, and
+     * `dump()` lists the top call sites by live bytes, by number
+     * of allocations and by average lifetime.
+     *
+     * The call site is the return address of the function that
+     * called `allocate()`; for `malloc()` and `operator new`,
+     * which set a `call_site` hint, it is the address of the
+     * application code calling them.
+     *
+     * The tables are stored in an existing arena, so the profiler
+     * itself does not allocate memory. When the tables are full,
+     * the allocations are still performed, but are counted as
+     * untracked.
+     *
+     * As for the other memory resources, the calls must be
+     * protected by the caller; `dump()` uses its own scheduler
+     * critical section.
+     */
+    class alloc_profiler : public rtos::memory::memory_resource
+    {
+    public:
+
+      /**
+       * @brief Type of the allocation time stamps.
+       */
+      using timestamp_t = rtos::clock::timestamp_t;
+
+      /**
+       * @brief Call site hint.
+       *
+       * @details
+       * Functions that allocate on behalf of their callers, like
+       * `malloc()` or `operator new`, can create an object of
+       * this type, with their return address, before calling
+       * `allocate()`, to have the allocation recorded with the
+       * caller address. Only the outermost hint is used, so nested
+       * calls like `operator new[]` calling `operator new`
+       * record the original caller.
+       *
+       * Since hints are not per thread, they must be used inside
+       * the same critical section as the allocation.
+       */
+      class call_site
+      {
+      public:
+
+        /**
+         * @brief Set the call site hint.
+         * @param [in] addr Address of the allocating code.
+         */
+        call_site (const void* addr);
+
+        /**
+         * @cond ignore
+         */
+
+        call_site (const call_site&) = delete;
+        call_site (call_site&&) = delete;
+        call_site&
+        operator= (const call_site&) = delete;
+        call_site&
+        operator= (call_site&&) = delete;
+
+        /**
+         * @endcond
+         */
+
+        /**
+         * @brief Clear the call site hint.
+         */
+        ~call_site ();
+
+        /**
+         * @brief Get the current call site hint.
+         * @par Parameters
+         *  None.
+         * @return The address, or `nullptr` if no hint is set.
+         */
+        static const void*
+        address (void);
+
+      protected:
+
+        /**
+         * @cond ignore
+         */
+
+        bool owner_;
+
+        static const void* address_;
+
+        /**
+         * @endcond
+         */
+      };
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+      /**
+       * @brief Construct a memory resource object instance.
+       * @param [in] upstream Pointer to the profiled memory resource.
+       * @param [in] live Max number of live allocations to record.
+       * @param [in] sites Max number of call sites to record.
+       * @param [in] addr Begin of the tables arena.
+       * @param [in] bytes Size of the tables arena, in bytes.
+       */
+      alloc_profiler (rtos::memory::memory_resource* upstream,
+                      std::size_t live, std::size_t sites, void* addr,
+                      std::size_t bytes);
+
+      /**
+       * @brief Construct a named memory resource object instance.
+       * @param [in] name Pointer to name.
+       * @param [in] upstream Pointer to the profiled memory resource.
+       * @param [in] live Max number of live allocations to record.
+       * @param [in] sites Max number of call sites to record.
+       * @param [in] addr Begin of the tables arena.
+       * @param [in] bytes Size of the tables arena, in bytes.
+       */
+      alloc_profiler (const char* name,
+                      rtos::memory::memory_resource* upstream,
+                      std::size_t live, std::size_t sites, void* addr,
+                      std::size_t bytes);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      alloc_profiler (const alloc_profiler&) = delete;
+      alloc_profiler (alloc_profiler&&) = delete;
+      alloc_profiler&
+      operator= (const alloc_profiler&) = delete;
+      alloc_profiler&
+      operator= (alloc_profiler&&) = delete;
+
+      /**
+       * @endcond
+       */
+
+      /**
+       * @brief Destruct the memory resource object instance.
+       */
+      virtual
+      ~alloc_profiler ();
+
+      /**
+       * @}
+       */
+
+    public:
+
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+      /**
+       * @brief Get the upstream memory resource.
+       * @par Parameters
+       *  None.
+       * @return Pointer to memory resource.
+       */
+      rtos::memory::memory_resource*
+      upstream (void) const;
+
+      /**
+       * @brief Get the number of allocations not recorded.
+       * @par Parameters
+       *  None.
+       * @return Number of allocations.
+       */
+      std::size_t
+      untracked (void) const;
+
+      /**
+       * @brief Print the top call sites.
+       * @param [in] top Max number of call sites in each list.
+       * @par Returns
+       *  Nothing.
+       */
+      void
+      dump (std::size_t top = OS_INTEGER_MEMORY_ALLOC_PROFILER_TOP);
+
+      /**
+       * @brief Forget the call sites statistics.
+       * @par Parameters
+       *  None.
+       * @par Returns
+       *  Nothing.
+       */
+      void
+      clear (void);
+
+      /**
+       * @brief Compute the arena size required for the tables.
+       * @param [in] live Max number of live allocations to record.
+       * @param [in] sites Max number of call sites to record.
+       * @return Number of bytes.
+       */
+      static std::size_t
+      arena_size (std::size_t live, std::size_t sites);
+
+      /**
+       * @}
+       */
+
+    protected:
+
+      /**
+       * @name Private Member Functions
+       * @{
+       */
+
+      /**
+       * @brief Implementation of the memory allocator.
+       * @param [in] bytes Number of bytes to allocate.
+       * @param [in] alignment Alignment constraint (power of 2).
+       * @return Pointer to newly allocated block, or `nullptr`.
+       */
+      virtual void*
+      do_allocate (std::size_t bytes, std::size_t alignment) override;
+
+      /**
+       * @brief Implementation of the memory deallocator.
+       * @param [in] addr Address of a previously allocated block to free.
+       * @param [in] bytes Number of bytes to deallocate (may be 0 if unknown).
+       * @param [in] alignment Alignment constraint (power of 2).
+       * @par Returns
+       *  Nothing.
+       */
+      virtual void
+      do_deallocate (void* addr, std::size_t bytes, std::size_t alignment)
+          noexcept override;
+
+      /**
+       * @brief Implementation of the function to get max size.
+       * @par Parameters
+       *  None.
+       * @return Integer with size in bytes, or 0 if unknown.
+       */
+      virtual std::size_t
+      do_max_size (void) const noexcept override;
+
+      /**
+       * @brief Implementation of the function to reset the memory manager.
+       * @par Parameters
+       *  None.
+       * @par Returns
+       *  Nothing.
+       */
+      virtual void
+      do_reset (void) noexcept override;
+
+      /**
+       * @brief Implementation of the function to coalesce free blocks.
+       * @par Parameters
+       *  None.
+       * @retval true if the operation resulted in larger blocks.
+       * @retval false if the operation was ineffective.
+       */
+      virtual bool
+      do_coalesce (void) noexcept override;
+
+      /**
+       * @}
+       */
+
+    protected:
+
+      /**
+       * @cond ignore
+       */
+
+      /**
+       * @brief Size of the thread name copies, including the
+       *  terminator; longer names are truncated.
+       */
+      static constexpr std::size_t thread_name_size = 16;
+
+      /**
+       * @brief Per call site data.
+       */
+      struct site_s
+      {
+        const void* caller;
+        char thread_name[thread_name_size];
+        std::size_t live_bytes;
+        std::size_t live_count;
+        std::size_t max_live_bytes;
+        std::size_t allocations;
+        // Sum of the allocation time stamps of the live blocks.
+        timestamp_t live_since;
+        // Sum of the lifetimes of the freed blocks.
+        timestamp_t freed_lifetime;
+      };
+
+      /**
+       * @brief Per live allocation data.
+       */
+      struct live_s
+      {
+        void* addr;
+        std::size_t bytes;
+        timestamp_t since;
+        site_s* site;
+      };
+
+      site_s*
+      internal_find_site_ (const void* caller);
+
+      live_s*
+      internal_find_live_ (void* addr);
+
+      void
+      internal_remove_live_ (live_s* entry);
+
+      timestamp_t
+      internal_value_ (const site_s* site, int key, timestamp_t now) const;
+
+      timestamp_t
+      internal_average_lifetime_ (const site_s* site, timestamp_t now) const;
+
+      void
+      internal_dump_sorted_ (const char* title, std::size_t top, int key,
+                             timestamp_t now);
+
+      void
+      internal_sync_statistics_ (void);
+
+      rtos::memory::memory_resource* upstream_ = nullptr;
+
+      live_s* live_ = nullptr;
+      site_s* sites_ = nullptr;
+      // Scratch array used when sorting the sites.
+      site_s** order_ = nullptr;
+
+      std::size_t live_capacity_ = 0;
+      std::size_t sites_capacity_ = 0;
+
+      std::size_t live_count_ = 0;
+      std::size_t sites_count_ = 0;
+      std::size_t untracked_ = 0;
+
+      /**
+       * @endcond
+       */
+
+    };
+
+  // -------------------------------------------------------------------------
+  } /* namespace memory */
+} /* namespace os */
+
+// ===== Inline & template implementations ====================================
+
+namespace os
+{
+  namespace memory
+  {
+
+    // ========================================================================
+
+    inline
+    alloc_profiler::call_site::call_site (const void* addr) :
+        owner_ (address_ == nullptr)
+    {
+      if (owner_)
+        {
+          address_ = addr;
+        }
+    }
+
+    inline
+    alloc_profiler::call_site::~call_site ()
+    {
+      if (owner_)
+        {
+          address_ = nullptr;
+        }
+    }
+
+    inline const void*
+    alloc_profiler::call_site::address (void)
+    {
+      return address_;
+    }
+
+    // ========================================================================
+
+    inline
+    alloc_profiler::alloc_profiler (rtos::memory::memory_resource* upstream,
+                                    std::size_t live, std::size_t sites,
+                                    void* addr, std::size_t bytes) :
+        alloc_profiler
+          { nullptr, upstream, live, sites, addr, bytes }
+    {
+      ;
+    }
+
+    inline rtos::memory::memory_resource*
+    alloc_profiler::upstream (void) const
+    {
+      return upstream_;
+    }
+
+    inline std::size_t
+    alloc_profiler::untracked (void) const
+    {
+      return untracked_;
+    }
+
+  // --------------------------------------------------------------------------
+
+  } /* namespace memory */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
+
+#endif /* __cplusplus */
+
+#endif /* CMSIS_PLUS_MEMORY_ALLOC_PROFILER_H_ */
@@ -0,0 +1,301 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CMSIS_PLUS_MEMORY_SLAB_H_
+#define CMSIS_PLUS_MEMORY_SLAB_H_
+
+// ----------------------------------------------------------------------------
+
+#if defined(__cplusplus)
+
+#include <cmsis-plus/memory/block-pool.h>
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace memory
+  {
+
+    // ========================================================================
+
+    /**
+     * @brief Memory resource routing requests to block pools
+     *  of several sizes, using an existing arena.
+     * @ingroup cmsis-plus-rtos-memres
+     * @headerfile slab.h <cmsis-plus/memory/slab.h>
+     *
+     * @details
+     * This class is a deterministic, non-fragmenting memory
+     * manager for small objects. The arena is split into a
+     * `block_pool` for each size class; a request is served
+     * by the smallest class with a free block large enough,
+     * in constant time.
+     *
+     * Requests larger than the largest class, requests with an
+     * alignment larger than `alignof(std::max_align_t)`, and requests
+     * that find all suitable pools empty, are passed to the
+     * upstream memory resource, if any.
+     *
+     * Deallocations are routed by address, so the size may be 0
+     * if unknown, as for `operator delete`.
+     */
+    class slab : public rtos::memory::memory_resource
+    {
+    public:
+
+      /**
+       * @brief Size class definition.
+       */
+      struct size_class
+      {
+        /**
+         * @brief The size of the blocks, in bytes.
+         */
+        std::size_t block_size_bytes;
+
+        /**
+         * @brief The number of blocks.
+         */
+        std::size_t blocks;
+      };
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+      /**
+       * @brief Construct a memory resource object instance.
+       * @param [in] classes Array of size classes, in increasing size order.
+       * @param [in] count Number of size classes.
+       * @param [in] addr Begin of allocator arena.
+       * @param [in] bytes Size of allocator arena, in bytes.
+       * @param [in] upstream Pointer to memory resource used for
+       *  the other requests, or `nullptr`.
+       */
+      slab (const size_class* classes, std::size_t count, void* addr,
+            std::size_t bytes, rtos::memory::memory_resource* upstream =
+                nullptr);
+
+      /**
+       * @brief Construct a named memory resource object instance.
+       * @param [in] name Pointer to name.
+       * @param [in] classes Array of size classes, in increasing size order.
+       * @param [in] count Number of size classes.
+       * @param [in] addr Begin of allocator arena.
+       * @param [in] bytes Size of allocator arena, in bytes.
+       * @param [in] upstream Pointer to memory resource used for
+       *  the other requests, or `nullptr`.
+       */
+      slab (const char* name, const size_class* classes, std::size_t count,
+            void* addr, std::size_t bytes,
+            rtos::memory::memory_resource* upstream = nullptr);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      slab (const slab&) = delete;
+      slab (slab&&) = delete;
+      slab&
+      operator= (const slab&) = delete;
+      slab&
+      operator= (slab&&) = delete;
+
+      /**
+       * @endcond
+       */
+
+      /**
+       * @brief Destruct the memory resource object instance.
+       */
+      virtual
+      ~slab ();
+
+      /**
+       * @}
+       */
+
+    public:
+
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+      /**
+       * @brief Get the upstream memory resource.
+       * @par Parameters
+       *  None.
+       * @return Pointer to memory resource, or `nullptr`.
+       */
+      rtos::memory::memory_resource*
+      upstream (void) const;
+
+      /**
+       * @brief Compute the arena size required for the size classes.
+       * @param [in] classes Array of size classes.
+       * @param [in] count Number of size classes.
+       * @return Number of bytes.
+       */
+      static std::size_t
+      arena_size (const size_class* classes, std::size_t count);
+
+      /**
+       * @}
+       */
+
+    protected:
+
+      /**
+       * @name Private Member Functions
+       * @{
+       */
+
+      /**
+       * @brief Implementation of the memory allocator.
+       * @param [in] bytes Number of bytes to allocate.
+       * @param [in] alignment Alignment constraint (power of 2).
+       * @return Pointer to newly allocated block, or `nullptr`.
+       */
+      virtual void*
+      do_allocate (std::size_t bytes, std::size_t alignment) override;
+
+      /**
+       * @brief Implementation of the memory deallocator.
+       * @param [in] addr Address of a previously allocated block to free.
+       * @param [in] bytes Number of bytes to deallocate (may be 0 if unknown).
+       * @param [in] alignment Alignment constraint (power of 2).
+       * @par Returns
+       *  Nothing.
+       */
+      virtual void
+      do_deallocate (void* addr, std::size_t bytes, std::size_t alignment)
+          noexcept override;
+
+      /**
+       * @brief Implementation of the function to get max size.
+       * @par Parameters
+       *  None.
+       * @return Integer with size in bytes, or 0 if unknown.
+       */
+      virtual std::size_t
+      do_max_size (void) const noexcept override;
+
+      /**
+       * @brief Implementation of the function to reset the memory manager.
+       * @par Parameters
+       *  None.
+       * @par Returns
+       *  Nothing.
+       */
+      virtual void
+      do_reset (void) noexcept override;
+
+      /**
+       * @brief Implementation of the function to coalesce free blocks.
+       * @par Parameters
+       *  None.
+       * @retval true if the operation resulted in larger blocks.
+       * @retval false if the operation was ineffective.
+       */
+      virtual bool
+      do_coalesce (void) noexcept override;
+
+      /**
+       * @}
+       */
+
+    protected:
+
+      /**
+       * @cond ignore
+       */
+
+      /**
+       * @brief Per size class data, stored at the beginning of the arena.
+       */
+      struct pool_s
+      {
+        block_pool* pool;
+        std::size_t block_size_bytes;
+        char* begin;
+        char* end;
+      };
+
+      pool_s* pools_ = nullptr;
+
+      std::size_t count_ = 0;
+
+      rtos::memory::memory_resource* upstream_ = nullptr;
+
+      /**
+       * @endcond
+       */
+
+    };
+
+  // -------------------------------------------------------------------------
+  } /* namespace memory */
+} /* namespace os */
+
+// ===== Inline & template implementations ====================================
+
+namespace os
+{
+  namespace memory
+  {
+
+    // ========================================================================
+
+    inline
+    slab::slab (const size_class* classes, std::size_t count, void* addr,
+                std::size_t bytes, rtos::memory::memory_resource* upstream) :
+        slab
+          { nullptr, classes, count, addr, bytes, upstream }
+    {
+      ;
+    }
+
+    inline rtos::memory::memory_resource*
+    slab::upstream (void) const
+    {
+      return upstream_;
+    }
+
+  // --------------------------------------------------------------------------
+
+  } /* namespace memory */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
+
+#endif /* __cplusplus */
+
+#endif /* CMSIS_PLUS_MEMORY_SLAB_H_ */
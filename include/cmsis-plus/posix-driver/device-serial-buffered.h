@@ -139,6 +139,9 @@ namespace os
         virtual ssize_t
         do_write (const void* buf, std::size_t nbyte) override;
 
+        virtual ssize_t
+        do_splice_to (io* out, std::size_t count) override;
+
 #if 0
         virtual ssize_t
         do_writev (const struct iovec* iov, int iovcnt) override;
@@ -435,6 +438,70 @@ namespace os
           }
       }
 
+    // Pass the received bytes to the destination directly from
+    // the rx circular buffer, one contiguous region at a time.
+    // Bytes not accepted by the destination remain in the buffer.
+    template<typename CS>
+      ssize_t
+      device_serial_buffered<CS>::do_splice_to (io* out, std::size_t count)
+      {
+        std::size_t total = 0;
+        while (total < count)
+          {
+            uint8_t* pbuf;
+            std::size_t nb;
+              {
+                // ----- Enter critical section -------------------------------
+                critical_section cs;
+
+                nb = rx_buf_->front_contiguous_buffer (&pbuf);
+                // ----- Exit critical section --------------------------------
+              }
+            if (nb == 0)
+              {
+                if (total > 0)
+                  {
+                    break;
+                  }
+                if (!is_connected_)
+                  {
+                    errno = EIO;
+                    return -1;
+                  }
+                // Block and wait for bytes to arrive.
+                rx_sem_.wait ();
+                continue;
+              }
+
+            if (nb > count - total)
+              {
+                nb = count - total;
+              }
+
+            ssize_t ret = out->write (pbuf, nb);
+            if (ret <= 0)
+              {
+                return (total > 0) ? static_cast<ssize_t> (total) : ret;
+              }
+
+              {
+                // ----- Enter critical section -------------------------------
+                critical_section cs;
+
+                rx_buf_->advance_front (static_cast<std::size_t> (ret));
+                // ----- Exit critical section --------------------------------
+              }
+            total += static_cast<std::size_t> (ret);
+
+            if (static_cast<std::size_t> (ret) < nb)
+              {
+                break;
+              }
+          }
+
+        return static_cast<ssize_t> (total);
+      }
+
     template<typename CS>
       ssize_t
       device_serial_buffered<CS>::do_write (const void* buf, std::size_t nbyte)
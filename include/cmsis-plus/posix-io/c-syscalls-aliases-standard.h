@@ -129,6 +129,13 @@ extern "C"
   int __attribute__((weak, alias ("__posix_mkdir")))
   mkdir (const char* path, mode_t mode);
 
+  void*
+  __attribute__((weak, alias ("__posix_mmap")))
+  mmap (void* addr, size_t len, int prot, int flags, int fildes, off_t off);
+
+  int __attribute__((weak, alias ("__posix_munmap")))
+  munmap (void* addr, size_t len);
+
   int __attribute__((weak, alias ("__posix_open")))
   open (const char* path, int oflag, ...);
 
@@ -183,6 +190,9 @@ extern "C"
   ssize_t __attribute__((weak, alias ("__posix_send")))
   send (int socket, const void* buffer, size_t length, int flags);
 
+  ssize_t __attribute__((weak, alias ("__posix_sendfile")))
+  sendfile (int out_fd, int in_fd, off_t* offset, size_t count);
+
   ssize_t __attribute__((weak, alias ("__posix_sendmsg")))
   sendmsg (int socket, const struct msghdr* message, int flags);
 
@@ -32,6 +32,11 @@
 
 // ----------------------------------------------------------------------------
 
+#include <cstddef>
+#include <sys/types.h>
+
+// ----------------------------------------------------------------------------
+
 namespace os
 {
   namespace posix
@@ -40,9 +45,20 @@ namespace os
      * @brief Block device class.
      * @headerfile device-block.h <cmsis-plus/posix-io/device-block.h>
      * @ingroup cmsis-plus-posix-io-base
+     *
+     * @details
+     * Devices which transfer data in fixed size blocks
+     * (flash, SD cards, RAM disks), addressed by block number.
+     * Implementations define `do_read_block()` and `do_write_block()`.
      */
     class device_block
     {
+    public:
+
+      /**
+       * @brief Type of block numbers.
+       */
+      using blknum_t = std::size_t;
 
       // ----------------------------------------------------------------------
 
@@ -53,7 +69,12 @@ namespace os
 
     public:
 
-      device_block () = default;
+      /**
+       * @brief Construct a block device object instance.
+       * @param [in] block_size_bytes The size of a block, in bytes.
+       * @param [in] blocks The number of blocks.
+       */
+      device_block (std::size_t block_size_bytes, blknum_t blocks);
 
       /**
        * @cond ignore
@@ -71,18 +92,135 @@ namespace os
        * @endcond
        */
 
-      ~device_block () = default;
+      virtual
+      ~device_block ();
 
       /**
        * @}
        */
 
-      // TODO: add content
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+
+      /**
+       * @brief Read consecutive blocks.
+       * @param [out] buf Pointer to a buffer of `nblocks` blocks.
+       * @param [in] blknum The first block number.
+       * @param [in] nblocks The number of blocks.
+       * @return The number of blocks read, or -1 with `errno` set.
+       */
+      ssize_t
+      read_block (void* buf, blknum_t blknum, std::size_t nblocks = 1);
+
+      /**
+       * @brief Write consecutive blocks.
+       * @param [in] buf Pointer to a buffer of `nblocks` blocks.
+       * @param [in] blknum The first block number.
+       * @param [in] nblocks The number of blocks.
+       * @return The number of blocks written, or -1 with `errno` set.
+       */
+      ssize_t
+      write_block (const void* buf, blknum_t blknum, std::size_t nblocks = 1);
+
+      /**
+       * @brief Wait for the device to complete the writes.
+       * @retval 0 Success.
+       * @retval -1 Failure, with `errno` set.
+       */
+      int
+      sync (void);
+
+      /**
+       * @brief Get the size of a block.
+       * @par Parameters
+       *  None.
+       * @return The number of bytes in a block.
+       */
+      std::size_t
+      block_size_bytes (void) const;
+
+      /**
+       * @brief Get the device size.
+       * @par Parameters
+       *  None.
+       * @return The number of blocks.
+       */
+      blknum_t
+      blocks (void) const;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Private Member Functions
+       * @{
+       */
+
+    protected:
+
+      virtual ssize_t
+      do_read_block (void* buf, blknum_t blknum, std::size_t nblocks) = 0;
+
+      virtual ssize_t
+      do_write_block (const void* buf, blknum_t blknum, std::size_t nblocks) = 0;
+
+      virtual int
+      do_sync (void);
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+
+    protected:
+
+      /**
+       * @cond ignore
+       */
+
+      std::size_t block_size_bytes_;
+      blknum_t blocks_;
+
+      /**
+       * @endcond
+       */
+
     };
 
   } /* namespace posix */
 } /* namespace os */
 
+// ===== Inline & template implementations ====================================
+
+namespace os
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    inline std::size_t
+    device_block::block_size_bytes (void) const
+    {
+      return block_size_bytes_;
+    }
+
+    inline device_block::blknum_t
+    device_block::blocks (void) const
+    {
+      return blocks_;
+    }
+
+  } /* namespace posix */
+} /* namespace os */
+
 // ----------------------------------------------------------------------------
 
 #endif /* __cplusplus */
@@ -296,6 +296,9 @@ namespace os
 
       device_block* block_device_;
 
+      // Set by the mount manager; file systems in RAM have no device.
+      bool mounted_;
+
       /**
        * @endcond
        */
@@ -34,6 +34,16 @@
 
 #include <cmsis-plus/posix-io/io.h>
 #include <cmsis-plus/posix/utime.h>
+#include <cmsis-plus/posix/sys/mman.h>
+
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Maximum number of simultaneous file mappings.
+ */
+#if !defined(OS_INTEGER_POSIX_IO_FILE_MAPPINGS)
+#define OS_INTEGER_POSIX_IO_FILE_MAPPINGS (8)
+#endif
 
 // ----------------------------------------------------------------------------
 
@@ -135,6 +145,40 @@ namespace os
       int
       fsync (void);
 
+      /**
+       * @brief Map a part of the file in memory.
+       * @param [in] length Number of bytes to map.
+       * @param [in] prot `PROT_READ`, optionally with `PROT_WRITE`.
+       * @param [in] flags `MAP_SHARED` or `MAP_PRIVATE`.
+       * @param [in] offset Offset in the file.
+       * @return The address of the mapping, or `MAP_FAILED`
+       *  with `errno` set.
+       *
+       * @details
+       * If the file system can expose the content directly
+       * (files in RAM or in execute-in-place flash), the returned
+       * address points to it, without copies. Otherwise the range
+       * is copied in a buffer from the default memory resource;
+       * for `MAP_SHARED` writable mappings, the buffer is written
+       * back to the file by `munmap()`.
+       *
+       * The mappings remain valid after the file is closed; the
+       * shared writable copies are written back by `close()`, and
+       * the file is actually closed by the last `munmap()`.
+       */
+      void*
+      mmap (std::size_t length, int prot, int flags, off_t offset);
+
+      /**
+       * @brief Remove a mapping.
+       * @param [in] addr The address returned by `mmap()`.
+       * @param [in] length The length passed to `mmap()`.
+       * @retval 0 Success.
+       * @retval -1 Failure, with `errno` set.
+       */
+      static int
+      munmap (void* addr, std::size_t length);
+
       // ----------------------------------------------------------------------
       // Support functions.
 
@@ -170,6 +214,19 @@ namespace os
       virtual int
       do_fsync (void);
 
+      /**
+       * return the address of the file content, nullptr if it cannot
+       * be accessed directly, or MAP_FAILED & errno
+       */
+      virtual void*
+      do_mmap (std::size_t length, int prot, int flags, off_t offset);
+
+      /**
+       * called for the mappings returned by do_mmap()
+       */
+      virtual int
+      do_munmap (void* addr, std::size_t length);
+
       virtual void
       do_release (void) override;
 
@@ -179,6 +236,17 @@ namespace os
       void
       file_system (class file_system* file_system);
 
+      /**
+       * @cond ignore
+       */
+
+      // The flags passed to open(), set before do_vopen().
+      int oflag_;
+
+      /**
+       * @endcond
+       */
+
       /**
        * @}
        */
@@ -189,8 +257,36 @@ namespace os
        * @cond ignore
        */
 
+      struct mapping_s
+      {
+        void* addr;
+        std::size_t length;
+        file* owner;
+        off_t offset;
+        int prot;
+        int flags;
+        // True if the content was copied in a buffer.
+        bool copy;
+      };
+
+      static int
+      internal_write_back_ (mapping_s* mapping);
+
+      static int
+      internal_unmap_ (mapping_s* mapping);
+
+      int
+      internal_close_mappings_ (bool* mapped);
+
+      static mapping_s mappings__[OS_INTEGER_POSIX_IO_FILE_MAPPINGS];
+
       class file_system* file_system_;
 
+      // The mappings of this file; they keep it open.
+      std::size_t mappings_count_;
+      // Closed by the user, waiting for the last munmap().
+      bool closed_;
+
       /**
        * @endcond
        */
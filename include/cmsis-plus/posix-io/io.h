@@ -42,6 +42,13 @@
 
 // ----------------------------------------------------------------------------
 
+// The size of the stack buffer used by the default do_splice_to().
+#if !defined(OS_INTEGER_POSIX_IO_SPLICE_BUFFER_SIZE)
+#define OS_INTEGER_POSIX_IO_SPLICE_BUFFER_SIZE (128)
+#endif
+
+// ----------------------------------------------------------------------------
+
 struct iovec;
 
 namespace os
@@ -65,6 +72,9 @@ namespace os
     io*
     vopen (const char* path, int oflag, std::va_list args);
 
+    ssize_t
+    sendfile (io* out, io* in, off_t* offset, std::size_t count);
+
     /**
      * @}
      */
@@ -169,6 +179,16 @@ namespace os
       ssize_t
       writev (const struct iovec* iov, int iovcnt);
 
+      /**
+       * @brief Transfer bytes to another object.
+       * @param out Pointer to the destination object.
+       * @param count Maximum number of bytes to transfer.
+       * @return The number of bytes transferred, 0 at end of file,
+       * or -1 with `errno` set if nothing could be transferred.
+       */
+      ssize_t
+      splice_to (io* out, std::size_t count);
+
       int
       fcntl (int cmd, ...);
 
@@ -227,6 +247,11 @@ namespace os
       virtual ssize_t
       do_writev (const struct iovec* iov, int iovcnt);
 
+      // Objects that can expose their content in place should
+      // override it and write() it directly to `out`.
+      virtual ssize_t
+      do_splice_to (io* out, std::size_t count);
+
       virtual int
       do_vfcntl (int cmd, std::va_list args);
 
@@ -32,17 +32,63 @@
 
 // ----------------------------------------------------------------------------
 
+#include <cmsis-plus/posix-io/pbuf.h>
+#include <cmsis-plus/rtos/os.h>
+
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Default number of slots of the interface rx and tx rings.
+ */
+#if !defined(OS_INTEGER_POSIX_IO_NET_INTERFACE_RING_SLOTS)
+#define OS_INTEGER_POSIX_IO_NET_INTERFACE_RING_SLOTS (8)
+#endif
+
+// ----------------------------------------------------------------------------
+
 namespace os
 {
   namespace posix
   {
+    // ------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
     /**
      * @brief Network interface class.
      * @headerfile net-interface.h <cmsis-plus/posix-io/net-interface.h>
      * @ingroup cmsis-plus-posix-io-base
+     *
+     * @details
+     * The packets are passed between the protocol code and the
+     * driver by reference, through two rings:
+     *
+     * - received packets are added by the driver with
+     *   `rx_enqueue()`, possibly from an interrupt handler,
+     *   and taken by the protocol code with `rx_dequeue()`
+     *   or `rx_wait()`;
+     * - packets to send are added by the protocol code with
+     *   `output()`, which calls `do_output()` to notify the driver,
+     *   and are taken by the driver with `tx_dequeue()`.
+     *
+     * When a ring is full, the packet is dropped and counted.
      */
     class net_interface
     {
+    public:
+
+      /**
+       * @brief Interface counters.
+       */
+      struct counters_s
+      {
+        std::size_t rx_packets;
+        std::size_t rx_dropped;
+        std::size_t tx_packets;
+        std::size_t tx_dropped;
+      };
+
       // ----------------------------------------------------------------------
 
       /**
@@ -52,7 +98,11 @@ namespace os
 
     public:
 
-      net_interface () = default;
+      net_interface (const char* name = nullptr, std::size_t rx_slots =
+                         OS_INTEGER_POSIX_IO_NET_INTERFACE_RING_SLOTS,
+                     std::size_t tx_slots =
+                         OS_INTEGER_POSIX_IO_NET_INTERFACE_RING_SLOTS,
+                     rtos::memory::memory_resource* mr = nullptr);
 
       /**
        * @cond ignore
@@ -70,15 +120,206 @@ namespace os
        * @endcond
        */
 
-      ~net_interface () = default;
+      virtual
+      ~net_interface ();
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+
+      /**
+       * @brief Queue a packet for transmission.
+       * @param p Packet; the interface takes over the reference.
+       * @retval 0 The packet was queued.
+       * @retval -1 The tx ring is full, the packet was
+       * dropped; `errno` is `ENOBUFS`.
+       */
+      int
+      output (pbuf* p);
+
+      /**
+       * @brief Get the next received packet, if any.
+       * @return The packet, with its reference, or `nullptr`.
+       */
+      pbuf*
+      rx_dequeue (void);
+
+      /**
+       * @brief Wait for the next received packet.
+       * @return The packet, with its reference.
+       */
+      pbuf*
+      rx_wait (void);
+
+      /**
+       * @brief Add a received packet; called by drivers.
+       * @param p Packet; the interface takes over the reference.
+       * @retval 0 The packet was queued.
+       * @retval -1 The rx ring is full, the packet was
+       * dropped; `errno` is `ENOBUFS`.
+       */
+      int
+      rx_enqueue (pbuf* p);
+
+      /**
+       * @brief Get the next packet to transmit; called by drivers.
+       * @return The packet, with its reference, or `nullptr`.
+       */
+      pbuf*
+      tx_dequeue (void);
+
+      const char*
+      name (void) const;
+
+      counters_s
+      counters (void) const;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Private Member Functions
+       * @{
+       */
+
+    protected:
+
+      /**
+       * @details
+       * Called after a packet was added to the tx ring, to start
+       * the transmission. The default does nothing, for drivers
+       * which poll the ring.
+       */
+      virtual void
+      do_output (void);
 
       /**
        * @}
        */
 
-      // TODO: add content
+      // ----------------------------------------------------------------------
+    private:
+
+      /**
+       * @cond ignore
+       */
+
+      const char* name_;
+
+      pbuf_ring rx_ring_;
+      pbuf_ring tx_ring_;
+
+      rtos::semaphore_binary rx_sem_;
+
+      counters_s counters_;
+
+      /**
+       * @endcond
+       */
+
     };
 
+    // ========================================================================
+
+    /**
+     * @brief Software loopback interface.
+     * @headerfile net-interface.h <cmsis-plus/posix-io/net-interface.h>
+     * @ingroup cmsis-plus-posix-io-base
+     *
+     * @details
+     * The packets sent are received back, by reference, as they
+     * are; useful for tests and for local traffic.
+     */
+    class net_interface_loopback : public net_interface
+    {
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+
+      net_interface_loopback (const char* name = "lo", std::size_t slots =
+                                  OS_INTEGER_POSIX_IO_NET_INTERFACE_RING_SLOTS,
+                              rtos::memory::memory_resource* mr = nullptr);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      net_interface_loopback (const net_interface_loopback&) = delete;
+      net_interface_loopback (net_interface_loopback&&) = delete;
+      net_interface_loopback&
+      operator= (const net_interface_loopback&) = delete;
+      net_interface_loopback&
+      operator= (net_interface_loopback&&) = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual
+      ~net_interface_loopback ();
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Private Member Functions
+       * @{
+       */
+
+    protected:
+
+      virtual void
+      do_output (void) override;
+
+      /**
+       * @}
+       */
+
+    };
+
+#pragma GCC diagnostic pop
+
+  } /* namespace posix */
+} /* namespace os */
+
+// ===== Inline & template implementations ====================================
+
+namespace os
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    inline const char*
+    net_interface::name (void) const
+    {
+      return name_;
+    }
+
+    inline net_interface::counters_s
+    net_interface::counters (void) const
+    {
+      return counters_;
+    }
+
   } /* namespace posix */
 } /* namespace os */
 
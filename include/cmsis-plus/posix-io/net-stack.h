@@ -49,6 +49,7 @@ namespace os
     class io;
     class socket;
     class pool;
+    class pbuf_pool;
 
     // ------------------------------------------------------------------------
 
@@ -68,7 +69,7 @@ namespace os
 
     public:
 
-      net_stack (pool* sockets_pool);
+      net_stack (pool* sockets_pool, pbuf_pool* pbufs_pool = nullptr);
 
       /**
        * @cond ignore
@@ -103,6 +104,13 @@ namespace os
       static pool*
       sockets_pool (void);
 
+      /**
+       * @brief Get the pool of packet buffers, used by the
+       * protocols and the network interfaces.
+       */
+      static pbuf_pool*
+      pbufs_pool (void);
+
       /**
        * @}
        */
@@ -115,6 +123,7 @@ namespace os
        */
 
       static pool* sockets_pool__;
+      static pbuf_pool* pbufs_pool__;
 
       /**
        * @endcond
@@ -139,6 +148,12 @@ namespace os
       return sockets_pool__;
     }
 
+    inline pbuf_pool*
+    net_stack::pbufs_pool (void)
+    {
+      return pbufs_pool__;
+    }
+
   } /* namespace posix */
 } /* namespace os */
 
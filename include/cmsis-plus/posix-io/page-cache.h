@@ -0,0 +1,479 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CMSIS_PLUS_POSIX_IO_PAGE_CACHE_H_
+#define CMSIS_PLUS_POSIX_IO_PAGE_CACHE_H_
+
+#if defined(__cplusplus)
+
+// ----------------------------------------------------------------------------
+
+#include <cmsis-plus/posix-io/device-block.h>
+#include <cmsis-plus/rtos/os.h>
+
+#include <type_traits>
+
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Percent of the pages which may be dirty before writers wait.
+ */
+#if !defined(OS_INTEGER_POSIX_IO_PAGE_CACHE_DIRTY_RATIO)
+#define OS_INTEGER_POSIX_IO_PAGE_CACHE_DIRTY_RATIO (50)
+#endif
+
+/**
+ * @brief Age of a dirty page before the flusher writes it, in ms.
+ */
+#if !defined(OS_INTEGER_POSIX_IO_PAGE_CACHE_WRITEBACK_MS)
+#define OS_INTEGER_POSIX_IO_PAGE_CACHE_WRITEBACK_MS (500)
+#endif
+
+/**
+ * @brief Maximum read-ahead window, in pages.
+ */
+#if !defined(OS_INTEGER_POSIX_IO_PAGE_CACHE_READAHEAD_PAGES)
+#define OS_INTEGER_POSIX_IO_PAGE_CACHE_READAHEAD_PAGES (8)
+#endif
+
+/**
+ * @brief Maximum number of consecutive blocks in a device transfer.
+ */
+#if !defined(OS_INTEGER_POSIX_IO_PAGE_CACHE_CLUSTER_PAGES)
+#define OS_INTEGER_POSIX_IO_PAGE_CACHE_CLUSTER_PAGES (8)
+#endif
+
+/**
+ * @brief Number of sequential read streams tracked for read-ahead.
+ */
+#if !defined(OS_INTEGER_POSIX_IO_PAGE_CACHE_STREAMS)
+#define OS_INTEGER_POSIX_IO_PAGE_CACHE_STREAMS (4)
+#endif
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    /**
+     * @brief Page cache for block devices.
+     * @headerfile page-cache.h <cmsis-plus/posix-io/page-cache.h>
+     * @ingroup cmsis-plus-posix-io-base
+     *
+     * @details
+     * A fixed number of pages, each holding one device block,
+     * keyed by (device, block number). File systems read and
+     * write bytes through the cache instead of calling the
+     * block device directly.
+     *
+     * - Writes only update the pages, which are written to the
+     *   device later by a flusher thread, in runs of consecutive
+     *   blocks; many small writes to the same block result in a
+     *   single device write.
+     * - When more than `OS_INTEGER_POSIX_IO_PAGE_CACHE_DIRTY_RATIO`
+     *   percent of the pages are dirty, writers wait for the flusher.
+     * - `sync()` writes all dirty pages of a device and returns
+     *   after the device confirms them.
+     * - Sequential reads are detected, and the flusher thread
+     *   reads the following blocks ahead, in a window which grows
+     *   up to `OS_INTEGER_POSIX_IO_PAGE_CACHE_READAHEAD_PAGES`.
+     * - Pages are reused in CLOCK order (an approximation of LRU).
+     *
+     * All memory is allocated at construction, from the given
+     * memory resource.
+     *
+     * The devices must have blocks of the page size.
+     */
+    class page_cache
+    {
+    public:
+
+      using blknum_t = device_block::blknum_t;
+
+      /**
+       * @brief Cache counters.
+       */
+      struct counters_s
+      {
+        /**
+         * @brief Blocks found in the cache.
+         */
+        std::size_t hits;
+
+        /**
+         * @brief Blocks read on demand.
+         */
+        std::size_t misses;
+
+        /**
+         * @brief Blocks read ahead.
+         */
+        std::size_t read_ahead;
+
+        /**
+         * @brief Device write calls.
+         */
+        std::size_t writes;
+
+        /**
+         * @brief Blocks written to the device.
+         */
+        std::size_t written_blocks;
+      };
+
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+
+      /**
+       * @brief Construct a page cache and start its flusher thread.
+       * @param [in] name Pointer to a null terminated name.
+       * @param [in] pages Number of pages.
+       * @param [in] page_size_bytes Size of a page.
+       * @param [in] mr Pointer to the memory resource; if null,
+       *  the default resource is used.
+       * @param [in] attr Reference to the flusher thread attributes.
+       */
+      page_cache (const char* name, std::size_t pages,
+                  std::size_t page_size_bytes,
+                  rtos::memory::memory_resource* mr = nullptr,
+                  const rtos::thread::attributes& attr =
+                      rtos::thread::initializer);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      page_cache (const page_cache&) = delete;
+      page_cache (page_cache&&) = delete;
+      page_cache&
+      operator= (const page_cache&) = delete;
+      page_cache&
+      operator= (page_cache&&) = delete;
+
+      /**
+       * @endcond
+       */
+
+      /**
+       * @brief Stop the flusher and write all dirty pages.
+       */
+      virtual
+      ~page_cache ();
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+
+      /**
+       * @brief Read bytes from a device, via the cache.
+       * @param [in] device Pointer to the block device.
+       * @param [out] buf Pointer to the destination buffer.
+       * @param [in] nbyte Number of bytes to read.
+       * @param [in] offset Byte offset on the device.
+       * @return The number of bytes read, 0 at the end
+       *  of the device, or -1 with `errno` set.
+       */
+      ssize_t
+      pread (device_block* device, void* buf, std::size_t nbyte,
+             off_t offset);
+
+      /**
+       * @brief Write bytes to a device, via the cache.
+       * @param [in] device Pointer to the block device.
+       * @param [in] buf Pointer to the source buffer.
+       * @param [in] nbyte Number of bytes to write.
+       * @param [in] offset Byte offset on the device.
+       * @return The number of bytes written, or -1 with `errno` set.
+       *
+       * @details
+       * The pages are written to the device later, by the
+       * flusher thread or by `sync()`. If the device fails
+       * to write them and too many pages are dirty, the call
+       * fails with the write-back error (usually `EIO`).
+       */
+      ssize_t
+      pwrite (device_block* device, const void* buf, std::size_t nbyte,
+              off_t offset);
+
+      /**
+       * @brief Write all dirty pages of a device.
+       * @param [in] device Pointer to the block device.
+       * @retval 0 Success; all previous writes reached the device.
+       * @retval -1 Failure, with `errno` set.
+       */
+      int
+      sync (device_block* device);
+
+      /**
+       * @brief Write the dirty pages of a device and forget all its pages.
+       * @param [in] device Pointer to the block device.
+       * @retval 0 Success.
+       * @retval -1 Failure, with `errno` set.
+       *
+       * @details
+       * Use it before unmounting or removing the device.
+       */
+      int
+      invalidate (device_block* device);
+
+      /**
+       * @brief Get the cache name.
+       * @par Parameters
+       *  None.
+       * @return A null terminated string.
+       */
+      const char*
+      name (void) const;
+
+      /**
+       * @brief Get the number of pages.
+       * @par Parameters
+       *  None.
+       * @return The number of pages.
+       */
+      std::size_t
+      pages (void) const;
+
+      /**
+       * @brief Get the page size.
+       * @par Parameters
+       *  None.
+       * @return The number of bytes in a page.
+       */
+      std::size_t
+      page_size_bytes (void) const;
+
+      /**
+       * @brief Get the number of dirty pages.
+       * @par Parameters
+       *  None.
+       * @return The number of pages not yet written to the device.
+       */
+      std::size_t
+      dirty (void) const;
+
+      /**
+       * @brief Get the cache counters.
+       * @par Parameters
+       *  None.
+       * @return A reference to the counters.
+       */
+      const counters_s&
+      counters (void) const;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+
+    protected:
+
+      /**
+       * @cond ignore
+       */
+
+      enum flags_e : uint8_t
+      {
+        valid = 1,
+        dirty_flag = 2,
+        busy = 4,
+        referenced = 8
+      };
+
+      struct page_s
+      {
+        page_s* hash_next;
+        device_block* device;
+        blknum_t block;
+        char* data;
+        rtos::clock::timestamp_t dirtied;
+        uint8_t flags;
+      };
+
+      struct stream_s
+      {
+        device_block* device;
+        // The block expected by the next sequential read.
+        blknum_t next;
+        // The end of the blocks already requested ahead.
+        blknum_t ahead_end;
+        std::size_t window;
+        // Blocks to be read ahead by the flusher.
+        blknum_t pending_first;
+        std::size_t pending_count;
+      };
+
+      static void*
+      internal_flusher_ (void* args);
+
+      page_s*
+      internal_lookup_ (device_block* device, blknum_t block);
+
+      void
+      internal_insert_ (page_s* page);
+
+      void
+      internal_remove_ (page_s* page);
+
+      page_s*
+      internal_victim_ (void);
+
+      page_s*
+      internal_get_ (device_block* device, blknum_t block, bool whole);
+
+      void
+      internal_mark_dirty_ (page_s* page);
+
+      void
+      internal_detect_stream_ (device_block* device, blknum_t first,
+                               blknum_t last);
+
+      bool
+      internal_read_ahead_ (void);
+
+      ssize_t
+      internal_write_back_ (device_block* device, bool all);
+
+      bool
+      internal_is_busy_ (device_block* device) const;
+
+      /**
+       * @endcond
+       */
+
+    protected:
+
+      /**
+       * @cond ignore
+       */
+
+      const char* name_;
+      rtos::memory::memory_resource* mr_;
+
+      std::size_t pages_count_;
+      std::size_t page_size_bytes_;
+      std::size_t dirty_limit_;
+      std::size_t dirty_;
+      std::size_t hand_;
+
+      page_s* pages_;
+      page_s** buckets_;
+      char* data_;
+      // Buffer for multi-block transfers.
+      char* cluster_;
+      bool cluster_busy_;
+
+      stream_s streams_[OS_INTEGER_POSIX_IO_PAGE_CACHE_STREAMS];
+      std::size_t stream_next_;
+
+      counters_s counters_;
+      // The errno of the last failed write-back, 0 after a success.
+      int error_;
+
+      rtos::mutex mutex_;
+      // Page state changes and fewer dirty pages.
+      rtos::condition_variable changed_;
+      // Wakes up the flusher.
+      rtos::condition_variable work_;
+      bool stop_;
+
+      rtos::thread* flusher_;
+      std::aligned_storage<sizeof(rtos::thread), alignof(rtos::thread)>::type flusher_storage_;
+
+      /**
+       * @endcond
+       */
+    };
+
+  } /* namespace posix */
+} /* namespace os */
+
+// ===== Inline & template implementations ====================================
+
+namespace os
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    inline const char*
+    page_cache::name (void) const
+    {
+      return name_;
+    }
+
+    inline std::size_t
+    page_cache::pages (void) const
+    {
+      return pages_count_;
+    }
+
+    inline std::size_t
+    page_cache::page_size_bytes (void) const
+    {
+      return page_size_bytes_;
+    }
+
+    inline std::size_t
+    page_cache::dirty (void) const
+    {
+      return dirty_;
+    }
+
+    inline const page_cache::counters_s&
+    page_cache::counters (void) const
+    {
+      return counters_;
+    }
+
+  } /* namespace posix */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
+
+#endif /* __cplusplus */
+
+#endif /* CMSIS_PLUS_POSIX_IO_PAGE_CACHE_H_ */
@@ -0,0 +1,670 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CMSIS_PLUS_POSIX_IO_PBUF_H_
+#define CMSIS_PLUS_POSIX_IO_PBUF_H_
+
+#if defined(__cplusplus)
+
+// ----------------------------------------------------------------------------
+
+#include <cmsis-plus/rtos/os.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Bytes reserved in front of the payload of a new packet,
+ * for the headers added by the lower layers.
+ */
+#if !defined(OS_INTEGER_POSIX_IO_PBUF_HEADROOM)
+#define OS_INTEGER_POSIX_IO_PBUF_HEADROOM (64)
+#endif
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    class pbuf_pool;
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+    /**
+     * @brief Packet buffer.
+     * @headerfile pbuf.h <cmsis-plus/posix-io/pbuf.h>
+     * @ingroup cmsis-plus-posix-io-base
+     *
+     * @details
+     * A fixed size buffer from a `pbuf_pool`, holding a part of
+     * a packet; larger packets are chains of buffers, linked by
+     * `next()`.
+     *
+     * The payload can grow in front, in the headroom, when a
+     * header is added, and can shrink when a header is removed,
+     * so the packet is passed between layers by reference,
+     * without copying it.
+     *
+     * The buffers are reference counted; a packet can be kept by
+     * several owners (for example a retransmission queue and
+     * a driver), each calling `release()` when done. When the
+     * count of a buffer reaches zero, it is returned to the pool,
+     * together with the rest of the chain it holds.
+     */
+    class pbuf
+    {
+      // ----------------------------------------------------------------------
+
+      /**
+       * @cond ignore
+       */
+
+      friend class pbuf_pool;
+
+      /**
+       * @endcond
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    private:
+
+      pbuf (pbuf_pool* pool);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      pbuf (const pbuf&) = delete;
+      pbuf (pbuf&&) = delete;
+      pbuf&
+      operator= (const pbuf&) = delete;
+      pbuf&
+      operator= (pbuf&&) = delete;
+
+      ~pbuf () = default;
+
+      /**
+       * @endcond
+       */
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+
+      /**
+       * @brief Get the address of the payload.
+       */
+      uint8_t*
+      payload (void);
+
+      const uint8_t*
+      payload (void) const;
+
+      /**
+       * @brief Get the length of the payload in this buffer.
+       */
+      std::size_t
+      length (void) const;
+
+      /**
+       * @brief Get the length of the payload in the chain.
+       */
+      std::size_t
+      total_length (void) const;
+
+      /**
+       * @brief Get the next buffer in the chain.
+       */
+      pbuf*
+      next (void) const;
+
+      /**
+       * @brief Get the space available in front of the payload.
+       */
+      std::size_t
+      headroom (void) const;
+
+      /**
+       * @brief Get the space available after the payload.
+       */
+      std::size_t
+      tailroom (void) const;
+
+      /**
+       * @brief Grow the payload in front, to add a header.
+       * @param nbyte Number of bytes.
+       * @retval 0 Success, `payload()` points to the new header.
+       * @retval -1 Not enough headroom; `errno` is `ENOBUFS`.
+       */
+      int
+      push_header (std::size_t nbyte);
+
+      /**
+       * @brief Shrink the payload in front, to remove a header.
+       * @param nbyte Number of bytes.
+       * @retval 0 Success.
+       * @retval -1 The buffer is shorter; `errno` is `EINVAL`.
+       */
+      int
+      pull_header (std::size_t nbyte);
+
+      /**
+       * @brief Grow the payload at the end.
+       * @param nbyte Number of bytes.
+       * @return The address of the added bytes, or `nullptr`
+       * with `errno` set to `ENOBUFS` if there is not enough tailroom.
+       */
+      uint8_t*
+      put (std::size_t nbyte);
+
+      /**
+       * @brief Append a chain after the last buffer of this chain.
+       * @param tail The chain to append; its reference is
+       * taken over by this chain.
+       */
+      void
+      chain (pbuf* tail);
+
+      /**
+       * @brief Copy bytes out of the chain.
+       * @param buf Destination.
+       * @param nbyte Maximum number of bytes.
+       * @param offset Offset in the chain payload.
+       * @return The number of bytes copied.
+       */
+      std::size_t
+      copy_to (void* buf, std::size_t nbyte, std::size_t offset = 0) const;
+
+      /**
+       * @brief Copy bytes into the chain payload.
+       * @param buf Source.
+       * @param nbyte Maximum number of bytes.
+       * @param offset Offset in the chain payload.
+       * @return The number of bytes copied; the payload lengths
+       * are not changed.
+       */
+      std::size_t
+      copy_from (const void* buf, std::size_t nbyte, std::size_t offset = 0);
+
+      /**
+       * @brief Add a reference.
+       * @return This buffer.
+       */
+      pbuf*
+      ref (void);
+
+      /**
+       * @brief Drop a reference, and free the buffers no longer used.
+       */
+      void
+      release (void);
+
+      /**
+       * @brief Get the number of references.
+       */
+      std::size_t
+      ref_count (void) const;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+    private:
+
+      /**
+       * @cond ignore
+       */
+
+      pbuf_pool* pool_;
+      pbuf* next_ = nullptr;
+      std::size_t offset_ = 0;
+      std::size_t length_ = 0;
+      std::size_t volatile ref_ = 0;
+
+      /**
+       * @endcond
+       */
+
+    };
+
+    // ========================================================================
+
+    /**
+     * @brief Pool of packet buffers.
+     * @headerfile pbuf.h <cmsis-plus/posix-io/pbuf.h>
+     * @ingroup cmsis-plus-posix-io-base
+     *
+     * @details
+     * All buffers are allocated at construction, from the given
+     * memory resource, each with room for _buffer_size_bytes_ of
+     * data. Allocating and freeing buffers take constant time,
+     * in interrupts critical sections, so drivers can use them in
+     * interrupt handlers.
+     */
+    class pbuf_pool
+    {
+      // ----------------------------------------------------------------------
+
+      /**
+       * @cond ignore
+       */
+
+      friend class pbuf;
+
+      /**
+       * @endcond
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+
+      pbuf_pool (const char* name, std::size_t count,
+                 std::size_t buffer_size_bytes,
+                 std::size_t headroom_bytes = OS_INTEGER_POSIX_IO_PBUF_HEADROOM,
+                 rtos::memory::memory_resource* mr = nullptr);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      pbuf_pool (const pbuf_pool&) = delete;
+      pbuf_pool (pbuf_pool&&) = delete;
+      pbuf_pool&
+      operator= (const pbuf_pool&) = delete;
+      pbuf_pool&
+      operator= (pbuf_pool&&) = delete;
+
+      /**
+       * @endcond
+       */
+
+      ~pbuf_pool ();
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+
+      /**
+       * @brief Allocate a packet.
+       * @param length Payload length.
+       * @return A chain of buffers with a total payload of
+       * _length_ bytes, and the headroom reserved in the first
+       * buffer, or `nullptr` with `errno` set to `ENOBUFS` if there
+       * are not enough free buffers.
+       */
+      pbuf*
+      alloc (std::size_t length);
+
+      const char*
+      name (void) const;
+
+      std::size_t
+      count (void) const;
+
+      std::size_t
+      available (void) const;
+
+      std::size_t
+      buffer_size_bytes (void) const;
+
+      std::size_t
+      headroom_bytes (void) const;
+
+      /**
+       * @brief Get the number of failed allocations.
+       */
+      std::size_t
+      failures (void) const;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+    private:
+
+      /**
+       * @cond ignore
+       */
+
+      uint8_t*
+      internal_data_ (const pbuf* p) const;
+
+      void
+      internal_free_ (pbuf* p);
+
+      /**
+       * @endcond
+       */
+
+    private:
+
+      /**
+       * @cond ignore
+       */
+
+      const char* name_;
+      rtos::memory::memory_resource* mr_;
+      std::size_t count_;
+      std::size_t buffer_size_bytes_;
+      std::size_t headroom_bytes_;
+      // Size of a buffer, header and data.
+      std::size_t stride_;
+
+      uint8_t* storage_;
+      pbuf* free_;
+      std::size_t volatile available_;
+      std::size_t volatile failures_;
+
+      /**
+       * @endcond
+       */
+
+    };
+
+    // ========================================================================
+
+    /**
+     * @brief Ring of packet references.
+     * @headerfile pbuf.h <cmsis-plus/posix-io/pbuf.h>
+     * @ingroup cmsis-plus-posix-io-base
+     *
+     * @details
+     * A fixed size FIFO of packets, like the descriptor rings of
+     * the network controllers; pushing and popping pass the
+     * packet reference, not the content. The operations are
+     * performed in interrupts critical sections.
+     */
+    class pbuf_ring
+    {
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+
+      pbuf_ring (std::size_t slots, rtos::memory::memory_resource* mr =
+                     nullptr);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      pbuf_ring (const pbuf_ring&) = delete;
+      pbuf_ring (pbuf_ring&&) = delete;
+      pbuf_ring&
+      operator= (const pbuf_ring&) = delete;
+      pbuf_ring&
+      operator= (pbuf_ring&&) = delete;
+
+      /**
+       * @endcond
+       */
+
+      /**
+       * @details
+       * The packets still in the ring are released.
+       */
+      ~pbuf_ring ();
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+
+      /**
+       * @brief Add a packet at the end.
+       * @retval true The ring took over the reference.
+       * @retval false The ring is full.
+       */
+      bool
+      push (pbuf* p);
+
+      /**
+       * @brief Remove the first packet.
+       * @return The packet, with its reference, or `nullptr`
+       * if the ring is empty.
+       */
+      pbuf*
+      pop (void);
+
+      std::size_t
+      length (void) const;
+
+      std::size_t
+      slots (void) const;
+
+      bool
+      empty (void) const;
+
+      bool
+      full (void) const;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+    private:
+
+      /**
+       * @cond ignore
+       */
+
+      rtos::memory::memory_resource* mr_;
+      pbuf** slots_;
+      std::size_t count_;
+      std::size_t head_ = 0;
+      std::size_t volatile length_ = 0;
+
+      /**
+       * @endcond
+       */
+
+    };
+
+#pragma GCC diagnostic pop
+
+  } /* namespace posix */
+} /* namespace os */
+
+// ===== Inline & template implementations ====================================
+
+namespace os
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    inline uint8_t*
+    pbuf::payload (void)
+    {
+      return pool_->internal_data_ (this) + offset_;
+    }
+
+    inline const uint8_t*
+    pbuf::payload (void) const
+    {
+      return pool_->internal_data_ (this) + offset_;
+    }
+
+    inline std::size_t
+    pbuf::length (void) const
+    {
+      return length_;
+    }
+
+    inline pbuf*
+    pbuf::next (void) const
+    {
+      return next_;
+    }
+
+    inline std::size_t
+    pbuf::headroom (void) const
+    {
+      return offset_;
+    }
+
+    inline std::size_t
+    pbuf::tailroom (void) const
+    {
+      return pool_->buffer_size_bytes_ - offset_ - length_;
+    }
+
+    inline std::size_t
+    pbuf::ref_count (void) const
+    {
+      return ref_;
+    }
+
+    // ------------------------------------------------------------------------
+
+    inline const char*
+    pbuf_pool::name (void) const
+    {
+      return name_;
+    }
+
+    inline std::size_t
+    pbuf_pool::count (void) const
+    {
+      return count_;
+    }
+
+    inline std::size_t
+    pbuf_pool::available (void) const
+    {
+      return available_;
+    }
+
+    inline std::size_t
+    pbuf_pool::buffer_size_bytes (void) const
+    {
+      return buffer_size_bytes_;
+    }
+
+    inline std::size_t
+    pbuf_pool::headroom_bytes (void) const
+    {
+      return headroom_bytes_;
+    }
+
+    inline std::size_t
+    pbuf_pool::failures (void) const
+    {
+      return failures_;
+    }
+
+    inline uint8_t*
+    pbuf_pool::internal_data_ (const pbuf* p) const
+    {
+      // The data follows the buffer header.
+      return const_cast<uint8_t*> (reinterpret_cast<const uint8_t*> (p))
+          + sizeof(pbuf);
+    }
+
+    // ------------------------------------------------------------------------
+
+    inline std::size_t
+    pbuf_ring::length (void) const
+    {
+      return length_;
+    }
+
+    inline std::size_t
+    pbuf_ring::slots (void) const
+    {
+      return count_;
+    }
+
+    inline bool
+    pbuf_ring::empty (void) const
+    {
+      return (length_ == 0);
+    }
+
+    inline bool
+    pbuf_ring::full (void) const
+    {
+      return (length_ == count_);
+    }
+
+  } /* namespace posix */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
+
+#endif /* __cplusplus */
+
+#endif /* CMSIS_PLUS_POSIX_IO_PBUF_H_ */
@@ -59,6 +59,8 @@
 #define __posix_listen listen
 #define __posix_lseek lseek
 #define __posix_mkdir mkdir
+#define __posix_mmap mmap
+#define __posix_munmap munmap
 #define __posix_open open
 #define __posix_opendir opendir
 #define __posix_raise raise
@@ -74,6 +76,7 @@
 #define __posix_rmdir rmdir
 #define __posix_select select
 #define __posix_send send
+#define __posix_sendfile sendfile
 #define __posix_sendmsg sendmsg
 #define __posix_sendto sendto
 #define __posix_setsockopt setsockopt
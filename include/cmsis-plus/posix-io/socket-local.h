@@ -0,0 +1,232 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CMSIS_PLUS_POSIX_IO_SOCKET_LOCAL_H_
+#define CMSIS_PLUS_POSIX_IO_SOCKET_LOCAL_H_
+
+#if defined(__cplusplus)
+
+// ----------------------------------------------------------------------------
+
+#include <cmsis-plus/posix-io/socket.h>
+#include <cmsis-plus/rtos/os.h>
+
+#include <cstdint>
+
+// ----------------------------------------------------------------------------
+
+#if !defined(OS_INTEGER_POSIX_IO_SOCKET_LOCAL_BUFFER_SIZE)
+#define OS_INTEGER_POSIX_IO_SOCKET_LOCAL_BUFFER_SIZE (512)
+#endif
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+    /**
+     * @brief Local (`AF_LOCAL`) socket.
+     * @headerfile socket-local.h <cmsis-plus/posix-io/socket-local.h>
+     * @ingroup cmsis-plus-posix-io-base
+     *
+     * @details
+     * Sockets connected in the same process, created in pairs
+     * by `socketpair()`, of `SOCK_STREAM` or `SOCK_DGRAM` type.
+     *
+     * Each socket has a receive ring buffer of
+     * `OS_INTEGER_POSIX_IO_SOCKET_LOCAL_BUFFER_SIZE` bytes; the
+     * sender copies the bytes directly into the ring of the peer,
+     * so each byte is copied once on send and once on receive,
+     * or only once when the receiver uses `sendfile()`.
+     * Datagrams are stored in the ring with a length prefix and
+     * must fit in the ring.
+     *
+     * To be used, the network stack sockets pool must hold
+     * `socket_local` objects.
+     */
+    class socket_local : public socket
+    {
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+
+      socket_local ();
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      socket_local (const socket_local&) = delete;
+      socket_local (socket_local&&) = delete;
+      socket_local&
+      operator= (const socket_local&) = delete;
+      socket_local&
+      operator= (socket_local&&) = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual
+      ~socket_local ();
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Private Member Functions
+       * @{
+       */
+
+    protected:
+
+      virtual int
+      do_socket (int domain, int type, int protocol) override;
+
+      virtual int
+      do_socketpair (socket* peer) override;
+
+      virtual int
+      do_close (void) override;
+
+      virtual ssize_t
+      do_read (void* buf, std::size_t nbyte) override;
+
+      virtual ssize_t
+      do_write (const void* buf, std::size_t nbyte) override;
+
+      virtual ssize_t
+      do_splice_to (io* out, std::size_t count) override;
+
+      virtual ssize_t
+      do_recv (void* buffer, size_t length, int flags) override;
+
+      virtual ssize_t
+      do_send (const void* buffer, size_t length, int flags) override;
+
+      virtual int
+      do_shutdown (int how) override;
+
+      virtual int
+      do_getsockname (struct sockaddr* address, socklen_t* address_len)
+          override;
+
+      virtual int
+      do_getpeername (struct sockaddr* address, socklen_t* address_len)
+          override;
+
+      virtual bool
+      do_is_opened (void) override;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+    private:
+
+      /**
+       * @cond ignore
+       */
+
+      // Must be called in a critical section.
+      void
+      internal_put_ (const void* buf, std::size_t nbyte);
+
+      void
+      internal_get_ (void* buf, std::size_t offset, std::size_t nbyte) const;
+
+      void
+      internal_consume_ (std::size_t nbyte);
+
+      std::size_t
+      internal_space_ (void) const;
+
+      /**
+       * @endcond
+       */
+
+    private:
+
+      /**
+       * @cond ignore
+       */
+
+      // Length prefix of the datagrams in the ring.
+      using dgram_length_t = uint16_t;
+
+      socket_local* peer_ = nullptr;
+
+      // Posted when bytes are added to the ring, or at end of stream.
+      rtos::semaphore_binary readable_
+        { "readable", 0 };
+      // Posted when the peer frees space in its ring.
+      rtos::semaphore_binary writable_
+        { "writable", 0 };
+
+      std::size_t front_ = 0;
+      std::size_t length_ = 0;
+
+      int sock_type_ = 0;
+      bool opened_ = false;
+      // No more bytes will arrive.
+      bool rx_shut_ = false;
+      // No more bytes can be sent.
+      bool tx_shut_ = false;
+
+      uint8_t ring_[OS_INTEGER_POSIX_IO_SOCKET_LOCAL_BUFFER_SIZE];
+
+      /**
+       * @endcond
+       */
+
+    };
+
+#pragma GCC diagnostic pop
+
+  } /* namespace posix */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
+
+#endif /* __cplusplus */
+
+#endif /* CMSIS_PLUS_POSIX_IO_SOCKET_LOCAL_H_ */
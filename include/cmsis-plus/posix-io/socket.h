@@ -60,10 +60,9 @@ namespace os
 
 #pragma GCC diagnostic pop
 
-#if 0
     int
-    socketpair (int domain, int type, int protocol, socket* socket_vector[2]);
-#endif
+    socketpair (int domain, int type, int protocol,
+                class socket* socket_vector[2]);
 
     /**
      * @}
@@ -86,6 +85,10 @@ namespace os
       friend socket*
       socket (int domain, int type, int protocol);
 
+      friend int
+      socketpair (int domain, int type, int protocol,
+                  class socket* socket_vector[2]);
+
       /**
        * @endcond
        */
@@ -201,6 +204,13 @@ namespace os
       virtual int
       do_socket (int domain, int type, int protocol) = 0;
 
+      /**
+       * Connect this socket to _peer_, both already created by
+       * do_socket(); return 0 if success or -1 & errno.
+       */
+      virtual int
+      do_socketpair (socket* peer);
+
       virtual int
       do_accept (socket* sock, struct sockaddr* address,
                  socklen_t* address_len);
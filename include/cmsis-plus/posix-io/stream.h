@@ -0,0 +1,595 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CMSIS_PLUS_POSIX_IO_STREAM_H_
+#define CMSIS_PLUS_POSIX_IO_STREAM_H_
+
+#if defined(__cplusplus)
+
+// ----------------------------------------------------------------------------
+
+#include <cmsis-plus/posix-io/io.h>
+#include <cmsis-plus/rtos/os.h>
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Default size of the stream buffers.
+ */
+#if !defined(OS_INTEGER_POSIX_IO_STREAM_BUFFER_SIZE)
+#define OS_INTEGER_POSIX_IO_STREAM_BUFFER_SIZE (256)
+#endif
+
+// ----------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+namespace os
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    /**
+     * @brief Buffered stream.
+     * @headerfile stream.h <cmsis-plus/posix-io/stream.h>
+     * @ingroup cmsis-plus-posix-io-base
+     *
+     * @details
+     * A lightweight replacement for the C `FILE` streams, which
+     * buffers the bytes written to or read from an `io` object,
+     * so that many small writes result in few calls to `io::write()`.
+     *
+     * Each stream has its own buffer, of configurable size, and
+     * its own recursive mutex. The public functions lock the
+     * stream; the `*_unlocked()` variants do not, and must be
+     * called between `lock()` and `unlock()`, or when the stream
+     * is used by a single thread. When the data fits in the buffer,
+     * `putc_unlocked()`, `getc_unlocked()` and `write_unlocked()`
+     * are inline and do not call any function.
+     *
+     * The buffer is used either for writing or for reading;
+     * changing direction flushes the output, or drops the input
+     * (for files, the position is moved back over the unread bytes).
+     *
+     * Streams must not be used from interrupt handlers.
+     */
+    class stream
+    {
+    public:
+
+      /**
+       * @brief Buffering modes.
+       */
+      enum class buffering
+        : uint8_t
+          {
+            /**
+             * @brief Write when the buffer is full.
+             */
+            full = 0,
+            /**
+             * @brief Write also after each new line.
+             */
+            line = 1,
+            /**
+             * @brief Do not buffer; write each call directly.
+             */
+            none = 2
+      };
+
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+
+      /**
+       * @brief Construct a stream with a dynamically allocated buffer.
+       * @param [in] io Pointer to the input/output object.
+       * @param [in] mode The buffering mode.
+       * @param [in] buffer_size_bytes Size of the buffer.
+       * @param [in] mr Pointer to the memory resource; if null,
+       *  the default resource is used.
+       */
+      stream (io* io, buffering mode = buffering::full,
+              std::size_t buffer_size_bytes =
+                  OS_INTEGER_POSIX_IO_STREAM_BUFFER_SIZE,
+              rtos::memory::memory_resource* mr = nullptr);
+
+      /**
+       * @brief Construct a stream with a user buffer.
+       * @param [in] io Pointer to the input/output object.
+       * @param [in] mode The buffering mode.
+       * @param [in] buffer Pointer to the buffer.
+       * @param [in] buffer_size_bytes Size of the buffer.
+       */
+      stream (io* io, buffering mode, void* buffer,
+              std::size_t buffer_size_bytes);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      stream (const stream&) = delete;
+      stream (stream&&) = delete;
+      stream&
+      operator= (const stream&) = delete;
+      stream&
+      operator= (stream&&) = delete;
+
+      /**
+       * @endcond
+       */
+
+      /**
+       * @brief Flush the output and free the buffer.
+       */
+      virtual
+      ~stream ();
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+
+      /**
+       * @brief Write bytes.
+       * @param [in] buf Pointer to the source buffer.
+       * @param [in] nbyte Number of bytes to write.
+       * @return The number of bytes written, or -1 with `errno` set.
+       */
+      ssize_t
+      write (const void* buf, std::size_t nbyte);
+
+      /**
+       * @brief Read bytes.
+       * @param [out] buf Pointer to the destination buffer.
+       * @param [in] nbyte Number of bytes to read.
+       * @return The number of bytes read, less than `nbyte` only
+       *  at the end of file, or -1 with `errno` set.
+       */
+      ssize_t
+      read (void* buf, std::size_t nbyte);
+
+      /**
+       * @brief Write a character.
+       * @param [in] c The character.
+       * @return The character, as `unsigned char`, or `EOF`
+       *  with `errno` set.
+       */
+      int
+      putc (int c);
+
+      /**
+       * @brief Read a character.
+       * @par Parameters
+       *  None.
+       * @return The character, as `unsigned char`, or `EOF`
+       *  at the end of file or on error.
+       */
+      int
+      getc (void);
+
+      /**
+       * @brief Write a string, without a new line.
+       * @param [in] s Pointer to a null terminated string.
+       * @return A non negative number, or `EOF` with `errno` set.
+       */
+      int
+      puts (const char* s);
+
+      /**
+       * @brief Write formatted text.
+       * @param [in] format Pointer to a `printf()` format string.
+       * @return The number of characters written, or -1
+       *  with `errno` set.
+       */
+      int
+      printf (const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+      /**
+       * @brief Write formatted text.
+       * @param [in] format Pointer to a `printf()` format string.
+       * @param [in] args The arguments.
+       * @return The number of characters written, or -1
+       *  with `errno` set.
+       */
+      int
+      vprintf (const char* format, std::va_list args);
+
+      /**
+       * @brief Write the buffered bytes.
+       * @par Parameters
+       *  None.
+       * @retval 0 Success.
+       * @retval -1 Failure, with `errno` set.
+       */
+      int
+      flush (void);
+
+      /**
+       * @brief Change the buffer.
+       * @param [in] buffer Pointer to the new buffer; if null,
+       *  a buffer is allocated from the memory resource.
+       * @param [in] buffer_size_bytes Size of the new buffer.
+       * @param [in] mode The buffering mode.
+       * @retval 0 Success.
+       * @retval -1 Failure, with `errno` set.
+       *
+       * @details
+       * The output is flushed and the input dropped before
+       * changing the buffer.
+       */
+      int
+      set_buffer (void* buffer, std::size_t buffer_size_bytes,
+                  buffering mode);
+
+      /**
+       * @brief Lock the stream.
+       * @par Parameters
+       *  None.
+       * @par Returns
+       *  Nothing.
+       *
+       * @details
+       * Like `flockfile()`; the lock is recursive.
+       */
+      void
+      lock (void);
+
+      /**
+       * @brief Unlock the stream.
+       * @par Parameters
+       *  None.
+       * @par Returns
+       *  Nothing.
+       */
+      void
+      unlock (void);
+
+      /**
+       * @brief Write bytes, without locking the stream.
+       * @param [in] buf Pointer to the source buffer.
+       * @param [in] nbyte Number of bytes to write.
+       * @return The number of bytes written, or -1 with `errno` set.
+       */
+      ssize_t
+      write_unlocked (const void* buf, std::size_t nbyte);
+
+      /**
+       * @brief Read bytes, without locking the stream.
+       * @param [out] buf Pointer to the destination buffer.
+       * @param [in] nbyte Number of bytes to read.
+       * @return The number of bytes read, or -1 with `errno` set.
+       */
+      ssize_t
+      read_unlocked (void* buf, std::size_t nbyte);
+
+      /**
+       * @brief Write a character, without locking the stream.
+       * @param [in] c The character.
+       * @return The character, as `unsigned char`, or `EOF`.
+       */
+      int
+      putc_unlocked (int c);
+
+      /**
+       * @brief Read a character, without locking the stream.
+       * @par Parameters
+       *  None.
+       * @return The character, as `unsigned char`, or `EOF`.
+       */
+      int
+      getc_unlocked (void);
+
+      /**
+       * @brief Write a string, without locking the stream.
+       * @param [in] s Pointer to a null terminated string.
+       * @return A non negative number, or `EOF`.
+       */
+      int
+      puts_unlocked (const char* s);
+
+      /**
+       * @brief Write formatted text, without locking the stream.
+       * @param [in] format Pointer to a `printf()` format string.
+       * @param [in] args The arguments.
+       * @return The number of characters written, or -1.
+       */
+      int
+      vprintf_unlocked (const char* format, std::va_list args);
+
+      /**
+       * @brief Write the buffered bytes, without locking the stream.
+       * @par Parameters
+       *  None.
+       * @retval 0 Success.
+       * @retval -1 Failure, with `errno` set.
+       */
+      int
+      flush_unlocked (void);
+
+      /**
+       * @brief Get the input/output object.
+       * @par Parameters
+       *  None.
+       * @return Pointer to the object.
+       */
+      io*
+      get_io (void) const;
+
+      /**
+       * @brief Get the buffering mode.
+       * @par Parameters
+       *  None.
+       * @return The mode.
+       */
+      buffering
+      mode (void) const;
+
+      /**
+       * @brief Get the buffer size.
+       * @par Parameters
+       *  None.
+       * @return The number of bytes.
+       */
+      std::size_t
+      buffer_size_bytes (void) const;
+
+      /**
+       * @brief Check if an error occurred.
+       * @par Parameters
+       *  None.
+       * @retval true An error occurred since the last `clear_error()`.
+       * @retval false No error.
+       */
+      bool
+      error (void) const;
+
+      /**
+       * @brief Check if the end of file was reached.
+       * @par Parameters
+       *  None.
+       * @retval true The end of file was reached.
+       * @retval false Not at the end of file.
+       */
+      bool
+      eof (void) const;
+
+      /**
+       * @brief Clear the error and end of file flags.
+       * @par Parameters
+       *  None.
+       * @par Returns
+       *  Nothing.
+       */
+      void
+      clear_error (void);
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+
+    protected:
+
+      /**
+       * @cond ignore
+       */
+
+      int
+      internal_set_buffer_ (void* buffer, std::size_t buffer_size_bytes,
+                            buffering mode);
+
+      void
+      internal_begin_write_ (void);
+
+      ssize_t
+      internal_write_ (const void* buf, std::size_t nbyte);
+
+      int
+      internal_putc_ (int c);
+
+      int
+      internal_getc_ (void);
+
+      bool
+      internal_fill_ (void);
+
+      ssize_t
+      internal_write_all_ (const void* buf, std::size_t nbyte);
+
+      void
+      internal_drop_input_ (void);
+
+      void
+      internal_free_ (void);
+
+      /**
+       * @endcond
+       */
+
+    protected:
+
+      /**
+       * @cond ignore
+       */
+
+      io* io_;
+      rtos::memory::memory_resource* mr_;
+
+      uint8_t* buffer_;
+      std::size_t size_;
+
+      // The next byte to write or to read.
+      uint8_t* pos_;
+      // The end of the space to write; equal to buffer_ when not writing.
+      uint8_t* wend_;
+      // The end of the bytes to read; equal to buffer_ when not reading.
+      uint8_t* rend_;
+
+      buffering mode_;
+      bool error_;
+      bool eof_;
+      // The buffer was allocated from mr_.
+      bool allocated_;
+
+      rtos::mutex_recursive mutex_;
+
+      /**
+       * @endcond
+       */
+    };
+
+  } /* namespace posix */
+} /* namespace os */
+
+#pragma GCC diagnostic pop
+
+// ===== Inline & template implementations ====================================
+
+namespace os
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    inline void
+    stream::lock (void)
+    {
+      mutex_.lock ();
+    }
+
+    inline void
+    stream::unlock (void)
+    {
+      mutex_.unlock ();
+    }
+
+    inline ssize_t
+    stream::write_unlocked (const void* buf, std::size_t nbyte)
+    {
+      if ((mode_ == buffering::full)
+          && (nbyte <= static_cast<std::size_t> (wend_ - pos_)))
+        {
+          std::memcpy (pos_, buf, nbyte);
+          pos_ += nbyte;
+          return static_cast<ssize_t> (nbyte);
+        }
+      return internal_write_ (buf, nbyte);
+    }
+
+    inline int
+    stream::putc_unlocked (int c)
+    {
+      if ((pos_ < wend_) && ((c != '\n') || (mode_ != buffering::line)))
+        {
+          *pos_++ = static_cast<uint8_t> (c);
+          return static_cast<uint8_t> (c);
+        }
+      return internal_putc_ (c);
+    }
+
+    inline int
+    stream::getc_unlocked (void)
+    {
+      if (pos_ < rend_)
+        {
+          return *pos_++;
+        }
+      return internal_getc_ ();
+    }
+
+    inline int
+    stream::puts_unlocked (const char* s)
+    {
+      return (write_unlocked (s, std::strlen (s)) < 0) ? EOF : 0;
+    }
+
+    inline io*
+    stream::get_io (void) const
+    {
+      return io_;
+    }
+
+    inline stream::buffering
+    stream::mode (void) const
+    {
+      return mode_;
+    }
+
+    inline std::size_t
+    stream::buffer_size_bytes (void) const
+    {
+      return size_;
+    }
+
+    inline bool
+    stream::error (void) const
+    {
+      return error_;
+    }
+
+    inline bool
+    stream::eof (void) const
+    {
+      return eof_;
+    }
+
+    inline void
+    stream::clear_error (void)
+    {
+      error_ = false;
+      eof_ = false;
+    }
+
+  } /* namespace posix */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
+
+#endif /* __cplusplus */
+
+#endif /* CMSIS_PLUS_POSIX_IO_STREAM_H_ */
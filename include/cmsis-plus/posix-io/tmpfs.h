@@ -0,0 +1,565 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CMSIS_PLUS_POSIX_IO_TMPFS_H_
+#define CMSIS_PLUS_POSIX_IO_TMPFS_H_
+
+#if defined(__cplusplus)
+
+// ----------------------------------------------------------------------------
+
+#include <cmsis-plus/posix-io/file-system.h>
+#include <cmsis-plus/posix-io/file.h>
+#include <cmsis-plus/posix-io/directory.h>
+#include <cmsis-plus/rtos/os.h>
+
+#include <ctime>
+
+// ----------------------------------------------------------------------------
+
+#if !defined(OS_INTEGER_POSIX_IO_TMPFS_BUCKETS)
+#define OS_INTEGER_POSIX_IO_TMPFS_BUCKETS (32)
+#endif
+
+#if !defined(OS_INTEGER_POSIX_IO_TMPFS_MIN_EXTENT_BYTES)
+#define OS_INTEGER_POSIX_IO_TMPFS_MIN_EXTENT_BYTES (64)
+#endif
+
+#if !defined(OS_INTEGER_POSIX_IO_TMPFS_MAX_EXTENT_BYTES)
+#define OS_INTEGER_POSIX_IO_TMPFS_MAX_EXTENT_BYTES (4096)
+#endif
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    class tmpfs;
+
+    // ------------------------------------------------------------------------
+
+    /**
+     * @brief File system in RAM.
+     * @headerfile tmpfs.h <cmsis-plus/posix-io/tmpfs.h>
+     * @ingroup cmsis-plus-posix-io-base
+     *
+     * @details
+     * The files and directories are kept in memory allocated from
+     * a memory resource, and are lost when the object is destroyed.
+     * No block device is needed; mount it with a null device.
+     *
+     * The file content is stored in a list of extents, each twice
+     * as large as the previous one, from
+     * `OS_INTEGER_POSIX_IO_TMPFS_MIN_EXTENT_BYTES` up to
+     * `OS_INTEGER_POSIX_IO_TMPFS_MAX_EXTENT_BYTES`; appending
+     * is done in constant time, at the end of the last extent.
+     * Each open file remembers the extent of the current offset,
+     * so sequential accesses do not walk the list.
+     *
+     * The names are found in a hash table keyed by the parent
+     * directory and the name, with
+     * `OS_INTEGER_POSIX_IO_TMPFS_BUCKETS` buckets by default.
+     *
+     * The pools must hold `tmpfs_file` and `tmpfs_directory` objects.
+     * The operations are performed in scheduler critical sections.
+     */
+    class tmpfs : public file_system
+    {
+      // ----------------------------------------------------------------------
+
+      /**
+       * @cond ignore
+       */
+
+      friend class tmpfs_file;
+      friend class tmpfs_directory;
+
+      /**
+       * @endcond
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+
+      tmpfs (pool* files_pool, pool* dirs_pool,
+             rtos::memory::memory_resource* mr = nullptr,
+             std::size_t buckets = OS_INTEGER_POSIX_IO_TMPFS_BUCKETS);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      tmpfs (const tmpfs&) = delete;
+      tmpfs (tmpfs&&) = delete;
+      tmpfs&
+      operator= (const tmpfs&) = delete;
+      tmpfs&
+      operator= (tmpfs&&) = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual
+      ~tmpfs ();
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+
+      /**
+       * @brief Get the memory resource.
+       * @par Parameters
+       *  None.
+       * @return Pointer to memory resource.
+       */
+      rtos::memory::memory_resource*
+      memory_resource (void) const;
+
+      /**
+       * @brief Get the number of bytes stored in files.
+       * @par Parameters
+       *  None.
+       * @return Number of bytes.
+       */
+      std::size_t
+      used_bytes (void) const;
+
+      /**
+       * @}
+       */
+
+    protected:
+
+      // ----------------------------------------------------------------------
+      // Implementations.
+
+      virtual int
+      do_chmod (const char* path, mode_t mode) override;
+
+      virtual int
+      do_stat (const char* path, struct stat* buf) override;
+
+      virtual int
+      do_truncate (const char* path, off_t length) override;
+
+      virtual int
+      do_rename (const char* existing, const char* _new) override;
+
+      virtual int
+      do_unlink (const char* path) override;
+
+      virtual int
+      do_utime (const char* path, const struct utimbuf* times) override;
+
+      virtual int
+      do_mkdir (const char* path, mode_t mode) override;
+
+      virtual int
+      do_rmdir (const char* path) override;
+
+      virtual void
+      do_sync (void) override;
+
+      virtual int
+      do_mount (unsigned int flags) override;
+
+      virtual int
+      do_unmount (unsigned int flags) override;
+
+    protected:
+
+      /**
+       * @cond ignore
+       */
+
+      // Part of the file content; the data follows the header.
+      struct extent_s
+      {
+        extent_s* next;
+        std::size_t capacity;
+        std::size_t used;
+      };
+
+      // File or directory.
+      struct node_s
+      {
+        node_s* hash_next;
+        node_s* parent;
+        // Directory children, in a doubly linked list.
+        node_s* first_child;
+        node_s* next_sibling;
+        node_s* prev_sibling;
+        extent_s* first_extent;
+        extent_s* last_extent;
+        char* name;
+        std::size_t name_length;
+        std::size_t hash;
+        off_t size;
+        // Incremented when extents are freed, to invalidate the
+        // extent hints in the open files.
+        std::size_t generation;
+        std::time_t mtime;
+        mode_t mode;
+        std::size_t opens;
+        // Direct mappings; the file cannot shrink while mapped.
+        std::size_t mappings;
+        bool unlinked;
+      };
+
+      static std::size_t
+      internal_hash_ (const node_s* parent, const char* name,
+                      std::size_t length);
+
+      node_s*
+      internal_find_ (const node_s* parent, const char* name,
+                      std::size_t length);
+
+      node_s*
+      internal_resolve_ (const char* path, node_s** parent,
+                         const char** name, std::size_t* length);
+
+      node_s*
+      internal_create_ (node_s* parent, const char* name, std::size_t length,
+                        mode_t mode);
+
+      void
+      internal_link_ (node_s* node, node_s* parent);
+
+      void
+      internal_unlink_ (node_s* node);
+
+      void
+      internal_destroy_ (node_s* node);
+
+      void
+      internal_destroy_all_ (node_s* node);
+
+      bool
+      internal_is_busy_ (const node_s* node) const;
+
+      void
+      internal_stat_ (const node_s* node, struct stat* buf) const;
+
+      ssize_t
+      internal_append_ (node_s* node, const void* buf, std::size_t nbyte);
+
+      int
+      internal_truncate_ (node_s* node, off_t length);
+
+      extent_s*
+      internal_locate_ (node_s* node, off_t offset, extent_s* hint,
+                        off_t hint_start, off_t* start);
+
+      static char*
+      internal_data_ (extent_s* extent);
+
+      static std::time_t
+      internal_now_ (void);
+
+      rtos::memory::memory_resource* mr_;
+
+      node_s** buckets_;
+      std::size_t buckets_count_;
+
+      node_s* root_;
+
+      std::size_t used_bytes_;
+
+      /**
+       * @endcond
+       */
+
+    };
+
+    // ------------------------------------------------------------------------
+
+    /**
+     * @brief File in RAM.
+     * @headerfile tmpfs.h <cmsis-plus/posix-io/tmpfs.h>
+     * @ingroup cmsis-plus-posix-io-base
+     */
+    class tmpfs_file : public file
+    {
+      // ----------------------------------------------------------------------
+
+      /**
+       * @cond ignore
+       */
+
+      friend class tmpfs;
+
+      /**
+       * @endcond
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+
+      tmpfs_file ();
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      tmpfs_file (const tmpfs_file&) = delete;
+      tmpfs_file (tmpfs_file&&) = delete;
+      tmpfs_file&
+      operator= (const tmpfs_file&) = delete;
+      tmpfs_file&
+      operator= (tmpfs_file&&) = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual
+      ~tmpfs_file ();
+
+      /**
+       * @}
+       */
+
+    protected:
+
+      // ----------------------------------------------------------------------
+      // Implementations.
+
+      virtual int
+      do_vopen (const char* path, int oflag, std::va_list args) override;
+
+      virtual int
+      do_close (void) override;
+
+      virtual ssize_t
+      do_read (void* buf, std::size_t nbyte) override;
+
+      virtual ssize_t
+      do_write (const void* buf, std::size_t nbyte) override;
+
+      virtual off_t
+      do_lseek (off_t offset, int whence) override;
+
+      virtual int
+      do_ftruncate (off_t length) override;
+
+      virtual int
+      do_fsync (void) override;
+
+      virtual int
+      do_fstat (struct stat* buf) override;
+
+      virtual ssize_t
+      do_splice_to (io* out, std::size_t count) override;
+
+      virtual void*
+      do_mmap (std::size_t length, int prot, int flags, off_t offset)
+          override;
+
+      virtual int
+      do_munmap (void* addr, std::size_t length) override;
+
+      virtual bool
+      do_is_opened (void) override;
+
+    protected:
+
+      /**
+       * @cond ignore
+       */
+
+      tmpfs*
+      fs (void) const;
+
+      tmpfs::node_s* node_;
+      off_t offset_;
+
+      // The extent of the last access, to avoid walking the list.
+      tmpfs::extent_s* hint_;
+      off_t hint_start_;
+      std::size_t hint_generation_;
+
+      /**
+       * @endcond
+       */
+
+    };
+
+    // ------------------------------------------------------------------------
+
+    /**
+     * @brief Directory in RAM.
+     * @headerfile tmpfs.h <cmsis-plus/posix-io/tmpfs.h>
+     * @ingroup cmsis-plus-posix-io-base
+     */
+    class tmpfs_directory : public directory
+    {
+      // ----------------------------------------------------------------------
+
+      /**
+       * @cond ignore
+       */
+
+      friend class tmpfs;
+
+      /**
+       * @endcond
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    public:
+
+      tmpfs_directory ();
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      tmpfs_directory (const tmpfs_directory&) = delete;
+      tmpfs_directory (tmpfs_directory&&) = delete;
+      tmpfs_directory&
+      operator= (const tmpfs_directory&) = delete;
+      tmpfs_directory&
+      operator= (tmpfs_directory&&) = delete;
+
+      /**
+       * @endcond
+       */
+
+      virtual
+      ~tmpfs_directory ();
+
+      /**
+       * @}
+       */
+
+    protected:
+
+      // ----------------------------------------------------------------------
+      // Implementations.
+
+      virtual directory*
+      do_vopen (const char* dirname) override;
+
+      virtual struct dirent*
+      do_read (void) override;
+
+      virtual void
+      do_rewind (void) override;
+
+      virtual int
+      do_close (void) override;
+
+    protected:
+
+      /**
+       * @cond ignore
+       */
+
+      tmpfs::node_s* node_;
+      tmpfs::node_s* next_;
+
+      /**
+       * @endcond
+       */
+
+    };
+
+  } /* namespace posix */
+} /* namespace os */
+
+// ===== Inline & template implementations ====================================
+
+namespace os
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    inline rtos::memory::memory_resource*
+    tmpfs::memory_resource (void) const
+    {
+      return mr_;
+    }
+
+    inline std::size_t
+    tmpfs::used_bytes (void) const
+    {
+      return used_bytes_;
+    }
+
+    inline char*
+    tmpfs::internal_data_ (extent_s* extent)
+    {
+      return reinterpret_cast<char*> (extent + 1);
+    }
+
+    // ------------------------------------------------------------------------
+
+    inline tmpfs*
+    tmpfs_file::fs (void) const
+    {
+      return static_cast<tmpfs*> (file_system ());
+    }
+
+  } /* namespace posix */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
+
+#endif /* __cplusplus */
+
+#endif /* CMSIS_PLUS_POSIX_IO_TMPFS_H_ */
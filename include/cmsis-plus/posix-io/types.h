@@ -167,6 +167,14 @@ extern "C"
   int __attribute__((weak))
   __posix_mkdir (const char* path, mode_t mode);
 
+  void*
+  __attribute__((weak))
+  __posix_mmap (void* addr, size_t len, int prot, int flags, int fildes,
+                off_t off);
+
+  int __attribute__((weak))
+  __posix_munmap (void* addr, size_t len);
+
   /**
    * @brief Open file relative to directory file descriptor.
    *
@@ -231,6 +239,9 @@ extern "C"
   ssize_t __attribute__((weak))
   __posix_send (int socket, const void* buffer, size_t length, int flags);
 
+  ssize_t __attribute__((weak))
+  __posix_sendfile (int out_fd, int in_fd, off_t* offset, size_t count);
+
   ssize_t __attribute__((weak))
   __posix_sendmsg (int socket, const struct msghdr* message, int flags);
 
@@ -43,6 +43,25 @@ extern "C"
 
   typedef unsigned int sa_family_t;
 
+// Address families.
+#define AF_UNSPEC       0
+#define AF_UNIX         1
+#define AF_LOCAL        AF_UNIX
+
+// Socket types.
+#define SOCK_STREAM     1
+#define SOCK_DGRAM      2
+
+// Message flags.
+#define MSG_PEEK        0x02
+#define MSG_TRUNC       0x20
+#define MSG_DONTWAIT    0x40
+
+// Shutdown options.
+#define SHUT_RD         0
+#define SHUT_WR         1
+#define SHUT_RDWR       2
+
   struct sockaddr
   {
     sa_family_t sa_family;  //Address family.
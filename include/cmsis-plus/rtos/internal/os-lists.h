@@ -111,6 +111,93 @@ namespace os
          */
       };
 
+      // ======================================================================
+
+      /**
+       * @brief Double linked list node, with thread reference and
+       *  the expected event flags.
+       *
+       * @details
+       * Used by event flags to resume only the threads whose
+       * condition is satisfied; the flags are checked (and cleared,
+       * if requested) by the raising code, on behalf of the
+       * waiting thread.
+       */
+      class waiting_flags_node : public waiting_thread_node
+      {
+      public:
+
+        /**
+         * @name Constructors & Destructor
+         * @{
+         */
+
+        /**
+         * @brief Construct a node with references to the thread.
+         * @param th Reference to the thread.
+         * @param mask The expected flags.
+         * @param mode Mode bits to select if either all or any flags
+         *  are expected, and if the flags should be cleared.
+         */
+        waiting_flags_node (thread& th, flags::mask_t mask,
+                            flags::mode_t mode);
+
+        /**
+         * @cond ignore
+         */
+
+        waiting_flags_node (const waiting_flags_node&) = delete;
+        waiting_flags_node (waiting_flags_node&&) = delete;
+        waiting_flags_node&
+        operator= (const waiting_flags_node&) = delete;
+        waiting_flags_node&
+        operator= (waiting_flags_node&&) = delete;
+
+        /**
+         * @endcond
+         */
+
+        /**
+         * @brief Destruct the node.
+         */
+        ~waiting_flags_node ();
+
+        /**
+         * @}
+         */
+
+      public:
+
+        /**
+         * @name Public Member Variables
+         * @{
+         */
+
+        /**
+         * @brief The expected flags.
+         */
+        flags::mask_t mask_;
+
+        /**
+         * @brief The wait mode.
+         */
+        flags::mode_t mode_;
+
+        /**
+         * @brief The flags that satisfied the condition.
+         */
+        flags::mask_t raised_ = 0;
+
+        /**
+         * @brief True if the condition was satisfied while waiting.
+         */
+        bool satisfied_ = false;
+
+        /**
+         * @}
+         */
+      };
+
 #pragma GCC diagnostic pop
 
       // ======================================================================
@@ -872,6 +959,26 @@ namespace os
 
       // ======================================================================
 
+      inline
+      waiting_flags_node::waiting_flags_node (rtos::thread& th,
+                                              flags::mask_t mask,
+                                              flags::mode_t mode) :
+          waiting_thread_node
+            { th }, //
+          mask_ (mask), //
+          mode_ (mode)
+      {
+        ;
+      }
+
+      inline
+      waiting_flags_node::~waiting_flags_node ()
+      {
+        ;
+      }
+
+      // ======================================================================
+
       /**
        * @details
        * The initial list status is empty.
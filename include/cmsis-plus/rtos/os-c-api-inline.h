@@ -0,0 +1,214 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CMSIS_PLUS_RTOS_OS_C_API_INLINE_H_
+#define CMSIS_PLUS_RTOS_OS_C_API_INLINE_H_
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Header only variants of the most frequently used C API functions.
+ *
+ * It is included by `<cmsis-plus/rtos/os-c-api.h>` when
+ * `OS_USE_RTOS_C_API_INLINE` is defined before including it,
+ * and should not be included directly.
+ *
+ * The argument checks are done inline, and the calls go to the
+ * `os_internal_*()` functions defined in `os-c-wrapper.cpp`,
+ * which only forward to the C++ member functions; since the
+ * object pointer is already the first argument, as the implicit
+ * `this`, they compile to a single jump. With LTO, they are
+ * inlined in the C code, together with the C++ bodies.
+ */
+
+#if !defined(CMSIS_PLUS_RTOS_OS_C_API_H_)
+#error "Include <cmsis-plus/rtos/os-c-api.h> instead."
+#endif
+
+#include <assert.h>
+
+// ----------------------------------------------------------------------------
+
+#ifdef  __cplusplus
+extern "C"
+{
+#endif
+
+  // --------------------------------------------------------------------------
+
+  /**
+   * @addtogroup cmsis-plus-rtos-c-thread
+   * @{
+   */
+
+  /**
+   * @brief Get the current running thread.
+   * @par Parameters
+   *  None.
+   * @return Pointer to the current running thread object instance.
+   */
+  static inline os_thread_t*
+  __attribute__((always_inline))
+  os_this_thread (void)
+  {
+    return os_internal_this_thread ();
+  }
+
+  /**
+   * @}
+   */
+
+  // --------------------------------------------------------------------------
+
+  /**
+   * @addtogroup cmsis-plus-rtos-c-mutex
+   * @{
+   */
+
+  /**
+   * @brief Lock/acquire the mutex.
+   * @param [in] mutex Pointer to mutex object instance.
+   * @return Result code, as for the out of line function.
+   */
+  static inline os_result_t
+  __attribute__((always_inline))
+  os_mutex_lock (os_mutex_t* mutex)
+  {
+    assert(mutex != NULL);
+    return os_internal_mutex_lock (mutex);
+  }
+
+  /**
+   * @brief Try to lock/acquire the mutex.
+   * @param [in] mutex Pointer to mutex object instance.
+   * @return Result code, as for the out of line function.
+   */
+  static inline os_result_t
+  __attribute__((always_inline))
+  os_mutex_try_lock (os_mutex_t* mutex)
+  {
+    assert(mutex != NULL);
+    return os_internal_mutex_try_lock (mutex);
+  }
+
+  /**
+   * @brief Unlock/release the mutex.
+   * @param [in] mutex Pointer to mutex object instance.
+   * @return Result code, as for the out of line function.
+   */
+  static inline os_result_t
+  __attribute__((always_inline))
+  os_mutex_unlock (os_mutex_t* mutex)
+  {
+    assert(mutex != NULL);
+    return os_internal_mutex_unlock (mutex);
+  }
+
+  /**
+   * @}
+   */
+
+  // --------------------------------------------------------------------------
+
+  /**
+   * @addtogroup cmsis-plus-rtos-c-semaphore
+   * @{
+   */
+
+  /**
+   * @brief Post (unlock) the semaphore.
+   * @param [in] semaphore Pointer to semaphore object instance.
+   * @return Result code, as for the out of line function.
+   */
+  static inline os_result_t
+  __attribute__((always_inline))
+  os_semaphore_post (os_semaphore_t* semaphore)
+  {
+    assert(semaphore != NULL);
+    return os_internal_semaphore_post (semaphore);
+  }
+
+  /**
+   * @brief Lock the semaphore, possibly waiting.
+   * @param [in] semaphore Pointer to semaphore object instance.
+   * @return Result code, as for the out of line function.
+   */
+  static inline os_result_t
+  __attribute__((always_inline))
+  os_semaphore_wait (os_semaphore_t* semaphore)
+  {
+    assert(semaphore != NULL);
+    return os_internal_semaphore_wait (semaphore);
+  }
+
+  /**
+   * @brief Try to lock the semaphore.
+   * @param [in] semaphore Pointer to semaphore object instance.
+   * @return Result code, as for the out of line function.
+   */
+  static inline os_result_t
+  __attribute__((always_inline))
+  os_semaphore_try_wait (os_semaphore_t* semaphore)
+  {
+    assert(semaphore != NULL);
+    return os_internal_semaphore_try_wait (semaphore);
+  }
+
+  /**
+   * @brief Get the semaphore count value.
+   * @param [in] semaphore Pointer to semaphore object instance.
+   * @return The semaphore count value.
+   *
+   * @details
+   * The count is read directly from the object, without any call.
+   */
+  static inline os_semaphore_count_t
+  __attribute__((always_inline))
+  os_semaphore_get_value (os_semaphore_t* semaphore)
+  {
+    assert(semaphore != NULL);
+    os_semaphore_count_t count =
+        *(volatile os_semaphore_count_t*) &semaphore->count;
+#if !defined(OS_USE_RTOS_PORT_SEMAPHORE)
+    return (count > 0) ? count : 0;
+#else
+    return count;
+#endif
+  }
+
+/**
+ * @}
+ */
+
+// --------------------------------------------------------------------------
+#ifdef  __cplusplus
+}
+#endif
+
+// ----------------------------------------------------------------------------
+
+#endif /* CMSIS_PLUS_RTOS_OS_C_API_INLINE_H_ */
@@ -231,6 +231,58 @@ extern "C"
   os_statistics_duration_t
   os_sched_stat_get_cpu_cycles (void);
 
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD)
+
+  /**
+   * @brief Close the current load window and start a new one.
+   * @par Parameters
+   *  None.
+   * @par Returns
+   *  Nothing.
+   */
+  void
+  os_sched_stat_update_load (void);
+
+  /**
+   * @brief Get the CPU load.
+   * @param [in] windows The number of most recent windows to average.
+   * @return The time spent in threads other than idle, in per-mille.
+   */
+  os_statistics_load_t
+  os_sched_stat_get_cpu_load (size_t windows);
+
+  /**
+   * @brief Get the idle load.
+   * @param [in] windows The number of most recent windows to average.
+   * @return The time spent in the idle thread, in per-mille.
+   */
+  os_statistics_load_t
+  os_sched_stat_get_idle_load (size_t windows);
+
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+
+  /**
+   * @brief Get the context switch rate.
+   * @param [in] windows The number of most recent windows to average.
+   * @return The number of context switches per second.
+   */
+  uint32_t
+  os_sched_stat_get_context_switches_rate (size_t windows);
+
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+
+  /**
+   * @brief Send a `top` like load report to the trace channel.
+   * @par Parameters
+   *  None.
+   * @par Returns
+   *  Nothing.
+   */
+  void
+  os_sched_stat_top (void);
+
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD) */
+
 #endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES) */
 
   /**
@@ -329,8 +381,10 @@ extern "C"
    *  None.
    * @return Pointer to the current running thread object instance.
    */
+#if !defined(OS_USE_RTOS_C_API_INLINE)
   os_thread_t*
   os_this_thread (void);
+#endif
 
   /**
    * @brief Suspend the current running thread to wait for an event.
@@ -713,6 +767,28 @@ extern "C"
   bool
   os_thread_stack_check_top_magic (os_thread_stack_t* stack);
 
+#if defined(OS_USE_RTOS_THREAD_STACK_WATERMARK)
+
+  /**
+   * @brief Get the deepest stack usage found by the idle tracker.
+   * @param [in] stack Pointer to stack object instance.
+   * @return Number of used bytes.
+   */
+  size_t
+  os_thread_stack_get_high_water_mark (os_thread_stack_t* stack);
+
+  /**
+   * @brief Set the overflow proximity callback.
+   * @param [in] callback Pointer to function, or `NULL`.
+   * @param [in] threshold_bytes Call it when less bytes are available.
+   * @return The previous callback.
+   */
+  os_thread_stack_proximity_callback_t
+  os_thread_stack_set_proximity_callback (
+      os_thread_stack_proximity_callback_t callback, size_t threshold_bytes);
+
+#endif /* defined(OS_USE_RTOS_THREAD_STACK_WATERMARK) */
+
   /**
    * @}
    */
@@ -745,6 +821,32 @@ extern "C"
   os_statistics_duration_t
   os_thread_stat_get_cpu_cycles (os_thread_t* thread);
 
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD)
+
+  /**
+   * @brief Get the thread CPU load.
+   * @param [in] thread Pointer to thread object instance.
+   * @return The time used by the thread in the last load window,
+   *  in per-mille.
+   */
+  os_statistics_load_t
+  os_thread_stat_get_cpu_load (os_thread_t* thread);
+
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+
+  /**
+   * @brief Get the thread context switch rate.
+   * @param [in] thread Pointer to thread object instance.
+   * @return The number of times the thread was scheduled per second,
+   *  in the last load window.
+   */
+  uint32_t
+  os_thread_stat_get_context_switches_rate (os_thread_t* thread);
+
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD) */
+
 #endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES) */
 
   /**
@@ -1286,8 +1388,10 @@ extern "C"
    * @retval EDEADLK The mutex type is `os_mutex_type_errorcheck` and
    *  the current thread already owns the mutex.
    */
+#if !defined(OS_USE_RTOS_C_API_INLINE)
   os_result_t
   os_mutex_lock (os_mutex_t* mutex);
+#endif
 
   /**
    * @brief Try to lock/acquire the mutex.
@@ -1311,8 +1415,10 @@ extern "C"
    * @retval EWOULDBLOCK The mutex could not be acquired because it was
    *  already locked.
    */
+#if !defined(OS_USE_RTOS_C_API_INLINE)
   os_result_t
   os_mutex_try_lock (os_mutex_t* mutex);
+#endif
 
   /**
    * @brief Timed attempt to lock/acquire the mutex.
@@ -1349,8 +1455,10 @@ extern "C"
    *  and the current thread does not own the mutex.
    * @retval ENOTRECOVERABLE The mutex was not unlocked.
    */
+#if !defined(OS_USE_RTOS_C_API_INLINE)
   os_result_t
   os_mutex_unlock (os_mutex_t* mutex);
+#endif
 
   /**
    * @brief Get the priority ceiling of a mutex.
@@ -1809,8 +1917,10 @@ extern "C"
    * @retval ENOTRECOVERABLE The semaphore could not be posted
    *  (extension to POSIX).
    */
+#if !defined(OS_USE_RTOS_C_API_INLINE)
   os_result_t
   os_semaphore_post (os_semaphore_t* semaphore);
+#endif
 
   /**
    * @brief Lock the semaphore, possibly waiting.
@@ -1822,8 +1932,10 @@ extern "C"
    * @retval EDEADLK A deadlock condition was detected.
    * @retval EINTR The operation was interrupted.
    */
+#if !defined(OS_USE_RTOS_C_API_INLINE)
   os_result_t
   os_semaphore_wait (os_semaphore_t* semaphore);
+#endif
 
   /**
    * @brief Try to lock the semaphore.
@@ -1836,8 +1948,10 @@ extern "C"
    * @retval EDEADLK A deadlock condition was detected.
    * @retval EINTR The operation was interrupted.
    */
+#if !defined(OS_USE_RTOS_C_API_INLINE)
   os_result_t
   os_semaphore_try_wait (os_semaphore_t* semaphore);
+#endif
 
   /**
    * @brief Timed wait to lock the semaphore.
@@ -1863,8 +1977,10 @@ extern "C"
    * @param [in] semaphore Pointer to semaphore object instance.
    * @return The semaphore count value.
    */
+#if !defined(OS_USE_RTOS_C_API_INLINE)
   os_semaphore_count_t
   os_semaphore_get_value (os_semaphore_t* semaphore);
+#endif
 
   /**
    * @brief Reset the semaphore.
@@ -2406,6 +2522,247 @@ extern "C"
 #define os_mqueue_create os_mqueue_construct
 #define os_mqueue_destroy os_mqueue_destruct
 
+  /**
+   * @}
+   */
+
+  /**
+   * @}
+   */
+
+  // --------------------------------------------------------------------------
+  /**
+   * @addtogroup cmsis-plus-rtos-c-mbuffer
+   * @{
+   */
+
+  /**
+   * @name Message Buffer Attributes Functions
+   * @{
+   */
+
+  /**
+   * @brief Initialise the message buffer attributes.
+   * @param [in] attr Pointer to message buffer attributes object instance.
+   * @par Returns
+   *  Nothing.
+   */
+  void
+  os_mbuffer_attr_init (os_mbuffer_attr_t* attr);
+
+  /**
+   * @}
+   */
+
+  /**
+   * @name Message Buffer Creation Functions
+   * @{
+   */
+
+  /**
+   * @brief Construct a statically allocated message buffer object instance.
+   * @param [in] mbuffer Pointer to message buffer object instance storage.
+   * @param [in] name Pointer to name (may be NULL).
+   * @param [in] size_bytes The buffer size, in bytes.
+   * @param [in] attr Pointer to attributes (may be NULL).
+   * @par Returns
+   *  Nothing.
+   */
+  void
+  os_mbuffer_construct (os_mbuffer_t* mbuffer, const char* name,
+                        size_t size_bytes, const os_mbuffer_attr_t* attr);
+
+  /**
+   * @brief Destruct the statically allocated message buffer object instance.
+   * @param [in] mbuffer Pointer to message buffer object instance.
+   * @par Returns
+   *  Nothing.
+   */
+  void
+  os_mbuffer_destruct (os_mbuffer_t* mbuffer);
+
+  /**
+   * @brief Allocate a message buffer object instance and construct it.
+   * @param [in] name Pointer to name (may be NULL).
+   * @param [in] size_bytes The buffer size, in bytes.
+   * @param [in] attr Pointer to attributes (may be NULL).
+   * @return Pointer to new message buffer object instance.
+   */
+  os_mbuffer_t*
+  os_mbuffer_new (const char* name, size_t size_bytes,
+                  const os_mbuffer_attr_t* attr);
+
+  /**
+   * @brief Destruct the message buffer object instance and deallocate it.
+   * @param [in] mbuffer Pointer to dynamically allocated message buffer
+   *  object instance.
+   * @par Returns
+   *  Nothing.
+   */
+  void
+  os_mbuffer_delete (os_mbuffer_t* mbuffer);
+
+  /**
+   * @}
+   */
+
+  /**
+   * @name Message Buffer Functions
+   * @{
+   */
+
+  /**
+   * @brief Get the message buffer name.
+   * @param [in] mbuffer Pointer to message buffer object instance.
+   * @return Null terminated string.
+   */
+  const char*
+  os_mbuffer_get_name (os_mbuffer_t* mbuffer);
+
+  /**
+   * @brief Send a message to the buffer.
+   * @param [in] mbuffer Pointer to message buffer object instance.
+   * @param [in] msg The address of the message to enqueue.
+   * @param [in] nbytes The length of the message.
+   * @retval os_ok The message was enqueued.
+   * @retval EINVAL A parameter is invalid or outside of a permitted range.
+   * @retval EMSGSIZE The message can never fit in the buffer.
+   * @retval EPERM Cannot be invoked from an Interrupt Service Routines.
+   * @retval EINTR The operation was interrupted.
+   */
+  os_result_t
+  os_mbuffer_send (os_mbuffer_t* mbuffer, const void* msg, size_t nbytes);
+
+  /**
+   * @brief Try to send a message to the buffer.
+   * @param [in] mbuffer Pointer to message buffer object instance.
+   * @param [in] msg The address of the message to enqueue.
+   * @param [in] nbytes The length of the message.
+   * @retval os_ok The message was enqueued.
+   * @retval EWOULDBLOCK There is not enough free space in the buffer.
+   * @retval EINVAL A parameter is invalid or outside of a permitted range.
+   * @retval EMSGSIZE The message can never fit in the buffer.
+   */
+  os_result_t
+  os_mbuffer_try_send (os_mbuffer_t* mbuffer, const void* msg, size_t nbytes);
+
+  /**
+   * @brief Send a message to the buffer with timeout.
+   * @param [in] mbuffer Pointer to message buffer object instance.
+   * @param [in] msg The address of the message to enqueue.
+   * @param [in] nbytes The length of the message.
+   * @param [in] timeout The timeout duration.
+   * @retval os_ok The message was enqueued.
+   * @retval EINVAL A parameter is invalid or outside of a permitted range.
+   * @retval EMSGSIZE The message can never fit in the buffer.
+   * @retval EPERM Cannot be invoked from an Interrupt Service Routines.
+   * @retval ETIMEDOUT The timeout expired before the message
+   *  could be added to the buffer.
+   * @retval EINTR The operation was interrupted.
+   */
+  os_result_t
+  os_mbuffer_timed_send (os_mbuffer_t* mbuffer, const void* msg,
+                         size_t nbytes, os_clock_duration_t timeout);
+
+  /**
+   * @brief Receive a message from the buffer.
+   * @param [in] mbuffer Pointer to message buffer object instance.
+   * @param [out] msg The address where to store the dequeued message.
+   * @param [in] nbytes The size of the destination buffer.
+   * @param [out] rbytes The address where to store the message
+   *  length (may be NULL).
+   * @retval os_ok The message was received.
+   * @retval EINVAL A parameter is invalid or outside of a permitted range.
+   * @retval EMSGSIZE The next message is larger than _nbytes_;
+   *  it is left in the buffer.
+   * @retval EPERM Cannot be invoked from an Interrupt Service Routines.
+   * @retval EINTR The operation was interrupted.
+   */
+  os_result_t
+  os_mbuffer_receive (os_mbuffer_t* mbuffer, void* msg, size_t nbytes,
+                      size_t* rbytes);
+
+  /**
+   * @brief Try to receive a message from the buffer.
+   * @param [in] mbuffer Pointer to message buffer object instance.
+   * @param [out] msg The address where to store the dequeued message.
+   * @param [in] nbytes The size of the destination buffer.
+   * @param [out] rbytes The address where to store the message
+   *  length (may be NULL).
+   * @retval os_ok The message was received.
+   * @retval EINVAL A parameter is invalid or outside of a permitted range.
+   * @retval EMSGSIZE The next message is larger than _nbytes_;
+   *  it is left in the buffer.
+   * @retval EWOULDBLOCK The message buffer is empty.
+   */
+  os_result_t
+  os_mbuffer_try_receive (os_mbuffer_t* mbuffer, void* msg, size_t nbytes,
+                          size_t* rbytes);
+
+  /**
+   * @brief Receive a message from the buffer with timeout.
+   * @param [in] mbuffer Pointer to message buffer object instance.
+   * @param [out] msg The address where to store the dequeued message.
+   * @param [in] nbytes The size of the destination buffer.
+   * @param [in] timeout The timeout duration.
+   * @param [out] rbytes The address where to store the message
+   *  length (may be NULL).
+   * @retval os_ok The message was received.
+   * @retval EINVAL A parameter is invalid or outside of a permitted range.
+   * @retval EMSGSIZE The next message is larger than _nbytes_;
+   *  it is left in the buffer.
+   * @retval EPERM Cannot be invoked from an Interrupt Service Routines.
+   * @retval EINTR The operation was interrupted.
+   * @retval ETIMEDOUT No message arrived before the
+   *  specified timeout expired.
+   */
+  os_result_t
+  os_mbuffer_timed_receive (os_mbuffer_t* mbuffer, void* msg, size_t nbytes,
+                            os_clock_duration_t timeout, size_t* rbytes);
+
+  /**
+   * @brief Get buffer capacity.
+   * @param [in] mbuffer Pointer to message buffer object instance.
+   * @return The size of the buffer, in bytes.
+   */
+  size_t
+  os_mbuffer_get_capacity (os_mbuffer_t* mbuffer);
+
+  /**
+   * @brief Get buffer length.
+   * @param [in] mbuffer Pointer to message buffer object instance.
+   * @return The number of messages in the buffer.
+   */
+  size_t
+  os_mbuffer_get_length (os_mbuffer_t* mbuffer);
+
+  /**
+   * @brief Get the free space.
+   * @param [in] mbuffer Pointer to message buffer object instance.
+   * @return The largest message that can be sent without blocking,
+   *  in bytes.
+   */
+  size_t
+  os_mbuffer_get_available (os_mbuffer_t* mbuffer);
+
+  /**
+   * @brief Check if the buffer is empty.
+   * @param [in] mbuffer Pointer to message buffer object instance.
+   * @retval true The buffer has no messages.
+   * @retval false The buffer has some messages.
+   */
+  bool
+  os_mbuffer_is_empty (os_mbuffer_t* mbuffer);
+
+  /**
+   * @brief Reset the message buffer.
+   * @param [in] mbuffer Pointer to message buffer object instance.
+   * @retval os_ok The buffer was reset.
+   * @retval EPERM Cannot be invoked from an Interrupt Service Routines.
+   */
+  os_result_t
+  os_mbuffer_reset (os_mbuffer_t* mbuffer);
+
   /**
    * @}
    */
@@ -2736,6 +3093,37 @@ extern "C"
  * @}
  */
 
+  /**
+   * @cond ignore
+   */
+
+  // Used by the header only variants, without argument checks.
+
+  os_thread_t*
+  os_internal_this_thread (void);
+
+  os_result_t
+  os_internal_mutex_lock (os_mutex_t* mutex);
+
+  os_result_t
+  os_internal_mutex_try_lock (os_mutex_t* mutex);
+
+  os_result_t
+  os_internal_mutex_unlock (os_mutex_t* mutex);
+
+  os_result_t
+  os_internal_semaphore_post (os_semaphore_t* semaphore);
+
+  os_result_t
+  os_internal_semaphore_wait (os_semaphore_t* semaphore);
+
+  os_result_t
+  os_internal_semaphore_try_wait (os_semaphore_t* semaphore);
+
+  /**
+   * @endcond
+   */
+
 // --------------------------------------------------------------------------
 #ifdef  __cplusplus
 }
@@ -2743,4 +3131,11 @@ extern "C"
 
 // ----------------------------------------------------------------------------
 
+#if defined(OS_USE_RTOS_C_API_INLINE)
+// Header only variants of the most frequently used functions.
+#include <cmsis-plus/rtos/os-c-api-inline.h>
+#endif
+
+// ----------------------------------------------------------------------------
+
 #endif /* CMSIS_PLUS_RTOS_OS_C_API_H_ */
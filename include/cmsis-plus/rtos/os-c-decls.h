@@ -251,6 +251,13 @@ extern "C"
    */
   typedef uint64_t os_statistics_duration_t;
 
+  /**
+   * @brief Type of variables holding loads, in per-mille.
+   *
+   * @see os::rtos::statistics::load_t
+   */
+  typedef uint16_t os_statistics_load_t;
+
   /**
    * @}
    */
@@ -415,6 +422,10 @@ extern "C"
 
     void* stack_addr;
     size_t stack_size_bytes;
+#if defined(OS_USE_RTOS_THREAD_STACK_WATERMARK)
+    void* stack_low;
+    void* stack_scan;
+#endif /* defined(OS_USE_RTOS_THREAD_STACK_WATERMARK) */
 
     /**
      * @endcond
@@ -476,6 +487,16 @@ extern "C"
     os_statistics_duration_t cpu_cycles;
 #endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES) */
 
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES) \
+  && defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD)
+    os_statistics_duration_t load_cpu_cycles;
+    os_statistics_duration_t window_cpu_cycles;
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+    os_statistics_counter_t load_context_switches;
+    os_statistics_counter_t window_context_switches;
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+#endif
+
     /**
      * @endcond
      */
@@ -588,6 +609,9 @@ extern "C"
     os_thread_prio_t prio_assigned;
     os_thread_prio_t prio_inherited;
     bool interrupted;
+#if defined(OS_USE_RTOS_THREAD_STACK_CACHE)
+    bool stack_recycled;
+#endif /* defined(OS_USE_RTOS_THREAD_STACK_CACHE) */
     os_internal_evflags_t event_flags;
 #if defined(OS_INCLUDE_RTOS_CUSTOM_THREAD_USER_STORAGE)
     os_thread_user_storage_t user_storage; //
@@ -609,6 +633,19 @@ extern "C"
 
   } os_thread_t;
 
+#if defined(OS_USE_RTOS_THREAD_STACK_WATERMARK)
+
+  /**
+   * @brief Type of overflow proximity callback.
+   *
+   * @see os::rtos::thread::stack::proximity_callback_t
+   */
+  typedef void
+  (*os_thread_stack_proximity_callback_t) (os_thread_t* thread,
+                                           size_t available_bytes);
+
+#endif /* defined(OS_USE_RTOS_THREAD_STACK_WATERMARK) */
+
 #pragma GCC diagnostic pop
 
   /**
@@ -1355,6 +1392,102 @@ extern "C"
 
   } os_mqueue_t;
 
+#pragma GCC diagnostic pop
+
+  /**
+   * @}
+   */
+
+  // ==========================================================================
+  /**
+   * @addtogroup cmsis-plus-rtos-c-mbuffer
+   * @{
+   */
+
+  /**
+   * @brief Type of variables holding message buffer message sizes.
+   *
+   * @see os::rtos::message_buffer::msg_size_t
+   */
+  typedef uint16_t os_mbuffer_msg_size_t;
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+  /**
+   * @brief Message buffer attributes.
+   * @headerfile os-c-api.h <cmsis-plus/rtos/os-c-api.h>
+   *
+   * @details
+   * Initialise this structure with `os_mbuffer_attr_init()` and then
+   * set any of the individual members directly.
+   *
+   * @see os::rtos::message_buffer::attributes
+   */
+  typedef struct os_mbuffer_attr_s
+  {
+    /**
+     * @brief Pointer to clock object instance.
+     */
+    void* clock;
+
+    /**
+     * @brief Pointer to user provided message buffer area.
+     */
+    void* mb_buffer_addr;
+
+    /**
+     * @brief Size of user provided message buffer area, in bytes.
+     */
+    size_t mb_buffer_size_bytes;
+
+  } os_mbuffer_attr_t;
+
+  /**
+   * @brief Message buffer object storage.
+   * @headerfile os-c-api.h <cmsis-plus/rtos/os-c-api.h>
+   *
+   * @details
+   * This C structure has the same size as the C++ `os::rtos::message_buffer`
+   * object and must be initialised with `os_mbuffer_construct()`.
+   *
+   * Later on a pointer to it can be used both in C and C++
+   * to refer to the message buffer object instance.
+   *
+   * The members of this structure are hidden and should not
+   * be used directly, but only through specific functions.
+   *
+   * @see os::rtos::message_buffer
+   */
+  typedef struct os_mbuffer_s
+  {
+    /**
+     * @cond ignore
+     */
+
+    void* vtbl;
+    const char* name;
+    os_internal_threads_waiting_list_t send_list;
+    os_internal_threads_waiting_list_t receive_list;
+    void* clock;
+
+    char* buffer_addr;
+    void* allocated_buffer_addr;
+    void* allocator;
+
+    size_t buffer_size_bytes;
+    size_t allocated_buffer_size_elements;
+
+    size_t head;
+    size_t used_bytes;
+    size_t count;
+
+    /**
+     * @endcond
+     */
+
+  } os_mbuffer_t;
+
 #pragma GCC diagnostic pop
 
   /**
@@ -413,9 +413,20 @@ namespace os
       virtual offset_t
       offset (offset_t value) override;
 
+      /**
+       * @cond ignore
+       */
+
+      internal::clock_timestamps_list&
+      adjusted_list (void);
+
       void
       internal_check_timestamps (void);
 
+      /**
+       * @endcond
+       */
+
       /**
        * @}
        */
@@ -528,6 +539,29 @@ namespace os
         static constexpr clock::duration_t
         ticks_cast (Rep_T microsec);
 
+      /**
+       * @cond ignore
+       */
+
+#if defined(OS_USE_RTOS_TICKLESS_IDLE)
+
+      /**
+       * @brief Sleep with the periodic tick suppressed, until the
+       *  next clock deadline.
+       * @par Parameters
+       *  None.
+       * @retval true The device slept in tickless mode.
+       * @retval false The next deadline is too close, nothing done.
+       */
+      bool
+      internal_sleep_tickless (void);
+
+#endif /* defined(OS_USE_RTOS_TICKLESS_IDLE) */
+
+      /**
+       * @endcond
+       */
+
       /**
        * @}
        */
@@ -851,6 +885,13 @@ namespace os
       ;
     }
 
+    inline internal::clock_timestamps_list&
+    __attribute__((always_inline))
+    adjustable_clock::adjusted_list (void)
+    {
+      return adjusted_list_;
+    }
+
     inline void
     __attribute__((always_inline))
     adjustable_clock::internal_check_timestamps (void)
@@ -229,6 +229,11 @@ namespace os
        */
       using duration_t = uint64_t;
 
+      /**
+       * @brief Type of variables holding loads, in per-mille.
+       */
+      using load_t = uint16_t;
+
     } /* namespace statistics */
 
     // ------------------------------------------------------------------------
@@ -1026,6 +1031,29 @@ namespace os
         static void
         internal_interrupt_service_routine (void);
 
+#if defined(OS_USE_RTOS_TICKLESS_IDLE)
+
+        /**
+         * @brief Sleep with the periodic tick suppressed.
+         * @param [in] max_ticks Maximum number of ticks to suppress.
+         * @return The number of suppressed ticks.
+         * @details
+         * It is called from the idle thread, with interrupts disabled.
+         * The implementation must stop the periodic tick, arm
+         * a one-shot wake-up after at most `max_ticks` suppressed
+         * ticks (clamped to the hardware limits), enter sleep,
+         * and on wake-up (either by the one-shot timer or by another
+         * interrupt) restore the periodic tick, phase aligned.
+         *
+         * The tick that ends the sleep is delivered as usual via
+         * `os_systick_handler()`, after interrupts are re-enabled,
+         * and must not be included in the returned value.
+         */
+        static clock::duration_t
+        sleep_tickless (clock::duration_t max_ticks);
+
+#endif /* defined(OS_USE_RTOS_TICKLESS_IDLE) */
+
       };
 
       // ======================================================================
@@ -1160,6 +1188,100 @@ extern "C"
 #define OS_BOOL_RTOS_SCHEDULER_PREEMPTIVE                   (true)
 #endif
 
+#if !defined(OS_INTEGER_RTOS_TICKLESS_IDLE_MIN_TICKS)
+#define OS_INTEGER_RTOS_TICKLESS_IDLE_MIN_TICKS             (2)
+#endif
+
+#if !defined(OS_INTEGER_RTOS_THREAD_STACK_CACHE_CLASSES)
+#define OS_INTEGER_RTOS_THREAD_STACK_CACHE_CLASSES          (4)
+#endif
+
+#if !defined(OS_INTEGER_RTOS_THREAD_STACK_CACHE_MIN_SIZE_BYTES)
+#define OS_INTEGER_RTOS_THREAD_STACK_CACHE_MIN_SIZE_BYTES   (1024)
+#endif
+
+#if !defined(OS_INTEGER_RTOS_THREAD_STACK_CACHE_DEPTH)
+#define OS_INTEGER_RTOS_THREAD_STACK_CACHE_DEPTH            (2)
+#endif
+
+#if !defined(OS_INTEGER_RTOS_THREAD_STACK_GUARD_SIZE_BYTES)
+#define OS_INTEGER_RTOS_THREAD_STACK_GUARD_SIZE_BYTES       (256)
+#endif
+
+#if !defined(OS_INTEGER_RTOS_THREAD_STACK_WATERMARK_STEP_WORDS)
+#define OS_INTEGER_RTOS_THREAD_STACK_WATERMARK_STEP_WORDS   (32)
+#endif
+
+// The lock-free memory pool needs a native compare-and-swap; on
+// cores without it (like ARMv6-M) the atomic builtins are not lock
+// free, and the critical section implementation is used.
+#if defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE) \
+    && (defined(__ARM_ARCH_6M__) || (__GCC_ATOMIC_INT_LOCK_FREE < 2))
+#undef OS_USE_RTOS_MEMORY_POOL_LOCK_FREE
+#endif
+
+#if !defined(OS_INTEGER_RTOS_PROFILER_BUCKETS)
+#define OS_INTEGER_RTOS_PROFILER_BUCKETS                    (128)
+#endif
+
+#if !defined(OS_INTEGER_RTOS_PROFILER_TICKS_PER_SAMPLE)
+#define OS_INTEGER_RTOS_PROFILER_TICKS_PER_SAMPLE           (1)
+#endif
+
+#if !defined(OS_INTEGER_RTOS_STATISTICS_LOAD_WINDOWS)
+#define OS_INTEGER_RTOS_STATISTICS_LOAD_WINDOWS             (8)
+#endif
+
+#if !defined(OS_INTEGER_RTOS_STATISTICS_TOP_THREADS)
+#define OS_INTEGER_RTOS_STATISTICS_TOP_THREADS              (16)
+#endif
+
+// ----------------------------------------------------------------------------
+
+#if !defined(OS_INTEGER_STARTUP_DEFERRED_BSS_CHUNK_BYTES)
+#define OS_INTEGER_STARTUP_DEFERRED_BSS_CHUNK_BYTES         (1024)
+#endif
+
+// ----------------------------------------------------------------------------
+
+#if !defined(OS_INTEGER_MEMORY_SLAB_CLASSES)
+#define OS_INTEGER_MEMORY_SLAB_CLASSES                      (4)
+#endif
+
+#if !defined(OS_INTEGER_MEMORY_SLAB_MIN_BLOCK_SIZE_BYTES)
+#define OS_INTEGER_MEMORY_SLAB_MIN_BLOCK_SIZE_BYTES         (16)
+#endif
+
+#if !defined(OS_INTEGER_MEMORY_ALLOC_PROFILER_LIVE)
+#define OS_INTEGER_MEMORY_ALLOC_PROFILER_LIVE               (256)
+#endif
+
+#if !defined(OS_INTEGER_MEMORY_ALLOC_PROFILER_SITES)
+#define OS_INTEGER_MEMORY_ALLOC_PROFILER_SITES              (64)
+#endif
+
+#if !defined(OS_INTEGER_MEMORY_ALLOC_PROFILER_TOP)
+#define OS_INTEGER_MEMORY_ALLOC_PROFILER_TOP                (10)
+#endif
+
+// ----------------------------------------------------------------------------
+
+#if !defined(OS_INTEGER_ESTD_FUTURE_POOL_BLOCKS)
+#define OS_INTEGER_ESTD_FUTURE_POOL_BLOCKS                  (8)
+#endif
+
+#if !defined(OS_INTEGER_ESTD_FUTURE_POOL_BLOCK_SIZE_BYTES)
+#define OS_INTEGER_ESTD_FUTURE_POOL_BLOCK_SIZE_BYTES        (128)
+#endif
+
+#if !defined(OS_INTEGER_ESTD_ASYNC_POOL_WORKERS)
+#define OS_INTEGER_ESTD_ASYNC_POOL_WORKERS                  (2)
+#endif
+
+#if !defined(OS_INTEGER_ESTD_ASYNC_POOL_STACK_SIZE_BYTES)
+#define OS_INTEGER_ESTD_ASYNC_POOL_STACK_SIZE_BYTES         (os::rtos::port::stack::default_size_bytes)
+#endif
+
 // ----------------------------------------------------------------------------
 
 #endif /* CMSIS_PLUS_RTOS_OS_DECLS_H_ */
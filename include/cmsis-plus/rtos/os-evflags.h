@@ -291,6 +291,32 @@ namespace os
        * @}
        */
 
+    protected:
+
+      /**
+       * @name Private Member Functions
+       * @{
+       */
+
+      /**
+       * @cond ignore
+       */
+
+#if !defined(OS_USE_RTOS_PORT_EVENT_FLAGS)
+
+      void
+      internal_resume_satisfied_ (void);
+
+#endif
+
+      /**
+       * @endcond
+       */
+
+      /**
+       * @}
+       */
+
     protected:
 
       /**
@@ -29,10 +29,27 @@
 #define CMSIS_PLUS_RTOS_OS_HOOKS_H_
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 
 // ----------------------------------------------------------------------------
 
+/**
+ * @brief Place a zero initialised object in the deferred .bss.
+ *
+ * @details
+ * Only for large buffers without initialisers or constructors;
+ * they are cleared after startup, and must not be used before
+ * `os_startup_initialize_bss_deferred()` returns `true`.
+ */
+#if defined(OS_INCLUDE_STARTUP_DEFERRED_BSS)
+#define OS_ATTRIBUTE_BSS_DEFERRED __attribute__((section(".bss_deferred")))
+#else
+#define OS_ATTRIBUTE_BSS_DEFERRED
+#endif
+
+// ----------------------------------------------------------------------------
+
 #if defined(__cplusplus)
 extern "C"
 {
@@ -107,6 +124,45 @@ extern "C"
   void
   os_startup_create_thread_idle (void);
 
+  /**
+   * @brief Clear a part of the deferred .bss region.
+   * @param [in] max_bytes Maximum number of bytes to clear.
+   * @retval true The region is completely cleared.
+   * @retval false Some bytes are not yet cleared.
+   */
+  bool
+  os_startup_initialize_bss_deferred (size_t max_bytes);
+
+  /**
+   * @brief Startup timestamps, in CPU cycles since reset.
+   */
+  typedef struct os_startup_timestamps_s
+  {
+    uint32_t hardware_early;
+    uint32_t data;
+    uint32_t bss;
+    uint32_t hardware;
+    uint32_t free_store;
+    uint32_t init_array;
+    uint32_t main;
+    uint32_t os_main;
+    uint32_t bss_deferred;
+  } os_startup_timestamps_t;
+
+  /**
+   * @brief The moments when the startup phases ended.
+   */
+  extern os_startup_timestamps_t os_startup_timestamps;
+
+  /**
+   * @brief Get the current startup timestamp.
+   * @par Parameters
+   *  None.
+   * @return The number of CPU cycles since reset.
+   */
+  uint32_t
+  os_startup_timestamp (void);
+
   /**
    * @}
    */
@@ -0,0 +1,521 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CMSIS_PLUS_RTOS_OS_LAZY_H_
+#define CMSIS_PLUS_RTOS_OS_LAZY_H_
+
+// ----------------------------------------------------------------------------
+
+#if defined(__cplusplus)
+
+#include <cmsis-plus/rtos/os-decls.h>
+
+#include <new>
+#include <type_traits>
+
+// ----------------------------------------------------------------------------
+
+#if defined(OS_USE_RTOS_LAZY_INIT)
+
+/**
+ * @brief Stack size of the thread which runs the background stages;
+ *  0 for the default stack size.
+ */
+#if !defined(OS_INTEGER_RTOS_LAZY_INIT_STACK_SIZE_BYTES)
+#define OS_INTEGER_RTOS_LAZY_INIT_STACK_SIZE_BYTES (0)
+#endif
+
+/**
+ * @brief Priority of the thread which runs the background stages.
+ */
+#if !defined(OS_INTEGER_RTOS_LAZY_INIT_PRIORITY)
+#define OS_INTEGER_RTOS_LAZY_INIT_PRIORITY \
+  (os::rtos::thread::priority::below_normal)
+#endif
+
+namespace os
+{
+  namespace rtos
+  {
+    // ------------------------------------------------------------------------
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+    /**
+     * @brief Base class of the objects constructed after startup.
+     * @headerfile os.h <cmsis-plus/rtos/os.h>
+     * @ingroup cmsis-plus-rtos-core
+     *
+     * @details
+     * The static objects are constructed by `os_run_init_array()`,
+     * one after the other, before `main()`. With many objects,
+     * this delays the moment when the application is ready.
+     *
+     * A `lazy<T>` static object only registers itself before `main()`;
+     * the `T` object is constructed later, depending on its stage:
+     *
+     * - `stage::main`: by the main thread, after the scheduler
+     *   started, before `os_main()`; the constructors may use
+     *   the RTOS services;
+     * - `stage::background + n`: by a low priority thread, in
+     *   increasing stage order, while `os_main()` runs;
+     * - `stage::on_demand`: only when used.
+     *
+     * In all cases, the object is constructed at the first use,
+     * if this happens before its stage. The constructions are
+     * serialised by a recursive mutex with priority inheritance,
+     * so a thread which uses an object constructed by the background
+     * thread waits for it, and the background thread gets the
+     * thread priority.
+     */
+    class lazy_init
+    {
+    public:
+
+      /**
+       * @brief Type of the stage numbers.
+       */
+      using stage_t = uint8_t;
+
+      /**
+       * @brief Type of the functions which construct the objects.
+       * @param [in] storage Pointer to the object storage.
+       */
+      using func_t = void (*) (void* storage);
+
+      /**
+       * @brief Stage numbers.
+       */
+      struct stage
+      {
+        enum
+          : stage_t
+            {
+              /**
+               * @brief Before `os_main()`, by the main thread.
+               */
+              main = 0,
+          /**
+           * @brief The first stage run by the background thread.
+           */
+          background = 1,
+          /**
+           * @brief Only on the first use.
+           */
+          on_demand = 255
+        };
+      };
+
+      // ----------------------------------------------------------------------
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+    protected:
+
+      /**
+       * @brief Register an object.
+       * @param [in] stage The stage when the object is constructed.
+       * @param [in] func Pointer to the function which constructs it.
+       * @param [in] storage Pointer to the object storage.
+       */
+      lazy_init (stage_t stage, func_t func, void* storage);
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      lazy_init (const lazy_init&) = delete;
+      lazy_init (lazy_init&&) = delete;
+      lazy_init&
+      operator= (const lazy_init&) = delete;
+      lazy_init&
+      operator= (lazy_init&&) = delete;
+
+      /**
+       * @endcond
+       */
+
+      /**
+       * @brief Unregister the object.
+       */
+      ~lazy_init ();
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+    public:
+
+      /**
+       * @brief Check if the object was constructed.
+       * @par Parameters
+       *  None.
+       * @retval true The object was constructed.
+       * @retval false The object was not yet constructed.
+       */
+      bool
+      is_constructed (void) const;
+
+      /**
+       * @brief Get the object stage.
+       * @par Parameters
+       *  None.
+       * @return The stage number.
+       */
+      stage_t
+      get_stage (void) const;
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+      /**
+       * @name Public Static Functions
+       * @{
+       */
+
+    public:
+
+      /**
+       * @brief Construct the objects of a stage.
+       * @param [in] stage The stage number.
+       * @par Returns
+       *  Nothing.
+       */
+      static void
+      run_stage (stage_t stage);
+
+      /**
+       * @brief Run the main stage and start the background stages.
+       * @par Parameters
+       *  None.
+       * @par Returns
+       *  Nothing.
+       *
+       * @details
+       * Called by the main thread before `os_main()`. The background
+       * thread is created only if there are objects which need it.
+       */
+      static void
+      start (void);
+
+      /**
+       * @brief Wait until all background stages ran.
+       * @par Parameters
+       *  None.
+       * @par Returns
+       *  Nothing.
+       */
+      static void
+      join (void);
+
+      /**
+       * @}
+       */
+
+      // ----------------------------------------------------------------------
+
+    protected:
+
+      /**
+       * @cond ignore
+       */
+
+      void
+      internal_construct_ (void);
+
+      static bool
+      internal_construct_next_ (stage_t stage);
+
+      static void*
+      internal_run_background_ (void* args);
+
+      /**
+       * @endcond
+       */
+
+    protected:
+
+      /**
+       * @cond ignore
+       */
+
+      enum state_e
+        : uint8_t
+          {
+            pending = 0,
+        constructing = 1,
+        constructed = 2
+      };
+
+      lazy_init* next_;
+      func_t func_;
+      void* storage_;
+      stage_t stage_;
+      volatile uint8_t state_;
+
+      // All registered objects; statically initialised, so objects
+      // can register from any static constructor.
+      static lazy_init* list__;
+
+      /**
+       * @endcond
+       */
+    };
+
+    /**
+     * @brief Object constructed after startup.
+     * @headerfile os.h <cmsis-plus/rtos/os.h>
+     * @ingroup cmsis-plus-rtos-core
+     * @tparam T Type of the object.
+     *
+     * @details
+     * Use it for static objects which are expensive to construct,
+     * and are not needed right after reset.
+     *
+     * @code{.cpp}
+     * // Constructed with T(), when first used.
+     * rtos::lazy<lookup_table> table;
+     *
+     * // Constructed by the background thread, or when first used.
+     * rtos::lazy<rtos::message_queue_typed<msg_t>> queue
+     *   {
+     *     [] (void* p)
+     *       { new (p) rtos::message_queue_typed<msg_t> { "q", 16 };},
+     *     rtos::lazy_init::stage::background
+     *   };
+     *
+     * queue->send (&msg);
+     * @endcode
+     *
+     * The object is destroyed with the `lazy` object, if it was
+     * constructed.
+     */
+    template<typename T>
+      class lazy : public lazy_init
+      {
+      public:
+
+        /**
+         * @brief Type of the object.
+         */
+        using value_type = T;
+
+        // --------------------------------------------------------------------
+
+        /**
+         * @name Constructors & Destructor
+         * @{
+         */
+
+        /**
+         * @brief Register an object constructed with `T()`.
+         * @param [in] stage The stage when the object is constructed.
+         */
+        lazy (stage_t stage = stage::on_demand);
+
+        /**
+         * @brief Register an object constructed by a function.
+         * @param [in] func Pointer to the function which constructs
+         *  the object in the given storage, with placement new.
+         * @param [in] stage The stage when the object is constructed.
+         */
+        lazy (func_t func, stage_t stage = stage::on_demand);
+
+        /**
+         * @brief Destroy the object, if it was constructed.
+         */
+        ~lazy ();
+
+        /**
+         * @}
+         */
+
+        // --------------------------------------------------------------------
+        /**
+         * @name Operators
+         * @{
+         */
+
+        /**
+         * @brief Get the object, constructing it if needed.
+         */
+        T*
+        operator-> (void);
+
+        /**
+         * @brief Get the object, constructing it if needed.
+         */
+        T&
+        operator* (void);
+
+        /**
+         * @}
+         */
+
+        // --------------------------------------------------------------------
+        /**
+         * @name Public Member Functions
+         * @{
+         */
+
+        /**
+         * @brief Get the object, constructing it if needed.
+         * @par Parameters
+         *  None.
+         * @return Pointer to the object.
+         */
+        T*
+        get (void);
+
+        /**
+         * @}
+         */
+
+      protected:
+
+        /**
+         * @cond ignore
+         */
+
+        static void
+        internal_construct_default_ (void* storage);
+
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type object_;
+
+        /**
+         * @endcond
+         */
+      };
+
+#pragma GCC diagnostic pop
+
+  } /* namespace rtos */
+} /* namespace os */
+
+// ===== Inline & template implementations ====================================
+
+namespace os
+{
+  namespace rtos
+  {
+    // ------------------------------------------------------------------------
+
+    inline bool
+    lazy_init::is_constructed (void) const
+    {
+      return state_ == constructed;
+    }
+
+    inline lazy_init::stage_t
+    lazy_init::get_stage (void) const
+    {
+      return stage_;
+    }
+
+    // ------------------------------------------------------------------------
+
+    template<typename T>
+      lazy<T>::lazy (stage_t stage) :
+          lazy_init
+            { stage, internal_construct_default_, &object_ }
+      {
+        ;
+      }
+
+    template<typename T>
+      lazy<T>::lazy (func_t func, stage_t stage) :
+          lazy_init
+            { stage, func, &object_ }
+      {
+        ;
+      }
+
+    template<typename T>
+      lazy<T>::~lazy ()
+      {
+        if (state_ == constructed)
+          {
+            reinterpret_cast<T*> (&object_)->~T ();
+          }
+      }
+
+    template<typename T>
+      inline T*
+      lazy<T>::get (void)
+      {
+        if (state_ != constructed)
+          {
+            internal_construct_ ();
+          }
+        return reinterpret_cast<T*> (&object_);
+      }
+
+    template<typename T>
+      inline T*
+      lazy<T>::operator-> (void)
+      {
+        return get ();
+      }
+
+    template<typename T>
+      inline T&
+      lazy<T>::operator* (void)
+      {
+        return *get ();
+      }
+
+    template<typename T>
+      void
+      lazy<T>::internal_construct_default_ (void* storage)
+      {
+        new (storage) T
+          { };
+      }
+
+  } /* namespace rtos */
+} /* namespace os */
+
+#endif /* defined(OS_USE_RTOS_LAZY_INIT) */
+
+// ----------------------------------------------------------------------------
+
+#endif /* __cplusplus */
+
+#endif /* CMSIS_PLUS_RTOS_OS_LAZY_H_ */
@@ -0,0 +1,768 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CMSIS_PLUS_RTOS_OS_MBUFFER_H_
+#define CMSIS_PLUS_RTOS_OS_MBUFFER_H_
+
+// ----------------------------------------------------------------------------
+
+#if defined(__cplusplus)
+
+#include <cmsis-plus/rtos/os-decls.h>
+#include <cmsis-plus/rtos/os-memory.h>
+
+#include <cmsis-plus/diag/trace.h>
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace rtos
+  {
+
+    // ========================================================================
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpadded"
+
+    /**
+     * @brief Variable length **message buffer**, using the
+     * default RTOS allocator.
+     * @headerfile os.h <cmsis-plus/rtos/os.h>
+     * @ingroup cmsis-plus-rtos-mbuffer
+     */
+    class message_buffer : public internal::object_named_system
+    {
+    public:
+
+      // ======================================================================
+
+      /**
+       * @brief Type of message size storage.
+       * @details
+       * Each message is stored in the buffer prefixed by its length,
+       * stored in a variable of this type.
+       * @ingroup cmsis-plus-rtos-mbuffer
+       */
+      using msg_size_t = uint16_t;
+
+      /**
+       * @brief Maximum message size.
+       * @ingroup cmsis-plus-rtos-mbuffer
+       */
+      static constexpr msg_size_t max_msg_size = 0xFFFF;
+
+      // ======================================================================
+
+      /**
+       * @brief Message buffer attributes.
+       * @headerfile os.h <cmsis-plus/rtos/os.h>
+       * @ingroup cmsis-plus-rtos-mbuffer
+       */
+      class attributes : public internal::attributes_clocked
+      {
+      public:
+
+        /**
+         * @name Constructors & Destructor
+         * @{
+         */
+
+        /**
+         * @brief Construct a message buffer attributes object instance.
+         * @par Parameters
+         *  None.
+         */
+        constexpr
+        attributes ();
+
+        // The rule of five.
+        attributes (const attributes&) = default;
+        attributes (attributes&&) = default;
+        attributes&
+        operator= (const attributes&) = default;
+        attributes&
+        operator= (attributes&&) = default;
+
+        /**
+         * @brief Destruct the message buffer attributes object instance.
+         */
+        ~attributes () = default;
+
+        /**
+         * @}
+         */
+
+      public:
+
+        /**
+         * @name Public Member Variables
+         * @{
+         */
+
+        // Public members; no accessors and mutators required.
+        // Warning: must match the type & order of the C file header.
+        /**
+         * @brief Address of the user defined storage for the message buffer.
+         */
+        void* mb_buffer_address = nullptr;
+
+        /**
+         * @brief Size of the user defined storage for the message buffer.
+         */
+        std::size_t mb_buffer_size_bytes = 0;
+
+        // Add more attributes here.
+
+        /**
+         * @}
+         */
+
+      }; /* class attributes */
+
+      /**
+       * @brief Default message buffer initialiser.
+       * @ingroup cmsis-plus-rtos-mbuffer
+       */
+      static const attributes initializer;
+
+      /**
+       * @brief Default RTOS allocator.
+       * @ingroup cmsis-plus-rtos-mbuffer
+       */
+      using allocator_type = memory::allocator<thread::stack::allocation_element_t>;
+
+      /**
+       * @brief Calculator for buffer storage requirements.
+       * @param msgs Number of messages.
+       * @param msg_size_bytes Size of message.
+       * @return Bytes required to store _msgs_ messages
+       *  of _msg_size_bytes_ each.
+       */
+      static constexpr std::size_t
+      compute_size_bytes (std::size_t msgs, std::size_t msg_size_bytes)
+      {
+        return msgs * (sizeof(msg_size_t) + msg_size_bytes);
+      }
+
+      // ======================================================================
+
+      /**
+       * @name Constructors & Destructor
+       * @{
+       */
+
+      /**
+       * @brief Construct a message buffer object instance.
+       * @param [in] size_bytes The buffer size, in bytes.
+       * @param [in] attr Reference to attributes.
+       * @param [in] allocator Reference to allocator. Default a
+       * local temporary instance.
+       */
+      message_buffer (std::size_t size_bytes, const attributes& attr =
+                          initializer,
+                      const allocator_type& allocator = allocator_type ());
+
+      /**
+       * @brief Construct a named message buffer object instance.
+       * @param [in] name Pointer to name.
+       * @param [in] size_bytes The buffer size, in bytes.
+       * @param [in] attr Reference to attributes.
+       * @param [in] allocator Reference to allocator. Default a
+       * local temporary instance.
+       */
+      message_buffer (const char* name, std::size_t size_bytes,
+                      const attributes& attr = initializer,
+                      const allocator_type& allocator = allocator_type ());
+
+    protected:
+
+      /**
+       * @cond ignore
+       */
+
+      // Internal constructor, used from templates.
+      message_buffer (const char* name);
+
+      /**
+       * @endcond
+       */
+
+    public:
+
+      /**
+       * @cond ignore
+       */
+
+      // The rule of five.
+      message_buffer (const message_buffer&) = delete;
+      message_buffer (message_buffer&&) = delete;
+      message_buffer&
+      operator= (const message_buffer&) = delete;
+      message_buffer&
+      operator= (message_buffer&&) = delete;
+
+      /**
+       * @endcond
+       */
+
+      /**
+       * @brief Destruct the message buffer object instance.
+       */
+      virtual
+      ~message_buffer ();
+
+      /**
+       * @}
+       */
+
+      /**
+       * @name Operators
+       * @{
+       */
+
+      /**
+       * @brief Compare message buffers.
+       * @retval true The given message buffer is the same as this one.
+       * @retval false The message buffers are different.
+       */
+      bool
+      operator== (const message_buffer& rhs) const;
+
+      /**
+       * @}
+       */
+
+    public:
+
+      /**
+       * @name Public Member Functions
+       * @{
+       */
+
+      /**
+       * @brief Send a message to the buffer.
+       * @param [in] msg The address of the message to enqueue.
+       * @param [in] nbytes The length of the message.
+       * @retval result::ok The message was enqueued.
+       * @retval EINVAL A parameter is invalid or outside of a permitted range.
+       * @retval EMSGSIZE The message can never fit in the buffer.
+       * @retval EPERM Cannot be invoked from an Interrupt Service Routines.
+       * @retval EINTR The operation was interrupted.
+       */
+      result_t
+      send (const void* msg, std::size_t nbytes);
+
+      /**
+       * @brief Try to send a message to the buffer.
+       * @param [in] msg The address of the message to enqueue.
+       * @param [in] nbytes The length of the message.
+       * @retval result::ok The message was enqueued.
+       * @retval EWOULDBLOCK There is not enough free space in the buffer.
+       * @retval EINVAL A parameter is invalid or outside of a permitted range.
+       * @retval EMSGSIZE The message can never fit in the buffer.
+       */
+      result_t
+      try_send (const void* msg, std::size_t nbytes);
+
+      /**
+       * @brief Send a message to the buffer with timeout.
+       * @param [in] msg The address of the message to enqueue.
+       * @param [in] nbytes The length of the message.
+       * @param [in] timeout The timeout duration.
+       * @retval result::ok The message was enqueued.
+       * @retval EINVAL A parameter is invalid or outside of a permitted range.
+       * @retval EMSGSIZE The message can never fit in the buffer.
+       * @retval EPERM Cannot be invoked from an Interrupt Service Routines.
+       * @retval ETIMEDOUT The timeout expired before the message
+       *  could be added to the buffer.
+       * @retval EINTR The operation was interrupted.
+       */
+      result_t
+      timed_send (const void* msg, std::size_t nbytes,
+                  clock::duration_t timeout);
+
+      /**
+       * @brief Receive a message from the buffer.
+       * @param [out] msg The address where to store the dequeued message.
+       * @param [in] nbytes The size of the destination buffer.
+       * @param [out] rbytes The address where to store the message
+       *  length. The default is `nullptr`.
+       * @retval result::ok The message was received.
+       * @retval EINVAL A parameter is invalid or outside of a permitted range.
+       * @retval EMSGSIZE The next message is larger than _nbytes_;
+       *  it is left in the buffer.
+       * @retval EPERM Cannot be invoked from an Interrupt Service Routines.
+       * @retval EINTR The operation was interrupted.
+       */
+      result_t
+      receive (void* msg, std::size_t nbytes, std::size_t* rbytes = nullptr);
+
+      /**
+       * @brief Try to receive a message from the buffer.
+       * @param [out] msg The address where to store the dequeued message.
+       * @param [in] nbytes The size of the destination buffer.
+       * @param [out] rbytes The address where to store the message
+       *  length. The default is `nullptr`.
+       * @retval result::ok The message was received.
+       * @retval EINVAL A parameter is invalid or outside of a permitted range.
+       * @retval EMSGSIZE The next message is larger than _nbytes_;
+       *  it is left in the buffer.
+       * @retval EWOULDBLOCK The message buffer is empty.
+       */
+      result_t
+      try_receive (void* msg, std::size_t nbytes,
+                   std::size_t* rbytes = nullptr);
+
+      /**
+       * @brief Receive a message from the buffer with timeout.
+       * @param [out] msg The address where to store the dequeued message.
+       * @param [in] nbytes The size of the destination buffer.
+       * @param [in] timeout The timeout duration.
+       * @param [out] rbytes The address where to store the message
+       *  length. The default is `nullptr`.
+       * @retval result::ok The message was received.
+       * @retval EINVAL A parameter is invalid or outside of a permitted range.
+       * @retval EMSGSIZE The next message is larger than _nbytes_;
+       *  it is left in the buffer.
+       * @retval EPERM Cannot be invoked from an Interrupt Service Routines.
+       * @retval EINTR The operation was interrupted.
+       * @retval ETIMEDOUT No message arrived before the
+       *  specified timeout expired.
+       */
+      result_t
+      timed_receive (void* msg, std::size_t nbytes, clock::duration_t timeout,
+                     std::size_t* rbytes = nullptr);
+
+      /**
+       * @brief Get buffer capacity.
+       * @par Parameters
+       *  None.
+       * @return The size of the buffer, in bytes, including the
+       *  message length prefixes.
+       */
+      std::size_t
+      capacity (void) const;
+
+      /**
+       * @brief Get the number of messages.
+       * @par Parameters
+       *  None.
+       * @return The number of messages in the buffer.
+       */
+      std::size_t
+      length (void) const;
+
+      /**
+       * @brief Get the free space.
+       * @par Parameters
+       *  None.
+       * @return The largest message that can be sent without blocking,
+       *  in bytes.
+       */
+      std::size_t
+      available (void) const;
+
+      /**
+       * @brief Check if the buffer is empty.
+       * @par Parameters
+       *  None.
+       * @retval true The buffer has no messages.
+       * @retval false The buffer has some messages.
+       */
+      bool
+      empty (void) const;
+
+      /**
+       * @brief Reset the message buffer.
+       * @par Parameters
+       *  None.
+       * @retval result::ok The buffer was reset.
+       * @retval EPERM Cannot be invoked from an Interrupt Service Routines.
+       */
+      result_t
+      reset (void);
+
+      /**
+       * @}
+       */
+
+    protected:
+
+      /**
+       * @name Private Member Functions
+       * @{
+       */
+
+      /**
+       * @cond ignore
+       */
+
+      /**
+       * @brief Internal function used during message buffer construction.
+       * @param [in] size_bytes The buffer size, in bytes.
+       * @param [in] attr Reference to attributes.
+       * @param [in] buffer_address Pointer to buffer storage.
+       * @param [in] buffer_size_bytes Size of buffer storage.
+       * @par Returns
+       *  Nothing.
+       */
+      void
+      internal_construct_ (std::size_t size_bytes, const attributes& attr,
+                           void* buffer_address,
+                           std::size_t buffer_size_bytes);
+
+      /**
+       * @brief Internal function used to enqueue a message, if possible.
+       * @param [in] msg The address of the message to enqueue.
+       * @param [in] nbytes The length of the message.
+       * @retval true The message was enqueued.
+       * @retval false There is not enough free space.
+       */
+      bool
+      internal_try_send_ (const void* msg, std::size_t nbytes);
+
+      /**
+       * @brief Internal function used to dequeue a message, if available.
+       * @param [out] msg The address where to store the dequeued message.
+       * @param [in] nbytes The size of the destination buffer.
+       * @param [out] rbytes The address where to store the message length.
+       * @retval result::ok The message was dequeued.
+       * @retval EWOULDBLOCK There are no messages in the buffer.
+       * @retval EMSGSIZE The next message is larger than _nbytes_.
+       */
+      result_t
+      internal_try_receive_ (void* msg, std::size_t nbytes,
+                             std::size_t* rbytes);
+
+      /**
+       * @brief Internal function used to copy bytes into the ring.
+       * @param [in] offset Offset in the ring.
+       * @param [in] src Source address.
+       * @param [in] nbytes Number of bytes.
+       * @return The offset after the copied bytes.
+       */
+      std::size_t
+      internal_copy_in_ (std::size_t offset, const void* src,
+                         std::size_t nbytes);
+
+      /**
+       * @brief Internal function used to copy bytes from the ring.
+       * @param [in] offset Offset in the ring.
+       * @param [out] dest Destination address.
+       * @param [in] nbytes Number of bytes.
+       * @return The offset after the copied bytes.
+       */
+      std::size_t
+      internal_copy_out_ (std::size_t offset, void* dest,
+                          std::size_t nbytes) const;
+
+      /**
+       * @endcond
+       */
+
+      /**
+       * @}
+       */
+
+    protected:
+
+      /**
+       * @name Private Member Variables
+       * @{
+       */
+
+      /**
+       * @cond ignore
+       */
+
+      // Keep these in sync with the structure declarations in os-c-decl.h.
+      /**
+       * @brief List of threads waiting to send.
+       */
+      internal::waiting_threads_list send_list_;
+      /**
+       * @brief List of threads waiting to receive.
+       */
+      internal::waiting_threads_list receive_list_;
+      /**
+       * @brief Pointer to clock to be used for timeouts.
+       */
+      clock* clock_ = nullptr;
+
+      /**
+       * @brief The address where the buffer is stored.
+       */
+      char* buffer_addr_ = nullptr;
+      /**
+       * @brief The dynamic address if the buffer was allocated
+       * (and must be deallocated)
+       */
+      void* allocated_buffer_addr_ = nullptr;
+      /**
+       * @brief Pointer to allocator.
+       */
+      const void* allocator_ = nullptr;
+
+      /**
+       * @brief Size of the buffer, in bytes.
+       */
+      std::size_t buffer_size_bytes_ = 0;
+      /**
+       * @brief Total size of the dynamically allocated buffer storage.
+       */
+      std::size_t allocated_buffer_size_elements_ = 0;
+
+      /**
+       * @brief Offset of the first message.
+       */
+      std::size_t head_ = 0;
+      /**
+       * @brief Number of bytes used by messages and their prefixes.
+       */
+      std::size_t used_bytes_ = 0;
+      /**
+       * @brief Current number of messages in the buffer.
+       */
+      std::size_t count_ = 0;
+
+      /**
+       * @endcond
+       */
+
+      /**
+       * @}
+       */
+
+    };
+
+    // ========================================================================
+
+    /**
+     * @brief Template of a **message buffer** with
+     *  the storage allocated inside the object.
+     * @headerfile os.h <cmsis-plus/rtos/os.h>
+     * @ingroup cmsis-plus-rtos-mbuffer
+     * @tparam N Size of the buffer, in bytes.
+     */
+    template<std::size_t N>
+      class message_buffer_inclusive : public message_buffer
+      {
+      public:
+
+        /**
+         * @brief Local constant based on template definition.
+         */
+        static const std::size_t size_bytes = N;
+
+        /**
+         * @name Constructors & Destructor
+         * @{
+         */
+
+        /**
+         * @brief Construct a message buffer object instance.
+         * @param [in] attr Reference to attributes.
+         */
+        message_buffer_inclusive (const attributes& attr = initializer);
+
+        /**
+         * @brief Construct a named message buffer object instance.
+         * @param [in] name Pointer to name.
+         * @param [in] attr Reference to attributes.
+         */
+        message_buffer_inclusive (const char* name, const attributes& attr =
+                                      initializer);
+
+        /**
+         * @cond ignore
+         */
+
+        // The rule of five.
+        message_buffer_inclusive (const message_buffer_inclusive&) = delete;
+        message_buffer_inclusive (message_buffer_inclusive&&) = delete;
+        message_buffer_inclusive&
+        operator= (const message_buffer_inclusive&) = delete;
+        message_buffer_inclusive&
+        operator= (message_buffer_inclusive&&) = delete;
+
+        /**
+         * @endcond
+         */
+
+        /**
+         * @brief Destruct the message buffer object instance.
+         */
+        virtual
+        ~message_buffer_inclusive ();
+
+        /**
+         * @}
+         */
+
+      protected:
+
+        /**
+         * @cond ignore
+         */
+
+        /**
+         * @brief The buffer storage.
+         */
+        char arena_[N];
+
+        /**
+         * @endcond
+         */
+
+      };
+
+#pragma GCC diagnostic pop
+
+  } /* namespace rtos */
+} /* namespace os */
+
+// ===== Inline & template implementations ====================================
+
+namespace os
+{
+  namespace rtos
+  {
+    constexpr
+    message_buffer::attributes::attributes ()
+    {
+      ;
+    }
+
+    // ========================================================================
+
+    /**
+     * @details
+     * Identical message buffers should have the same memory address.
+     */
+    inline bool
+    message_buffer::operator== (const message_buffer& rhs) const
+    {
+      return this == &rhs;
+    }
+
+    /**
+     * @details
+     *
+     * @note Can be invoked from Interrupt Service Routines.
+     */
+    inline std::size_t
+    message_buffer::capacity (void) const
+    {
+      return buffer_size_bytes_;
+    }
+
+    /**
+     * @details
+     *
+     * @note Can be invoked from Interrupt Service Routines.
+     */
+    inline std::size_t
+    message_buffer::length (void) const
+    {
+      return count_;
+    }
+
+    /**
+     * @details
+     *
+     * @note Can be invoked from Interrupt Service Routines.
+     */
+    inline std::size_t
+    message_buffer::available (void) const
+    {
+      std::size_t free_bytes = buffer_size_bytes_ - used_bytes_;
+      if (free_bytes <= sizeof(msg_size_t))
+        {
+          return 0;
+        }
+      free_bytes -= sizeof(msg_size_t);
+      return (free_bytes < max_msg_size) ? free_bytes : max_msg_size;
+    }
+
+    /**
+     * @details
+     *
+     * @note Can be invoked from Interrupt Service Routines.
+     */
+    inline bool
+    message_buffer::empty (void) const
+    {
+      return (count_ == 0);
+    }
+
+    // ========================================================================
+
+    template<std::size_t N>
+      inline
+      message_buffer_inclusive<N>::message_buffer_inclusive (
+          const attributes& attr) :
+          message_buffer_inclusive (nullptr, attr)
+      {
+        ;
+      }
+
+    /**
+     * @details
+     * The storage is part of the object, so no allocator is used;
+     * the attributes must not define a storage area.
+     *
+     * @warning Cannot be invoked from Interrupt Service Routines.
+     */
+    template<std::size_t N>
+      message_buffer_inclusive<N>::message_buffer_inclusive (
+          const char* name, const attributes& attr) :
+          message_buffer
+            { name }
+      {
+        internal_construct_ (N, attr, &arena_[0], N);
+      }
+
+    /**
+     * @details
+     *
+     * @warning Cannot be invoked from Interrupt Service Routines.
+     */
+    template<std::size_t N>
+      message_buffer_inclusive<N>::~message_buffer_inclusive ()
+      {
+        ;
+      }
+
+  } /* namespace rtos */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
+
+#endif /* __cplusplus */
+
+#endif /* CMSIS_PLUS_RTOS_OS_MBUFFER_H_ */
@@ -433,6 +433,9 @@ namespace os
        * @par Parameters
        *  None.
        * @return Pointer to block or `nullptr` if no more blocks available.
+       *
+       * @note With `OS_USE_RTOS_MEMORY_POOL_LOCK_FREE` it needs
+       *  no critical section.
        */
       void*
       internal_try_first_ (void);
@@ -512,10 +515,18 @@ namespace os
        */
       volatile memory_pool::size_t count_ = 0;
 
+#if defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE)
+      /**
+       * @brief Index of the first free block, plus one, in the
+       *  low 16 bits, or 0; the higher bits count the changes.
+       */
+      std::uintptr_t volatile first_ = 0;
+#else
       /**
        * @brief Pointer to the first free block, or nullptr.
        */
       void* volatile first_ = nullptr;
+#endif /* defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE) */
 
       /**
        * @endcond
@@ -0,0 +1,196 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CMSIS_PLUS_RTOS_OS_PROFILER_H_
+#define CMSIS_PLUS_RTOS_OS_PROFILER_H_
+
+// ----------------------------------------------------------------------------
+
+#if defined(__cplusplus)
+
+#include <cmsis-plus/rtos/os-decls.h>
+
+// ----------------------------------------------------------------------------
+
+#if defined(OS_USE_RTOS_PROFILER)
+
+namespace os
+{
+  namespace rtos
+  {
+    /**
+     * @brief Sampling CPU profiler namespace.
+     * @ingroup cmsis-plus-rtos-core
+     * @details
+     * The thread CPU cycles statistics tell how much time each thread
+     * used, but not where inside the thread the time was spent.
+     *
+     * The profiler periodically samples the interrupted program
+     * counter, the link register and the current thread, and counts
+     * the samples in a RAM histogram (a small hash table, with one
+     * entry for each distinct location). Hot paths show up as
+     * entries with large counts.
+     *
+     * By default the samples are taken from `os_systick_handler()`,
+     * every `OS_INTEGER_RTOS_PROFILER_TICKS_PER_SAMPLE` ticks; on
+     * Cortex-M the interrupted context is read from the exception
+     * frame saved on the thread (process) stack. Any other periodic
+     * interrupt (like a high resolution timer compare) can call
+     * `sample()` with its own interrupted context.
+     *
+     * The histogram is sent to the trace channel as text by `dump()`,
+     * and converted on the host to folded stacks, suitable for
+     * flame graphs, by the `scripts/profiler-flamegraph.py` script,
+     * which reads the function symbols from the application ELF file.
+     */
+    namespace profiler
+    {
+      // ----------------------------------------------------------------------
+
+      /**
+       * @brief Start sampling.
+       * @par Parameters
+       *  None.
+       * @par Returns
+       *  Nothing.
+       *
+       * @note Can be invoked from Interrupt Service Routines.
+       */
+      void
+      start (void);
+
+      /**
+       * @brief Stop sampling.
+       * @par Parameters
+       *  None.
+       * @par Returns
+       *  Nothing.
+       *
+       * @note Can be invoked from Interrupt Service Routines.
+       */
+      void
+      stop (void);
+
+      /**
+       * @brief Check if sampling is enabled.
+       * @par Parameters
+       *  None.
+       * @retval true The profiler is taking samples.
+       * @retval false The profiler is stopped.
+       */
+      bool
+      running (void);
+
+      /**
+       * @brief Clear the histogram.
+       * @par Parameters
+       *  None.
+       * @par Returns
+       *  Nothing.
+       */
+      void
+      clear (void);
+
+      /**
+       * @brief Record a sample.
+       * @param [in] pc The interrupted program counter.
+       * @param [in] lr The interrupted link register.
+       * @par Returns
+       *  Nothing.
+       *
+       * @details
+       * The sample is attributed to the current thread.
+       *
+       * @note Can be invoked from Interrupt Service Routines.
+       */
+      void
+      sample (const void* pc, const void* lr);
+
+      /**
+       * @brief Get the number of samples.
+       * @par Parameters
+       *  None.
+       * @return The number of samples taken since the last `clear()`.
+       */
+      std::size_t
+      samples (void);
+
+      /**
+       * @brief Get the number of dropped samples.
+       * @par Parameters
+       *  None.
+       * @return The number of samples not recorded because the
+       *  histogram was full.
+       */
+      std::size_t
+      dropped (void);
+
+      /**
+       * @brief Send the histogram to the trace channel.
+       * @par Parameters
+       *  None.
+       * @par Returns
+       *  Nothing.
+       *
+       * @details
+       * The sampling is suspended while the histogram is dumped.
+       *
+       * @warning Cannot be invoked from Interrupt Service Routines.
+       */
+      void
+      dump (void);
+
+      /**
+       * @cond ignore
+       */
+
+      /**
+       * @brief Take a sample of the context interrupted by the SysTick.
+       * @par Parameters
+       *  None.
+       * @par Returns
+       *  Nothing.
+       */
+      void
+      internal_tick_ (void);
+
+      /**
+       * @endcond
+       */
+
+    // ------------------------------------------------------------------------
+    } /* namespace profiler */
+  } /* namespace rtos */
+} /* namespace os */
+
+#endif /* defined(OS_USE_RTOS_PROFILER) */
+
+// ----------------------------------------------------------------------------
+
+#endif /* __cplusplus */
+
+#endif /* CMSIS_PLUS_RTOS_OS_PROFILER_H_ */
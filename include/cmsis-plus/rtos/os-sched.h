@@ -467,6 +467,73 @@ namespace os
        * @endcond
        */
 
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD)
+
+        /**
+         * @brief Close the current load window and start a new one.
+         * @par Parameters
+         *  None.
+         * @par Returns
+         *  Nothing.
+         */
+        void
+        update_load (void);
+
+        /**
+         * @brief Get the CPU load.
+         * @param [in] windows The number of most recent windows to average.
+         * @return The time spent in threads other than idle,
+         *  in per-mille.
+         */
+        rtos::statistics::load_t
+        cpu_load (std::size_t windows = 1);
+
+        /**
+         * @brief Get the idle load.
+         * @param [in] windows The number of most recent windows to average.
+         * @return The time spent in the idle thread, in per-mille.
+         */
+        rtos::statistics::load_t
+        idle_load (std::size_t windows = 1);
+
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+
+        /**
+         * @brief Get the context switch rate.
+         * @param [in] windows The number of most recent windows to average.
+         * @return The number of context switches per second.
+         */
+        uint32_t
+        context_switches_rate (std::size_t windows = 1);
+
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+
+        /**
+         * @brief Send a `top` like load report to the trace channel.
+         * @par Parameters
+         *  None.
+         * @par Returns
+         *  Nothing.
+         */
+        void
+        top (void);
+
+        /**
+         * @cond ignore
+         */
+
+        void
+        internal_update_load_ (thread* th);
+
+        extern rtos::statistics::duration_t window_cpu_cycles_;
+        extern clock::duration_t window_ticks_;
+
+        /**
+         * @endcond
+         */
+
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD) */
+
 #endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES) */
 
       } /* namespace statistics */
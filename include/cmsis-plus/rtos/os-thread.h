@@ -485,13 +485,13 @@ namespace os
 
         /**
          * @brief Align the pointers and initialise to a known pattern.
-         * @par Parameters
-         *  None.
+         * @param [in] paint If false, the stack is already filled
+         *  with the magic word (for example a recycled stack).
          * @par Returns
          *  Nothing.
          */
         void
-        initialize (void);
+        initialize (bool paint = true);
 
         /**
          * @brief Get the stack lowest reserved address.
@@ -549,6 +549,19 @@ namespace os
         std::size_t
         available (void);
 
+#if defined(OS_USE_RTOS_THREAD_STACK_WATERMARK)
+
+        /**
+         * @brief Get the deepest stack usage found by the idle tracker.
+         * @par Parameters
+         *  None.
+         * @return Number of used bytes.
+         */
+        std::size_t
+        high_water_mark (void);
+
+#endif /* defined(OS_USE_RTOS_THREAD_STACK_WATERMARK) */
+
         /**
          * @}
          */
@@ -594,6 +607,88 @@ namespace os
         static std::size_t
         default_size (std::size_t size_bytes);
 
+#if defined(OS_USE_RTOS_THREAD_STACK_WATERMARK)
+
+        /**
+         * @brief Type of overflow proximity callback.
+         * @param [in] th Pointer to the thread.
+         * @param [in] available_bytes Number of bytes still available.
+         */
+        using proximity_callback_t = void (*) (thread* th, std::size_t available_bytes);
+
+        /**
+         * @brief Set the overflow proximity callback.
+         * @param [in] callback Pointer to function, or `nullptr`.
+         * @param [in] threshold_bytes Call it when less bytes are available.
+         * @return The previous callback.
+         */
+        static proximity_callback_t
+        proximity_callback (proximity_callback_t callback,
+                            std::size_t threshold_bytes);
+
+        /**
+         * @cond ignore
+         */
+
+        bool
+        internal_track_ (std::size_t words);
+
+        static void
+        internal_track_all_ (thread* th);
+
+        /**
+         * @endcond
+         */
+
+#endif /* defined(OS_USE_RTOS_THREAD_STACK_WATERMARK) */
+
+#if defined(OS_USE_RTOS_THREAD_STACK_CACHE)
+
+        /**
+         * @brief Pre-allocate stacks in the cache.
+         * @param [in] size_bytes Stack size in bytes.
+         * @param [in] count Number of stacks to add.
+         * @return The number of stacks available in the cache
+         *  for this size class.
+         *
+         * @warning Cannot be invoked from Interrupt Service Routines.
+         */
+        static std::size_t
+        cache_reserve (std::size_t size_bytes, std::size_t count);
+
+        /**
+         * @brief Return all cached stacks to the allocator.
+         * @par Parameters
+         *  None.
+         * @par Returns
+         *  Nothing.
+         *
+         * @warning Cannot be invoked from Interrupt Service Routines.
+         */
+        static void
+        cache_release (void);
+
+        /**
+         * @cond ignore
+         */
+
+        static std::size_t
+        internal_cache_class_ (std::size_t& size_elements);
+
+        static stack::element_t*
+        internal_cache_get_ (std::size_t& size_elements);
+
+        static bool
+        internal_cache_put_ (stack::element_t* address,
+                             std::size_t size_elements,
+                             stack::element_t* used);
+
+        /**
+         * @endcond
+         */
+
+#endif
+
         /**
          * @}
          */
@@ -609,9 +704,20 @@ namespace os
         stack::element_t* bottom_address_;
         std::size_t size_bytes_;
 
+#if defined(OS_USE_RTOS_THREAD_STACK_WATERMARK)
+        // Lowest word known to be used, and the incremental scan position.
+        stack::element_t* low_;
+        stack::element_t* scan_;
+#endif /* defined(OS_USE_RTOS_THREAD_STACK_WATERMARK) */
+
         static std::size_t min_size_bytes_;
         static std::size_t default_size_bytes_;
 
+#if defined(OS_USE_RTOS_THREAD_STACK_WATERMARK)
+        static proximity_callback_t proximity_callback_;
+        static std::size_t proximity_threshold_bytes_;
+#endif /* defined(OS_USE_RTOS_THREAD_STACK_WATERMARK) */
+
         /**
          * @endcond
          */
@@ -923,6 +1029,34 @@ namespace os
         rtos::statistics::duration_t
         cpu_cycles (void);
 
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD)
+
+        /**
+         * @brief Get the thread CPU load.
+         * @par Parameters
+         *  None.
+         * @return The time used by the thread in the last load window,
+         *  in per-mille.
+         */
+        rtos::statistics::load_t
+        cpu_load (void);
+
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+
+        /**
+         * @brief Get the thread context switch rate.
+         * @par Parameters
+         *  None.
+         * @return The number of times the thread was scheduled per
+         *  second, in the last load window.
+         */
+        uint32_t
+        context_switches_rate (void);
+
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD) */
+
 #endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES) */
 
         /**
@@ -938,6 +1072,17 @@ namespace os
         friend void
         rtos::scheduler::internal_switch_threads (void);
 
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES) \
+  && defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD)
+
+        friend void
+        rtos::scheduler::statistics::update_load (void);
+
+        friend void
+        rtos::scheduler::statistics::internal_update_load_ (thread* th);
+
+#endif
+
 #if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
         rtos::statistics::counter_t context_switches_ = 0;
 #endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
@@ -946,6 +1091,20 @@ namespace os
         rtos::statistics::duration_t cpu_cycles_ = 0;
 #endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES) */
 
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES) \
+  && defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD)
+
+        // Counter values at the beginning of the current load window.
+        rtos::statistics::duration_t load_cpu_cycles_ = 0;
+        // Cycles used during the last complete load window.
+        rtos::statistics::duration_t window_cpu_cycles_ = 0;
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+        rtos::statistics::counter_t load_context_switches_ = 0;
+        rtos::statistics::counter_t window_context_switches_ = 0;
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+
+#endif
+
         /**
          * @endcond
          */
@@ -1629,17 +1788,23 @@ namespace os
 
       bool volatile interrupted_ = false;
 
+#if defined(OS_USE_RTOS_THREAD_STACK_CACHE)
+      // The stack came from the cache, already painted.
+      bool stack_recycled_ = false;
+#endif
+
       internal::event_flags event_flags_;
 
 #if defined(OS_INCLUDE_RTOS_CUSTOM_THREAD_USER_STORAGE) || defined(__DOXYGEN__)
       os_thread_user_storage_t user_storage_;
 #endif /* defined(OS_INCLUDE_RTOS_CUSTOM_THREAD_USER_STORAGE) */
 
-#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) \
+  || defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES)
 
       class statistics statistics_;
 
-#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) || defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES) */
 
       // Add other internal data
 
@@ -2083,6 +2248,10 @@ namespace os
     {
       bottom_address_ = nullptr;
       size_bytes_ = 0;
+#if defined(OS_USE_RTOS_THREAD_STACK_WATERMARK)
+      low_ = nullptr;
+      scan_ = nullptr;
+#endif /* defined(OS_USE_RTOS_THREAD_STACK_WATERMARK) */
     }
 
     /**
@@ -2153,6 +2322,31 @@ namespace os
       return *top () == stack::magic;
     }
 
+#if defined(OS_USE_RTOS_THREAD_STACK_WATERMARK)
+
+    /**
+     * @details
+     * The value is updated by the idle thread, a few words at a
+     * time, so it may lag behind the actual usage.
+     *
+     * With `OS_USE_RTOS_THREAD_STACK_LAZY_PAINT`, only the guard band
+     * is painted, and the usage above it is not known; until the guard
+     * band is reached, the result is the stack size minus the guard band.
+     *
+     * @note Can be invoked from Interrupt Service Routines.
+     */
+    inline std::size_t
+    thread::stack::high_water_mark (void)
+    {
+      if (low_ == nullptr)
+        {
+          return 0;
+        }
+      return static_cast<std::size_t> (top () - low_) * sizeof(element_t);
+    }
+
+#endif /* defined(OS_USE_RTOS_THREAD_STACK_WATERMARK) */
+
     /**
      * @details
      *
@@ -2274,6 +2468,58 @@ namespace os
       return cpu_cycles_;
     }
 
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD)
+
+    /**
+     * @details
+     * The load is computed by `scheduler::statistics::update_load()`,
+     * as the ratio between the cycles used by the thread and the
+     * total cycles in the last window.
+     *
+     * @note This function is available only when
+     * @ref OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD
+     * is defined.
+     *
+     * @warning Cannot be invoked from Interrupt Service Routines.
+     */
+    inline rtos::statistics::load_t
+    thread::statistics::cpu_load (void)
+    {
+      if (scheduler::statistics::window_cpu_cycles_ == 0)
+        {
+          return 0;
+        }
+      return static_cast<rtos::statistics::load_t> (window_cpu_cycles_ * 1000
+          / scheduler::statistics::window_cpu_cycles_);
+    }
+
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+
+    /**
+     * @details
+     *
+     * @note This function is available only when
+     * @ref OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD
+     * and @ref OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES
+     * are defined.
+     *
+     * @warning Cannot be invoked from Interrupt Service Routines.
+     */
+    inline uint32_t
+    thread::statistics::context_switches_rate (void)
+    {
+      if (scheduler::statistics::window_ticks_ == 0)
+        {
+          return 0;
+        }
+      return static_cast<uint32_t> (window_context_switches_
+          * clock_systick::frequency_hz / scheduler::statistics::window_ticks_);
+    }
+
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD) */
+
 #endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES) */
 
     // ========================================================================
@@ -2394,7 +2640,8 @@ namespace os
       return context_.stack_;
     }
 
-#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) \
+  || defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES)
 
     /**
      * @details
@@ -2407,7 +2654,7 @@ namespace os
       return statistics_;
     }
 
-#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) || defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES) */
 
 #if defined(OS_INCLUDE_RTOS_THREAD_PUBLIC_FLAGS_CLEAR)
 
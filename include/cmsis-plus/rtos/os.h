@@ -98,7 +98,10 @@
 #include <cmsis-plus/rtos/os-semaphore.h>
 #include <cmsis-plus/rtos/os-mempool.h>
 #include <cmsis-plus/rtos/os-mqueue.h>
+#include <cmsis-plus/rtos/os-mbuffer.h>
 #include <cmsis-plus/rtos/os-evflags.h>
+#include <cmsis-plus/rtos/os-profiler.h>
+#include <cmsis-plus/rtos/os-lazy.h>
 
 #include <cmsis-plus/rtos/os-hooks.h>
 
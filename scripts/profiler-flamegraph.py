@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# This file is part of the µOS++ distribution.
+#   (https://github.com/micro-os-plus)
+# Copyright (c) 2017 Liviu Ionescu.
+#
+# Convert the histogram produced by os::rtos::profiler::dump() into
+# folded stacks, one line per stack, as expected by flamegraph.pl
+# (https://github.com/brendangregg/FlameGraph) or speedscope.
+#
+# Usage:
+#   profiler-flamegraph.py application.elf profile.txt > profile.folded
+#   flamegraph.pl profile.folded > profile.svg
+#
+# The function names are read from the symbol table of the application
+# ELF file (32-bit, little endian). Each stack is `thread;caller;function`,
+# where the caller is derived from the link register; it is omitted when
+# it does not resolve to a different function.
+# -----------------------------------------------------------------------------
+
+import bisect
+import collections
+import struct
+import sys
+
+STT_FUNC = 2
+
+
+class Symbols(object):
+    """Function symbols from the ELF symbol table."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            data = f.read()
+        if data[:4] != b'\x7fELF' or data[4] != 1:
+            raise ValueError('%s: not a 32-bit ELF file' % path)
+        (shoff,) = struct.unpack_from('<I', data, 0x20)
+        shentsize, shnum = struct.unpack_from('<HH', data, 0x2E)
+        sections = []
+        for i in range(shnum):
+            sections.append(struct.unpack_from(
+                '<IIIIIIIIII', data, shoff + i * shentsize))
+
+        functions = {}
+        for (_, sh_type, _, _, offset, size, link, _, _, entsize) in sections:
+            # SHT_SYMTAB
+            if sh_type != 2 or entsize == 0:
+                continue
+            strtab = sections[link][4]
+            for j in range(size // entsize):
+                (name, value, sym_size, info, _, _) = struct.unpack_from(
+                    '<IIIBBH', data, offset + j * entsize)
+                if (info & 0xF) != STT_FUNC or value == 0:
+                    continue
+                end = data.index(b'\0', strtab + name)
+                # Clear the Thumb bit.
+                functions[value & ~1] = (
+                    max(sym_size, 2),
+                    data[strtab + name:end].decode('utf-8', 'replace'))
+
+        self.starts = sorted(functions)
+        self.functions = [functions[a] for a in self.starts]
+
+    def lookup(self, address):
+        address &= ~1
+        i = bisect.bisect_right(self.starts, address) - 1
+        if i < 0:
+            return None
+        size, name = self.functions[i]
+        if address >= self.starts[i] + size:
+            return None
+        return name
+
+
+def parse(stream):
+    """Yield (pc, lr, count, thread) tuples from the dump text."""
+    inside = False
+    for line in stream:
+        line = line.strip()
+        if line.startswith('# profiler'):
+            inside = True
+            continue
+        if line.startswith('# end'):
+            inside = False
+            continue
+        if not inside or not line:
+            continue
+        fields = line.split(' ', 3)
+        if len(fields) != 4:
+            continue
+        yield (int(fields[0], 16), int(fields[1], 16), int(fields[2]),
+               fields[3])
+
+
+def fold(symbols, samples):
+    stacks = collections.Counter()
+    for (pc, lr, count, thread) in samples:
+        frames = [thread]
+        function = symbols.lookup(pc) if pc != 0 else None
+        if function is None:
+            function = '0x%08x' % pc if pc != 0 else '[unknown]'
+        caller = symbols.lookup(lr) if lr != 0 else None
+        if caller is not None and caller != function:
+            frames.append(caller)
+        frames.append(function)
+        stacks[';'.join(f.replace(';', ':') for f in frames)] += count
+    return stacks
+
+
+def main(argv):
+    if len(argv) != 3:
+        sys.stderr.write('Usage: %s application.elf profile.txt\n' % argv[0])
+        return 1
+    symbols = Symbols(argv[1])
+    with open(argv[2], 'r', errors='replace') as f:
+        stacks = fold(symbols, parse(f))
+    for stack, count in sorted(stacks.items()):
+        sys.stdout.write('%s %u\n' % (stack, count))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# This file is part of the µOS++ distribution.
+#   (https://github.com/micro-os-plus)
+# Copyright (c) 2017 Liviu Ionescu.
+#
+# Compress the initialisation values of the data sections of an
+# application built with OS_INCLUDE_STARTUP_COMPRESSED_DATA.
+#
+# Usage:
+#   startup-compress-data.py application.elf
+#
+# The file is changed in place: the content of each writable
+# allocated section with initial values (.data and the other RAM
+# sections copied by the startup code) is replaced by an LZ4 block,
+# which the startup code decompresses in RAM. The rest of the
+# section content is left unchanged, and is not used.
+#
+# Each section must correspond to one region in the data regions
+# array; run the script only once for an ELF file.
+# -----------------------------------------------------------------------------
+
+import struct
+import sys
+
+SHT_PROGBITS = 1
+SHF_WRITE = 0x1
+SHF_ALLOC = 0x2
+
+MIN_MATCH = 4
+# The format requires the last 5 bytes to be literals, and the last
+# match to start at least 12 bytes before the end.
+LAST_LITERALS = 5
+MF_LIMIT = 12
+MAX_OFFSET = 65535
+
+
+def lz4_length(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+
+def lz4_sequence(out, literals, match_length, offset):
+    lit = len(literals)
+    token = min(lit, 15) << 4
+    if match_length is not None:
+        token |= min(match_length - MIN_MATCH, 15)
+    out.append(token)
+    if lit >= 15:
+        lz4_length(out, lit - 15)
+    out += literals
+    if match_length is not None:
+        out += struct.pack('<H', offset)
+        if match_length - MIN_MATCH >= 15:
+            lz4_length(out, match_length - MIN_MATCH - 15)
+
+
+def lz4_compress(data):
+    """Greedy LZ4 block compressor, with a hash of 4 byte sequences."""
+    n = len(data)
+    out = bytearray()
+    table = {}
+    anchor = 0
+    i = 0
+    while i + MF_LIMIT <= n:
+        key = data[i:i + MIN_MATCH]
+        candidate = table.get(key)
+        table[key] = i
+        if candidate is None or i - candidate > MAX_OFFSET:
+            i += 1
+            continue
+        length = MIN_MATCH
+        while (i + length < n - LAST_LITERALS
+               and data[candidate + length] == data[i + length]):
+            length += 1
+        lz4_sequence(out, data[anchor:i], length, i - candidate)
+        i += length
+        anchor = i
+    lz4_sequence(out, data[anchor:], None, 0)
+    return bytes(out)
+
+
+def lz4_decompress(block, size):
+    """Reference decoder, the same algorithm as the startup code."""
+    out = bytearray()
+    i = 0
+    while len(out) < size:
+        token = block[i]
+        i += 1
+        length = token >> 4
+        if length == 15:
+            while True:
+                b = block[i]
+                i += 1
+                length += b
+                if b != 255:
+                    break
+        out += block[i:i + length]
+        i += length
+        if len(out) >= size:
+            break
+        offset = block[i] | (block[i + 1] << 8)
+        i += 2
+        length = token & 0x0F
+        if length == 15:
+            while True:
+                b = block[i]
+                i += 1
+                length += b
+                if b != 255:
+                    break
+        length += MIN_MATCH
+        for _ in range(length):
+            out.append(out[-offset])
+    return bytes(out)
+
+
+def data_sections(image):
+    if image[:4] != b'\x7fELF' or image[4] != 1:
+        raise ValueError('not a 32-bit ELF file')
+    (shoff,) = struct.unpack_from('<I', image, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from('<HHH', image, 0x2E)
+    headers = [struct.unpack_from('<IIIIII', image, shoff + i * shentsize)
+               for i in range(shnum)]
+    strtab = headers[shstrndx][4]
+    for (name, sh_type, flags, _, offset, size) in headers:
+        if (sh_type == SHT_PROGBITS and (flags & SHF_WRITE)
+                and (flags & SHF_ALLOC) and size > 0):
+            end = image.index(b'\0', strtab + name)
+            yield (image[strtab + name:end].decode(), offset, size)
+
+
+def main(argv):
+    if len(argv) != 2:
+        sys.stderr.write('Usage: %s application.elf\n' % argv[0])
+        return 1
+    with open(argv[1], 'rb') as f:
+        image = bytearray(f.read())
+
+    for (name, offset, size) in list(data_sections(image)):
+        data = bytes(image[offset:offset + size])
+        block = lz4_compress(data)
+        if lz4_decompress(block, size) != data:
+            sys.stderr.write('%s: compression failed\n' % name)
+            return 1
+        if len(block) > size:
+            sys.stderr.write('%s: %d bytes do not compress\n' % (name, size))
+            return 1
+        image[offset:offset + len(block)] = block
+        print('%-16s %8d -> %8d bytes' % (name, size, len(block)))
+
+    with open(argv[1], 'wb') as f:
+        f.write(image)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+# -----------------------------------------------------------------------------
+# This file is part of the µOS++ distribution.
+#   (https://github.com/micro-os-plus)
+# Copyright (c) 2017 Liviu Ionescu.
+#
+# Decode the binary stream produced by os::trace::deferred::drain().
+#
+# Usage:
+#   trace-deferred-decode.py application.elf trace.bin
+#
+# The format strings (and the `%s` arguments) are referred in the
+# stream only by address, and are read from the allocated sections
+# of the application ELF file (32-bit, little endian).
+# -----------------------------------------------------------------------------
+
+import re
+import struct
+import sys
+
+RECORD_DROPPED = 1
+
+# In the count word, the number of argument words and the flag
+# set when some arguments did not fit in the record.
+COUNT_MASK = 0x0000FFFF
+COUNT_TRUNCATED = 0x80000000
+
+CONVERSION = re.compile(
+    r'%(?P<flags>[-+ #0]*)(?P<width>\*|\d+)?(?:\.(?P<prec>\*|\d+))?'
+    r'(?P<len>hh|h|ll|l|j|z|t|L)?(?P<conv>[diouxXcpsnfFeEgGaA%])')
+
+
+class Image(object):
+    """Read-only view of the ELF allocated sections."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        if self.data[:4] != b'\x7fELF' or self.data[4] != 1:
+            raise ValueError('%s: not a 32-bit ELF file' % path)
+        (shoff,) = struct.unpack_from('<I', self.data, 0x20)
+        shentsize, shnum = struct.unpack_from('<HH', self.data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            (_, sh_type, flags, addr, offset, size) = struct.unpack_from(
+                '<IIIIII', self.data, shoff + i * shentsize)
+            # SHT_PROGBITS, SHF_ALLOC
+            if sh_type == 1 and (flags & 0x2) and size > 0:
+                self.sections.append((addr, offset, size))
+
+    def string(self, address):
+        for (addr, offset, size) in self.sections:
+            if addr <= address < addr + size:
+                start = offset + address - addr
+                end = self.data.index(b'\0', start, offset + size)
+                return self.data[start:end].decode('utf-8', 'replace')
+        return None
+
+
+def signed(value, bits):
+    if value & (1 << (bits - 1)):
+        value -= 1 << bits
+    return value
+
+
+class MissingArgument(Exception):
+    pass
+
+
+def format_record(image, fmt, words):
+    words = list(words)
+
+    def fetch(count=1):
+        if len(words) < count:
+            raise MissingArgument()
+        value = 0
+        for i in range(count):
+            value |= words.pop(0) << (32 * i)
+        return value
+
+    def replace(m):
+        try:
+            return convert(m)
+        except MissingArgument:
+            # The argument was not stored, the record was truncated.
+            return '<?>'
+
+    def convert(m):
+        conv = m.group('conv')
+        if conv == '%':
+            return '%'
+        width = m.group('width') or ''
+        if width == '*':
+            width = str(signed(fetch(), 32))
+        prec = m.group('prec')
+        if prec == '*':
+            prec = str(signed(fetch(), 32))
+        spec = '%' + m.group('flags') + width + \
+            ('.' + prec if prec is not None else '')
+        wide = 2 if m.group('len') in ('ll', 'j') else 1
+
+        if conv in 'di':
+            return (spec + 'd') % signed(fetch(wide), 32 * wide)
+        if conv in 'ouxX':
+            return (spec + conv) % fetch(wide)
+        if conv == 'c':
+            return (spec + 'c') % chr(fetch() & 0xFF)
+        if conv == 'p':
+            return (spec + 's') % ('0x%x' % fetch())
+        if conv == 's':
+            address = fetch()
+            text = image.string(address)
+            if text is None:
+                text = '<0x%08x>' % address
+            return (spec + 's') % text
+        if conv == 'n':
+            fetch()
+            return ''
+        value = struct.unpack('<d', struct.pack('<Q', fetch(2)))[0]
+        if conv in 'aA':
+            text = value.hex()
+            return text.upper() if conv == 'A' else text
+        return (spec + conv) % value
+
+    return CONVERSION.sub(replace, fmt)
+
+
+def decode(image, stream, out):
+    offset = 0
+    while offset + 8 <= len(stream):
+        header, count = struct.unpack_from('<II', stream, offset)
+        offset += 8
+        truncated = (count & COUNT_TRUNCATED) != 0
+        count &= COUNT_MASK
+        words = struct.unpack_from('<%dI' % count, stream, offset)
+        offset += 4 * count
+
+        if header == RECORD_DROPPED:
+            out.write('[%u messages dropped]\n' % words[0])
+            continue
+
+        fmt = image.string(header)
+        if fmt is None:
+            out.write('[unknown format at 0x%08x]\n' % header)
+            continue
+        out.write(format_record(image, fmt, words))
+        if truncated:
+            out.write('[arguments truncated]\n')
+
+
+def main(argv):
+    if len(argv) != 3:
+        sys.stderr.write('Usage: %s application.elf trace.bin\n' % argv[0])
+        return 1
+    image = Image(argv[1])
+    with open(argv[2], 'rb') as f:
+        stream = f.read()
+    decode(image, stream, sys.stdout)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
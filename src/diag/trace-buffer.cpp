@@ -0,0 +1,207 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined(TRACE)
+
+#include <cmsis-plus/os-app-config.h>
+
+#if defined(OS_USE_TRACE_BUFFER)
+
+#include <cmsis-plus/diag/trace.h>
+#include <cmsis-plus/diag/trace-ring.h>
+
+#include <atomic>
+#include <cstdint>
+
+// ----------------------------------------------------------------------------
+
+#ifndef OS_INTEGER_TRACE_BUFFER_SIZE_BYTES
+#define OS_INTEGER_TRACE_BUFFER_SIZE_BYTES (1024)
+#endif
+
+// ----------------------------------------------------------------------------
+
+/*
+ * The buffer is a ring of 32-bit words, shared by multiple producers
+ * (threads and interrupt handlers) and a single consumer (the drain).
+ *
+ * Each record is a header word, with the payload length in bytes,
+ * followed by the payload, padded to a word boundary. A header
+ * equal to 0 means the record was reserved but not yet committed.
+ */
+
+namespace
+{
+  using ring_type = os::trace::internal::ring<OS_INTEGER_TRACE_BUFFER_SIZE_BYTES
+  / sizeof(std::uint32_t)>;
+  using word_t = ring_type::word_t;
+
+  // Longer writes are split, to leave room for other producers.
+  constexpr std::size_t max_record_bytes = (ring_type::size / 2 - 1)
+      * sizeof(word_t);
+
+  static_assert(ring_type::size >= 16, "OS_INTEGER_TRACE_BUFFER_SIZE_BYTES too small");
+
+#pragma GCC diagnostic push
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+#endif
+
+  ring_type ring_;
+
+  // Prevent concurrent drains (idle thread and explicit flush).
+  std::atomic<bool> draining_
+    { false };
+
+#pragma GCC diagnostic pop
+
+  inline std::size_t
+  words (std::size_t bytes)
+  {
+    return (bytes + sizeof(word_t) - 1) / sizeof(word_t);
+  }
+
+  /**
+   * @brief Reserve, fill and commit a single record.
+   * @retval true The record was committed.
+   * @retval false There is not enough space in the ring.
+   */
+  bool
+  put_record (const std::uint8_t* src, std::size_t nbyte)
+  {
+    std::size_t head;
+    if (!ring_.reserve (1 + words (nbyte), head))
+      {
+        return false;
+      }
+
+    // Copy outside any critical section; interrupts remain enabled.
+    ring_.store_bytes (head + 1, src, nbyte);
+
+    ring_.commit (head, static_cast<word_t> (nbyte));
+    return true;
+  }
+
+} /* namespace */
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace trace
+  {
+    // ------------------------------------------------------------------------
+
+    /**
+     * @details
+     * The data is only copied into the lock-free buffer, without
+     * disabling interrupts; the physical channel is written
+     * later, by `drain()`.
+     *
+     * If the buffer is full, the rest of the data is dropped, and
+     * the returned count is less than `nbyte`.
+     *
+     * @note Can be invoked from Interrupt Service Routines.
+     */
+    ssize_t
+    write (const void* buf, std::size_t nbyte)
+    {
+      if (buf == nullptr || nbyte == 0)
+        {
+          return 0;
+        }
+
+      const std::uint8_t* p = static_cast<const std::uint8_t*> (buf);
+      std::size_t togo = nbyte;
+      while (togo > 0)
+        {
+          std::size_t n = (togo < max_record_bytes) ? togo : max_record_bytes;
+          if (!put_record (p, n))
+            {
+              break;
+            }
+          p += n;
+          togo -= n;
+        }
+
+      return static_cast<ssize_t> (nbyte - togo);
+    }
+
+    /**
+     * @details
+     * Committed records are passed to `channel_write()` directly
+     * from the ring (in two parts, if wrapped around), then the
+     * space is released. The process stops at the first record still
+     * being filled in by a producer.
+     *
+     * If another drain is in progress, the call returns immediately.
+     */
+    std::size_t
+    drain (void)
+    {
+      if (internal::test_and_set (draining_))
+        {
+          return 0;
+        }
+
+      std::size_t total = 0;
+      std::size_t tail;
+      word_t nbyte;
+      // Stop at the first record not yet committed.
+      while ((nbyte = ring_.front (tail)) != 0)
+        {
+          std::size_t first;
+          const std::uint8_t* p = ring_.bytes (tail + 1, nbyte, first);
+          channel_write (p, first);
+          if (first < nbyte)
+            {
+              channel_write (ring_.begin (), nbyte - first);
+            }
+          total += nbyte;
+
+          ring_.pop (tail, 1 + words (nbyte));
+        }
+
+      draining_.store (false, std::memory_order_release);
+      return total;
+    }
+
+    void
+    flush (void)
+    {
+      drain ();
+      channel_flush ();
+    }
+
+  } /* namespace trace */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
+
+#endif /* defined(OS_USE_TRACE_BUFFER) */
+#endif /* defined(TRACE) */
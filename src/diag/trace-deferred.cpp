@@ -0,0 +1,443 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined(TRACE)
+
+#include <cmsis-plus/os-app-config.h>
+
+#if defined(OS_USE_TRACE_DEFERRED)
+
+#include <cmsis-plus/diag/trace-deferred.h>
+#include <cmsis-plus/diag/trace-ring.h>
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdint>
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+
+#ifndef OS_INTEGER_TRACE_DEFERRED_BUFFER_SIZE_WORDS
+#define OS_INTEGER_TRACE_DEFERRED_BUFFER_SIZE_WORDS (256)
+#endif
+
+#ifndef OS_INTEGER_TRACE_DEFERRED_MAX_ARGS_WORDS
+#define OS_INTEGER_TRACE_DEFERRED_MAX_ARGS_WORDS (8)
+#endif
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Each record is a sequence of 32-bit words:
+ * - the address of the format string (the commit marker)
+ * - the number of argument words that follow; if the arguments do not
+ *   fit in OS_INTEGER_TRACE_DEFERRED_MAX_ARGS_WORDS, the last ones are
+ *   not stored, and the `count_truncated` bit is set
+ * - the raw arguments, 64-bit values as two words, low word first.
+ *
+ * The drained binary stream has exactly the same layout; a record
+ * with the special header `record_dropped` reports the total number
+ * of messages dropped so far.
+ */
+
+namespace
+{
+  using ring_type = os::trace::internal::ring<
+  OS_INTEGER_TRACE_DEFERRED_BUFFER_SIZE_WORDS>;
+  using word_t = ring_type::word_t;
+
+  constexpr std::size_t max_args = OS_INTEGER_TRACE_DEFERRED_MAX_ARGS_WORDS;
+  constexpr std::size_t header_words = 2;
+
+  constexpr word_t record_dropped = 1;
+
+  // Set in the count word when some arguments were not stored.
+  constexpr word_t count_truncated = 0x80000000;
+  constexpr word_t count_mask = 0x0000FFFF;
+
+  static_assert(ring_type::size >= header_words + max_args,
+      "OS_INTEGER_TRACE_DEFERRED_BUFFER_SIZE_WORDS too small");
+
+#pragma GCC diagnostic push
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+#endif
+
+  ring_type ring_;
+
+  std::atomic<std::size_t> dropped_
+    { 0 };
+
+#pragma GCC diagnostic pop
+
+  // Only used by the consumer.
+  std::size_t reported_dropped_;
+
+  // --------------------------------------------------------------------------
+
+  /**
+   * @brief Local collector of argument words.
+   */
+  class args_words
+  {
+  public:
+
+    // Arguments are stored entirely or not at all; after the
+    // first one that does not fit, the following are skipped.
+    void
+    push (std::uint64_t value, std::size_t bytes)
+    {
+      std::size_t n = (bytes > sizeof(word_t)) ? 2 : 1;
+      if (truncated || count + n > max_args)
+        {
+          truncated = true;
+          return;
+        }
+      words[count++] = static_cast<word_t> (value);
+      if (n == 2)
+        {
+          words[count++] = static_cast<word_t> (value >> 32);
+        }
+    }
+
+    word_t words[max_args];
+    std::size_t count = 0;
+    bool truncated = false;
+  };
+
+} /* namespace */
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace trace
+  {
+    namespace deferred
+    {
+      // ----------------------------------------------------------------------
+
+      /**
+       * @details
+       * Only the arguments are fetched, without any formatting.
+       * The format string is scanned to learn the type of
+       * each argument.
+       */
+      int
+      printf (const char* format, ...)
+      {
+        std::va_list args;
+        va_start(args, format);
+
+        int ret = vprintf (format, args);
+
+        va_end(args);
+        return ret;
+      }
+
+      /**
+       * @details
+       * The space in the ring buffer is reserved with a
+       * compare-and-swap on the head index, so concurrent producers
+       * (threads or interrupt handlers) get separate areas without
+       * disabling interrupts. The record is committed by writing
+       * its header last.
+       *
+       * If there is not enough space, the message is dropped
+       * and counted.
+       *
+       * Arguments that do not fit in `OS_INTEGER_TRACE_DEFERRED_MAX_ARGS_WORDS`
+       * are not stored, and the record is marked as truncated; the
+       * decoder displays them as `<?>`.
+       */
+      int
+      vprintf (const char* format, std::va_list args)
+      {
+        args_words aw;
+
+        for (const char* p = format; *p != '\0'; ++p)
+          {
+            if (*p != '%')
+              {
+                continue;
+              }
+            ++p;
+
+            // Flags.
+            while (*p == '-' || *p == '+' || *p == ' ' || *p == '#'
+                || *p == '0')
+              {
+                ++p;
+              }
+
+            // Width.
+            if (*p == '*')
+              {
+                aw.push (static_cast<unsigned int> (va_arg(args, int)),
+                         sizeof(int));
+                ++p;
+              }
+            while (*p >= '0' && *p <= '9')
+              {
+                ++p;
+              }
+
+            // Precision.
+            if (*p == '.')
+              {
+                ++p;
+                if (*p == '*')
+                  {
+                    aw.push (static_cast<unsigned int> (va_arg(args, int)),
+                             sizeof(int));
+                    ++p;
+                  }
+                while (*p >= '0' && *p <= '9')
+                  {
+                    ++p;
+                  }
+              }
+
+            // Length modifiers.
+            std::size_t bytes = sizeof(int);
+            if (*p == 'h')
+              {
+                ++p;
+                if (*p == 'h')
+                  {
+                    ++p;
+                  }
+              }
+            else if (*p == 'l')
+              {
+                ++p;
+                if (*p == 'l')
+                  {
+                    bytes = sizeof(long long);
+                    ++p;
+                  }
+                else
+                  {
+                    bytes = sizeof(long);
+                  }
+              }
+            else if (*p == 'j')
+              {
+                bytes = sizeof(std::intmax_t);
+                ++p;
+              }
+            else if (*p == 'z' || *p == 't')
+              {
+                bytes = sizeof(std::size_t);
+                ++p;
+              }
+            else if (*p == 'L')
+              {
+                ++p;
+              }
+
+            switch (*p)
+              {
+              case 'd':
+              case 'i':
+              case 'u':
+              case 'o':
+              case 'x':
+              case 'X':
+              case 'c':
+                if (bytes == sizeof(long long))
+                  {
+                    aw.push (va_arg(args, unsigned long long), bytes);
+                  }
+                else if (bytes == sizeof(long))
+                  {
+                    aw.push (va_arg(args, unsigned long), bytes);
+                  }
+                else
+                  {
+                    aw.push (va_arg(args, unsigned int), bytes);
+                  }
+                break;
+
+              case 'p':
+              case 's':
+              case 'n':
+                aw.push (reinterpret_cast<std::uintptr_t> (va_arg(args, void*)),
+                         sizeof(void*));
+                break;
+
+              case 'f':
+              case 'F':
+              case 'e':
+              case 'E':
+              case 'g':
+              case 'G':
+              case 'a':
+              case 'A':
+                {
+                  // Long doubles are stored as doubles.
+                  double d = (*(p - 1) == 'L') ?
+                      static_cast<double> (va_arg(args, long double)) :
+                      va_arg(args, double);
+                  std::uint64_t u;
+                  std::memcpy (&u, &d, sizeof(u));
+                  aw.push (u, sizeof(u));
+                }
+                break;
+
+              case '\0':
+                // Malformed format, stop before the terminator.
+                --p;
+                break;
+
+              default:
+                // Including "%%", nothing to fetch.
+                break;
+              }
+          }
+
+        std::size_t head;
+        if (!ring_.reserve (header_words + aw.count, head))
+          {
+            os::trace::internal::increment (dropped_);
+            return -1;
+          }
+
+        // Fill in the reserved space; the header goes last.
+        word_t count = static_cast<word_t> (aw.count);
+        if (aw.truncated)
+          {
+            count |= count_truncated;
+          }
+        ring_.store (head + 1, count);
+        for (std::size_t i = 0; i < aw.count; ++i)
+          {
+            ring_.store (head + header_words + i, aw.words[i]);
+          }
+        ring_.commit (
+            head, static_cast<word_t> (reinterpret_cast<std::uintptr_t> (format)));
+
+        return static_cast<int> (aw.count);
+      }
+
+      /**
+       * @details
+       * Committed records are copied out of the ring buffer, one by
+       * one, and passed to `write()`. The process stops at the first
+       * record still being filled in by a producer.
+       *
+       * If messages were dropped since the previous call, a special
+       * record with the total count is sent first.
+       */
+      std::size_t
+      drain (void)
+      {
+        word_t buf[header_words + max_args];
+        std::size_t total = 0;
+
+        std::size_t dropped = dropped_.load (std::memory_order_relaxed);
+        if (dropped != reported_dropped_)
+          {
+            reported_dropped_ = dropped;
+            buf[0] = record_dropped;
+            buf[1] = 1;
+            buf[2] = static_cast<word_t> (dropped);
+            write (buf, 3 * sizeof(word_t));
+            total += 3 * sizeof(word_t);
+          }
+
+        std::size_t tail;
+        word_t header;
+        // Stop at the first record not yet committed.
+        while ((header = ring_.front (tail)) != 0)
+          {
+            buf[0] = header;
+            buf[1] = ring_.load (tail + 1);
+            std::size_t len = header_words + (buf[1] & count_mask);
+            for (std::size_t i = header_words; i < len; ++i)
+              {
+                buf[i] = ring_.load (tail + i);
+              }
+
+            ring_.pop (tail, len);
+
+            write (buf, len * sizeof(word_t));
+            total += len * sizeof(word_t);
+          }
+
+        return total;
+      }
+
+      ssize_t __attribute__((weak))
+      write (const void* buf, std::size_t nbyte)
+      {
+        return trace::write (buf, nbyte);
+      }
+
+      std::size_t
+      dropped (void)
+      {
+        return dropped_.load (std::memory_order_relaxed);
+      }
+
+    } /* namespace deferred */
+  } /* namespace trace */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
+
+using namespace os;
+
+int
+trace_deferred_printf (const char* format, ...)
+{
+  std::va_list args;
+  va_start(args, format);
+
+  int ret = trace::deferred::vprintf (format, args);
+
+  va_end(args);
+  return ret;
+}
+
+int
+trace_deferred_vprintf (const char* format, va_list args)
+{
+  return trace::deferred::vprintf (format, args);
+}
+
+size_t
+trace_deferred_drain (void)
+{
+  return trace::deferred::drain ();
+}
+
+// ----------------------------------------------------------------------------
+
+#endif /* defined(OS_USE_TRACE_DEFERRED) */
+#endif /* defined(TRACE) */
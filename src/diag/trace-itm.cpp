@@ -74,7 +74,7 @@ namespace os
 #endif
 
       ssize_t
-      write (const void* buf, std::size_t nbyte)
+      channel_write (const void* buf, std::size_t nbyte)
       {
         if (buf == nullptr || nbyte == 0)
           {
@@ -65,7 +65,7 @@ namespace os
     // --------------------------------------------------------------------
 
     ssize_t
-    write (const void* buf, std::size_t nbyte)
+    channel_write (const void* buf, std::size_t nbyte)
     {
       if (buf == nullptr || nbyte == 0)
         {
@@ -79,14 +79,17 @@ namespace os
 
       ssize_t ret;
 
+#if !defined(OS_USE_TRACE_BUFFER)
+      // With the trace buffer, the drain is the only writer.
       rtos::interrupts::critical_section ics;
+#endif
       ret = (ssize_t) SEGGER_RTT_WriteNoLock (0, buf, nbyte);
 
       return ret;
     }
 
     void
-    flush (void)
+    channel_flush (void)
     {
       while (_SEGGER_RTT.aUp[0].WrOff != _SEGGER_RTT.aUp[0].RdOff)
         {
@@ -45,6 +45,10 @@
 
 #include <cmsis-plus/arm/semihosting.h>
 
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+#include <cmsis-plus/arm/semihosting-buffer.h>
+#endif
+
 // ----------------------------------------------------------------------------
 
 namespace os
@@ -53,10 +57,27 @@ namespace os
     {
       // ----------------------------------------------------------------------
 
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+
+      namespace
+      {
+        // Coalesce the small writes, to reduce the number of operations.
+        char channel_storage[OS_INTEGER_SEMIHOSTING_BUFFER_SIZE];
+
+        semihosting::buffer channel_buffer
+          { channel_storage, sizeof(channel_storage) };
+      } /* namespace */
+
+#endif /* defined(OS_INCLUDE_SEMIHOSTING_BUFFERS) */
+
       void
       initialize (void)
       {
-        // For semihosting, no inits are required.
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS) \
+    && defined(OS_USE_TRACE_SEMIHOSTING_DEBUG)
+        channel_buffer.bind (semihosting::buffer::debug_channel);
+#endif
+        // For semihosting, no other inits are required.
       }
 
       // ----------------------------------------------------------------------
@@ -94,13 +115,23 @@ namespace os
 #endif
 
       ssize_t
-      write (const void* buf, std::size_t nbyte)
+      channel_write (const void* buf, std::size_t nbyte)
       {
         if (buf == nullptr || nbyte == 0)
           {
             return 0;
           }
 
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+
+        // Keep the order of the output sent to the same terminal.
+        semihosting::buffer::flush_all (false, &channel_buffer);
+
+        // The buffer is sent with a single SYS_WRITE0.
+        return channel_buffer.write (buf, nbyte);
+
+#else
+
         const char* cbuf = (const char*) buf;
 
         // Since the single character debug channel is quite slow, try to
@@ -135,12 +166,14 @@ namespace os
 
         // All bytes written.
         return (ssize_t) nbyte;
+
+#endif /* defined(OS_INCLUDE_SEMIHOSTING_BUFFERS) */
       }
 
 #elif defined(OS_USE_TRACE_SEMIHOSTING_STDOUT)
 
     ssize_t
-    write (const void* buf, std::size_t nbyte)
+    channel_write (const void* buf, std::size_t nbyte)
       {
       if (buf == nullptr || nbyte == 0)
         {
@@ -169,8 +202,20 @@ namespace os
               }
 
             handle = ret;
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+            channel_buffer.bind (handle);
+#endif
           }
 
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+
+        // Keep the order of the output sent to the same terminal.
+        semihosting::buffer::flush_all (false, &channel_buffer);
+
+        return channel_buffer.write (buf, nbyte);
+
+#else
+
         block[0] = (void*) handle;
         block[1] = (void*) buf;
         block[2] = (void*) nbyte;
@@ -192,10 +237,22 @@ namespace os
 
         // Return the number of bytes written.
         return (ssize_t) (nbyte) - (ssize_t) ret;
+
+#endif /* defined(OS_INCLUDE_SEMIHOSTING_BUFFERS) */
       }
 
 #endif /* defined(OS_USE_TRACE_SEMIHOSTING_STDOUT) */
 
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+
+      void
+      channel_flush (void)
+      {
+        channel_buffer.flush ();
+      }
+
+#endif /* defined(OS_INCLUDE_SEMIHOSTING_BUFFERS) */
+
   } /* namespace trace */
 } /* namespace os */
 
@@ -57,13 +57,35 @@ namespace os
      * @return  The number of characters actually written, or -1 if error.
      */
     ssize_t __attribute__((weak))
-    write (const void* buf __attribute__((unused)), std::size_t nbyte)
+    write (const void* buf, std::size_t nbyte)
     {
-      return static_cast<ssize_t> (nbyte);
+      return channel_write (buf, nbyte);
     }
 
     void __attribute__((weak))
     flush (void)
+    {
+      channel_flush ();
+    }
+
+    std::size_t __attribute__((weak))
+    drain (void)
+    {
+      return 0;
+    }
+
+    /**
+     * @brief Write the given number of bytes to the physical channel.
+     * @return  The number of characters actually written, or -1 if error.
+     */
+    ssize_t __attribute__((weak))
+    channel_write (const void* buf __attribute__((unused)), std::size_t nbyte)
+    {
+      return static_cast<ssize_t> (nbyte);
+    }
+
+    void __attribute__((weak))
+    channel_flush (void)
     {
       ;
     }
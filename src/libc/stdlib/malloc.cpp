@@ -32,6 +32,10 @@
 #include <cmsis-plus/rtos/os.h>
 #include <cmsis-plus/estd/memory_resource>
 
+#if defined(OS_USE_MEMORY_ALLOCATION_PROFILER)
+#include <cmsis-plus/memory/alloc-profiler.h>
+#endif
+
 #include <malloc.h>
 
 // ----------------------------------------------------------------------------
@@ -100,6 +104,10 @@ malloc (size_t bytes)
     {
       // ----- Begin of critical section --------------------------------------
       rtos::scheduler::critical_section scs;
+#if defined(OS_USE_MEMORY_ALLOCATION_PROFILER)
+      memory::alloc_profiler::call_site cs
+        { __builtin_return_address (0) };
+#endif
 
       errno = 0;
       mem = estd::pmr::get_default_resource ()->allocate (bytes);
@@ -173,6 +181,10 @@ calloc (size_t nelem, size_t elbytes)
     {
       // ----- Begin of critical section --------------------------------------
       rtos::scheduler::critical_section scs;
+#if defined(OS_USE_MEMORY_ALLOCATION_PROFILER)
+      memory::alloc_profiler::call_site cs
+        { __builtin_return_address (0) };
+#endif
 
       mem = estd::pmr::get_default_resource ()->allocate (nelem * elbytes);
 
@@ -267,6 +279,10 @@ realloc (void* ptr, size_t bytes)
     {
       // ----- Begin of critical section --------------------------------------
       rtos::scheduler::critical_section scs;
+#if defined(OS_USE_MEMORY_ALLOCATION_PROFILER)
+      memory::alloc_profiler::call_site cs
+        { __builtin_return_address (0) };
+#endif
 
       errno = 0;
       if (ptr == nullptr)
@@ -0,0 +1,137 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/estd/future>
+#include <cmsis-plus/estd/thread_pool>
+#include <cmsis-plus/diag/trace.h>
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace estd
+  {
+    // ========================================================================
+
+    using namespace os;
+
+    /**
+     * @cond ignore
+     */
+
+    using async_pool_type = thread_pool_inclusive<
+    OS_INTEGER_ESTD_ASYNC_POOL_WORKERS,
+    OS_INTEGER_ESTD_ASYNC_POOL_STACK_SIZE_BYTES>;
+
+    static thread_pool* async_pool = nullptr;
+
+    /**
+     * @endcond
+     */
+
+    /**
+     * @details
+     * Threads waiting for results of the previous pool are not
+     * affected; the previous pool is not destroyed.
+     */
+    thread_pool*
+    set_async_pool (thread_pool* pool) noexcept
+    {
+      trace::printf ("estd::%s(%p) \n", __func__, pool);
+
+      thread_pool* old = async_pool;
+      async_pool = pool;
+
+      return old;
+    }
+
+    /**
+     * @details
+     * The default pool is dynamically allocated once, and
+     * never destroyed.
+     *
+     * @warning Cannot be invoked from Interrupt Service Routines.
+     */
+    thread_pool*
+    get_async_pool (void)
+    {
+      if (async_pool == nullptr)
+        {
+          // Creating the threads may yield, so build it outside
+          // the critical section and discard it if another thread
+          // was faster.
+          thread_pool* pool = new async_pool_type
+            { "async" };
+            {
+              // ----- Enter critical section ---------------------------------
+              rtos::scheduler::critical_section scs;
+
+              if (async_pool == nullptr)
+                {
+                  async_pool = pool;
+                  pool = nullptr;
+                }
+              // ----- Exit critical section ----------------------------------
+            }
+
+          delete pool;
+        }
+
+      return async_pool;
+    }
+
+    namespace internal
+    {
+      // ======================================================================
+
+      /**
+       * @details
+       * Tasks launched from a worker of the pool are not queued,
+       * since the worker may block waiting for the result while
+       * the other workers are busy.
+       */
+      bool
+      async_enqueue (pool_task* task)
+      {
+        thread_pool* pool = get_async_pool ();
+
+        if (pool->internal_current_worker_ () != nullptr)
+          {
+            return false;
+          }
+
+        return pool->internal_enqueue_ (task);
+      }
+
+    } /* namespace internal */
+
+  // --------------------------------------------------------------------------
+
+  } /* namespace estd */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,499 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/estd/future>
+#include <cmsis-plus/memory/block-pool.h>
+#include <cmsis-plus/diag/trace.h>
+
+#include <cstdlib>
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace estd
+  {
+    // ========================================================================
+
+    using namespace os;
+
+    static const char*
+    future_errc_message (future_errc ec)
+    {
+      switch (ec)
+        {
+        case future_errc::broken_promise:
+          return "broken promise";
+
+        case future_errc::future_already_retrieved:
+          return "future already retrieved";
+
+        case future_errc::promise_already_satisfied:
+          return "promise already satisfied";
+
+        case future_errc::no_state:
+          return "no associated state";
+        }
+      return "unknown future error";
+    }
+
+#if defined(__EXCEPTIONS)
+
+    future_error::future_error (future_errc ec) :
+        std::logic_error (future_errc_message (ec)), //
+        code_ (ec)
+    {
+      ;
+    }
+
+    future_errc
+    future_error::code () const noexcept
+    {
+      return code_;
+    }
+
+#endif
+
+    namespace internal
+    {
+      void
+      throw_future_error (future_errc ec)
+      {
+#if defined(__EXCEPTIONS)
+        throw future_error (ec);
+#else
+        trace_printf ("future_error(%s)\n", future_errc_message (ec));
+        std::abort ();
+#endif
+      }
+
+    } /* namespace internal */
+
+    namespace pmr
+    {
+      // ======================================================================
+
+      /**
+       * @cond ignore
+       */
+
+#if OS_INTEGER_ESTD_FUTURE_POOL_BLOCKS > 0
+
+      /**
+       * @brief Memory resource for shared states, with fixed size
+       *  blocks.
+       * @details
+       * The states larger than the blocks, and the states allocated
+       * when the pool is exhausted, use the default resource.
+       */
+      class future_pool_resource : public memory_resource
+      {
+      public:
+
+        future_pool_resource ();
+
+        future_pool_resource (const future_pool_resource&) = delete;
+        future_pool_resource (future_pool_resource&&) = delete;
+        future_pool_resource&
+        operator= (const future_pool_resource&) = delete;
+        future_pool_resource&
+        operator= (future_pool_resource&&) = delete;
+
+        virtual
+        ~future_pool_resource () = default;
+
+      protected:
+
+        virtual void*
+        do_allocate (std::size_t bytes, std::size_t alignment) override;
+
+        virtual void
+        do_deallocate (void* addr, std::size_t bytes, std::size_t alignment)
+            noexcept override;
+
+      protected:
+
+        static constexpr std::size_t block_size_bytes = rtos::memory::align_size (
+        OS_INTEGER_ESTD_FUTURE_POOL_BLOCK_SIZE_BYTES,
+            alignof(std::max_align_t));
+
+        typename std::aligned_storage<block_size_bytes,
+            alignof(std::max_align_t)>::type arena_[OS_INTEGER_ESTD_FUTURE_POOL_BLOCKS];
+
+        os::memory::block_pool pool_;
+      };
+
+      future_pool_resource::future_pool_resource () :
+          memory_resource
+            { "future" }, //
+          pool_
+            { "future", OS_INTEGER_ESTD_FUTURE_POOL_BLOCKS, block_size_bytes,
+                arena_, sizeof(arena_) }
+      {
+        ;
+      }
+
+      void*
+      future_pool_resource::do_allocate (std::size_t bytes,
+                                         std::size_t alignment)
+      {
+        void* mem = nullptr;
+        if (bytes <= block_size_bytes && alignment <= alignof(std::max_align_t))
+          {
+            mem = pool_.allocate (bytes, alignment);
+          }
+
+        if (mem == nullptr)
+          {
+            // Too large, or no more blocks.
+            mem = get_default_resource ()->allocate (bytes, alignment);
+          }
+        return mem;
+      }
+
+      void
+      future_pool_resource::do_deallocate (void* addr, std::size_t bytes,
+                                           std::size_t alignment) noexcept
+      {
+        if (addr >= static_cast<void*> (&arena_[0])
+            && addr
+                < static_cast<void*> (&arena_[OS_INTEGER_ESTD_FUTURE_POOL_BLOCKS]))
+          {
+            pool_.deallocate (addr, bytes, alignment);
+          }
+        else
+          {
+            get_default_resource ()->deallocate (addr, bytes, alignment);
+          }
+      }
+
+#pragma GCC diagnostic push
+#if defined(__clang__)
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+#endif
+
+      // Not destructed, states may outlive static objects.
+      static std::aligned_storage<sizeof(future_pool_resource),
+          alignof(future_pool_resource)>::type future_pool_res;
+
+      static void
+      __attribute__((constructor))
+      __init (void)
+      {
+        new (&future_pool_res) future_pool_resource ();
+      }
+
+#pragma GCC diagnostic pop
+
+      static memory_resource* future_resource =
+          reinterpret_cast<memory_resource*> (&future_pool_res);
+
+#else
+
+      static memory_resource* future_resource = nullptr;
+
+#endif
+
+      /**
+       * @endcond
+       */
+
+      memory_resource*
+      set_future_resource (memory_resource* res) noexcept
+      {
+        trace::printf ("estd::pmr::%s(%p) \n", __func__, res);
+
+        memory_resource* old = future_resource;
+        future_resource = res;
+
+        return old;
+      }
+
+      memory_resource*
+      get_future_resource (void) noexcept
+      {
+        return future_resource;
+      }
+
+    } /* namespace pmr */
+
+    namespace internal
+    {
+      // ======================================================================
+
+      future_state_base::~future_state_base ()
+      {
+        ;
+      }
+
+      /**
+       * @details
+       * The shared states are allocated from the dedicated
+       * memory resource, under a scheduler critical section, like
+       * the global `operator new`; if there is no such resource,
+       * the global `operator new` is used.
+       *
+       * @warning Cannot be invoked from Interrupt Service Routines.
+       */
+      void*
+      future_state_base::operator new (std::size_t bytes)
+      {
+        assert(!rtos::interrupts::in_handler_mode ());
+
+        pmr::memory_resource* res = pmr::get_future_resource ();
+        if (res == nullptr)
+          {
+            return ::operator new (bytes);
+          }
+
+        void* mem;
+          {
+            // ----- Enter critical section -----------------------------------
+            rtos::scheduler::critical_section scs;
+
+            mem = res->allocate (bytes);
+            // ----- Exit critical section ------------------------------------
+          }
+
+        if (mem == nullptr)
+          {
+            __throw_bad_alloc ();
+          }
+        return mem;
+      }
+
+      void
+      future_state_base::operator delete (void* ptr, std::size_t bytes) noexcept
+      {
+        assert(!rtos::interrupts::in_handler_mode ());
+
+        pmr::memory_resource* res = pmr::get_future_resource ();
+        if (res == nullptr)
+          {
+            ::operator delete (ptr);
+            return;
+          }
+
+        // ----- Enter critical section ---------------------------------------
+        rtos::scheduler::critical_section scs;
+
+        res->deallocate (ptr, bytes);
+        // ----- Exit critical section ----------------------------------------
+      }
+
+      void
+      future_state_base::retain (void) noexcept
+      {
+        // ----- Enter critical section ---------------------------------------
+        rtos::scheduler::critical_section scs;
+
+        ++refs_;
+        // ----- Exit critical section ----------------------------------------
+      }
+
+      void
+      future_state_base::release (void) noexcept
+      {
+        bool last;
+          {
+            // ----- Enter critical section -----------------------------------
+            rtos::scheduler::critical_section scs;
+
+            last = (--refs_ == 0);
+            // ----- Exit critical section ------------------------------------
+          }
+
+        if (last)
+          {
+            delete this;
+          }
+      }
+
+      void
+      future_state_base::wait (void)
+      {
+        if (deferred_)
+          {
+            run_deferred ();
+          }
+
+        // The flag is never cleared, all waiting threads are released.
+        evf_.wait (ready_flag, nullptr, rtos::flags::mode::all);
+      }
+
+      /**
+       * @details
+       * Only the first waiting thread runs the deferred function;
+       * the other threads wait for it to complete.
+       */
+      void
+      future_state_base::run_deferred (void)
+      {
+          {
+            // ----- Enter critical section -----------------------------------
+            rtos::scheduler::critical_section scs;
+
+            if (!deferred_)
+              {
+                return;
+              }
+            deferred_ = false;
+            // ----- Exit critical section ------------------------------------
+          }
+
+        do_run_deferred ();
+      }
+
+      void
+      future_state_base::do_run_deferred (void)
+      {
+        ;
+      }
+
+      future_status
+      future_state_base::timed_wait (rtos::clock::duration_t ticks)
+      {
+        rtos::result_t res;
+        res = evf_.timed_wait (ready_flag, ticks, nullptr,
+                               rtos::flags::mode::all);
+        return
+            (res == rtos::result::ok) ?
+                future_status::ready : future_status::timeout;
+      }
+
+      void
+      future_state_base::retrieve (void)
+      {
+        bool already;
+          {
+            // ----- Enter critical section -----------------------------------
+            rtos::scheduler::critical_section scs;
+
+            already = retrieved_;
+            retrieved_ = true;
+            // ----- Exit critical section ------------------------------------
+          }
+
+        if (already)
+          {
+            throw_future_error (future_errc::future_already_retrieved);
+          }
+      }
+
+      void
+      future_state_base::satisfy (void)
+      {
+        bool already;
+          {
+            // ----- Enter critical section -----------------------------------
+            rtos::scheduler::critical_section scs;
+
+            already = satisfied_;
+            satisfied_ = true;
+            // ----- Exit critical section ------------------------------------
+          }
+
+        if (already)
+          {
+            throw_future_error (future_errc::promise_already_satisfied);
+          }
+      }
+
+      void
+      future_state_base::make_ready (void) noexcept
+      {
+        evf_.raise (ready_flag);
+      }
+
+      /**
+       * @details
+       * Called when the provider is destroyed; if no result was
+       * stored, the state is marked as broken and made ready,
+       * so waiting threads do not block forever.
+       */
+      void
+      future_state_base::abandon (void) noexcept
+      {
+        bool broken;
+          {
+            // ----- Enter critical section -----------------------------------
+            rtos::scheduler::critical_section scs;
+
+            broken = !satisfied_;
+            satisfied_ = true;
+            // ----- Exit critical section ------------------------------------
+          }
+
+        if (broken)
+          {
+            broken_ = true;
+            make_ready ();
+          }
+      }
+
+      /**
+       * @details
+       * Called after the state is ready, before accessing the value;
+       * report a broken promise or rethrow the stored exception.
+       */
+      void
+      future_state_base::check (void)
+      {
+        if (broken_)
+          {
+            throw_future_error (future_errc::broken_promise);
+          }
+
+#if defined(__EXCEPTIONS)
+        if (exception_)
+          {
+            std::rethrow_exception (exception_);
+          }
+#endif
+      }
+
+#if defined(__EXCEPTIONS)
+
+      void
+      future_state_base::set_exception (std::exception_ptr p)
+      {
+        satisfy ();
+        exception_ = p;
+        make_ready ();
+      }
+
+#endif
+
+    } /* namespace internal */
+
+  // --------------------------------------------------------------------------
+
+  } /* namespace estd */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
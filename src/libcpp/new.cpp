@@ -41,6 +41,10 @@
 #include <cmsis-plus/rtos/os.h>
 #include <cmsis-plus/estd/memory_resource>
 
+#if defined(OS_USE_MEMORY_ALLOCATION_PROFILER)
+#include <cmsis-plus/memory/alloc-profiler.h>
+#endif
+
 // ----------------------------------------------------------------------------
 
 using namespace os;
@@ -155,6 +159,10 @@ operator new (std::size_t bytes)
 
   // ----- Begin of critical section ------------------------------------------
   rtos::scheduler::critical_section scs;
+#if defined(OS_USE_MEMORY_ALLOCATION_PROFILER)
+  memory::alloc_profiler::call_site cs
+    { __builtin_return_address (0) };
+#endif
 
   while (true)
     {
@@ -219,6 +227,10 @@ operator new (std::size_t bytes,
 
   // ----- Begin of critical section ------------------------------------------
   rtos::scheduler::critical_section scs;
+#if defined(OS_USE_MEMORY_ALLOCATION_PROFILER)
+  memory::alloc_profiler::call_site cs
+    { __builtin_return_address (0) };
+#endif
 
   while (true)
     {
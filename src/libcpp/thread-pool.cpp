@@ -0,0 +1,411 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/estd/thread_pool>
+#include <cmsis-plus/diag/trace.h>
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace estd
+  {
+    // ========================================================================
+
+    using namespace os;
+
+    /**
+     * @class thread_pool
+     * @details
+     * The queues are protected by short scheduler critical
+     * sections; on single core devices this is cheaper than
+     * lock free deques and keeps the stealing logic simple.
+     */
+
+    thread_pool::thread_pool (const char* name, worker_s* workers,
+                              size_type count, internal::pool_task** slots,
+                              size_type depth) :
+        name_ (name), //
+        workers_ (workers), //
+        count_ (count), //
+        depth_ (depth), //
+        evf_
+          { name }
+    {
+#if defined(OS_TRACE_LIBCPP_THREAD_POOL)
+      trace::printf ("%s() @%p %s %u workers\n", __func__, this, name_,
+                     static_cast<unsigned int> (count_));
+#endif
+
+      for (size_type i = 0; i < count_; ++i)
+        {
+          worker_s* w = &workers_[i];
+          w->pool = this;
+          w->thread = nullptr;
+          w->slots = &slots[i * depth_];
+          w->head = 0;
+          w->count = 0;
+          w->flag = (static_cast<rtos::flags::mask_t> (1) << i);
+          w->parked = false;
+        }
+    }
+
+    thread_pool::~thread_pool ()
+    {
+#if defined(OS_TRACE_LIBCPP_THREAD_POOL)
+      trace::printf ("%s() @%p %s\n", __func__, this, name_);
+#endif
+
+      // The derived class must stop the workers before
+      // destroying their threads.
+      assert(stopping_);
+    }
+
+    /**
+     * @details
+     * Ask the workers to terminate after the queues are emptied,
+     * and wait for all of them to finish.
+     */
+    void
+    thread_pool::internal_stop_ (void)
+    {
+        {
+          // ----- Enter critical section -------------------------------------
+          rtos::scheduler::critical_section scs;
+
+          stopping_ = true;
+          // ----- Exit critical section --------------------------------------
+        }
+
+      evf_.raise (rtos::flags::all);
+
+      for (size_type i = 0; i < count_; ++i)
+        {
+          workers_[i].thread->join ();
+        }
+    }
+
+    void*
+    thread_pool::internal_worker_ (void* args)
+    {
+      worker_s* w = static_cast<worker_s*> (args);
+      thread_pool* pool = w->pool;
+
+      w->thread = &rtos::this_thread::thread ();
+
+      for (;;)
+        {
+          internal::pool_task* task = pool->internal_pop_ (w);
+          if (task == nullptr)
+            {
+              task = pool->internal_steal_ (w);
+            }
+
+          if (task != nullptr)
+            {
+              task->run ();
+              continue;
+            }
+
+            {
+              // ----- Enter critical section ---------------------------------
+              rtos::scheduler::critical_section scs;
+
+              if (pool->stopping_)
+                {
+                  break;
+                }
+
+              w->parked = true;
+              ++pool->idle_;
+              // ----- Exit critical section ----------------------------------
+            }
+
+          // A flag raised after the queues were checked is not lost,
+          // it remains set and the wait returns immediately.
+          pool->evf_.wait (w->flag | steal_flag, nullptr,
+                           rtos::flags::mode::any | rtos::flags::mode::clear);
+
+          pool->internal_unpark_ (w);
+        }
+
+      return nullptr;
+    }
+
+    void
+    thread_pool::internal_unpark_ (worker_s* w)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      if (w->parked)
+        {
+          w->parked = false;
+          --idle_;
+        }
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /**
+     * @details
+     * Must be called with the scheduler locked.
+     */
+    bool
+    thread_pool::internal_push_ (worker_s* w, internal::pool_task* task)
+    {
+      if (w->count >= depth_)
+        {
+          return false;
+        }
+
+      w->slots[(w->head + w->count) % depth_] = task;
+      ++w->count;
+
+      return true;
+    }
+
+    /**
+     * @details
+     * The owner takes the most recently queued task (LIFO).
+     */
+    internal::pool_task*
+    thread_pool::internal_pop_ (worker_s* w)
+    {
+      internal::pool_task* task = nullptr;
+      bool wake = false;
+        {
+          // ----- Enter critical section -------------------------------------
+          rtos::scheduler::critical_section scs;
+
+          if (w->count > 0)
+            {
+              --w->count;
+              task = w->slots[(w->head + w->count) % depth_];
+
+              // Tasks left behind; let a parked peer steal them.
+              wake = (w->count > 0 && idle_ > 0);
+            }
+          // ----- Exit critical section --------------------------------------
+        }
+
+      if (wake)
+        {
+          evf_.raise (steal_flag);
+        }
+      return task;
+    }
+
+    /**
+     * @details
+     * Thieves take the oldest task (FIFO) from the first
+     * non empty queue, starting with the next worker.
+     */
+    internal::pool_task*
+    thread_pool::internal_steal_ (worker_s* w)
+    {
+      size_type self = static_cast<size_type> (w - workers_);
+
+      for (size_type k = 1; k < count_; ++k)
+        {
+          worker_s* victim = &workers_[(self + k) % count_];
+
+          internal::pool_task* task = nullptr;
+          bool wake = false;
+            {
+              // ----- Enter critical section ---------------------------------
+              rtos::scheduler::critical_section scs;
+
+              if (victim->count > 0)
+                {
+                  task = victim->slots[victim->head];
+                  victim->head = (victim->head + 1) % depth_;
+                  --victim->count;
+
+                  wake = (victim->count > 0 && idle_ > 0);
+                }
+              // ----- Exit critical section ----------------------------------
+            }
+
+          if (task != nullptr)
+            {
+              if (wake)
+                {
+                  evf_.raise (steal_flag);
+                }
+              return task;
+            }
+        }
+
+      return nullptr;
+    }
+
+    thread_pool::worker_s*
+    thread_pool::internal_current_worker_ (void)
+    {
+      rtos::thread* th = &rtos::this_thread::thread ();
+      for (size_type i = 0; i < count_; ++i)
+        {
+          if (workers_[i].thread == th)
+            {
+              return &workers_[i];
+            }
+        }
+      return nullptr;
+    }
+
+    /**
+     * @details
+     * Tasks queued by a worker (the `parallel_for()` helpers) go
+     * to its own queue; tasks queued by other threads go preferably
+     * to a parked worker, otherwise to the next queue with free
+     * space, in round robin order.
+     *
+     * @return `false` if all queues are full.
+     */
+    bool
+    thread_pool::internal_enqueue_ (internal::pool_task* task)
+    {
+      worker_s* self = internal_current_worker_ ();
+
+      rtos::flags::mask_t wake = 0;
+        {
+          // ----- Enter critical section -------------------------------------
+          rtos::scheduler::critical_section scs;
+
+          if (stopping_)
+            {
+              return false;
+            }
+
+          if (self != nullptr && internal_push_ (self, task))
+            {
+              if (idle_ > 0)
+                {
+                  wake = steal_flag;
+                }
+            }
+          else
+            {
+              worker_s* target = nullptr;
+              for (int pass = 0; pass < 2 && target == nullptr; ++pass)
+                {
+                  for (size_type k = 0; k < count_; ++k)
+                    {
+                      worker_s* w = &workers_[(next_ + k) % count_];
+                      if ((pass > 0 || w->parked) && internal_push_ (w, task))
+                        {
+                          target = w;
+                          break;
+                        }
+                    }
+                }
+
+              if (target == nullptr)
+                {
+                  return false;
+                }
+
+              next_ = (static_cast<size_type> (target - workers_) + 1)
+                  % count_;
+
+              if (target->parked)
+                {
+                  // Do not select it again before it wakes up.
+                  target->parked = false;
+                  --idle_;
+                }
+              wake = target->flag;
+            }
+          // ----- Exit critical section --------------------------------------
+        }
+
+      if (wake != 0)
+        {
+          evf_.raise (wake);
+        }
+      return true;
+    }
+
+    /**
+     * @details
+     * Remove all occurrences of the task from the queues.
+     *
+     * @return The number of removed entries.
+     */
+    thread_pool::size_type
+    thread_pool::internal_revoke_ (internal::pool_task* task)
+    {
+      size_type removed = 0;
+
+      for (size_type i = 0; i < count_; ++i)
+        {
+          worker_s* w = &workers_[i];
+
+          // ----- Enter critical section -------------------------------------
+          rtos::scheduler::critical_section scs;
+
+          size_type kept = 0;
+          for (size_type k = 0; k < w->count; ++k)
+            {
+              internal::pool_task* t = w->slots[(w->head + k) % depth_];
+              if (t != task)
+                {
+                  w->slots[(w->head + kept) % depth_] = t;
+                  ++kept;
+                }
+            }
+          removed += (w->count - kept);
+          w->count = kept;
+          // ----- Exit critical section --------------------------------------
+        }
+
+      return removed;
+    }
+
+    thread_pool::size_type
+    thread_pool::pending (void) const noexcept
+    {
+      size_type n = 0;
+        {
+          // ----- Enter critical section -------------------------------------
+          rtos::scheduler::critical_section scs;
+
+          for (size_type i = 0; i < count_; ++i)
+            {
+              n += workers_[i].count;
+            }
+          // ----- Exit critical section --------------------------------------
+        }
+      return n;
+    }
+
+  // --------------------------------------------------------------------------
+
+  } /* namespace estd */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,544 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/memory/alloc-profiler.h>
+#include <memory>
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace memory
+  {
+
+    /**
+     * @cond ignore
+     */
+
+    namespace
+    {
+      enum
+        : int
+          {
+            key_bytes, key_count, key_lifetime
+      };
+
+      inline std::size_t
+      hash (const void* addr, std::size_t capacity)
+      {
+        uint32_t h =
+            static_cast<uint32_t> (reinterpret_cast<std::uintptr_t> (addr) >> 2);
+        // Knuth multiplicative hash.
+        h *= 2654435761u;
+        return (h ^ (h >> 16)) % capacity;
+      }
+
+    } /* namespace */
+
+    /**
+     * @endcond
+     */
+
+    // ========================================================================
+
+    const void* alloc_profiler::call_site::address_;
+
+    // ========================================================================
+
+    /**
+     * @details
+     * The arena holds the live allocations table, the call sites
+     * table and a scratch array used by `dump()`. Use `arena_size()`
+     * to compute the required size.
+     *
+     * The live allocations table is kept at most 7/8 full, to
+     * limit the length of the probe sequences.
+     */
+    alloc_profiler::alloc_profiler (const char* name,
+                                    rtos::memory::memory_resource* upstream,
+                                    std::size_t live, std::size_t sites,
+                                    void* addr, std::size_t bytes) :
+        rtos::memory::memory_resource
+          { name }
+    {
+      trace::printf ("%s(%p,%u,%u,%p,%u) @%p %s\n", __func__, upstream, live,
+                     sites, addr, bytes, this, this->name ());
+
+      assert(upstream != nullptr);
+      assert(live > 0);
+      assert(sites > 0);
+      assert(addr != nullptr);
+
+      upstream_ = upstream;
+
+      std::size_t sz = bytes;
+      void* p = addr;
+
+      p = std::align (alignof(live_s), live * sizeof(live_s), p, sz);
+      assert(p != nullptr);
+      live_ = static_cast<live_s*> (p);
+      p = static_cast<char*> (p) + live * sizeof(live_s);
+      sz -= live * sizeof(live_s);
+
+      p = std::align (alignof(site_s), sites * sizeof(site_s), p, sz);
+      assert(p != nullptr);
+      sites_ = static_cast<site_s*> (p);
+      p = static_cast<char*> (p) + sites * sizeof(site_s);
+      sz -= sites * sizeof(site_s);
+
+      p = std::align (alignof(site_s*), sites * sizeof(site_s*), p, sz);
+      // If there is not enough space for all tables, fail.
+      assert(p != nullptr);
+      order_ = static_cast<site_s**> (p);
+
+      live_capacity_ = live;
+      sites_capacity_ = sites;
+
+      std::memset (live_, 0, live * sizeof(live_s));
+      std::memset (sites_, 0, sites * sizeof(site_s));
+
+      internal_sync_statistics_ ();
+    }
+
+    /**
+     * @details
+     */
+    alloc_profiler::~alloc_profiler ()
+    {
+      trace::printf ("%s() @%p %s\n", __func__, this, this->name ());
+    }
+
+    /**
+     * @details
+     * The result includes the alignment padding.
+     */
+    std::size_t
+    alloc_profiler::arena_size (std::size_t live, std::size_t sites)
+    {
+      std::size_t bytes = live * sizeof(live_s) + alignof(live_s) - 1;
+      bytes = rtos::memory::align_size (bytes, alignof(site_s));
+      bytes += sites * sizeof(site_s);
+      bytes = rtos::memory::align_size (bytes, alignof(site_s*));
+      bytes += sites * sizeof(site_s*);
+
+      return bytes;
+    }
+
+    /**
+     * @details
+     * The call site is the `call_site` hint, if set, otherwise
+     * the return address of this function, which is in the
+     * code that called `allocate()`.
+     */
+    void*
+    alloc_profiler::do_allocate (std::size_t bytes, std::size_t alignment)
+    {
+      const void* caller = call_site::address ();
+      if (caller == nullptr)
+        {
+          caller = __builtin_return_address (0);
+        }
+
+      void* p = upstream_->allocate (bytes, alignment);
+
+      if (p == nullptr)
+        {
+          internal_sync_statistics_ ();
+          if (out_of_memory_handler_ != nullptr)
+            {
+              out_of_memory_handler_ ();
+            }
+          return nullptr;
+        }
+
+      // Update statistics.
+      allocated_bytes_ += bytes;
+      if (allocated_bytes_ > max_allocated_bytes_)
+        {
+          max_allocated_bytes_ = allocated_bytes_;
+        }
+      ++allocated_chunks_;
+      internal_sync_statistics_ ();
+
+      site_s* site = internal_find_site_ (caller);
+      if (site == nullptr
+          || live_count_ >= live_capacity_ - live_capacity_ / 8)
+        {
+          ++untracked_;
+          return p;
+        }
+
+      timestamp_t now = rtos::sysclock.now ();
+
+      std::size_t ix = hash (p, live_capacity_);
+      while (live_[ix].addr != nullptr)
+        {
+          ix = (ix + 1) % live_capacity_;
+        }
+
+      live_[ix].addr = p;
+      live_[ix].bytes = bytes;
+      live_[ix].since = now;
+      live_[ix].site = site;
+      ++live_count_;
+
+      // Keep a copy, the thread may be gone at dump time.
+      const char* th_name =
+          (rtos::scheduler::started () && !rtos::interrupts::in_handler_mode ()) ?
+              rtos::this_thread::thread ().name () : "-";
+      std::strncpy (site->thread_name, th_name, thread_name_size - 1);
+      site->thread_name[thread_name_size - 1] = '\0';
+
+      site->live_bytes += bytes;
+      if (site->live_bytes > site->max_live_bytes)
+        {
+          site->max_live_bytes = site->live_bytes;
+        }
+      ++site->live_count;
+      ++site->allocations;
+      site->live_since += now;
+
+      return p;
+    }
+
+    /**
+     * @details
+     * The size is taken from the live allocations table, so it
+     * may be 0 if unknown, as for `operator delete`.
+     */
+    void
+    alloc_profiler::do_deallocate (void* addr, std::size_t bytes,
+                                   std::size_t alignment) noexcept
+    {
+      live_s* entry = internal_find_live_ (addr);
+      if (entry != nullptr)
+        {
+          bytes = entry->bytes;
+
+          site_s* site = entry->site;
+          site->live_bytes -= entry->bytes;
+          --site->live_count;
+          site->live_since -= entry->since;
+          site->freed_lifetime += rtos::sysclock.now () - entry->since;
+
+          internal_remove_live_ (entry);
+        }
+
+      upstream_->deallocate (addr, bytes, alignment);
+
+      // Update statistics; the size of untracked blocks may be unknown.
+      allocated_bytes_ -= (bytes <= allocated_bytes_) ? bytes : allocated_bytes_;
+      if (allocated_chunks_ > 0)
+        {
+          --allocated_chunks_;
+        }
+      internal_sync_statistics_ ();
+    }
+
+    /**
+     * @details
+     */
+    std::size_t
+    alloc_profiler::do_max_size (void) const noexcept
+    {
+      return upstream_->max_size ();
+    }
+
+    /**
+     * @details
+     * Reset the upstream resource and forget all allocations.
+     */
+    void
+    alloc_profiler::do_reset (void) noexcept
+    {
+#if defined(OS_TRACE_LIBCPP_MEMORY_RESOURCE)
+      trace::printf ("%s() @%p %s\n", __func__, this, name ());
+#endif
+
+      upstream_->reset ();
+
+      std::memset (live_, 0, live_capacity_ * sizeof(live_s));
+      std::memset (sites_, 0, sites_capacity_ * sizeof(site_s));
+
+      live_count_ = 0;
+      sites_count_ = 0;
+      untracked_ = 0;
+
+      allocated_bytes_ = 0;
+      allocated_chunks_ = 0;
+      internal_sync_statistics_ ();
+    }
+
+    /**
+     * @details
+     */
+    bool
+    alloc_profiler::do_coalesce (void) noexcept
+    {
+      bool ret = upstream_->coalesce ();
+      internal_sync_statistics_ ();
+
+      return ret;
+    }
+
+    /**
+     * @details
+     * The call sites keep the live allocations; only the
+     * cumulative counters are restarted.
+     */
+    void
+    alloc_profiler::clear (void)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      for (std::size_t i = 0; i < sites_capacity_; ++i)
+        {
+          site_s* site = &sites_[i];
+          site->allocations = site->live_count;
+          site->max_live_bytes = site->live_bytes;
+          site->freed_lifetime = 0;
+        }
+      untracked_ = 0;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /**
+     * @details
+     * Print three lists, with the top call sites by live bytes,
+     * by number of allocations and by average lifetime. Each
+     * line has the caller address, the live bytes, the live
+     * blocks, the max live bytes, the number of allocations,
+     * the average lifetime in ticks, and the name of the thread
+     * which did the last allocation.
+     *
+     * The addresses can be converted to source lines with
+     * `addr2line -f -e application.elf`.
+     */
+    void
+    alloc_profiler::dump (std::size_t top)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      timestamp_t now = rtos::sysclock.now ();
+
+      trace::printf ("# alloc-profiler %s sites=%u live=%u untracked=%u\n",
+                     name (), static_cast<unsigned int> (sites_count_),
+                     static_cast<unsigned int> (live_count_),
+                     static_cast<unsigned int> (untracked_));
+
+      internal_dump_sorted_ ("bytes", top, key_bytes, now);
+      internal_dump_sorted_ ("count", top, key_count, now);
+      internal_dump_sorted_ ("lifetime", top, key_lifetime, now);
+
+      trace::printf ("# end\n");
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /**
+     * @cond ignore
+     */
+
+    alloc_profiler::site_s*
+    alloc_profiler::internal_find_site_ (const void* caller)
+    {
+      std::size_t ix = hash (caller, sites_capacity_);
+      for (std::size_t i = 0; i < sites_capacity_; ++i)
+        {
+          site_s* site = &sites_[ix];
+          if (site->caller == caller)
+            {
+              return site;
+            }
+          if (site->caller == nullptr)
+            {
+              site->caller = caller;
+              ++sites_count_;
+              return site;
+            }
+          ix = (ix + 1) % sites_capacity_;
+        }
+
+      // Table full.
+      return nullptr;
+    }
+
+    alloc_profiler::live_s*
+    alloc_profiler::internal_find_live_ (void* addr)
+    {
+      if (addr == nullptr)
+        {
+          return nullptr;
+        }
+
+      std::size_t ix = hash (addr, live_capacity_);
+      while (live_[ix].addr != nullptr)
+        {
+          if (live_[ix].addr == addr)
+            {
+              return &live_[ix];
+            }
+          ix = (ix + 1) % live_capacity_;
+        }
+
+      return nullptr;
+    }
+
+    /*
+     * Backward shift deletion; the entries that follow in the
+     * same cluster are moved back, if this does not place them
+     * before their home slot, so no tombstones are needed.
+     */
+    void
+    alloc_profiler::internal_remove_live_ (live_s* entry)
+    {
+      std::size_t i = static_cast<std::size_t> (entry - live_);
+      std::size_t j = i;
+      while (true)
+        {
+          j = (j + 1) % live_capacity_;
+          if (live_[j].addr == nullptr)
+            {
+              break;
+            }
+          std::size_t k = hash (live_[j].addr, live_capacity_);
+          // Keep the entry if its home is cyclically in (i, j].
+          if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j))
+            {
+              continue;
+            }
+          live_[i] = live_[j];
+          i = j;
+        }
+
+      live_[i].addr = nullptr;
+      --live_count_;
+    }
+
+    alloc_profiler::timestamp_t
+    alloc_profiler::internal_value_ (const site_s* site, int key,
+                                     timestamp_t now) const
+    {
+      switch (key)
+        {
+        case key_bytes:
+          return site->live_bytes;
+
+        case key_count:
+          return site->allocations;
+
+        default:
+          return internal_average_lifetime_ (site, now);
+        }
+    }
+
+    alloc_profiler::timestamp_t
+    alloc_profiler::internal_average_lifetime_ (const site_s* site,
+                                                timestamp_t now) const
+    {
+      if (site->allocations == 0)
+        {
+          return 0;
+        }
+
+      // The live blocks contribute their current age.
+      timestamp_t lifetime = site->freed_lifetime + site->live_count * now
+          - site->live_since;
+      return lifetime / site->allocations;
+    }
+
+    void
+    alloc_profiler::internal_dump_sorted_ (const char* title, std::size_t top,
+                                           int key, timestamp_t now)
+    {
+      trace::printf ("# by %s\n", title);
+
+      std::size_t n = 0;
+      for (std::size_t i = 0; i < sites_capacity_; ++i)
+        {
+          if (sites_[i].caller != nullptr)
+            {
+              order_[n++] = &sites_[i];
+            }
+        }
+
+      // Partial selection sort, only the first entries are needed.
+      if (top > n)
+        {
+          top = n;
+        }
+      for (std::size_t i = 0; i < top; ++i)
+        {
+          std::size_t max = i;
+          for (std::size_t j = i + 1; j < n; ++j)
+            {
+              if (internal_value_ (order_[j], key, now)
+                  > internal_value_ (order_[max], key, now))
+                {
+                  max = j;
+                }
+            }
+          site_s* tmp = order_[i];
+          order_[i] = order_[max];
+          order_[max] = tmp;
+
+          const site_s* site = order_[i];
+          trace::printf (
+              "%08X %u %u %u %u %u %s\n",
+              static_cast<unsigned int> (reinterpret_cast<std::uintptr_t> (site->caller)),
+              static_cast<unsigned int> (site->live_bytes),
+              static_cast<unsigned int> (site->live_count),
+              static_cast<unsigned int> (site->max_live_bytes),
+              static_cast<unsigned int> (site->allocations),
+              static_cast<unsigned int> (internal_average_lifetime_ (site,
+                                                                     now)),
+              site->thread_name);
+        }
+    }
+
+    /*
+     * The free space is the one of the upstream resource.
+     */
+    void
+    alloc_profiler::internal_sync_statistics_ (void)
+    {
+      total_bytes_ = upstream_->total_bytes ();
+      free_bytes_ = upstream_->free_bytes ();
+      free_chunks_ = upstream_->free_chunks ();
+    }
+
+    /**
+     * @endcond
+     */
+
+  // --------------------------------------------------------------------------
+  } /* namespace memory */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
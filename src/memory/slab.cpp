@@ -0,0 +1,285 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/memory/slab.h>
+#include <cmsis-plus/rtos/os.h>
+#include <memory>
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace memory
+  {
+
+    // ========================================================================
+
+    /**
+     * @details
+     * The arena starts with the per class data and the
+     * `block_pool` objects, followed by the blocks of each class,
+     * aligned to `alignof(std::max_align_t)`. Use `arena_size()`
+     * to compute the required size.
+     */
+    slab::slab (const char* name, const size_class* classes,
+                std::size_t count, void* addr, std::size_t bytes,
+                rtos::memory::memory_resource* upstream) :
+        rtos::memory::memory_resource
+          { name }
+    {
+      trace::printf ("%s(%p,%u,%p,%u,%p) @%p %s\n", __func__, classes, count,
+                     addr, bytes, upstream, this, this->name ());
+
+      assert(classes != nullptr);
+      assert(count > 0);
+      assert(addr != nullptr);
+
+      upstream_ = upstream;
+      count_ = count;
+
+      std::size_t sz = bytes;
+      void* p = addr;
+      p = std::align (alignof(pool_s), count * sizeof(pool_s), p, sz);
+      assert(p != nullptr);
+
+      pools_ = static_cast<pool_s*> (p);
+      p = static_cast<char*> (p) + count * sizeof(pool_s);
+      sz -= count * sizeof(pool_s);
+
+      for (std::size_t i = 0; i < count; ++i)
+        {
+          assert(i == 0
+              || classes[i].block_size_bytes > classes[i - 1].block_size_bytes);
+
+          p = std::align (alignof(block_pool), sizeof(block_pool), p, sz);
+          assert(p != nullptr);
+
+          block_pool* pool = static_cast<block_pool*> (p);
+          p = static_cast<char*> (p) + sizeof(block_pool);
+          sz -= sizeof(block_pool);
+
+          std::size_t block_size_bytes = rtos::memory::align_size (
+              classes[i].block_size_bytes, alignof(std::max_align_t));
+          std::size_t pool_bytes = classes[i].blocks * block_size_bytes;
+
+          p = std::align (alignof(std::max_align_t), pool_bytes, p, sz);
+          // If there is not enough space for all classes, fail.
+          assert(p != nullptr);
+
+          new (pool) block_pool
+            { this->name (), classes[i].blocks, block_size_bytes, p, pool_bytes };
+
+          pools_[i].pool = pool;
+          pools_[i].block_size_bytes = block_size_bytes;
+          pools_[i].begin = static_cast<char*> (p);
+          pools_[i].end = static_cast<char*> (p) + pool_bytes;
+
+          p = static_cast<char*> (p) + pool_bytes;
+          sz -= pool_bytes;
+
+          total_bytes_ += pool_bytes;
+          free_chunks_ += classes[i].blocks;
+        }
+
+      free_bytes_ = total_bytes_;
+    }
+
+    /**
+     * @details
+     */
+    slab::~slab ()
+    {
+      trace::printf ("%s() @%p %s\n", __func__, this, this->name ());
+
+      for (std::size_t i = 0; i < count_; ++i)
+        {
+          pools_[i].pool->~block_pool ();
+        }
+    }
+
+    /**
+     * @details
+     * The result includes the alignment padding, assuming the
+     * arena itself is aligned to `alignof(std::max_align_t)`.
+     */
+    std::size_t
+    slab::arena_size (const size_class* classes, std::size_t count)
+    {
+      std::size_t bytes = rtos::memory::align_size (count * sizeof(pool_s),
+                                                    alignof(block_pool));
+      for (std::size_t i = 0; i < count; ++i)
+        {
+          bytes = rtos::memory::align_size (bytes + sizeof(block_pool),
+                                            alignof(std::max_align_t));
+          bytes += classes[i].blocks
+              * rtos::memory::align_size (classes[i].block_size_bytes,
+                                          alignof(std::max_align_t));
+        }
+
+      return bytes;
+    }
+
+    /**
+     * @details
+     * Try the smallest class that fits, then the larger ones,
+     * then the upstream resource.
+     */
+    void*
+    slab::do_allocate (std::size_t bytes, std::size_t alignment)
+    {
+      void* p = nullptr;
+
+      if (alignment <= alignof(std::max_align_t))
+        {
+          for (std::size_t i = 0; i < count_; ++i)
+            {
+              if (bytes <= pools_[i].block_size_bytes)
+                {
+                  p = pools_[i].pool->allocate (bytes, alignment);
+                  if (p != nullptr)
+                    {
+                      // Update statistics.
+                      internal_increase_allocated_statistics (
+                          pools_[i].block_size_bytes);
+                      break;
+                    }
+                }
+            }
+        }
+
+      if (p == nullptr && upstream_ != nullptr)
+        {
+          p = upstream_->allocate (bytes, alignment);
+        }
+
+      if (p == nullptr && out_of_memory_handler_ != nullptr)
+        {
+          out_of_memory_handler_ ();
+        }
+
+#if defined(OS_TRACE_LIBCPP_MEMORY_RESOURCE)
+      trace::printf ("%s(%u,%u)=%p @%p %s\n", __func__, bytes, alignment, p,
+                     this, name ());
+#endif
+
+      return p;
+    }
+
+    /**
+     * @details
+     * The pool is identified by the address, so the size is not used.
+     */
+    void
+    slab::do_deallocate (void* addr, std::size_t bytes,
+                         std::size_t alignment) noexcept
+    {
+#if defined(OS_TRACE_LIBCPP_MEMORY_RESOURCE)
+      trace::printf ("%s(%p,%u,%u) @%p %s\n", __func__, addr, bytes, alignment,
+                     this, name ());
+#endif
+
+      for (std::size_t i = 0; i < count_; ++i)
+        {
+          if (addr >= pools_[i].begin && addr < pools_[i].end)
+            {
+              pools_[i].pool->deallocate (addr, pools_[i].block_size_bytes,
+                                          alignment);
+
+              // Update statistics.
+              internal_decrease_allocated_statistics (
+                  pools_[i].block_size_bytes);
+              return;
+            }
+        }
+
+      if (upstream_ != nullptr)
+        {
+          upstream_->deallocate (addr, bytes, alignment);
+          return;
+        }
+
+      assert(false);
+    }
+
+    /**
+     * @details
+     */
+    std::size_t
+    slab::do_max_size (void) const noexcept
+    {
+      if (upstream_ != nullptr)
+        {
+          return upstream_->max_size ();
+        }
+
+      return pools_[count_ - 1].block_size_bytes;
+    }
+
+    /**
+     * @details
+     * Only the pools are reset; the upstream resource is not affected.
+     */
+    void
+    slab::do_reset (void) noexcept
+    {
+#if defined(OS_TRACE_LIBCPP_MEMORY_RESOURCE)
+      trace::printf ("%s() @%p %s\n", __func__, this, name ());
+#endif
+
+      free_chunks_ = 0;
+      for (std::size_t i = 0; i < count_; ++i)
+        {
+          pools_[i].pool->reset ();
+          free_chunks_ += static_cast<std::size_t> (pools_[i].end
+              - pools_[i].begin) / pools_[i].block_size_bytes;
+        }
+
+      allocated_bytes_ = 0;
+      allocated_chunks_ = 0;
+      free_bytes_ = total_bytes_;
+    }
+
+    /**
+     * @details
+     * The pools do not fragment; forward the request upstream.
+     */
+    bool
+    slab::do_coalesce (void) noexcept
+    {
+      if (upstream_ != nullptr)
+        {
+          return upstream_->coalesce ();
+        }
+
+      return false;
+    }
+
+  // --------------------------------------------------------------------------
+  } /* namespace memory */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
@@ -165,6 +165,25 @@ __posix_writev (int fildes, const struct iovec* iov, int iovcnt)
   return io->writev (iov, iovcnt);
 }
 
+/**
+ * @details
+ * Transfer the bytes between the two objects, without passing
+ * them through a user buffer; if the input object can
+ * expose its content directly, the bytes are copied only once.
+ */
+ssize_t
+__posix_sendfile (int out_fd, int in_fd, off_t* offset, size_t count)
+{
+  auto* const out = posix::file_descriptors_manager::io (out_fd);
+  auto* const in = posix::file_descriptors_manager::io (in_fd);
+  if ((out == nullptr) || (in == nullptr))
+    {
+      errno = EBADF;
+      return -1;
+    }
+  return posix::sendfile (out, in, offset, count);
+}
+
 int
 __posix_ioctl (int fildes, int request, ...)
 {
@@ -302,6 +321,39 @@ __posix_fsync (int fildes)
   return (static_cast<posix::file*> (io))->fsync ();
 }
 
+/**
+ * @details
+ * The `mmap()` function shall establish a mapping between the
+ * address space of the process and a file. The _addr_ hint is
+ * ignored; `MAP_FIXED` is not supported.
+ */
+void*
+__posix_mmap (void* addr __attribute__((unused)), size_t len, int prot,
+              int flags, int fildes, off_t off)
+{
+  auto* const io = posix::file_descriptors_manager::io (fildes);
+  if (io == nullptr)
+    {
+      errno = EBADF;
+      return MAP_FAILED;
+    }
+
+  // Works only on files (Does not work on sockets, pipes or FIFOs...)
+  if ((io->get_type () & posix::io::type::file) == 0)
+    {
+      errno = ENODEV; // Not a file.
+      return MAP_FAILED;
+    }
+
+  return (static_cast<posix::file*> (io))->mmap (len, prot, flags, off);
+}
+
+int
+__posix_munmap (void* addr, size_t len)
+{
+  return posix::file::munmap (addr, len);
+}
+
 // ----------------------------------------------------------------------------
 // ----- POSIX file functions -----
 
@@ -440,14 +492,24 @@ __posix_socket (int domain, int type, int protocol)
   return sock->file_descriptor ();
 }
 
-#if 0
 int
 __posix_socketpair (int domain, int type, int protocol, int socket_vector[2])
-  {
-    errno = ENOSYS; // Not implemented
-    return -1;
-  }
-#endif
+{
+  if (socket_vector == nullptr)
+    {
+      errno = EFAULT;
+      return -1;
+    }
+
+  class posix::socket* sockets[2];
+  if (posix::socketpair (domain, type, protocol, sockets) < 0)
+    {
+      return -1;
+    }
+  socket_vector[0] = sockets[0]->file_descriptor ();
+  socket_vector[1] = sockets[1]->file_descriptor ();
+  return 0;
+}
 
 int
 __posix_accept (int socket, struct sockaddr* address, socklen_t* address_len)
@@ -675,13 +737,6 @@ __posix_readdir_r (DIR* dirp, struct dirent* entry, struct dirent** result)
   return -1;
 }
 
-int __attribute__((weak))
-__posix_socketpair (int domain, int type, int protocol, int socket_vector[2])
-{
-  errno = ENOSYS; // Not implemented
-  return -1;
-}
-
 int
 __posix_gettimeofday (struct timeval* ptimeval, void* ptimezone)
 {
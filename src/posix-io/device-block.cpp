@@ -0,0 +1,126 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/posix-io/device-block.h>
+
+#include <cmsis-plus/diag/trace.h>
+
+#include <cassert>
+#include <cerrno>
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    device_block::device_block (std::size_t block_size_bytes, blknum_t blocks) :
+        block_size_bytes_ (block_size_bytes), //
+        blocks_ (blocks)
+    {
+      trace::printf ("%s(%u,%u) @%p\n", __func__, block_size_bytes, blocks,
+                     this);
+
+      assert (block_size_bytes > 0);
+    }
+
+    device_block::~device_block ()
+    {
+      trace::printf ("%s() @%p\n", __func__, this);
+    }
+
+    // ------------------------------------------------------------------------
+
+    ssize_t
+    device_block::read_block (void* buf, blknum_t blknum, std::size_t nblocks)
+    {
+      assert (buf != nullptr);
+
+      if ((blknum >= blocks_) || (nblocks > blocks_ - blknum))
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      if (nblocks == 0)
+        {
+          return 0;
+        }
+
+      errno = 0;
+
+      // Execute the implementation specific code.
+      return do_read_block (buf, blknum, nblocks);
+    }
+
+    ssize_t
+    device_block::write_block (const void* buf, blknum_t blknum,
+                               std::size_t nblocks)
+    {
+      assert (buf != nullptr);
+
+      if ((blknum >= blocks_) || (nblocks > blocks_ - blknum))
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      if (nblocks == 0)
+        {
+          return 0;
+        }
+
+      errno = 0;
+
+      // Execute the implementation specific code.
+      return do_write_block (buf, blknum, nblocks);
+    }
+
+    int
+    device_block::sync (void)
+    {
+      errno = 0;
+
+      // Execute the implementation specific code.
+      return do_sync ();
+    }
+
+    // ------------------------------------------------------------------------
+
+    int
+    device_block::do_sync (void)
+    {
+      // By default, writes are synchronous.
+      return 0;
+    }
+
+  } /* namespace posix */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
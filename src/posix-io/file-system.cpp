@@ -66,7 +66,7 @@ namespace os
           return -1;
         }
 
-      assert (fs->device () != nullptr);
+      assert (fs->mounted_);
       errno = 0;
 
       // Execute the implementation specific code.
@@ -97,7 +97,7 @@ namespace os
           return -1;
         }
 
-      assert (fs->device () != nullptr);
+      assert (fs->mounted_);
       errno = 0;
 
       // Execute the implementation specific code.
@@ -301,11 +301,13 @@ namespace os
       files_pool_ = files_pool;
       dirs_pool_ = dirs_pool;
       block_device_ = nullptr;
+      mounted_ = false;
     }
 
     file_system::~file_system ()
     {
       block_device_ = nullptr;
+      mounted_ = false;
     }
 
     // ------------------------------------------------------------------------
@@ -313,7 +315,7 @@ namespace os
     io*
     file_system::open (const char* path, int oflag, std::va_list args)
     {
-      if (block_device_ == nullptr)
+      if (!mounted_)
         {
           errno = EBADF;
           return nullptr;
@@ -321,13 +323,25 @@ namespace os
 
       // Get a file object from the pool.
       auto* const f = static_cast<file*> (files_pool_->acquire ());
+      if (f == nullptr)
+        {
+          errno = ENFILE;
+          return nullptr;
+        }
 
       // Associate the file with this file system (used, for example,
       // to reach the pools at close).
       f->file_system (this);
+      f->oflag_ = oflag;
 
       // Execute the file specific implementation code.
-      f->do_vopen (path, oflag, args);
+      if (f->do_vopen (path, oflag, args) < 0)
+        {
+          // Open failed, return the file to the pool.
+          f->file_system (nullptr);
+          files_pool_->release (f);
+          return nullptr;
+        }
 
       return f;
     }
@@ -335,7 +349,7 @@ namespace os
     directory*
     file_system::opendir (const char* dirpath)
     {
-      if (block_device_ == nullptr)
+      if (!mounted_)
         {
           errno = EBADF;
           return nullptr;
@@ -343,13 +357,24 @@ namespace os
 
       // Get a directory object from the pool.
       auto* const dir = static_cast<directory*> (dirs_pool_->acquire ());
+      if (dir == nullptr)
+        {
+          errno = ENFILE;
+          return nullptr;
+        }
 
       // Associate the dir with this file system (used, for example,
       // to reach the pools at close).
       dir->file_system (this);
 
       // Execute the dir specific implementation code.
-      dir->do_vopen (dirpath);
+      if (dir->do_vopen (dirpath) == nullptr)
+        {
+          // Open failed, return the directory to the pool.
+          dir->file_system (nullptr);
+          dirs_pool_->release (dir);
+          return nullptr;
+        }
 
       return dir;
     }
@@ -360,7 +385,7 @@ namespace os
     int
     file_system::chmod (const char* path, mode_t mode)
     {
-      assert (block_device_ != nullptr);
+      assert (mounted_);
       errno = 0;
 
       // Execute the implementation specific code.
@@ -370,7 +395,7 @@ namespace os
     int
     file_system::stat (const char* path, struct stat* buf)
     {
-      assert (block_device_ != nullptr);
+      assert (mounted_);
       errno = 0;
 
       // Execute the implementation specific code.
@@ -380,7 +405,7 @@ namespace os
     int
     file_system::truncate (const char* path, off_t length)
     {
-      assert (block_device_ != nullptr);
+      assert (mounted_);
       errno = 0;
 
       // Execute the implementation specific code.
@@ -390,7 +415,7 @@ namespace os
     int
     file_system::rename (const char* existing, const char* _new)
     {
-      assert (block_device_ != nullptr);
+      assert (mounted_);
       errno = 0;
 
       // Execute the implementation specific code.
@@ -400,7 +425,7 @@ namespace os
     int
     file_system::unlink (const char* path)
     {
-      assert (block_device_ != nullptr);
+      assert (mounted_);
       errno = 0;
 
       // Execute the implementation specific code.
@@ -410,7 +435,7 @@ namespace os
     int
     file_system::utime (const char* path, const struct utimbuf* times)
     {
-      assert (block_device_ != nullptr);
+      assert (mounted_);
       errno = 0;
 
       // Execute the implementation specific code.
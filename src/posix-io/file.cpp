@@ -29,7 +29,12 @@
 #include <cmsis-plus/posix-io/file-system.h>
 #include <cmsis-plus/posix-io/mount-manager.h>
 #include <cmsis-plus/posix-io/pool.h>
+#include <cmsis-plus/rtos/os.h>
+#include <cmsis-plus/estd/memory_resource>
 #include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 // ----------------------------------------------------------------------------
 
@@ -53,10 +58,25 @@ namespace os
 
     // ------------------------------------------------------------------------
 
+    /**
+     * @cond ignore
+     */
+
+    file::mapping_s file::mappings__[OS_INTEGER_POSIX_IO_FILE_MAPPINGS];
+
+    /**
+     * @endcond
+     */
+
+    // ------------------------------------------------------------------------
+
     file::file () :
         io (type::file)
     {
       file_system_ = nullptr;
+      oflag_ = 0;
+      mappings_count_ = 0;
+      closed_ = false;
     }
 
     file::~file ()
@@ -117,6 +137,356 @@ namespace os
       return do_fsync ();
     }
 
+    /**
+     * @details
+     * Private writable mappings always use a copy, since their
+     * changes must not reach the file. The address hint and
+     * `MAP_FIXED` are not supported.
+     *
+     * The file must be open for reading, and for shared
+     * writable mappings, also for writing.
+     */
+    void*
+    file::mmap (std::size_t length, int prot, int flags, off_t offset)
+    {
+      if ((length == 0) || (offset < 0))
+        {
+          errno = EINVAL;
+          return MAP_FAILED;
+        }
+
+      int type = flags & (MAP_SHARED | MAP_PRIVATE);
+      if ((type != MAP_SHARED) && (type != MAP_PRIVATE))
+        {
+          errno = EINVAL;
+          return MAP_FAILED;
+        }
+
+      if ((flags & MAP_FIXED) != 0)
+        {
+          errno = ENOTSUP;
+          return MAP_FAILED;
+        }
+
+      int mode = oflag_ & O_ACCMODE;
+      if ((mode == O_WRONLY)
+          || ((type == MAP_SHARED) && ((prot & PROT_WRITE) != 0)
+              && (mode != O_RDWR)))
+        {
+          errno = EACCES;
+          return MAP_FAILED;
+        }
+
+      errno = 0;
+
+      mapping_s* mapping = nullptr;
+        {
+          // ----- Enter critical section -------------------------------------
+          rtos::scheduler::critical_section scs;
+
+          if (closed_)
+            {
+              errno = EBADF;
+              return MAP_FAILED;
+            }
+
+          for (auto& m : mappings__)
+            {
+              if (m.owner == nullptr)
+                {
+                  // Reserve the slot.
+                  m.owner = this;
+                  m.addr = nullptr;
+                  mapping = &m;
+                  ++mappings_count_;
+                  break;
+                }
+            }
+          // ----- Exit critical section --------------------------------------
+        }
+
+      if (mapping == nullptr)
+        {
+          errno = EMFILE;
+          return MAP_FAILED;
+        }
+
+      void* addr = nullptr;
+      if ((type == MAP_SHARED) || ((prot & PROT_WRITE) == 0))
+        {
+          // Execute the implementation specific code.
+          addr = do_mmap (length, prot, flags, offset);
+        }
+
+      bool copy = false;
+      if (addr == nullptr)
+        {
+          // No direct access, copy the content.
+          addr = estd::pmr::get_default_resource ()->allocate (
+              length, alignof(std::max_align_t));
+          if (addr == nullptr)
+            {
+              errno = ENOMEM;
+              addr = MAP_FAILED;
+            }
+          else
+            {
+              copy = true;
+
+              char* p = static_cast<char*> (addr);
+              std::size_t count = 0;
+              off_t pos = do_lseek (0, SEEK_CUR);
+              if ((pos < 0) || (do_lseek (offset, SEEK_SET) < 0))
+                {
+                  errno = ENODEV;
+                  count = length + 1;
+                }
+              while (count < length)
+                {
+                  ssize_t n = do_read (p + count, length - count);
+                  if (n <= 0)
+                    {
+                      // Past the end of file, or error.
+                      if (n < 0)
+                        {
+                          count = length + 1;
+                        }
+                      break;
+                    }
+                  count += static_cast<std::size_t> (n);
+                }
+
+              if (count > length)
+                {
+                  estd::pmr::get_default_resource ()->deallocate (
+                      addr, length, alignof(std::max_align_t));
+                  addr = MAP_FAILED;
+                }
+              else
+                {
+                  std::memset (p + count, 0, length - count);
+                }
+
+              if (pos >= 0)
+                {
+                  do_lseek (pos, SEEK_SET);
+                }
+            }
+        }
+
+      if (addr == MAP_FAILED)
+        {
+          // ----- Enter critical section -------------------------------------
+          rtos::scheduler::critical_section scs;
+
+          // Release the slot.
+          mapping->owner = nullptr;
+          --mappings_count_;
+          return MAP_FAILED;
+          // ----- Exit critical section --------------------------------------
+        }
+
+      mapping->length = length;
+      mapping->offset = offset;
+      mapping->prot = prot;
+      mapping->flags = flags;
+      mapping->copy = copy;
+      mapping->addr = addr;
+
+      return addr;
+    }
+
+    /**
+     * @details
+     * Only entire mappings can be removed. If the file was closed
+     * while mapped, removing its last mapping also closes it.
+     */
+    int
+    file::munmap (void* addr, std::size_t length)
+    {
+      mapping_s* mapping = nullptr;
+        {
+          // ----- Enter critical section -------------------------------------
+          rtos::scheduler::critical_section scs;
+
+          for (auto& m : mappings__)
+            {
+              if ((m.owner != nullptr) && (m.addr == addr))
+                {
+                  mapping = &m;
+                  break;
+                }
+            }
+          // ----- Exit critical section --------------------------------------
+        }
+
+      if ((mapping == nullptr) || (mapping->length != length))
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      errno = 0;
+
+      return internal_unmap_ (mapping);
+    }
+
+    /**
+     * @cond ignore
+     */
+
+    /*
+     * Write back a shared writable copy. Return 0 or -1 and errno.
+     */
+    int
+    file::internal_write_back_ (mapping_s* mapping)
+    {
+      if (!mapping->copy || ((mapping->flags & MAP_SHARED) == 0)
+          || ((mapping->prot & PROT_WRITE) == 0))
+        {
+          return 0;
+        }
+
+      file* f = mapping->owner;
+
+      // Write back the part inside the file.
+      struct stat st;
+      if (f->do_fstat (&st) < 0)
+        {
+          return -1;
+        }
+      if (st.st_size <= mapping->offset)
+        {
+          return 0;
+        }
+
+      std::size_t length = mapping->length;
+      if (length > static_cast<std::size_t> (st.st_size - mapping->offset))
+        {
+          length = static_cast<std::size_t> (st.st_size - mapping->offset);
+        }
+
+      int ret = 0;
+      const char* p = static_cast<const char*> (mapping->addr);
+      off_t pos = f->do_lseek (0, SEEK_CUR);
+      if ((pos < 0) || (f->do_lseek (mapping->offset, SEEK_SET) < 0))
+        {
+          return -1;
+        }
+
+      std::size_t count = 0;
+      while (count < length)
+        {
+          ssize_t n = f->do_write (p + count, length - count);
+          if (n <= 0)
+            {
+              if (n == 0)
+                {
+                  errno = EIO;
+                }
+              ret = -1;
+              break;
+            }
+          count += static_cast<std::size_t> (n);
+        }
+
+      int err = errno;
+      f->do_lseek (pos, SEEK_SET);
+      errno = err;
+
+      return ret;
+    }
+
+    int
+    file::internal_unmap_ (mapping_s* mapping)
+    {
+      file* f = mapping->owner;
+      int ret = internal_write_back_ (mapping);
+      int err = errno;
+
+      if (mapping->copy)
+        {
+          estd::pmr::get_default_resource ()->deallocate (
+              mapping->addr, mapping->length, alignof(std::max_align_t));
+        }
+      else
+        {
+          // Execute the implementation specific code.
+          if (f->do_munmap (mapping->addr, mapping->length) < 0)
+            {
+              ret = -1;
+              err = errno;
+            }
+        }
+
+      bool last;
+        {
+          // ----- Enter critical section -------------------------------------
+          rtos::scheduler::critical_section scs;
+
+          mapping->addr = nullptr;
+          mapping->owner = nullptr;
+          --f->mappings_count_;
+          last = f->closed_ && (f->mappings_count_ == 0);
+          // ----- Exit critical section --------------------------------------
+        }
+
+      if (last)
+        {
+          // The file was closed while mapped; complete the close.
+          f->closed_ = false;
+          if (f->do_close () < 0 && ret == 0)
+            {
+              ret = -1;
+              err = errno;
+            }
+          f->do_release ();
+        }
+
+      errno = (ret < 0) ? err : 0;
+      return ret;
+    }
+
+    /*
+     * Called by close(), while the file is still open. Write back
+     * the shared writable copies, and tell if mappings remain, which
+     * keep the file open until the last `munmap()`. Return 0 or -1 and
+     * errno; the mappings remain valid in both cases.
+     */
+    int
+    file::internal_close_mappings_ (bool* mapped)
+    {
+      int ret = 0;
+      int err = 0;
+      for (auto& m : mappings__)
+        {
+          if ((m.owner == this) && (m.addr != nullptr))
+            {
+              if (internal_write_back_ (&m) < 0 && ret == 0)
+                {
+                  ret = -1;
+                  err = errno;
+                }
+            }
+        }
+
+        {
+          // ----- Enter critical section -------------------------------------
+          rtos::scheduler::critical_section scs;
+
+          *mapped = (mappings_count_ > 0);
+          closed_ = *mapped;
+          // ----- Exit critical section --------------------------------------
+        }
+
+      errno = err;
+      return ret;
+    }
+
+    /**
+     * @endcond
+     */
+
     // ------------------------------------------------------------------------
 
 #pragma GCC diagnostic push
@@ -136,6 +506,19 @@ namespace os
       return -1;
     }
 
+    void*
+    file::do_mmap (std::size_t length, int prot, int flags, off_t offset)
+    {
+      // No direct access, use a copy.
+      return nullptr;
+    }
+
+    int
+    file::do_munmap (void* addr, std::size_t length)
+    {
+      return 0;
+    }
+
 #pragma GCC diagnostic pop
 
     int
@@ -135,6 +135,56 @@ namespace os
       return ret;
     }
 
+    /**
+     * Transfer up to _count_ bytes from _in_ to _out_, without
+     * passing them through a user buffer.
+     *
+     * If _offset_ is not null, _in_ must be a file; the transfer
+     * starts at `*offset`, which is updated, and the file position
+     * is not changed. Otherwise the transfer starts at the current
+     * position, which is advanced.
+     */
+    ssize_t
+    sendfile (io* out, io* in, off_t* offset, std::size_t count)
+    {
+      if ((out == nullptr) || (in == nullptr))
+        {
+          errno = EBADF;
+          return -1;
+        }
+
+      if (offset == nullptr)
+        {
+          return in->splice_to (out, count);
+        }
+
+      if ((in->get_type () & io::type::file) == 0)
+        {
+          errno = ESPIPE; // Not a file.
+          return -1;
+        }
+
+      auto* const f = static_cast<file*> (in);
+      off_t pos = f->lseek (0, SEEK_CUR);
+      if ((pos < 0) || (f->lseek (*offset, SEEK_SET) < 0))
+        {
+          return -1;
+        }
+
+      ssize_t ret = in->splice_to (out, count);
+      int err = errno;
+      if (ret > 0)
+        {
+          *offset += ret;
+        }
+
+      // Restore the file position.
+      f->lseek (pos, SEEK_SET);
+      errno = err;
+
+      return ret;
+    }
+
     // ------------------------------------------------------------------------
 
     io*
@@ -144,9 +194,11 @@ namespace os
       int fd = file_descriptors_manager::alloc (this);
       if (fd < 0)
         {
-          // If allocation failed, close this object.
+          // If allocation failed, close this object and return it
+          // to the pool, if any.
           do_close ();
           clear_file_descriptor ();
+          do_release ();
           return nullptr;
         }
 
@@ -180,6 +232,29 @@ namespace os
           return -1;
         }
 
+      int err = 0;
+      if ((get_type () & type::file) != 0)
+        {
+          // While the file is still open, to write back the copies.
+          bool mapped;
+          if (static_cast<posix::file*> (this)->internal_close_mappings_ (
+              &mapped) < 0)
+            {
+              err = errno;
+            }
+
+          if (mapped)
+            {
+              // The mappings keep the file open; the last munmap()
+              // closes it. Only the descriptor is released now.
+              file_descriptors_manager::free (file_descriptor_);
+              file_descriptor_ = no_file_descriptor;
+
+              errno = err;
+              return (err != 0) ? -1 : 0;
+            }
+        }
+
       // Execute the implementation specific code.
       int ret = do_close ();
 
@@ -189,6 +264,13 @@ namespace os
 
       // Release objects acquired from a pool.
       do_release ();
+
+      if (err != 0)
+        {
+          // The write-back error has precedence.
+          errno = err;
+          return -1;
+        }
       return ret;
     }
 
@@ -307,6 +389,38 @@ namespace os
       return do_writev (iov, iovcnt);
     }
 
+    ssize_t
+    io::splice_to (io* out, std::size_t count)
+    {
+      if (out == nullptr)
+        {
+          errno = EBADF;
+          return -1;
+        }
+
+      if (!do_is_opened () || !out->do_is_opened ())
+        {
+          errno = EBADF; // Not opened.
+          return -1;
+        }
+
+      if (!do_is_connected () || !out->do_is_connected ())
+        {
+          errno = EIO; // Not connected.
+          return -1;
+        }
+
+      errno = 0;
+
+      if (count == 0)
+        {
+          return 0; // Nothing to do.
+        }
+
+      // Execute the implementation specific code.
+      return do_splice_to (out, count);
+    }
+
     int
     io::fcntl (int cmd, ...)
     {
@@ -427,6 +541,58 @@ namespace os
       return total;
     }
 
+    // The default implementation copies the bytes through a small
+    // buffer. It stops at the first short read, to avoid waiting
+    // for more bytes on devices; if the destination fails,
+    // the bytes already read are lost.
+
+    ssize_t
+    io::do_splice_to (io* out, std::size_t count)
+    {
+      char buf[OS_INTEGER_POSIX_IO_SPLICE_BUFFER_SIZE];
+      std::size_t total = 0;
+
+      while (total < count)
+        {
+          std::size_t n = count - total;
+          if (n > sizeof(buf))
+            {
+              n = sizeof(buf);
+            }
+
+          ssize_t ret = do_read (buf, n);
+          if (ret <= 0)
+            {
+              if ((ret < 0) && (total == 0))
+                {
+                  return -1;
+                }
+              break;
+            }
+
+          std::size_t done = 0;
+          while (done < static_cast<std::size_t> (ret))
+            {
+              ssize_t w = out->write (buf + done,
+                                      static_cast<std::size_t> (ret) - done);
+              if (w <= 0)
+                {
+                  total += done;
+                  return (total > 0) ? static_cast<ssize_t> (total) : -1;
+                }
+              done += static_cast<std::size_t> (w);
+            }
+          total += done;
+
+          if (static_cast<std::size_t> (ret) < n)
+            {
+              break;
+            }
+        }
+
+      return static_cast<ssize_t> (total);
+    }
+
     int
     io::do_vfcntl (int cmd, std::va_list args)
     {
@@ -131,6 +131,7 @@ namespace os
       root__ = fs;
 
       fs->device (blockDevice);
+      fs->mounted_ = true;
       return fs->do_mount (flags);
     }
 
@@ -163,6 +164,7 @@ namespace os
           if (file_systems_array__[i] == nullptr)
             {
               fs->device (blockDevice);
+              fs->mounted_ = true;
               fs->do_mount (flags);
 
               file_systems_array__[i] = fs;
@@ -192,6 +194,7 @@ namespace os
               file_systems_array__[i]->do_sync ();
               file_systems_array__[i]->do_unmount (flags);
               file_systems_array__[i]->device (nullptr);
+              file_systems_array__[i]->mounted_ = false;
 
               file_systems_array__[i] = nullptr;
               paths_array__[i] = nullptr;
@@ -0,0 +1,169 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/posix-io/net-interface.h>
+#include <cmsis-plus/diag/trace.h>
+
+#include <cerrno>
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace posix
+  {
+    // ========================================================================
+
+    /**
+     * @details
+     * The ring slots are allocated from the memory resource, or
+     * from the application default resource.
+     */
+    net_interface::net_interface (const char* name, std::size_t rx_slots,
+                                  std::size_t tx_slots,
+                                  rtos::memory::memory_resource* mr) :
+        name_ (name), //
+        rx_ring_
+          { rx_slots, mr }, //
+        tx_ring_
+          { tx_slots, mr }, //
+        rx_sem_
+          { name, 0 }
+    {
+      trace::printf ("%s(\"%s\",%u,%u,%p) @%p\n", __func__, name, rx_slots,
+                     tx_slots, mr, this);
+
+      std::memset (&counters_, 0, sizeof(counters_));
+    }
+
+    net_interface::~net_interface ()
+    {
+      trace::printf ("%s() @%p\n", __func__, this);
+    }
+
+    // ------------------------------------------------------------------------
+
+    int
+    net_interface::output (pbuf* p)
+    {
+      if (!tx_ring_.push (p))
+        {
+          ++counters_.tx_dropped;
+          p->release ();
+          errno = ENOBUFS;
+          return -1;
+        }
+      ++counters_.tx_packets;
+
+      // Execute the implementation specific code.
+      do_output ();
+      return 0;
+    }
+
+    pbuf*
+    net_interface::rx_dequeue (void)
+    {
+      return rx_ring_.pop ();
+    }
+
+    pbuf*
+    net_interface::rx_wait (void)
+    {
+      pbuf* p;
+      while ((p = rx_ring_.pop ()) == nullptr)
+        {
+          rx_sem_.wait ();
+        }
+      return p;
+    }
+
+    /**
+     * @details
+     * Can be called from interrupt handlers.
+     */
+    int
+    net_interface::rx_enqueue (pbuf* p)
+    {
+      if (!rx_ring_.push (p))
+        {
+          ++counters_.rx_dropped;
+          p->release ();
+          errno = ENOBUFS;
+          return -1;
+        }
+      ++counters_.rx_packets;
+
+      rx_sem_.post ();
+      return 0;
+    }
+
+    pbuf*
+    net_interface::tx_dequeue (void)
+    {
+      return tx_ring_.pop ();
+    }
+
+    void
+    net_interface::do_output (void)
+    {
+      ;
+    }
+
+    // ========================================================================
+
+    net_interface_loopback::net_interface_loopback (
+        const char* name, std::size_t slots, rtos::memory::memory_resource* mr) :
+        net_interface
+          { name, slots, slots, mr }
+    {
+      trace::printf ("%s() @%p\n", __func__, this);
+    }
+
+    net_interface_loopback::~net_interface_loopback ()
+    {
+      trace::printf ("%s() @%p\n", __func__, this);
+    }
+
+    /**
+     * @details
+     * Move the packets from the tx ring to the rx ring.
+     */
+    void
+    net_interface_loopback::do_output (void)
+    {
+      pbuf* p;
+      while ((p = tx_dequeue ()) != nullptr)
+        {
+          rx_enqueue (p);
+        }
+    }
+
+  } /* namespace posix */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
@@ -40,15 +40,17 @@ namespace os
      */
 
     pool* net_stack::sockets_pool__;
+    pbuf_pool* net_stack::pbufs_pool__;
 
     /**
      * @endcond
      */
 
     // ------------------------------------------------------------------------
-    net_stack::net_stack (pool* sockets_pool)
+    net_stack::net_stack (pool* sockets_pool, pbuf_pool* pbufs_pool)
     {
       sockets_pool__ = sockets_pool;
+      pbufs_pool__ = pbufs_pool;
     }
 
     net_stack::~net_stack ()
@@ -0,0 +1,949 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/posix-io/page-cache.h>
+#include <cmsis-plus/estd/memory_resource>
+
+#include <cmsis-plus/diag/trace.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    /**
+     * @cond ignore
+     */
+
+    namespace
+    {
+      inline std::size_t
+      hash (const device_block* device, device_block::blknum_t block)
+      {
+        return (reinterpret_cast<std::uintptr_t> (device) >> 3)
+            ^ (block * 2654435761u);
+      }
+    }
+
+    /**
+     * @endcond
+     */
+
+    // ========================================================================
+
+    /**
+     * @details
+     * The pages, the hash table and the transfer buffer are
+     * allocated from the memory resource; the flusher thread
+     * uses the thread allocator, unless the attributes define
+     * a stack.
+     */
+    page_cache::page_cache (const char* name, std::size_t pages,
+                            std::size_t page_size_bytes,
+                            rtos::memory::memory_resource* mr,
+                            const rtos::thread::attributes& attr) :
+        name_ (name), //
+        mutex_
+          { name }, //
+        changed_
+          { name }, //
+        work_
+          { name }
+    {
+      trace::printf ("%s(\"%s\",%u,%u,%p) @%p\n", __func__, name, pages,
+                     page_size_bytes, mr, this);
+
+      assert (pages > 0);
+      assert (page_size_bytes > 0);
+
+      mr_ = (mr != nullptr) ? mr : estd::pmr::get_default_resource ();
+      pages_count_ = pages;
+      page_size_bytes_ = page_size_bytes;
+
+      dirty_limit_ = pages * OS_INTEGER_POSIX_IO_PAGE_CACHE_DIRTY_RATIO / 100;
+      if (dirty_limit_ == 0)
+        {
+          dirty_limit_ = 1;
+        }
+      dirty_ = 0;
+      hand_ = 0;
+      cluster_busy_ = false;
+      stream_next_ = 0;
+      error_ = 0;
+      stop_ = false;
+
+      std::memset (&counters_, 0, sizeof(counters_));
+      std::memset (&streams_, 0, sizeof(streams_));
+
+      pages_ = static_cast<page_s*> (mr_->allocate (pages * sizeof(page_s),
+                                                    alignof(page_s)));
+      buckets_ = static_cast<page_s**> (mr_->allocate (
+          pages * sizeof(page_s*), alignof(page_s*)));
+      data_ = static_cast<char*> (mr_->allocate (pages * page_size_bytes,
+                                                 alignof(std::max_align_t)));
+      cluster_ = static_cast<char*> (mr_->allocate (
+          OS_INTEGER_POSIX_IO_PAGE_CACHE_CLUSTER_PAGES * page_size_bytes,
+          alignof(std::max_align_t)));
+
+      assert (pages_ != nullptr);
+      assert (buckets_ != nullptr);
+      assert (data_ != nullptr);
+      assert (cluster_ != nullptr);
+
+      for (std::size_t i = 0; i < pages; ++i)
+        {
+          pages_[i].hash_next = nullptr;
+          pages_[i].device = nullptr;
+          pages_[i].block = 0;
+          pages_[i].data = data_ + i * page_size_bytes;
+          pages_[i].dirtied = 0;
+          pages_[i].flags = 0;
+
+          buckets_[i] = nullptr;
+        }
+
+      // Start the thread last, when everything is in place.
+      flusher_ = new (&flusher_storage_) rtos::thread
+        { name, internal_flusher_, this, attr };
+    }
+
+    page_cache::~page_cache ()
+    {
+      trace::printf ("%s() @%p %s\n", __func__, this, name_);
+
+      mutex_.lock ();
+      stop_ = true;
+      work_.signal ();
+      mutex_.unlock ();
+
+      flusher_->join ();
+      flusher_->~thread ();
+      flusher_ = nullptr;
+
+      mutex_.lock ();
+      while (internal_write_back_ (nullptr, true) > 0)
+        {
+          ;
+        }
+      mutex_.unlock ();
+
+      std::size_t cluster_bytes = OS_INTEGER_POSIX_IO_PAGE_CACHE_CLUSTER_PAGES
+          * page_size_bytes_;
+      mr_->deallocate (cluster_, cluster_bytes, alignof(std::max_align_t));
+      mr_->deallocate (data_, pages_count_ * page_size_bytes_,
+                       alignof(std::max_align_t));
+      mr_->deallocate (buckets_, pages_count_ * sizeof(page_s*),
+                       alignof(page_s*));
+      mr_->deallocate (pages_, pages_count_ * sizeof(page_s),
+                       alignof(page_s));
+    }
+
+    // ------------------------------------------------------------------------
+
+    ssize_t
+    page_cache::pread (device_block* device, void* buf, std::size_t nbyte,
+                       off_t offset)
+    {
+      assert (device != nullptr);
+      assert (buf != nullptr);
+      assert (device->block_size_bytes () == page_size_bytes_);
+
+      if (offset < 0)
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      off_t size = static_cast<off_t> (device->blocks () * page_size_bytes_);
+      if (offset >= size || nbyte == 0)
+        {
+          return 0;
+        }
+      if (nbyte > static_cast<std::size_t> (size - offset))
+        {
+          nbyte = static_cast<std::size_t> (size - offset);
+        }
+
+      blknum_t first = static_cast<blknum_t> (offset) / page_size_bytes_;
+      blknum_t last = (static_cast<blknum_t> (offset) + nbyte - 1)
+          / page_size_bytes_;
+      std::size_t pos = static_cast<std::size_t> (offset) % page_size_bytes_;
+
+      char* dst = static_cast<char*> (buf);
+      std::size_t count = 0;
+
+      mutex_.lock ();
+
+      // Before the demand reads, to overlap them with the read-ahead.
+      internal_detect_stream_ (device, first, last);
+
+      for (blknum_t block = first; block <= last; ++block)
+        {
+          page_s* page = internal_get_ (device, block, false);
+          if (page == nullptr)
+            {
+              mutex_.unlock ();
+              return (count > 0) ? static_cast<ssize_t> (count) : -1;
+            }
+
+          std::size_t n = page_size_bytes_ - pos;
+          if (n > nbyte - count)
+            {
+              n = nbyte - count;
+            }
+          std::memcpy (dst + count, page->data + pos, n);
+
+          count += n;
+          pos = 0;
+        }
+
+      mutex_.unlock ();
+
+      return static_cast<ssize_t> (count);
+    }
+
+    /**
+     * @details
+     * Blocks which are entirely overwritten are not read from
+     * the device. If too many pages are dirty, wait for the
+     * flusher to write some of them.
+     *
+     * If the write-back fails, the writers are not kept waiting
+     * for pages which cannot be cleaned; once over the limit,
+     * `pwrite()` fails with the write-back error, until a
+     * write-back succeeds.
+     */
+    ssize_t
+    page_cache::pwrite (device_block* device, const void* buf,
+                        std::size_t nbyte, off_t offset)
+    {
+      assert (device != nullptr);
+      assert (buf != nullptr);
+      assert (device->block_size_bytes () == page_size_bytes_);
+
+      if (offset < 0)
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      if (nbyte == 0)
+        {
+          return 0;
+        }
+
+      off_t size = static_cast<off_t> (device->blocks () * page_size_bytes_);
+      if (offset >= size)
+        {
+          errno = ENOSPC;
+          return -1;
+        }
+      if (nbyte > static_cast<std::size_t> (size - offset))
+        {
+          nbyte = static_cast<std::size_t> (size - offset);
+        }
+
+      blknum_t first = static_cast<blknum_t> (offset) / page_size_bytes_;
+      blknum_t last = (static_cast<blknum_t> (offset) + nbyte - 1)
+          / page_size_bytes_;
+      std::size_t pos = static_cast<std::size_t> (offset) % page_size_bytes_;
+
+      const char* src = static_cast<const char*> (buf);
+      std::size_t count = 0;
+
+      mutex_.lock ();
+
+      for (blknum_t block = first; block <= last; ++block)
+        {
+          std::size_t n = page_size_bytes_ - pos;
+          if (n > nbyte - count)
+            {
+              n = nbyte - count;
+            }
+
+          if (error_ != 0 && dirty_ > dirty_limit_)
+            {
+              int err = error_;
+              mutex_.unlock ();
+              errno = err;
+              return (count > 0) ? static_cast<ssize_t> (count) : -1;
+            }
+
+          page_s* page = internal_get_ (device, block,
+                                        (n == page_size_bytes_));
+          if (page == nullptr)
+            {
+              mutex_.unlock ();
+              return (count > 0) ? static_cast<ssize_t> (count) : -1;
+            }
+
+          std::memcpy (page->data + pos, src + count, n);
+          internal_mark_dirty_ (page);
+
+          count += n;
+          pos = 0;
+
+          while (dirty_ > dirty_limit_ && error_ == 0)
+            {
+              work_.signal ();
+              changed_.wait (mutex_);
+            }
+        }
+
+      mutex_.unlock ();
+
+      return static_cast<ssize_t> (count);
+    }
+
+    /**
+     * @details
+     * Pages written by the flusher while `sync()` runs are
+     * waited for, so at return all writes issued before the
+     * call are on the device. Then the device `sync()` is called.
+     */
+    int
+    page_cache::sync (device_block* device)
+    {
+      assert (device != nullptr);
+
+      int ret = 0;
+
+      mutex_.lock ();
+
+      while (true)
+        {
+          ssize_t n = internal_write_back_ (device, true);
+          if (n < 0)
+            {
+              ret = -1;
+              break;
+            }
+          if (n == 0)
+            {
+              if (!internal_is_busy_ (device))
+                {
+                  break;
+                }
+              changed_.wait (mutex_);
+            }
+        }
+
+      mutex_.unlock ();
+
+      if (ret == 0)
+        {
+          ret = device->sync ();
+        }
+
+      return ret;
+    }
+
+    /**
+     * @details
+     * The dirty pages which cannot be written are discarded.
+     */
+    int
+    page_cache::invalidate (device_block* device)
+    {
+      assert (device != nullptr);
+
+      int ret = sync (device);
+
+      mutex_.lock ();
+
+      while (internal_is_busy_ (device))
+        {
+          changed_.wait (mutex_);
+        }
+
+      for (std::size_t i = 0; i < pages_count_; ++i)
+        {
+          page_s* page = &pages_[i];
+          if (page->flags != 0 && page->device == device)
+            {
+              if ((page->flags & dirty_flag) != 0)
+                {
+                  --dirty_;
+                }
+              internal_remove_ (page);
+              page->flags = 0;
+            }
+        }
+
+      for (auto& stream : streams_)
+        {
+          if (stream.device == device)
+            {
+              stream.device = nullptr;
+              stream.pending_count = 0;
+            }
+        }
+
+      changed_.broadcast ();
+      mutex_.unlock ();
+
+      return ret;
+    }
+
+    // ------------------------------------------------------------------------
+
+    /**
+     * @cond ignore
+     */
+
+    void*
+    page_cache::internal_flusher_ (void* args)
+    {
+      page_cache* self = static_cast<page_cache*> (args);
+
+      rtos::clock::duration_t interval = rtos::sysclock.ticks_cast (
+          OS_INTEGER_POSIX_IO_PAGE_CACHE_WRITEBACK_MS * 1000u / 2);
+      if (interval == 0)
+        {
+          interval = 1;
+        }
+
+      self->mutex_.lock ();
+
+      while (!self->stop_)
+        {
+          bool done = self->internal_read_ahead_ ();
+
+          // Above half the limit, do not wait for the pages to age.
+          bool all = (self->dirty_ * 2 >= self->dirty_limit_);
+          if (self->internal_write_back_ (nullptr, all) > 0)
+            {
+              done = true;
+            }
+
+          if (!done)
+            {
+              self->work_.timed_wait (self->mutex_, interval);
+            }
+        }
+
+      self->mutex_.unlock ();
+
+      return nullptr;
+    }
+
+    page_cache::page_s*
+    page_cache::internal_lookup_ (device_block* device, blknum_t block)
+    {
+      page_s* page = buckets_[hash (device, block) % pages_count_];
+      while (page != nullptr)
+        {
+          if (page->block == block && page->device == device)
+            {
+              return page;
+            }
+          page = page->hash_next;
+        }
+
+      return nullptr;
+    }
+
+    void
+    page_cache::internal_insert_ (page_s* page)
+    {
+      page_s** bucket = &buckets_[hash (page->device, page->block)
+          % pages_count_];
+      page->hash_next = *bucket;
+      *bucket = page;
+    }
+
+    void
+    page_cache::internal_remove_ (page_s* page)
+    {
+      page_s** link = &buckets_[hash (page->device, page->block)
+          % pages_count_];
+      while (*link != page)
+        {
+          link = &(*link)->hash_next;
+        }
+      *link = page->hash_next;
+      page->hash_next = nullptr;
+    }
+
+    /*
+     * CLOCK: advance the hand over the pages, clearing the
+     * referenced flags, and take the first clean page which
+     * was not referenced since the previous pass.
+     */
+    page_cache::page_s*
+    page_cache::internal_victim_ (void)
+    {
+      for (std::size_t i = 0; i < 2 * pages_count_; ++i)
+        {
+          page_s* page = &pages_[hand_];
+          if (++hand_ == pages_count_)
+            {
+              hand_ = 0;
+            }
+
+          if (page->flags == 0)
+            {
+              return page;
+            }
+          if ((page->flags & (busy | dirty_flag)) != 0)
+            {
+              continue;
+            }
+          if ((page->flags & referenced) != 0)
+            {
+              page->flags &= static_cast<uint8_t> (~referenced);
+              continue;
+            }
+
+          internal_remove_ (page);
+          page->flags = 0;
+          return page;
+        }
+
+      return nullptr;
+    }
+
+    /*
+     * Return the valid page of the block, reading it if needed,
+     * or nullptr and errno. If `whole`, the caller will overwrite
+     * the entire page, and it is not read. Called with the mutex
+     * locked; it may be temporarily released.
+     */
+    page_cache::page_s*
+    page_cache::internal_get_ (device_block* device, blknum_t block,
+                               bool whole)
+    {
+      while (true)
+        {
+          page_s* page = internal_lookup_ (device, block);
+          if (page != nullptr)
+            {
+              if ((page->flags & busy) != 0)
+                {
+                  // Being read or written.
+                  changed_.wait (mutex_);
+                  continue;
+                }
+              page->flags |= referenced;
+              ++counters_.hits;
+              return page;
+            }
+
+          page = internal_victim_ ();
+          if (page == nullptr)
+            {
+              if (error_ != 0)
+                {
+                  // The dirty pages cannot be written.
+                  errno = error_;
+                  return nullptr;
+                }
+              // All pages are busy or dirty.
+              work_.signal ();
+              changed_.wait (mutex_);
+              continue;
+            }
+
+          page->device = device;
+          page->block = block;
+          internal_insert_ (page);
+
+          if (whole)
+            {
+              page->flags = valid | referenced;
+              return page;
+            }
+
+          page->flags = busy;
+          ++counters_.misses;
+
+          mutex_.unlock ();
+          ssize_t ret = device->read_block (page->data, block, 1);
+          int err = errno;
+          mutex_.lock ();
+
+          changed_.broadcast ();
+          if (ret != 1)
+            {
+              internal_remove_ (page);
+              page->flags = 0;
+              errno = (err != 0) ? err : EIO;
+              return nullptr;
+            }
+
+          page->flags = valid | referenced;
+          return page;
+        }
+    }
+
+    void
+    page_cache::internal_mark_dirty_ (page_s* page)
+    {
+      if ((page->flags & dirty_flag) == 0)
+        {
+          page->flags |= dirty_flag;
+          page->dirtied = rtos::sysclock.now ();
+          ++dirty_;
+
+          if (dirty_ * 2 >= dirty_limit_)
+            {
+              work_.signal ();
+            }
+        }
+    }
+
+    /*
+     * Track the sequential readers. When a read continues
+     * where the previous one ended, double the window and,
+     * if less than half of it is already read ahead, ask the
+     * flusher to read up to the window end.
+     */
+    void
+    page_cache::internal_detect_stream_ (device_block* device,
+                                         blknum_t first, blknum_t last)
+    {
+      stream_s* stream = nullptr;
+      for (auto& s : streams_)
+        {
+          if (s.device == device && (s.next == first || s.next == first + 1))
+            {
+              stream = &s;
+              break;
+            }
+        }
+
+      if (stream == nullptr)
+        {
+          // Possibly the start of a new stream; replace the oldest.
+          stream = &streams_[stream_next_];
+          if (++stream_next_ == OS_INTEGER_POSIX_IO_PAGE_CACHE_STREAMS)
+            {
+              stream_next_ = 0;
+            }
+
+          stream->device = device;
+          stream->next = last + 1;
+          stream->ahead_end = last + 1;
+          stream->window = 0;
+          stream->pending_count = 0;
+          return;
+        }
+
+      if (stream->next == last + 1)
+        {
+          // Still in the same block.
+          return;
+        }
+
+      stream->next = last + 1;
+      stream->window =
+          (stream->window == 0) ? 2 : (stream->window * 2);
+      if (stream->window > OS_INTEGER_POSIX_IO_PAGE_CACHE_READAHEAD_PAGES)
+        {
+          stream->window = OS_INTEGER_POSIX_IO_PAGE_CACHE_READAHEAD_PAGES;
+        }
+
+      if (stream->ahead_end < stream->next)
+        {
+          stream->ahead_end = stream->next;
+          stream->pending_count = 0;
+        }
+
+      if (stream->ahead_end - stream->next > stream->window / 2)
+        {
+          return;
+        }
+
+      blknum_t end = stream->next + stream->window;
+      if (end > device->blocks ())
+        {
+          end = device->blocks ();
+        }
+      if (end <= stream->ahead_end)
+        {
+          return;
+        }
+
+      if (stream->pending_count == 0)
+        {
+          stream->pending_first = stream->ahead_end;
+        }
+      stream->pending_count = end - stream->pending_first;
+      stream->ahead_end = end;
+
+      work_.signal ();
+    }
+
+    /*
+     * Read ahead one run of consecutive blocks, for the first
+     * stream with pending blocks. Return true if there was work.
+     */
+    bool
+    page_cache::internal_read_ahead_ (void)
+    {
+      for (auto& stream : streams_)
+        {
+          if (stream.pending_count == 0)
+            {
+              continue;
+            }
+
+          device_block* device = stream.device;
+
+          // Skip the blocks already in the cache.
+          while (stream.pending_count > 0
+              && internal_lookup_ (device, stream.pending_first) != nullptr)
+            {
+              ++stream.pending_first;
+              --stream.pending_count;
+            }
+
+          std::size_t limit =
+              cluster_busy_ ? 1 : OS_INTEGER_POSIX_IO_PAGE_CACHE_CLUSTER_PAGES;
+          blknum_t first = stream.pending_first;
+
+          page_s* run[OS_INTEGER_POSIX_IO_PAGE_CACHE_CLUSTER_PAGES];
+          std::size_t n = 0;
+          while (n < limit && n < stream.pending_count
+              && internal_lookup_ (device, first + n) == nullptr)
+            {
+              page_s* page = internal_victim_ ();
+              if (page == nullptr)
+                {
+                  break;
+                }
+              page->device = device;
+              page->block = first + n;
+              page->flags = busy;
+              internal_insert_ (page);
+              run[n++] = page;
+            }
+
+          if (n == 0)
+            {
+              // No free pages, give up.
+              stream.pending_count = 0;
+              continue;
+            }
+
+          stream.pending_first += n;
+          stream.pending_count -= n;
+
+          char* buf = run[0]->data;
+          if (n > 1)
+            {
+              buf = cluster_;
+              cluster_busy_ = true;
+            }
+
+          mutex_.unlock ();
+          ssize_t ret = device->read_block (buf, first, n);
+          mutex_.lock ();
+
+          for (std::size_t i = 0; i < n; ++i)
+            {
+              if (ret == static_cast<ssize_t> (n))
+                {
+                  if (n > 1)
+                    {
+                      std::memcpy (run[i]->data, cluster_ + i * page_size_bytes_,
+                                   page_size_bytes_);
+                    }
+                  // Referenced, to survive until the reader gets there.
+                  run[i]->flags = valid | referenced;
+                }
+              else
+                {
+                  internal_remove_ (run[i]);
+                  run[i]->flags = 0;
+                }
+            }
+          if (ret == static_cast<ssize_t> (n))
+            {
+              counters_.read_ahead += n;
+            }
+
+          if (n > 1)
+            {
+              cluster_busy_ = false;
+            }
+          changed_.broadcast ();
+
+          return true;
+        }
+
+      return false;
+    }
+
+    /*
+     * Write one run of consecutive dirty blocks, of the given
+     * device or of any device. If not `all`, only pages dirty
+     * for longer than the write-back delay are considered.
+     * Return the number of blocks written, 0 if there was
+     * nothing to write, or -1 and errno. The outcome is
+     * remembered in `error_`, for the waiting writers.
+     */
+    ssize_t
+    page_cache::internal_write_back_ (device_block* device, bool all)
+    {
+      rtos::clock::timestamp_t now = rtos::sysclock.now ();
+      rtos::clock::duration_t delay = rtos::sysclock.ticks_cast (
+          OS_INTEGER_POSIX_IO_PAGE_CACHE_WRITEBACK_MS * 1000u);
+
+      page_s* page = nullptr;
+      for (std::size_t i = 0; i < pages_count_; ++i)
+        {
+          page_s* p = &pages_[i];
+          if ((p->flags & (dirty_flag | busy)) != dirty_flag)
+            {
+              continue;
+            }
+          if (device != nullptr && p->device != device)
+            {
+              continue;
+            }
+          if (!all && (now - p->dirtied) < delay)
+            {
+              continue;
+            }
+          page = p;
+          break;
+        }
+
+      if (page == nullptr)
+        {
+          return 0;
+        }
+
+      // Extend to the run of consecutive dirty blocks around it.
+      device_block* dev = page->device;
+      std::size_t limit =
+          cluster_busy_ ? 1 : OS_INTEGER_POSIX_IO_PAGE_CACHE_CLUSTER_PAGES;
+
+      blknum_t first = page->block;
+      while (first > 0 && (page->block - first + 1) < limit)
+        {
+          page_s* p = internal_lookup_ (dev, first - 1);
+          if (p == nullptr || (p->flags & (dirty_flag | busy)) != dirty_flag)
+            {
+              break;
+            }
+          --first;
+        }
+
+      page_s* run[OS_INTEGER_POSIX_IO_PAGE_CACHE_CLUSTER_PAGES];
+      std::size_t n = 0;
+      while (n < limit)
+        {
+          page_s* p = internal_lookup_ (dev, first + n);
+          if (p == nullptr || (p->flags & (dirty_flag | busy)) != dirty_flag)
+            {
+              break;
+            }
+          p->flags = static_cast<uint8_t> ((p->flags & ~dirty_flag) | busy);
+          run[n++] = p;
+        }
+      dirty_ -= n;
+
+      const char* buf = run[0]->data;
+      if (n > 1)
+        {
+          for (std::size_t i = 0; i < n; ++i)
+            {
+              std::memcpy (cluster_ + i * page_size_bytes_, run[i]->data,
+                           page_size_bytes_);
+            }
+          buf = cluster_;
+          cluster_busy_ = true;
+        }
+
+      mutex_.unlock ();
+      ssize_t ret = dev->write_block (buf, first, n);
+      int err = errno;
+      mutex_.lock ();
+
+      if (n > 1)
+        {
+          cluster_busy_ = false;
+        }
+      ++counters_.writes;
+
+      bool ok = (ret == static_cast<ssize_t> (n));
+      for (std::size_t i = 0; i < n; ++i)
+        {
+          run[i]->flags &= static_cast<uint8_t> (~busy);
+          if (!ok)
+            {
+              // Keep the data, retry later.
+              run[i]->flags |= dirty_flag;
+            }
+        }
+      changed_.broadcast ();
+
+      if (!ok)
+        {
+          dirty_ += n;
+          error_ = (err != 0) ? err : EIO;
+          errno = error_;
+          return -1;
+        }
+
+      error_ = 0;
+      counters_.written_blocks += n;
+      return static_cast<ssize_t> (n);
+    }
+
+    bool
+    page_cache::internal_is_busy_ (device_block* device) const
+    {
+      for (std::size_t i = 0; i < pages_count_; ++i)
+        {
+          if ((pages_[i].flags & busy) != 0 && pages_[i].device == device)
+            {
+              return true;
+            }
+        }
+
+      return false;
+    }
+
+    /**
+     * @endcond
+     */
+
+  } /* namespace posix */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,401 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/posix-io/pbuf.h>
+#include <cmsis-plus/estd/memory_resource>
+#include <cmsis-plus/diag/trace.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace posix
+  {
+    // ========================================================================
+
+    pbuf::pbuf (pbuf_pool* pool) :
+        pool_ (pool)
+    {
+      ;
+    }
+
+    std::size_t
+    pbuf::total_length (void) const
+    {
+      std::size_t total = 0;
+      for (const pbuf* p = this; p != nullptr; p = p->next_)
+        {
+          total += p->length_;
+        }
+      return total;
+    }
+
+    int
+    pbuf::push_header (std::size_t nbyte)
+    {
+      if (nbyte > offset_)
+        {
+          errno = ENOBUFS;
+          return -1;
+        }
+
+      offset_ -= nbyte;
+      length_ += nbyte;
+      return 0;
+    }
+
+    int
+    pbuf::pull_header (std::size_t nbyte)
+    {
+      if (nbyte > length_)
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      offset_ += nbyte;
+      length_ -= nbyte;
+      return 0;
+    }
+
+    uint8_t*
+    pbuf::put (std::size_t nbyte)
+    {
+      if (nbyte > tailroom ())
+        {
+          errno = ENOBUFS;
+          return nullptr;
+        }
+
+      uint8_t* p = payload () + length_;
+      length_ += nbyte;
+      return p;
+    }
+
+    void
+    pbuf::chain (pbuf* tail)
+    {
+      pbuf* p = this;
+      while (p->next_ != nullptr)
+        {
+          p = p->next_;
+        }
+      p->next_ = tail;
+    }
+
+    std::size_t
+    pbuf::copy_to (void* buf, std::size_t nbyte, std::size_t offset) const
+    {
+      uint8_t* dst = static_cast<uint8_t*> (buf);
+      std::size_t count = 0;
+      for (const pbuf* p = this; p != nullptr && count < nbyte; p = p->next_)
+        {
+          if (offset >= p->length_)
+            {
+              offset -= p->length_;
+              continue;
+            }
+
+          std::size_t n = p->length_ - offset;
+          if (n > nbyte - count)
+            {
+              n = nbyte - count;
+            }
+          std::memcpy (dst + count, p->payload () + offset, n);
+          count += n;
+          offset = 0;
+        }
+      return count;
+    }
+
+    std::size_t
+    pbuf::copy_from (const void* buf, std::size_t nbyte, std::size_t offset)
+    {
+      const uint8_t* src = static_cast<const uint8_t*> (buf);
+      std::size_t count = 0;
+      for (pbuf* p = this; p != nullptr && count < nbyte; p = p->next_)
+        {
+          if (offset >= p->length_)
+            {
+              offset -= p->length_;
+              continue;
+            }
+
+          std::size_t n = p->length_ - offset;
+          if (n > nbyte - count)
+            {
+              n = nbyte - count;
+            }
+          std::memcpy (p->payload () + offset, src + count, n);
+          count += n;
+          offset = 0;
+        }
+      return count;
+    }
+
+    pbuf*
+    pbuf::ref (void)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::interrupts::critical_section ics;
+
+      ++ref_;
+      return this;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /**
+     * @details
+     * The next buffers in the chain are released only when this
+     * buffer is freed, since the chain holds a single reference
+     * to them.
+     */
+    void
+    pbuf::release (void)
+    {
+      pbuf* p = this;
+      while (p != nullptr)
+        {
+          pbuf* next;
+            {
+              // ----- Enter critical section ---------------------------------
+              rtos::interrupts::critical_section ics;
+
+              assert (p->ref_ > 0);
+              if (--p->ref_ > 0)
+                {
+                  // Still used.
+                  break;
+                }
+
+              next = p->next_;
+              p->pool_->internal_free_ (p);
+              // ----- Exit critical section ----------------------------------
+            }
+          p = next;
+        }
+    }
+
+    // ========================================================================
+
+    /**
+     * @details
+     * If the memory resource is not specified, the application
+     * default resource is used.
+     */
+    pbuf_pool::pbuf_pool (const char* name, std::size_t count,
+                          std::size_t buffer_size_bytes,
+                          std::size_t headroom_bytes,
+                          rtos::memory::memory_resource* mr) :
+        name_ (name)
+    {
+      trace::printf ("%s(\"%s\",%u,%u,%u,%p) @%p\n", __func__, name, count,
+                     buffer_size_bytes, headroom_bytes, mr, this);
+
+      assert (count > 0);
+      assert (headroom_bytes < buffer_size_bytes);
+
+      mr_ = (mr != nullptr) ? mr : estd::pmr::get_default_resource ();
+      count_ = count;
+      buffer_size_bytes_ = buffer_size_bytes;
+      headroom_bytes_ = headroom_bytes;
+      stride_ = (sizeof(pbuf) + buffer_size_bytes + alignof(pbuf) - 1)
+          & ~(alignof(pbuf) - 1);
+      failures_ = 0;
+
+      storage_ = static_cast<uint8_t*> (mr_->allocate (count * stride_,
+                                                       alignof(pbuf)));
+      assert (storage_ != nullptr);
+
+      // Link all buffers in the free list.
+      free_ = nullptr;
+      for (std::size_t i = count; i > 0; --i)
+        {
+          pbuf* p = new (storage_ + (i - 1) * stride_) pbuf
+            { this };
+          p->next_ = free_;
+          free_ = p;
+        }
+      available_ = count;
+    }
+
+    pbuf_pool::~pbuf_pool ()
+    {
+      trace::printf ("%s() @%p\n", __func__, this);
+
+      // All buffers should be back.
+      assert (available_ == count_);
+
+      for (std::size_t i = 0; i < count_; ++i)
+        {
+          reinterpret_cast<pbuf*> (storage_ + i * stride_)->~pbuf ();
+        }
+      mr_->deallocate (storage_, count_ * stride_, alignof(pbuf));
+    }
+
+    /**
+     * @details
+     * The buffers are taken all at once, or none. The first
+     * buffer has the headroom reserved and the others are used
+     * entirely; each buffer has a single reference, the first one
+     * owned by the caller, the others by the chain.
+     */
+    pbuf*
+    pbuf_pool::alloc (std::size_t length)
+    {
+      std::size_t first = buffer_size_bytes_ - headroom_bytes_;
+      std::size_t n = 1;
+      if (length > first)
+        {
+          n += (length - first + buffer_size_bytes_ - 1) / buffer_size_bytes_;
+        }
+
+      pbuf* head;
+        {
+          // ----- Enter critical section -------------------------------------
+          rtos::interrupts::critical_section ics;
+
+          if (n > available_)
+            {
+              ++failures_;
+              errno = ENOBUFS;
+              return nullptr;
+            }
+
+          head = free_;
+          pbuf* last = head;
+          for (std::size_t i = 1; i < n; ++i)
+            {
+              last = last->next_;
+            }
+          free_ = last->next_;
+          last->next_ = nullptr;
+          available_ -= n;
+          // ----- Exit critical section --------------------------------------
+        }
+
+      std::size_t left = length;
+      for (pbuf* p = head; p != nullptr; p = p->next_)
+        {
+          p->offset_ = (p == head) ? headroom_bytes_ : 0;
+          std::size_t room = buffer_size_bytes_ - p->offset_;
+          p->length_ = (left < room) ? left : room;
+          left -= p->length_;
+          p->ref_ = 1;
+        }
+
+      return head;
+    }
+
+    /**
+     * @details
+     * Must be called in an interrupts critical section.
+     */
+    void
+    pbuf_pool::internal_free_ (pbuf* p)
+    {
+      p->next_ = free_;
+      free_ = p;
+      ++available_;
+    }
+
+    // ========================================================================
+
+    pbuf_ring::pbuf_ring (std::size_t slots,
+                          rtos::memory::memory_resource* mr)
+    {
+      assert (slots > 0);
+
+      mr_ = (mr != nullptr) ? mr : estd::pmr::get_default_resource ();
+      count_ = slots;
+      slots_ = static_cast<pbuf**> (mr_->allocate (slots * sizeof(pbuf*),
+                                                   alignof(pbuf*)));
+      assert (slots_ != nullptr);
+    }
+
+    pbuf_ring::~pbuf_ring ()
+    {
+      pbuf* p;
+      while ((p = pop ()) != nullptr)
+        {
+          p->release ();
+        }
+      mr_->deallocate (slots_, count_ * sizeof(pbuf*), alignof(pbuf*));
+    }
+
+    bool
+    pbuf_ring::push (pbuf* p)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::interrupts::critical_section ics;
+
+      if (length_ == count_)
+        {
+          return false;
+        }
+
+      std::size_t tail = head_ + length_;
+      if (tail >= count_)
+        {
+          tail -= count_;
+        }
+      slots_[tail] = p;
+      ++length_;
+      return true;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    pbuf*
+    pbuf_ring::pop (void)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::interrupts::critical_section ics;
+
+      if (length_ == 0)
+        {
+          return nullptr;
+        }
+
+      pbuf* p = slots_[head_];
+      if (++head_ == count_)
+        {
+          head_ = 0;
+        }
+      --length_;
+      return p;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+  } /* namespace posix */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
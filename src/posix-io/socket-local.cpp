@@ -0,0 +1,560 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/posix-io/socket-local.h>
+#include <cmsis-plus/rtos/os.h>
+#include <cmsis-plus/diag/trace.h>
+
+#include <cerrno>
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    socket_local::socket_local ()
+    {
+      trace::printf ("%s() @%p\n", __func__, this);
+    }
+
+    socket_local::~socket_local ()
+    {
+      trace::printf ("%s() @%p\n", __func__, this);
+
+      peer_ = nullptr;
+    }
+
+    // ------------------------------------------------------------------------
+
+    int
+    socket_local::do_socket (int domain, int type, int protocol)
+    {
+      if (domain != AF_LOCAL)
+        {
+          errno = EAFNOSUPPORT;
+          return -1;
+        }
+
+      if ((type != SOCK_STREAM) && (type != SOCK_DGRAM))
+        {
+          errno = EPROTOTYPE;
+          return -1;
+        }
+
+      if (protocol != 0)
+        {
+          errno = EPROTONOSUPPORT;
+          return -1;
+        }
+
+      readable_.reset ();
+      writable_.reset ();
+
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      peer_ = nullptr;
+      front_ = 0;
+      length_ = 0;
+      sock_type_ = type;
+      rx_shut_ = false;
+      tx_shut_ = false;
+      opened_ = true;
+
+      return 0;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /**
+     * @details
+     * The peer comes from the same pool, so it is also a
+     * `socket_local`.
+     */
+    int
+    socket_local::do_socketpair (socket* peer)
+    {
+      auto* const p = static_cast<socket_local*> (peer);
+
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      peer_ = p;
+      p->peer_ = this;
+
+      return 0;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /**
+     * @details
+     * The peer reads the remaining bytes, then end of file;
+     * its sends fail with `EPIPE`.
+     */
+    int
+    socket_local::do_close (void)
+    {
+      socket_local* peer;
+        {
+          // ----- Enter critical section -------------------------------------
+          rtos::scheduler::critical_section scs;
+
+          peer = peer_;
+          if (peer != nullptr)
+            {
+              peer->peer_ = nullptr;
+              peer->rx_shut_ = true;
+            }
+          peer_ = nullptr;
+          length_ = 0;
+          opened_ = false;
+          // ----- Exit critical section --------------------------------------
+        }
+
+      if (peer != nullptr)
+        {
+          peer->readable_.post ();
+          peer->writable_.post ();
+        }
+
+      // Wake up the threads waiting on this socket.
+      readable_.post ();
+      writable_.post ();
+
+      return 0;
+    }
+
+    bool
+    socket_local::do_is_opened (void)
+    {
+      return opened_;
+    }
+
+    ssize_t
+    socket_local::do_read (void* buf, std::size_t nbyte)
+    {
+      return do_recv (buf, nbyte, 0);
+    }
+
+    ssize_t
+    socket_local::do_write (const void* buf, std::size_t nbyte)
+    {
+      return do_send (buf, nbyte, 0);
+    }
+
+    /**
+     * @details
+     * Stream sockets wait until all bytes are copied into the ring
+     * of the peer, unless `MSG_DONTWAIT` is set. Datagrams are
+     * copied entirely or not at all.
+     */
+    ssize_t
+    socket_local::do_send (const void* buffer, size_t length, int flags)
+    {
+      if ((sock_type_ == SOCK_DGRAM)
+          && (length > sizeof(ring_) - sizeof(dgram_length_t)))
+        {
+          errno = EMSGSIZE;
+          return -1;
+        }
+
+      const uint8_t* src = static_cast<const uint8_t*> (buffer);
+      std::size_t count = 0;
+      while (true)
+        {
+          socket_local* peer;
+          bool done = false;
+            {
+              // ----- Enter critical section ---------------------------------
+              rtos::scheduler::critical_section scs;
+
+              peer = peer_;
+              if ((peer == nullptr) || tx_shut_)
+                {
+                  if (count > 0)
+                    {
+                      return static_cast<ssize_t> (count);
+                    }
+                  errno = (peer == nullptr && !rx_shut_) ? ENOTCONN : EPIPE;
+                  return -1;
+                }
+
+              std::size_t space = peer->internal_space_ ();
+              if (sock_type_ == SOCK_STREAM)
+                {
+                  std::size_t n = length - count;
+                  if (n > space)
+                    {
+                      n = space;
+                    }
+                  peer->internal_put_ (src + count, n);
+                  count += n;
+                  done = (count == length);
+                }
+              else if (space >= sizeof(dgram_length_t) + length)
+                {
+                  dgram_length_t len = static_cast<dgram_length_t> (length);
+                  peer->internal_put_ (&len, sizeof(len));
+                  peer->internal_put_ (src, length);
+                  count = length;
+                  done = true;
+                }
+              // ----- Exit critical section ----------------------------------
+            }
+
+          if (count > 0 || done)
+            {
+              peer->readable_.post ();
+            }
+
+          if (done)
+            {
+              return static_cast<ssize_t> (count);
+            }
+
+          if ((flags & MSG_DONTWAIT) != 0)
+            {
+              if (count > 0)
+                {
+                  return static_cast<ssize_t> (count);
+                }
+              errno = EAGAIN;
+              return -1;
+            }
+
+          // Wait for the peer to free space.
+          writable_.wait ();
+        }
+    }
+
+    /**
+     * @details
+     * Datagrams longer than the buffer are truncated. After the
+     * peer closes or shuts down writing, the bytes left are
+     * returned, then 0.
+     */
+    ssize_t
+    socket_local::do_recv (void* buffer, size_t length, int flags)
+    {
+      const bool consume = ((flags & MSG_PEEK) == 0);
+      while (true)
+        {
+          socket_local* peer;
+          ssize_t ret = -1;
+            {
+              // ----- Enter critical section ---------------------------------
+              rtos::scheduler::critical_section scs;
+
+              peer = peer_;
+              if (length_ > 0)
+                {
+                  std::size_t n;
+                  if (sock_type_ == SOCK_STREAM)
+                    {
+                      n = (length < length_) ? length : length_;
+                      internal_get_ (buffer, 0, n);
+                      if (consume)
+                        {
+                          internal_consume_ (n);
+                        }
+                    }
+                  else
+                    {
+                      dgram_length_t len;
+                      internal_get_ (&len, 0, sizeof(len));
+                      n = (length < len) ? length : len;
+                      internal_get_ (buffer, sizeof(len), n);
+                      if (consume)
+                        {
+                          internal_consume_ (sizeof(len) + len);
+                        }
+                    }
+                  ret = static_cast<ssize_t> (n);
+                }
+              else if (rx_shut_)
+                {
+                  // End of file.
+                  return 0;
+                }
+              else if (peer == nullptr)
+                {
+                  errno = ENOTCONN;
+                  return -1;
+                }
+              // ----- Exit critical section ----------------------------------
+            }
+
+          if (ret >= 0)
+            {
+              if (consume && (peer != nullptr))
+                {
+                  peer->writable_.post ();
+                }
+              return ret;
+            }
+
+          if ((flags & MSG_DONTWAIT) != 0)
+            {
+              errno = EAGAIN;
+              return -1;
+            }
+
+          // Wait for the peer to send.
+          readable_.wait ();
+        }
+    }
+
+    /**
+     * @details
+     * For stream sockets, the bytes are written to the destination
+     * directly from the ring, one contiguous region at a time.
+     * There should be a single reader.
+     */
+    ssize_t
+    socket_local::do_splice_to (io* out, std::size_t count)
+    {
+      if (sock_type_ != SOCK_STREAM)
+        {
+          return socket::do_splice_to (out, count);
+        }
+
+      std::size_t total = 0;
+      while (total < count)
+        {
+          socket_local* peer;
+          const uint8_t* p = nullptr;
+          std::size_t n;
+          bool eof;
+            {
+              // ----- Enter critical section ---------------------------------
+              rtos::scheduler::critical_section scs;
+
+              peer = peer_;
+              eof = rx_shut_;
+              n = length_;
+              if (n > sizeof(ring_) - front_)
+                {
+                  n = sizeof(ring_) - front_;
+                }
+              p = ring_ + front_;
+              // ----- Exit critical section ----------------------------------
+            }
+
+          if (n == 0)
+            {
+              if ((total > 0) || eof)
+                {
+                  break;
+                }
+              if (peer == nullptr)
+                {
+                  errno = ENOTCONN;
+                  return -1;
+                }
+              // Wait for the peer to send.
+              readable_.wait ();
+              continue;
+            }
+
+          if (n > count - total)
+            {
+              n = count - total;
+            }
+
+          ssize_t ret = out->write (p, n);
+          if (ret <= 0)
+            {
+              return (total > 0) ? static_cast<ssize_t> (total) : ret;
+            }
+
+            {
+              // ----- Enter critical section ---------------------------------
+              rtos::scheduler::critical_section scs;
+
+              internal_consume_ (static_cast<std::size_t> (ret));
+              // ----- Exit critical section ----------------------------------
+            }
+
+          if (peer != nullptr)
+            {
+              peer->writable_.post ();
+            }
+
+          total += static_cast<std::size_t> (ret);
+          if (static_cast<std::size_t> (ret) < n)
+            {
+              break;
+            }
+        }
+
+      return static_cast<ssize_t> (total);
+    }
+
+    int
+    socket_local::do_shutdown (int how)
+    {
+      if ((how != SHUT_RD) && (how != SHUT_WR) && (how != SHUT_RDWR))
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      socket_local* peer;
+        {
+          // ----- Enter critical section -------------------------------------
+          rtos::scheduler::critical_section scs;
+
+          peer = peer_;
+          if ((peer == nullptr) && !rx_shut_)
+            {
+              errno = ENOTCONN;
+              return -1;
+            }
+
+          if (how != SHUT_WR)
+            {
+              rx_shut_ = true;
+            }
+          if (how != SHUT_RD)
+            {
+              tx_shut_ = true;
+              if (peer != nullptr)
+                {
+                  peer->rx_shut_ = true;
+                }
+            }
+          // ----- Exit critical section --------------------------------------
+        }
+
+      readable_.post ();
+      writable_.post ();
+      if ((how != SHUT_RD) && (peer != nullptr))
+        {
+          peer->readable_.post ();
+        }
+
+      return 0;
+    }
+
+    /**
+     * @details
+     * The local sockets are not named, only the family is returned.
+     */
+    int
+    socket_local::do_getsockname (struct sockaddr* address,
+                                  socklen_t* address_len)
+    {
+      if ((address == nullptr) || (address_len == nullptr))
+        {
+          errno = EFAULT;
+          return -1;
+        }
+
+      if (*address_len >= sizeof(address->sa_family))
+        {
+          address->sa_family = AF_LOCAL;
+        }
+      *address_len = sizeof(address->sa_family);
+
+      return 0;
+    }
+
+    int
+    socket_local::do_getpeername (struct sockaddr* address,
+                                  socklen_t* address_len)
+    {
+      if (peer_ == nullptr)
+        {
+          errno = ENOTCONN;
+          return -1;
+        }
+
+      return do_getsockname (address, address_len);
+    }
+
+    // ------------------------------------------------------------------------
+
+    std::size_t
+    socket_local::internal_space_ (void) const
+    {
+      return sizeof(ring_) - length_;
+    }
+
+    void
+    socket_local::internal_put_ (const void* buf, std::size_t nbyte)
+    {
+      const uint8_t* src = static_cast<const uint8_t*> (buf);
+      std::size_t back = (front_ + length_) % sizeof(ring_);
+      std::size_t n = sizeof(ring_) - back;
+      if (n > nbyte)
+        {
+          n = nbyte;
+        }
+
+      std::memcpy (ring_ + back, src, n);
+      // Wrap around.
+      std::memcpy (ring_, src + n, nbyte - n);
+
+      length_ += nbyte;
+    }
+
+    void
+    socket_local::internal_get_ (void* buf, std::size_t offset,
+                                 std::size_t nbyte) const
+    {
+      uint8_t* dst = static_cast<uint8_t*> (buf);
+      std::size_t pos = (front_ + offset) % sizeof(ring_);
+      std::size_t n = sizeof(ring_) - pos;
+      if (n > nbyte)
+        {
+          n = nbyte;
+        }
+
+      std::memcpy (dst, ring_ + pos, n);
+      // Wrap around.
+      std::memcpy (dst + n, ring_, nbyte - n);
+    }
+
+    void
+    socket_local::internal_consume_ (std::size_t nbyte)
+    {
+      front_ = (front_ + nbyte) % sizeof(ring_);
+      length_ -= nbyte;
+      if (length_ == 0)
+        {
+          // Keep the empty ring contiguous.
+          front_ = 0;
+        }
+    }
+
+  } /* namespace posix */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
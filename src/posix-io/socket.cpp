@@ -57,20 +57,95 @@ namespace os
       int ret = sock->do_socket (domain, type, protocol);
       if (ret < 0)
         {
-          sock->close ();
+          // Return it to the pool.
+          sock->do_release ();
           return nullptr;
         }
-      sock->alloc_file_descriptor ();
-      return sock;
+      return static_cast<class socket*> (sock->alloc_file_descriptor ());
     }
 
-#if 0
-    socket*
-    socketpair (int domain, int type, int protocol, int socket_vector[2])
-      {
-        return nullptr;
-      }
-#endif
+    /**
+     * Create two connected sockets, acquired from the sockets pool;
+     * the pool objects must implement do_socketpair(), like
+     * `socket_local`.
+     */
+    int
+    socketpair (int domain, int type, int protocol,
+                class socket* socket_vector[2])
+    {
+      if (socket_vector == nullptr)
+        {
+          errno = EFAULT;
+          return -1;
+        }
+
+      errno = 0;
+
+      auto pool = net_stack::sockets_pool ();
+      if (pool == nullptr)
+        {
+          errno = ENFILE;
+          return -1;
+        }
+
+      class socket* sock[2];
+      sock[0] = static_cast<class socket*> (pool->acquire ());
+      sock[1] = static_cast<class socket*> (pool->acquire ());
+      if ((sock[0] == nullptr) || (sock[1] == nullptr))
+        {
+          for (auto* s : sock)
+            {
+              if (s != nullptr)
+                {
+                  s->do_release ();
+                }
+            }
+          errno = ENFILE;
+          return -1;
+        }
+
+      int ret = sock[0]->do_socket (domain, type, protocol);
+      if (ret == 0)
+        {
+          ret = sock[1]->do_socket (domain, type, protocol);
+          if (ret < 0)
+            {
+              sock[0]->do_close ();
+            }
+        }
+      if (ret == 0)
+        {
+          ret = sock[0]->do_socketpair (sock[1]);
+          if (ret < 0)
+            {
+              sock[0]->do_close ();
+              sock[1]->do_close ();
+            }
+        }
+      if (ret < 0)
+        {
+          sock[0]->do_release ();
+          sock[1]->do_release ();
+          return -1;
+        }
+
+      // On failure, alloc_file_descriptor() closes and releases the socket.
+      if (sock[0]->alloc_file_descriptor () == nullptr)
+        {
+          sock[1]->do_close ();
+          sock[1]->do_release ();
+          return -1;
+        }
+      if (sock[1]->alloc_file_descriptor () == nullptr)
+        {
+          sock[0]->close ();
+          return -1;
+        }
+
+      socket_vector[0] = sock[0];
+      socket_vector[1] = sock[1];
+      return 0;
+    }
 
 #pragma GCC diagnostic pop
 
@@ -272,6 +347,13 @@ namespace os
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 
+    int
+    socket::do_socketpair (socket* peer)
+    {
+      errno = EOPNOTSUPP; // Not supported by this socket type.
+      return -1;
+    }
+
     int
     socket::do_accept (socket* sock, struct sockaddr* address,
                        socklen_t* address_len)
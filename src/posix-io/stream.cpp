@@ -0,0 +1,579 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/posix-io/stream.h>
+#include <cmsis-plus/posix-io/file.h>
+#include <cmsis-plus/estd/memory_resource>
+
+#include <cmsis-plus/diag/trace.h>
+
+#include <cassert>
+#include <cerrno>
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace posix
+  {
+    // ------------------------------------------------------------------------
+
+    namespace
+    {
+      // vsnprintf() consumes the arguments; use a copy, to allow retries.
+      int
+      vformat (uint8_t* buf, std::size_t size, const char* format,
+               std::va_list args)
+      {
+        std::va_list ap;
+        va_copy(ap, args);
+        int n = std::vsnprintf (reinterpret_cast<char*> (buf), size, format,
+                                ap);
+        va_end(ap);
+        return n;
+      }
+    } /* namespace */
+
+    // ------------------------------------------------------------------------
+
+    /**
+     * @class stream
+     * @details
+     * Text logging example:
+     *
+     * @code{.cpp}
+     * stream log { uart, stream::buffering::line, 512 };
+     *
+     * log.lock ();
+     * log.puts_unlocked ("temp=");
+     * for (char c : digits)
+     *   {
+     *     log.putc_unlocked (c);
+     *   }
+     * log.putc_unlocked ('\n'); // Writes the line.
+     * log.unlock ();
+     * @endcode
+     */
+
+    /**
+     * @details
+     * If the buffer cannot be allocated, the stream is not buffered.
+     */
+    stream::stream (io* io, buffering mode, std::size_t buffer_size_bytes,
+                    rtos::memory::memory_resource* mr) :
+        io_ (io)
+    {
+      trace::printf ("%s(%p,%u,%u,%p) @%p\n", __func__, io,
+                     static_cast<unsigned int> (mode),
+                     buffer_size_bytes, mr, this);
+
+      assert (io != nullptr);
+
+      mr_ = (mr != nullptr) ? mr : estd::pmr::get_default_resource ();
+      buffer_ = nullptr;
+      size_ = 0;
+      error_ = false;
+      eof_ = false;
+      allocated_ = false;
+
+      internal_set_buffer_ (nullptr, buffer_size_bytes, mode);
+    }
+
+    stream::stream (io* io, buffering mode, void* buffer,
+                    std::size_t buffer_size_bytes) :
+        io_ (io)
+    {
+      trace::printf ("%s(%p,%u,%p,%u) @%p\n", __func__, io,
+                     static_cast<unsigned int> (mode), buffer,
+                     buffer_size_bytes, this);
+
+      assert (io != nullptr);
+      assert (buffer != nullptr);
+
+      mr_ = estd::pmr::get_default_resource ();
+      buffer_ = nullptr;
+      size_ = 0;
+      error_ = false;
+      eof_ = false;
+      allocated_ = false;
+
+      internal_set_buffer_ (buffer, buffer_size_bytes, mode);
+    }
+
+    /**
+     * @details
+     * The `io` object is not closed.
+     */
+    stream::~stream ()
+    {
+      trace::printf ("%s() @%p\n", __func__, this);
+
+      flush_unlocked ();
+      internal_drop_input_ ();
+      internal_free_ ();
+    }
+
+    // ------------------------------------------------------------------------
+
+    ssize_t
+    stream::write (const void* buf, std::size_t nbyte)
+    {
+      mutex_.lock ();
+      ssize_t ret = write_unlocked (buf, nbyte);
+      mutex_.unlock ();
+      return ret;
+    }
+
+    ssize_t
+    stream::read (void* buf, std::size_t nbyte)
+    {
+      mutex_.lock ();
+      ssize_t ret = read_unlocked (buf, nbyte);
+      mutex_.unlock ();
+      return ret;
+    }
+
+    int
+    stream::putc (int c)
+    {
+      mutex_.lock ();
+      int ret = putc_unlocked (c);
+      mutex_.unlock ();
+      return ret;
+    }
+
+    int
+    stream::getc (void)
+    {
+      mutex_.lock ();
+      int ret = getc_unlocked ();
+      mutex_.unlock ();
+      return ret;
+    }
+
+    int
+    stream::puts (const char* s)
+    {
+      mutex_.lock ();
+      int ret = puts_unlocked (s);
+      mutex_.unlock ();
+      return ret;
+    }
+
+    int
+    stream::printf (const char* format, ...)
+    {
+      std::va_list args;
+      va_start(args, format);
+      int ret = vprintf (format, args);
+      va_end(args);
+      return ret;
+    }
+
+    int
+    stream::vprintf (const char* format, std::va_list args)
+    {
+      mutex_.lock ();
+      int ret = vprintf_unlocked (format, args);
+      mutex_.unlock ();
+      return ret;
+    }
+
+    int
+    stream::flush (void)
+    {
+      mutex_.lock ();
+      int ret = flush_unlocked ();
+      mutex_.unlock ();
+      return ret;
+    }
+
+    int
+    stream::set_buffer (void* buffer, std::size_t buffer_size_bytes,
+                        buffering mode)
+    {
+      mutex_.lock ();
+
+      int ret = flush_unlocked ();
+      internal_drop_input_ ();
+      internal_free_ ();
+      if (internal_set_buffer_ (buffer, buffer_size_bytes, mode) < 0)
+        {
+          ret = -1;
+        }
+
+      mutex_.unlock ();
+      return ret;
+    }
+
+    // ------------------------------------------------------------------------
+
+    /**
+     * @details
+     * Reads larger than the buffer go directly to the destination.
+     */
+    ssize_t
+    stream::read_unlocked (void* buf, std::size_t nbyte)
+    {
+      if (flush_unlocked () < 0)
+        {
+          return -1;
+        }
+
+      uint8_t* p = static_cast<uint8_t*> (buf);
+      std::size_t left = nbyte;
+      while (left > 0)
+        {
+          std::size_t avail = static_cast<std::size_t> (rend_ - pos_);
+          if (avail > 0)
+            {
+              std::size_t n = (avail < left) ? avail : left;
+              std::memcpy (p, pos_, n);
+              pos_ += n;
+              p += n;
+              left -= n;
+            }
+          else if (left >= size_)
+            {
+              pos_ = rend_ = buffer_;
+              ssize_t ret = io_->read (p, left);
+              if (ret < 0)
+                {
+                  error_ = true;
+                  break;
+                }
+              if (ret == 0)
+                {
+                  eof_ = true;
+                  break;
+                }
+              p += ret;
+              left -= static_cast<std::size_t> (ret);
+            }
+          else if (!internal_fill_ ())
+            {
+              break;
+            }
+        }
+
+      if (left == nbyte && error_)
+        {
+          return -1;
+        }
+      return static_cast<ssize_t> (nbyte - left);
+    }
+
+    /**
+     * @details
+     * The text is formatted directly in the buffer. Only when it
+     * does not fit in the whole buffer it is formatted in a temporary
+     * buffer, allocated from the memory resource.
+     */
+    int
+    stream::vprintf_unlocked (const char* format, std::va_list args)
+    {
+      int n;
+      if ((mode_ != buffering::none) && (size_ > 0))
+        {
+          internal_begin_write_ ();
+          std::size_t room = static_cast<std::size_t> (wend_ - pos_);
+          n = vformat (pos_, room, format, args);
+          if ((n >= 0) && (static_cast<std::size_t> (n) >= room)
+              && (static_cast<std::size_t> (n) < size_))
+            {
+              // Does not fit in the remaining space, but fits in
+              // an empty buffer.
+              if (flush_unlocked () < 0)
+                {
+                  return -1;
+                }
+              internal_begin_write_ ();
+              n = vformat (pos_, size_, format, args);
+            }
+          if (n < 0)
+            {
+              error_ = true;
+              return -1;
+            }
+          if (static_cast<std::size_t> (n) < size_)
+            {
+              uint8_t* text = pos_;
+              pos_ += n;
+              if ((mode_ == buffering::line)
+                  && (std::memchr (text, '\n', static_cast<std::size_t> (n))
+                      != nullptr))
+                {
+                  if (flush_unlocked () < 0)
+                    {
+                      return -1;
+                    }
+                }
+              return n;
+            }
+        }
+      else
+        {
+          n = vformat (nullptr, 0, format, args);
+          if (n < 0)
+            {
+              error_ = true;
+              return -1;
+            }
+        }
+
+      std::size_t size = static_cast<std::size_t> (n) + 1;
+      uint8_t* tmp = static_cast<uint8_t*> (mr_->allocate (size, 1));
+      if (tmp == nullptr)
+        {
+          error_ = true;
+          errno = ENOMEM;
+          return -1;
+        }
+      vformat (tmp, size, format, args);
+      ssize_t ret = write_unlocked (tmp, static_cast<std::size_t> (n));
+      mr_->deallocate (tmp, size, 1);
+
+      return (ret < 0) ? -1 : n;
+    }
+
+    int
+    stream::flush_unlocked (void)
+    {
+      if (wend_ == buffer_)
+        {
+          // Not writing.
+          return 0;
+        }
+
+      std::size_t n = static_cast<std::size_t> (pos_ - buffer_);
+      pos_ = wend_ = buffer_;
+      if ((n > 0) && (internal_write_all_ (buffer_, n) < 0))
+        {
+          return -1;
+        }
+      return 0;
+    }
+
+    // ------------------------------------------------------------------------
+
+    /**
+     * @cond ignore
+     */
+
+    int
+    stream::internal_set_buffer_ (void* buffer, std::size_t buffer_size_bytes,
+                                  buffering mode)
+    {
+      int ret = 0;
+      mode_ = mode;
+      if ((mode == buffering::none) || (buffer_size_bytes == 0))
+        {
+          mode_ = buffering::none;
+        }
+      else if (buffer != nullptr)
+        {
+          buffer_ = static_cast<uint8_t*> (buffer);
+          size_ = buffer_size_bytes;
+        }
+      else
+        {
+          buffer_ = static_cast<uint8_t*> (mr_->allocate (buffer_size_bytes,
+                                                          1));
+          if (buffer_ != nullptr)
+            {
+              size_ = buffer_size_bytes;
+              allocated_ = true;
+            }
+          else
+            {
+              mode_ = buffering::none;
+              errno = ENOMEM;
+              ret = -1;
+            }
+        }
+
+      pos_ = wend_ = rend_ = buffer_;
+      return ret;
+    }
+
+    void
+    stream::internal_begin_write_ (void)
+    {
+      if (wend_ == buffer_)
+        {
+          internal_drop_input_ ();
+          wend_ = buffer_ + size_;
+        }
+    }
+
+    ssize_t
+    stream::internal_write_ (const void* buf, std::size_t nbyte)
+    {
+      if ((mode_ != buffering::none) && (nbyte < size_))
+        {
+          internal_begin_write_ ();
+
+          const uint8_t* p = static_cast<const uint8_t*> (buf);
+          std::size_t left = nbyte;
+          std::size_t room = static_cast<std::size_t> (wend_ - pos_);
+          if (left > room)
+            {
+              std::memcpy (pos_, p, room);
+              pos_ += room;
+              p += room;
+              left -= room;
+              if (flush_unlocked () < 0)
+                {
+                  return -1;
+                }
+              internal_begin_write_ ();
+            }
+          std::memcpy (pos_, p, left);
+          pos_ += left;
+
+          if ((mode_ == buffering::line)
+              && (std::memchr (buf, '\n', nbyte) != nullptr))
+            {
+              if (flush_unlocked () < 0)
+                {
+                  return -1;
+                }
+            }
+          return static_cast<ssize_t> (nbyte);
+        }
+
+      // Not buffered, or larger than the buffer; write the pending
+      // bytes, then the new ones directly.
+      if (flush_unlocked () < 0)
+        {
+          return -1;
+        }
+      internal_drop_input_ ();
+      return internal_write_all_ (buf, nbyte);
+    }
+
+    int
+    stream::internal_putc_ (int c)
+    {
+      uint8_t ch = static_cast<uint8_t> (c);
+      return (internal_write_ (&ch, 1) < 0) ? EOF : ch;
+    }
+
+    int
+    stream::internal_getc_ (void)
+    {
+      uint8_t ch;
+      return (read_unlocked (&ch, 1) == 1) ? ch : EOF;
+    }
+
+    bool
+    stream::internal_fill_ (void)
+    {
+      pos_ = rend_ = buffer_;
+      ssize_t ret = io_->read (buffer_, size_);
+      if (ret < 0)
+        {
+          error_ = true;
+          return false;
+        }
+      if (ret == 0)
+        {
+          eof_ = true;
+          return false;
+        }
+      rend_ = buffer_ + ret;
+      return true;
+    }
+
+    ssize_t
+    stream::internal_write_all_ (const void* buf, std::size_t nbyte)
+    {
+      const uint8_t* p = static_cast<const uint8_t*> (buf);
+      std::size_t left = nbyte;
+      while (left > 0)
+        {
+          ssize_t ret = io_->write (p, left);
+          if (ret <= 0)
+            {
+              if (ret == 0)
+                {
+                  errno = EIO;
+                }
+              error_ = true;
+              return -1;
+            }
+          p += ret;
+          left -= static_cast<std::size_t> (ret);
+        }
+      return static_cast<ssize_t> (nbyte);
+    }
+
+    /**
+     * @details
+     * For files, move the position back over the unread bytes,
+     * so that the next write or read continues from where
+     * the user stopped.
+     */
+    void
+    stream::internal_drop_input_ (void)
+    {
+      if (rend_ == buffer_)
+        {
+          // Not reading.
+          return;
+        }
+
+      std::size_t unread = static_cast<std::size_t> (rend_ - pos_);
+      pos_ = rend_ = buffer_;
+      if ((unread > 0) && ((io_->get_type () & io::type::file) != 0))
+        {
+          static_cast<file*> (io_)->lseek (-static_cast<off_t> (unread),
+                                           SEEK_CUR);
+        }
+    }
+
+    void
+    stream::internal_free_ (void)
+    {
+      if (allocated_)
+        {
+          mr_->deallocate (buffer_, size_, 1);
+          allocated_ = false;
+        }
+      buffer_ = nullptr;
+      size_ = 0;
+      pos_ = wend_ = rend_ = buffer_;
+    }
+
+  /**
+   * @endcond
+   */
+
+  } /* namespace posix */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
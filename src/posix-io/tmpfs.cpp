@@ -0,0 +1,1448 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/posix-io/tmpfs.h>
+#include <cmsis-plus/posix-io/pool.h>
+#include <cmsis-plus/rtos/os.h>
+#include <cmsis-plus/estd/memory_resource>
+
+#include <cerrno>
+#include <cassert>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace posix
+  {
+    // ========================================================================
+
+    /**
+     * @details
+     * If the memory resource is not specified, the application
+     * default resource is used. The root directory is created
+     * at mount.
+     */
+    tmpfs::tmpfs (pool* files_pool, pool* dirs_pool,
+                  rtos::memory::memory_resource* mr, std::size_t buckets) :
+        file_system
+          { files_pool, dirs_pool }
+    {
+      trace::printf ("%s(%p,%p,%p,%u) @%p\n", __func__, files_pool, dirs_pool,
+                     mr, buckets, this);
+
+      assert (buckets > 0);
+
+      mr_ = (mr != nullptr) ? mr : estd::pmr::get_default_resource ();
+      buckets_count_ = buckets;
+      root_ = nullptr;
+      used_bytes_ = 0;
+
+      buckets_ = static_cast<node_s**> (mr_->allocate (
+          buckets * sizeof(node_s*), alignof(node_s*)));
+      assert (buckets_ != nullptr);
+
+      for (std::size_t i = 0; i < buckets; ++i)
+        {
+          buckets_[i] = nullptr;
+        }
+    }
+
+    /**
+     * @details
+     * All files and directories are destroyed.
+     */
+    tmpfs::~tmpfs ()
+    {
+      trace::printf ("%s() @%p\n", __func__, this);
+
+      if (root_ != nullptr)
+        {
+          internal_destroy_all_ (root_);
+          root_ = nullptr;
+        }
+
+      mr_->deallocate (buckets_, buckets_count_ * sizeof(node_s*),
+                       alignof(node_s*));
+      buckets_ = nullptr;
+    }
+
+    // ------------------------------------------------------------------------
+
+    int
+    tmpfs::do_chmod (const char* path, mode_t mode)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      node_s* node = internal_resolve_ (path, nullptr, nullptr, nullptr);
+      if (node == nullptr)
+        {
+          return -1;
+        }
+
+      node->mode = (node->mode & S_IFMT) | (mode & ~S_IFMT);
+      return 0;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    int
+    tmpfs::do_stat (const char* path, struct stat* buf)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      node_s* node = internal_resolve_ (path, nullptr, nullptr, nullptr);
+      if (node == nullptr)
+        {
+          return -1;
+        }
+
+      internal_stat_ (node, buf);
+      return 0;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    int
+    tmpfs::do_truncate (const char* path, off_t length)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      node_s* node = internal_resolve_ (path, nullptr, nullptr, nullptr);
+      if (node == nullptr)
+        {
+          return -1;
+        }
+
+      if (S_ISDIR(node->mode))
+        {
+          errno = EISDIR;
+          return -1;
+        }
+
+      return internal_truncate_ (node, length);
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /**
+     * @details
+     * An existing destination is replaced, if it is a file, or
+     * an empty directory and the source is also a directory.
+     */
+    int
+    tmpfs::do_rename (const char* existing, const char* _new)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      node_s* node = internal_resolve_ (existing, nullptr, nullptr, nullptr);
+      if (node == nullptr)
+        {
+          return -1;
+        }
+      if (node == root_)
+        {
+          errno = EBUSY;
+          return -1;
+        }
+
+      node_s* parent;
+      const char* name;
+      std::size_t length;
+      node_s* target = internal_resolve_ (_new, &parent, &name, &length);
+      if (parent == nullptr)
+        {
+          return -1;
+        }
+
+      if (target == node)
+        {
+          // Same file, nothing to do.
+          return 0;
+        }
+
+      // A directory cannot be moved inside itself.
+      for (node_s* p = parent; p != root_; p = p->parent)
+        {
+          if (p == node)
+            {
+              errno = EINVAL;
+              return -1;
+            }
+        }
+
+      if (target != nullptr)
+        {
+          if (S_ISDIR(target->mode))
+            {
+              if (!S_ISDIR(node->mode))
+                {
+                  errno = EISDIR;
+                  return -1;
+                }
+              if (target->first_child != nullptr)
+                {
+                  errno = ENOTEMPTY;
+                  return -1;
+                }
+              if (internal_is_busy_ (target))
+                {
+                  errno = EBUSY;
+                  return -1;
+                }
+            }
+          else if (S_ISDIR(node->mode))
+            {
+              errno = ENOTDIR;
+              return -1;
+            }
+        }
+
+      char* new_name = static_cast<char*> (mr_->allocate (length + 1, 1));
+      if (new_name == nullptr)
+        {
+          errno = ENOSPC;
+          return -1;
+        }
+      std::memcpy (new_name, name, length);
+      new_name[length] = '\0';
+
+      if (target != nullptr)
+        {
+          internal_unlink_ (target);
+          if (target->opens == 0)
+            {
+              internal_destroy_ (target);
+            }
+        }
+
+      internal_unlink_ (node);
+      node->unlinked = false;
+
+      mr_->deallocate (node->name, node->name_length + 1, 1);
+      node->name = new_name;
+      node->name_length = length;
+
+      internal_link_ (node, parent);
+      node->mtime = internal_now_ ();
+
+      return 0;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /**
+     * @details
+     * If the file is open, the content is kept until the last close.
+     */
+    int
+    tmpfs::do_unlink (const char* path)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      node_s* node = internal_resolve_ (path, nullptr, nullptr, nullptr);
+      if (node == nullptr)
+        {
+          return -1;
+        }
+
+      if (S_ISDIR(node->mode))
+        {
+          errno = EISDIR;
+          return -1;
+        }
+
+      internal_unlink_ (node);
+      if (node->opens == 0)
+        {
+          internal_destroy_ (node);
+        }
+
+      return 0;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    int
+    tmpfs::do_utime (const char* path, const struct utimbuf* times)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      node_s* node = internal_resolve_ (path, nullptr, nullptr, nullptr);
+      if (node == nullptr)
+        {
+          return -1;
+        }
+
+      node->mtime = times->modtime;
+      return 0;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    int
+    tmpfs::do_mkdir (const char* path, mode_t mode)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      node_s* parent;
+      const char* name;
+      std::size_t length;
+      node_s* node = internal_resolve_ (path, &parent, &name, &length);
+      if (parent == nullptr)
+        {
+          return -1;
+        }
+
+      if (node != nullptr)
+        {
+          errno = EEXIST;
+          return -1;
+        }
+
+      node = internal_create_ (parent, name, length,
+                               S_IFDIR | (mode & ~S_IFMT));
+      if (node == nullptr)
+        {
+          return -1;
+        }
+
+      return 0;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    int
+    tmpfs::do_rmdir (const char* path)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      node_s* node = internal_resolve_ (path, nullptr, nullptr, nullptr);
+      if (node == nullptr)
+        {
+          return -1;
+        }
+
+      if (!S_ISDIR(node->mode))
+        {
+          errno = ENOTDIR;
+          return -1;
+        }
+
+      if (node->first_child != nullptr)
+        {
+          errno = ENOTEMPTY;
+          return -1;
+        }
+
+      if (node == root_ || internal_is_busy_ (node))
+        {
+          errno = EBUSY;
+          return -1;
+        }
+
+      internal_unlink_ (node);
+      internal_destroy_ (node);
+
+      return 0;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    void
+    tmpfs::do_sync (void)
+    {
+      // Nothing to write back.
+    }
+
+    int
+    tmpfs::do_mount (unsigned int flags __attribute__((unused)))
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      if (root_ == nullptr)
+        {
+          root_ = internal_create_ (nullptr, "", 0, S_IFDIR | 0777);
+          if (root_ == nullptr)
+            {
+              return -1;
+            }
+        }
+
+      return 0;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /**
+     * @details
+     * The content is preserved; it is destroyed with the object.
+     */
+    int
+    tmpfs::do_unmount (unsigned int flags __attribute__((unused)))
+    {
+      return 0;
+    }
+
+    // ------------------------------------------------------------------------
+
+    /**
+     * @cond ignore
+     */
+
+    std::size_t
+    tmpfs::internal_hash_ (const node_s* parent, const char* name,
+                           std::size_t length)
+    {
+      // FNV-1a, seeded with the parent address.
+      uint32_t h = 2166136261u
+          ^ static_cast<uint32_t> (reinterpret_cast<std::uintptr_t> (parent)
+              >> 2);
+      for (std::size_t i = 0; i < length; ++i)
+        {
+          h ^= static_cast<uint8_t> (name[i]);
+          h *= 16777619u;
+        }
+      return h;
+    }
+
+    tmpfs::node_s*
+    tmpfs::internal_find_ (const node_s* parent, const char* name,
+                           std::size_t length)
+    {
+      std::size_t hash = internal_hash_ (parent, name, length);
+      node_s* node = buckets_[hash % buckets_count_];
+      while (node != nullptr)
+        {
+          if (node->hash == hash && node->parent == parent
+              && node->name_length == length
+              && std::memcmp (node->name, name, length) == 0)
+            {
+              return node;
+            }
+          node = node->hash_next;
+        }
+
+      return nullptr;
+    }
+
+    /*
+     * Walk the path from the root. Return the node, or nullptr
+     * and ENOENT/ENOTDIR. If `parent` is not null, also return
+     * the parent directory and the last name, which may not exist;
+     * on errors, the parent is nullptr.
+     */
+    tmpfs::node_s*
+    tmpfs::internal_resolve_ (const char* path, node_s** parent,
+                              const char** name, std::size_t* length)
+    {
+      if (parent != nullptr)
+        {
+          *parent = nullptr;
+        }
+
+      if (root_ == nullptr)
+        {
+          errno = ENOENT;
+          return nullptr;
+        }
+
+      node_s* dir = root_;
+      node_s* node = root_;
+      const char* last = nullptr;
+      std::size_t last_length = 0;
+
+      const char* p = path;
+      while (true)
+        {
+          while (*p == '/')
+            {
+              ++p;
+            }
+          if (*p == '\0')
+            {
+              break;
+            }
+
+          if (node == nullptr)
+            {
+              // A middle component does not exist.
+              errno = ENOENT;
+              return nullptr;
+            }
+          if (!S_ISDIR(node->mode))
+            {
+              errno = ENOTDIR;
+              return nullptr;
+            }
+          dir = node;
+
+          const char* begin = p;
+          while (*p != '\0' && *p != '/')
+            {
+              ++p;
+            }
+          std::size_t len = static_cast<std::size_t> (p - begin);
+
+          if (len == 1 && begin[0] == '.')
+            {
+              last = nullptr;
+              continue;
+            }
+          if (len == 2 && begin[0] == '.' && begin[1] == '.')
+            {
+              node = (dir->parent != nullptr) ? dir->parent : dir;
+              last = nullptr;
+              continue;
+            }
+
+          last = begin;
+          last_length = len;
+          node = internal_find_ (dir, begin, len);
+        }
+
+      if (parent != nullptr)
+        {
+          if (last == nullptr)
+            {
+              // The path ends with the root, `.` or `..`.
+              errno = (node != nullptr) ? EEXIST : ENOENT;
+              return node;
+            }
+          if (last_length >= sizeof(dirent::d_name))
+            {
+              errno = ENAMETOOLONG;
+              return node;
+            }
+          *parent = dir;
+          *name = last;
+          *length = last_length;
+        }
+
+      if (node == nullptr)
+        {
+          errno = ENOENT;
+        }
+      return node;
+    }
+
+    tmpfs::node_s*
+    tmpfs::internal_create_ (node_s* parent, const char* name,
+                             std::size_t length, mode_t mode)
+    {
+      node_s* node = static_cast<node_s*> (mr_->allocate (sizeof(node_s),
+                                                          alignof(node_s)));
+      if (node == nullptr)
+        {
+          errno = ENOSPC;
+          return nullptr;
+        }
+
+      char* str = static_cast<char*> (mr_->allocate (length + 1, 1));
+      if (str == nullptr)
+        {
+          mr_->deallocate (node, sizeof(node_s), alignof(node_s));
+          errno = ENOSPC;
+          return nullptr;
+        }
+      std::memcpy (str, name, length);
+      str[length] = '\0';
+
+      std::memset (node, 0, sizeof(node_s));
+      node->name = str;
+      node->name_length = length;
+      node->mode = mode;
+      node->mtime = internal_now_ ();
+
+      if (parent != nullptr)
+        {
+          internal_link_ (node, parent);
+        }
+
+      return node;
+    }
+
+    void
+    tmpfs::internal_link_ (node_s* node, node_s* parent)
+    {
+      node->parent = parent;
+      node->hash = internal_hash_ (parent, node->name, node->name_length);
+
+      node_s** bucket = &buckets_[node->hash % buckets_count_];
+      node->hash_next = *bucket;
+      *bucket = node;
+
+      node->prev_sibling = nullptr;
+      node->next_sibling = parent->first_child;
+      if (parent->first_child != nullptr)
+        {
+          parent->first_child->prev_sibling = node;
+        }
+      parent->first_child = node;
+
+      parent->mtime = internal_now_ ();
+    }
+
+    /*
+     * Remove the node from the hash table and from the parent;
+     * the open directories positioned on it skip to the next one.
+     */
+    void
+    tmpfs::internal_unlink_ (node_s* node)
+    {
+      node_s** link = &buckets_[node->hash % buckets_count_];
+      while (*link != node)
+        {
+          link = &(*link)->hash_next;
+        }
+      *link = node->hash_next;
+
+      pool* dirs = dirs_pool ();
+      if (dirs != nullptr)
+        {
+          for (std::size_t i = 0; i < dirs->size (); ++i)
+            {
+              if (dirs->in_use (i))
+                {
+                  auto* dir = static_cast<tmpfs_directory*> (dirs->object (i));
+                  if (dir->next_ == node)
+                    {
+                      dir->next_ = node->next_sibling;
+                    }
+                }
+            }
+        }
+
+      node_s* parent = node->parent;
+      if (node->prev_sibling != nullptr)
+        {
+          node->prev_sibling->next_sibling = node->next_sibling;
+        }
+      else
+        {
+          parent->first_child = node->next_sibling;
+        }
+      if (node->next_sibling != nullptr)
+        {
+          node->next_sibling->prev_sibling = node->prev_sibling;
+        }
+
+      parent->mtime = internal_now_ ();
+      node->unlinked = true;
+    }
+
+    void
+    tmpfs::internal_destroy_ (node_s* node)
+    {
+      internal_truncate_ (node, 0);
+      mr_->deallocate (node->name, node->name_length + 1, 1);
+      mr_->deallocate (node, sizeof(node_s), alignof(node_s));
+    }
+
+    void
+    tmpfs::internal_destroy_all_ (node_s* node)
+    {
+      node_s* child = node->first_child;
+      while (child != nullptr)
+        {
+          node_s* next = child->next_sibling;
+          internal_destroy_all_ (child);
+          child = next;
+        }
+      internal_destroy_ (node);
+    }
+
+    bool
+    tmpfs::internal_is_busy_ (const node_s* node) const
+    {
+      pool* dirs = dirs_pool ();
+      if (dirs != nullptr)
+        {
+          for (std::size_t i = 0; i < dirs->size (); ++i)
+            {
+              if (dirs->in_use (i)
+                  && static_cast<tmpfs_directory*> (dirs->object (i))->node_
+                      == node)
+                {
+                  return true;
+                }
+            }
+        }
+
+      return false;
+    }
+
+    void
+    tmpfs::internal_stat_ (const node_s* node, struct stat* buf) const
+    {
+      std::memset (buf, 0, sizeof(struct stat));
+      buf->st_mode = node->mode;
+      buf->st_nlink = node->unlinked ? 0 : 1;
+      buf->st_size = node->size;
+      buf->st_ino = static_cast<ino_t> (reinterpret_cast<std::uintptr_t> (node));
+      buf->st_mtime = node->mtime;
+      buf->st_atime = node->mtime;
+      buf->st_ctime = node->mtime;
+    }
+
+    /*
+     * Fill the free space in the last extent, then add extents,
+     * each twice as large as the previous one. If `buf` is null,
+     * append zeros. Return the number of bytes appended.
+     */
+    ssize_t
+    tmpfs::internal_append_ (node_s* node, const void* buf, std::size_t nbyte)
+    {
+      const char* src = static_cast<const char*> (buf);
+      std::size_t count = 0;
+
+      while (count < nbyte)
+        {
+          extent_s* extent = node->last_extent;
+          if (extent == nullptr || extent->used == extent->capacity)
+            {
+              std::size_t capacity = OS_INTEGER_POSIX_IO_TMPFS_MIN_EXTENT_BYTES;
+              if (extent != nullptr)
+                {
+                  capacity = extent->capacity * 2;
+                  if (capacity > OS_INTEGER_POSIX_IO_TMPFS_MAX_EXTENT_BYTES)
+                    {
+                      capacity = OS_INTEGER_POSIX_IO_TMPFS_MAX_EXTENT_BYTES;
+                    }
+                }
+
+              extent = static_cast<extent_s*> (mr_->allocate (
+                  sizeof(extent_s) + capacity, alignof(extent_s)));
+              if (extent == nullptr)
+                {
+                  break;
+                }
+              extent->next = nullptr;
+              extent->capacity = capacity;
+              extent->used = 0;
+
+              if (node->last_extent != nullptr)
+                {
+                  node->last_extent->next = extent;
+                }
+              else
+                {
+                  node->first_extent = extent;
+                }
+              node->last_extent = extent;
+            }
+
+          std::size_t n = extent->capacity - extent->used;
+          if (n > nbyte - count)
+            {
+              n = nbyte - count;
+            }
+
+          char* dst = internal_data_ (extent) + extent->used;
+          if (src != nullptr)
+            {
+              std::memcpy (dst, src + count, n);
+            }
+          else
+            {
+              std::memset (dst, 0, n);
+            }
+
+          extent->used += n;
+          count += n;
+        }
+
+      node->size += static_cast<off_t> (count);
+      used_bytes_ += count;
+      node->mtime = internal_now_ ();
+
+      if (count == 0 && nbyte > 0)
+        {
+          errno = ENOSPC;
+          return -1;
+        }
+      return static_cast<ssize_t> (count);
+    }
+
+    int
+    tmpfs::internal_truncate_ (node_s* node, off_t length)
+    {
+      if (length > node->size)
+        {
+          std::size_t n = static_cast<std::size_t> (length - node->size);
+          if (internal_append_ (node, nullptr, n) != static_cast<ssize_t> (n))
+            {
+              errno = ENOSPC;
+              return -1;
+            }
+          return 0;
+        }
+
+      if (node->mappings > 0)
+        {
+          errno = EBUSY;
+          return -1;
+        }
+
+      // Keep the extents up to the new length, free the others.
+      extent_s* keep = nullptr;
+      extent_s* extent = node->first_extent;
+      off_t start = 0;
+      if (length > 0)
+        {
+          while (start + static_cast<off_t> (extent->used) < length)
+            {
+              start += static_cast<off_t> (extent->used);
+              extent = extent->next;
+            }
+          keep = extent;
+          keep->used = static_cast<std::size_t> (length - start);
+          extent = keep->next;
+          keep->next = nullptr;
+        }
+
+      while (extent != nullptr)
+        {
+          extent_s* next = extent->next;
+          mr_->deallocate (extent, sizeof(extent_s) + extent->capacity,
+                           alignof(extent_s));
+          extent = next;
+        }
+
+      if (keep == nullptr)
+        {
+          node->first_extent = nullptr;
+        }
+      node->last_extent = keep;
+
+      used_bytes_ -= static_cast<std::size_t> (node->size - length);
+      node->size = length;
+      ++node->generation;
+      node->mtime = internal_now_ ();
+
+      return 0;
+    }
+
+    /*
+     * Find the extent which holds the byte at `offset`, which
+     * must be less than the size, starting from the hint if
+     * possible. Return the extent and its start offset.
+     */
+    tmpfs::extent_s*
+    tmpfs::internal_locate_ (node_s* node, off_t offset, extent_s* hint,
+                             off_t hint_start, off_t* start)
+    {
+      extent_s* extent = node->first_extent;
+      off_t pos = 0;
+      if (hint != nullptr && hint_start <= offset)
+        {
+          extent = hint;
+          pos = hint_start;
+        }
+
+      while (pos + static_cast<off_t> (extent->used) <= offset)
+        {
+          pos += static_cast<off_t> (extent->used);
+          extent = extent->next;
+        }
+
+      *start = pos;
+      return extent;
+    }
+
+    std::time_t
+    tmpfs::internal_now_ (void)
+    {
+      return static_cast<std::time_t> (rtos::rtclock.now ());
+    }
+
+    /**
+     * @endcond
+     */
+
+    // ========================================================================
+
+    tmpfs_file::tmpfs_file ()
+    {
+      node_ = nullptr;
+      offset_ = 0;
+      hint_ = nullptr;
+      hint_start_ = 0;
+      hint_generation_ = 0;
+    }
+
+    tmpfs_file::~tmpfs_file ()
+    {
+      node_ = nullptr;
+    }
+
+    // ------------------------------------------------------------------------
+
+    int
+    tmpfs_file::do_vopen (const char* path, int oflag, std::va_list args)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      tmpfs* fs = this->fs ();
+
+      tmpfs::node_s* parent;
+      const char* name;
+      std::size_t length;
+      tmpfs::node_s* node = fs->internal_resolve_ (path, &parent, &name,
+                                                   &length);
+
+      if (node != nullptr)
+        {
+          if ((oflag & (O_CREAT | O_EXCL)) == (O_CREAT | O_EXCL))
+            {
+              errno = EEXIST;
+              return -1;
+            }
+          if (S_ISDIR(node->mode))
+            {
+              errno = EISDIR;
+              return -1;
+            }
+        }
+      else
+        {
+          if (parent == nullptr)
+            {
+              return -1;
+            }
+          if ((oflag & O_CREAT) == 0)
+            {
+              errno = ENOENT;
+              return -1;
+            }
+
+          mode_t mode = static_cast<mode_t> (va_arg(args, int));
+          node = fs->internal_create_ (parent, name, length,
+                                       S_IFREG | (mode & ~S_IFMT));
+          if (node == nullptr)
+            {
+              return -1;
+            }
+        }
+
+      if ((oflag & O_TRUNC) != 0 && (oflag & O_ACCMODE) != O_RDONLY)
+        {
+          fs->internal_truncate_ (node, 0);
+        }
+
+      ++node->opens;
+
+      node_ = node;
+      offset_ = 0;
+      hint_ = nullptr;
+      hint_start_ = 0;
+      hint_generation_ = node->generation;
+
+      return 0;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /**
+     * @details
+     * If the file was unlinked, the content is freed at the last close.
+     */
+    int
+    tmpfs_file::do_close (void)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      if (node_ != nullptr)
+        {
+          if (--node_->opens == 0 && node_->unlinked)
+            {
+              fs ()->internal_destroy_ (node_);
+            }
+          node_ = nullptr;
+        }
+
+      return 0;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    ssize_t
+    tmpfs_file::do_read (void* buf, std::size_t nbyte)
+    {
+      if ((oflag_ & O_ACCMODE) == O_WRONLY)
+        {
+          errno = EBADF;
+          return -1;
+        }
+
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      if (offset_ >= node_->size)
+        {
+          return 0;
+        }
+
+      if (hint_generation_ != node_->generation)
+        {
+          hint_ = nullptr;
+          hint_generation_ = node_->generation;
+        }
+
+      std::size_t available = static_cast<std::size_t> (node_->size - offset_);
+      if (nbyte > available)
+        {
+          nbyte = available;
+        }
+
+      off_t start;
+      tmpfs::extent_s* extent = fs ()->internal_locate_ (node_, offset_, hint_,
+                                                         hint_start_, &start);
+
+      char* dst = static_cast<char*> (buf);
+      std::size_t count = 0;
+      while (count < nbyte)
+        {
+          std::size_t pos = static_cast<std::size_t> (offset_ - start);
+          std::size_t n = extent->used - pos;
+          if (n > nbyte - count)
+            {
+              n = nbyte - count;
+            }
+
+          std::memcpy (dst + count, tmpfs::internal_data_ (extent) + pos, n);
+          count += n;
+          offset_ += static_cast<off_t> (n);
+
+          hint_ = extent;
+          hint_start_ = start;
+          if (offset_ - start == static_cast<off_t> (extent->used))
+            {
+              start += static_cast<off_t> (extent->used);
+              extent = extent->next;
+              if (extent != nullptr)
+                {
+                  hint_ = extent;
+                  hint_start_ = start;
+                }
+            }
+        }
+
+      return static_cast<ssize_t> (count);
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /**
+     * @details
+     * The part overlapping the existing content is overwritten
+     * in place, the rest is appended.
+     */
+    ssize_t
+    tmpfs_file::do_write (const void* buf, std::size_t nbyte)
+    {
+      if ((oflag_ & O_ACCMODE) == O_RDONLY)
+        {
+          errno = EBADF;
+          return -1;
+        }
+
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      tmpfs* fs = this->fs ();
+
+      if ((oflag_ & O_APPEND) != 0)
+        {
+          offset_ = node_->size;
+        }
+
+      if (offset_ > node_->size)
+        {
+          // Fill the gap with zeros.
+          if (fs->internal_truncate_ (node_, offset_) < 0)
+            {
+              return -1;
+            }
+        }
+
+      if (hint_generation_ != node_->generation)
+        {
+          hint_ = nullptr;
+          hint_generation_ = node_->generation;
+        }
+
+      const char* src = static_cast<const char*> (buf);
+      std::size_t count = 0;
+
+      if (offset_ < node_->size)
+        {
+          off_t start;
+          tmpfs::extent_s* extent = fs->internal_locate_ (node_, offset_,
+                                                          hint_, hint_start_,
+                                                          &start);
+          while (count < nbyte && extent != nullptr)
+            {
+              std::size_t pos = static_cast<std::size_t> (offset_ - start);
+              std::size_t n = extent->used - pos;
+              if (n > nbyte - count)
+                {
+                  n = nbyte - count;
+                }
+
+              std::memcpy (tmpfs::internal_data_ (extent) + pos, src + count,
+                           n);
+              count += n;
+              offset_ += static_cast<off_t> (n);
+
+              hint_ = extent;
+              hint_start_ = start;
+              if (offset_ - start == static_cast<off_t> (extent->used))
+                {
+                  start += static_cast<off_t> (extent->used);
+                  extent = extent->next;
+                }
+            }
+          node_->mtime = tmpfs::internal_now_ ();
+        }
+
+      if (count < nbyte)
+        {
+          ssize_t ret = fs->internal_append_ (node_, src + count,
+                                              nbyte - count);
+          if (ret < 0)
+            {
+              return (count > 0) ? static_cast<ssize_t> (count) : -1;
+            }
+          count += static_cast<std::size_t> (ret);
+          offset_ += ret;
+        }
+
+      return static_cast<ssize_t> (count);
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    off_t
+    tmpfs_file::do_lseek (off_t offset, int whence)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      off_t base;
+      switch (whence)
+        {
+        case SEEK_SET:
+          base = 0;
+          break;
+
+        case SEEK_CUR:
+          base = offset_;
+          break;
+
+        case SEEK_END:
+          base = node_->size;
+          break;
+
+        default:
+          errno = EINVAL;
+          return -1;
+        }
+
+      if (base + offset < 0)
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      offset_ = base + offset;
+      return offset_;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    int
+    tmpfs_file::do_ftruncate (off_t length)
+    {
+      if ((oflag_ & O_ACCMODE) == O_RDONLY)
+        {
+          errno = EINVAL;
+          return -1;
+        }
+
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      return fs ()->internal_truncate_ (node_, length);
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    int
+    tmpfs_file::do_fsync (void)
+    {
+      // The content is always up to date.
+      return 0;
+    }
+
+    int
+    tmpfs_file::do_fstat (struct stat* buf)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      fs ()->internal_stat_ (node_, buf);
+      return 0;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /**
+     * @details
+     * The extents are written to the destination in place. During
+     * the write the file is counted as mapped, so it cannot be
+     * shrunk and the extent remains valid.
+     */
+    ssize_t
+    tmpfs_file::do_splice_to (io* out, std::size_t count)
+    {
+      if ((oflag_ & O_ACCMODE) == O_WRONLY)
+        {
+          errno = EBADF;
+          return -1;
+        }
+
+      std::size_t total = 0;
+      while (total < count)
+        {
+          tmpfs::extent_s* extent;
+          off_t start;
+          const char* p;
+          std::size_t n;
+            {
+              // ----- Enter critical section ---------------------------------
+              rtos::scheduler::critical_section scs;
+
+              if (offset_ >= node_->size)
+                {
+                  break;
+                }
+
+              if (hint_generation_ != node_->generation)
+                {
+                  hint_ = nullptr;
+                  hint_generation_ = node_->generation;
+                }
+
+              extent = fs ()->internal_locate_ (node_, offset_, hint_,
+                                                hint_start_, &start);
+
+              std::size_t pos = static_cast<std::size_t> (offset_ - start);
+              p = tmpfs::internal_data_ (extent) + pos;
+              n = extent->used - pos;
+              if (n > count - total)
+                {
+                  n = count - total;
+                }
+
+              ++node_->mappings;
+              // ----- Exit critical section ----------------------------------
+            }
+
+          ssize_t ret = out->write (p, n);
+
+            {
+              // ----- Enter critical section ---------------------------------
+              rtos::scheduler::critical_section scs;
+
+              --node_->mappings;
+              if (ret > 0)
+                {
+                  offset_ += ret;
+                  hint_ = extent;
+                  hint_start_ = start;
+                }
+              // ----- Exit critical section ----------------------------------
+            }
+
+          if (ret <= 0)
+            {
+              return (total > 0) ? static_cast<ssize_t> (total) : ret;
+            }
+          total += static_cast<std::size_t> (ret);
+
+          if (static_cast<std::size_t> (ret) < n)
+            {
+              break;
+            }
+        }
+
+      return static_cast<ssize_t> (total);
+    }
+
+    /**
+     * @details
+     * If the range is inside a single extent, return its address;
+     * otherwise the caller uses a copy.
+     */
+    void*
+    tmpfs_file::do_mmap (std::size_t length, int prot __attribute__((unused)),
+                         int flags __attribute__((unused)), off_t offset)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      if (offset + static_cast<off_t> (length) > node_->size)
+        {
+          return nullptr;
+        }
+
+      off_t start;
+      tmpfs::extent_s* extent = fs ()->internal_locate_ (node_, offset,
+                                                         nullptr, 0, &start);
+      if (offset + static_cast<off_t> (length)
+          > start + static_cast<off_t> (extent->used))
+        {
+          // Spans more than one extent.
+          return nullptr;
+        }
+
+      ++node_->mappings;
+      return tmpfs::internal_data_ (extent) + (offset - start);
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    int
+    tmpfs_file::do_munmap (void* addr __attribute__((unused)),
+                           std::size_t length __attribute__((unused)))
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      --node_->mappings;
+      return 0;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    bool
+    tmpfs_file::do_is_opened (void)
+    {
+      return node_ != nullptr;
+    }
+
+    // ========================================================================
+
+    tmpfs_directory::tmpfs_directory ()
+    {
+      node_ = nullptr;
+      next_ = nullptr;
+    }
+
+    tmpfs_directory::~tmpfs_directory ()
+    {
+      node_ = nullptr;
+      next_ = nullptr;
+    }
+
+    // ------------------------------------------------------------------------
+
+    directory*
+    tmpfs_directory::do_vopen (const char* dirname)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      auto* fs = static_cast<tmpfs*> (file_system ());
+      tmpfs::node_s* node = fs->internal_resolve_ (dirname, nullptr, nullptr,
+                                                   nullptr);
+      if (node == nullptr)
+        {
+          return nullptr;
+        }
+
+      if (!S_ISDIR(node->mode))
+        {
+          errno = ENOTDIR;
+          return nullptr;
+        }
+
+      node_ = node;
+      next_ = node->first_child;
+
+      return this;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /**
+     * @details
+     * The entries are returned in reverse order of creation;
+     * `.` and `..` are not returned.
+     */
+    struct dirent*
+    tmpfs_directory::do_read (void)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      if (next_ == nullptr)
+        {
+          return nullptr;
+        }
+
+      struct dirent* entry = dir_entry ();
+      std::memcpy (entry->d_name, next_->name, next_->name_length + 1);
+
+      next_ = next_->next_sibling;
+      return entry;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    void
+    tmpfs_directory::do_rewind (void)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      next_ = node_->first_child;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    int
+    tmpfs_directory::do_close (void)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::scheduler::critical_section scs;
+
+      node_ = nullptr;
+      next_ = nullptr;
+
+      return 0;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+  } /* namespace posix */
+} /* namespace os */
+
+// ----------------------------------------------------------------------------
@@ -31,6 +31,9 @@
  */
 
 #include <cmsis-plus/rtos/os.h>
+
+// This file provides the out of line definitions.
+#undef OS_USE_RTOS_C_API_INLINE
 #include <cmsis-plus/rtos/os-c-api.h>
 
 // ----------------------------------------------------------------------------
@@ -72,6 +75,9 @@ static_assert(alignof(os_statistics_counter_t) == alignof(statistics::counter_t)
 static_assert(sizeof(os_statistics_duration_t) == sizeof(statistics::duration_t), "adjust size of os_statistics_duration_t");
 static_assert(alignof(os_statistics_duration_t) == alignof(statistics::duration_t), "adjust align of os_statistics_duration_t");
 
+static_assert(sizeof(os_statistics_load_t) == sizeof(statistics::load_t), "adjust size of os_statistics_load_t");
+static_assert(alignof(os_statistics_load_t) == alignof(statistics::load_t), "adjust align of os_statistics_load_t");
+
 static_assert(sizeof(os_thread_func_args_t) == sizeof(thread::func_args_t), "adjust size of os_thread_func_args_t");
 static_assert(alignof(os_thread_func_args_t) == alignof(thread::func_args_t), "adjust align of os_thread_func_args_t");
 
@@ -126,6 +132,9 @@ static_assert(alignof(os_mqueue_index_t) == alignof(message_queue::index_t), "ad
 static_assert(sizeof(os_mqueue_prio_t) == sizeof(message_queue::priority_t), "adjust size of os_mqueue_prio_t");
 static_assert(alignof(os_mqueue_prio_t) == alignof(message_queue::priority_t), "adjust align of os_mqueue_prio_t");
 
+static_assert(sizeof(os_mbuffer_msg_size_t) == sizeof(message_buffer::msg_size_t), "adjust size of os_mbuffer_msg_size_t");
+static_assert(alignof(os_mbuffer_msg_size_t) == alignof(message_buffer::msg_size_t), "adjust align of os_mbuffer_msg_size_t");
+
 // ----------------------------------------------------------------------------
 
 // Validate C enumeration values
@@ -216,6 +225,11 @@ static_assert(sizeof(rtos::message_queue::attributes) == sizeof(os_mqueue_attr_t
 static_assert(offsetof(rtos::message_queue::attributes, mq_queue_address) == offsetof(os_mqueue_attr_t, mq_queue_addr), "adjust os_mqueue_attr_t members");
 static_assert(offsetof(rtos::message_queue::attributes, mq_queue_size_bytes) == offsetof(os_mqueue_attr_t, mq_queue_size_bytes), "adjust os_mqueue_attr_t members");
 
+static_assert(sizeof(rtos::message_buffer) == sizeof(os_mbuffer_t), "adjust size of os_mbuffer_t");
+static_assert(sizeof(rtos::message_buffer::attributes) == sizeof(os_mbuffer_attr_t), "adjust size of os_mbuffer_attr_t");
+static_assert(offsetof(rtos::message_buffer::attributes, mb_buffer_address) == offsetof(os_mbuffer_attr_t, mb_buffer_addr), "adjust os_mbuffer_attr_t members");
+static_assert(offsetof(rtos::message_buffer::attributes, mb_buffer_size_bytes) == offsetof(os_mbuffer_attr_t, mb_buffer_size_bytes), "adjust os_mbuffer_attr_t members");
+
 static_assert(sizeof(rtos::event_flags) == sizeof(os_evflags_t), "adjust size of os_evflags_t");
 static_assert(sizeof(rtos::event_flags::attributes) == sizeof(os_evflags_attr_t), "adjust size of os_evflags_attr_t");
 
@@ -396,6 +410,78 @@ os_sched_stat_get_cpu_cycles (void)
   return static_cast<os_statistics_duration_t> (scheduler::statistics::cpu_cycles ());
 }
 
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD)
+
+/**
+ * @details
+ *
+ * @warning Cannot be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::scheduler::statistics::update_load()
+ */
+void
+os_sched_stat_update_load (void)
+{
+  scheduler::statistics::update_load ();
+}
+
+/**
+ * @details
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::scheduler::statistics::cpu_load()
+ */
+os_statistics_load_t
+os_sched_stat_get_cpu_load (size_t windows)
+{
+  return static_cast<os_statistics_load_t> (scheduler::statistics::cpu_load (windows));
+}
+
+/**
+ * @details
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::scheduler::statistics::idle_load()
+ */
+os_statistics_load_t
+os_sched_stat_get_idle_load (size_t windows)
+{
+  return static_cast<os_statistics_load_t> (scheduler::statistics::idle_load (windows));
+}
+
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+
+/**
+ * @details
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::scheduler::statistics::context_switches_rate()
+ */
+uint32_t
+os_sched_stat_get_context_switches_rate (size_t windows)
+{
+  return scheduler::statistics::context_switches_rate (windows);
+}
+
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+
+/**
+ * @details
+ *
+ * @warning Cannot be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::scheduler::statistics::top()
+ */
+void
+os_sched_stat_top (void)
+{
+  scheduler::statistics::top ();
+}
+
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD) */
+
 #endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES) */
 
 // ----------------------------------------------------------------------------
@@ -1013,6 +1099,42 @@ os_thread_stack_check_top_magic (os_thread_stack_t* stack)
   return (reinterpret_cast<class rtos::thread::stack&> (*stack)).check_top_magic ();
 }
 
+#if defined(OS_USE_RTOS_THREAD_STACK_WATERMARK)
+
+/**
+ * @details
+ *
+ * @note Can be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::thread::stack::high_water_mark()
+ */
+size_t
+os_thread_stack_get_high_water_mark (os_thread_stack_t* stack)
+{
+  assert (stack != nullptr);
+  return (reinterpret_cast<class rtos::thread::stack&> (*stack)).high_water_mark ();
+}
+
+/**
+ * @details
+ *
+ * @warning Cannot be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::thread::stack::proximity_callback()
+ */
+os_thread_stack_proximity_callback_t
+os_thread_stack_set_proximity_callback (
+    os_thread_stack_proximity_callback_t callback, size_t threshold_bytes)
+{
+  return reinterpret_cast<os_thread_stack_proximity_callback_t> (thread::stack::proximity_callback (
+      reinterpret_cast<thread::stack::proximity_callback_t> (callback),
+      threshold_bytes));
+}
+
+#endif /* defined(OS_USE_RTOS_THREAD_STACK_WATERMARK) */
+
 // ----------------------------------------------------------------------------
 
 #if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
@@ -1051,6 +1173,44 @@ os_thread_stat_get_cpu_cycles (os_thread_t* thread)
   return static_cast<os_statistics_duration_t> ((reinterpret_cast<rtos::thread&> (*thread)).statistics ().cpu_cycles ());
 }
 
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD)
+
+/**
+ * @details
+ *
+ * @warning Cannot be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::thread::statistics::cpu_load()
+ */
+os_statistics_load_t
+os_thread_stat_get_cpu_load (os_thread_t* thread)
+{
+  assert (thread != nullptr);
+  return static_cast<os_statistics_load_t> ((reinterpret_cast<rtos::thread&> (*thread)).statistics ().cpu_load ());
+}
+
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+
+/**
+ * @details
+ *
+ * @warning Cannot be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::thread::statistics::context_switches_rate()
+ */
+uint32_t
+os_thread_stat_get_context_switches_rate (os_thread_t* thread)
+{
+  assert (thread != nullptr);
+  return (reinterpret_cast<rtos::thread&> (*thread)).statistics ().context_switches_rate ();
+}
+
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD) */
+
 #endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES) */
 
 // ----------------------------------------------------------------------------
@@ -3062,6 +3222,299 @@ os_mqueue_reset (os_mqueue_t* mqueue)
 
 // --------------------------------------------------------------------------
 
+/**
+ * @details
+ *
+ * @warning Cannot be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::message_buffer::attributes
+ */
+void
+os_mbuffer_attr_init (os_mbuffer_attr_t* attr)
+{
+  assert (attr != nullptr);
+  new (attr) message_buffer::attributes ();
+}
+
+/**
+ * @details
+ *
+ * @note Must be paired with `os_mbuffer_destruct()`.
+ *
+ * @warning Cannot be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::message_buffer
+ */
+void
+os_mbuffer_construct (os_mbuffer_t* mbuffer, const char* name,
+                      size_t size_bytes, const os_mbuffer_attr_t* attr)
+{
+  assert (mbuffer != nullptr);
+  if (attr == nullptr)
+    {
+      attr = (const os_mbuffer_attr_t*) &message_buffer::initializer;
+    }
+  new (mbuffer) message_buffer (name, size_bytes,
+                                (message_buffer::attributes&) *attr);
+}
+
+/**
+ * @details
+ *
+ * @note Must be paired with `os_mbuffer_construct()`.
+ *
+ * @warning Cannot be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::message_buffer
+ */
+void
+os_mbuffer_destruct (os_mbuffer_t* mbuffer)
+{
+  assert (mbuffer != nullptr);
+  (reinterpret_cast<message_buffer&> (*mbuffer)).~message_buffer ();
+}
+
+/**
+ * @details
+ *
+ * Dynamically allocate the message buffer object instance using
+ * the RTOS system allocator and construct it.
+ *
+ * @note Equivalent of C++ `new message_buffer(...)`.
+ * @note Must be paired with `os_mbuffer_delete()`.
+ *
+ * @warning Cannot be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::message_buffer
+ */
+os_mbuffer_t*
+os_mbuffer_new (const char* name, size_t size_bytes,
+                const os_mbuffer_attr_t* attr)
+{
+  if (attr == nullptr)
+    {
+      attr = (const os_mbuffer_attr_t*) &message_buffer::initializer;
+    }
+  return reinterpret_cast<os_mbuffer_t*> (new message_buffer (
+      name, size_bytes, (message_buffer::attributes&) *attr));
+}
+
+/**
+ * @details
+ *
+ * Destruct the message buffer and deallocate the dynamically allocated
+ * space using the RTOS system allocator.
+ *
+ * @note Equivalent of C++ `delete ptr_mbuffer`.
+ * @note Must be paired with `os_mbuffer_new()`.
+ *
+ * @warning Cannot be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::message_buffer
+ */
+void
+os_mbuffer_delete (os_mbuffer_t* mbuffer)
+{
+  assert (mbuffer != nullptr);
+  delete reinterpret_cast<message_buffer*> (mbuffer);
+}
+
+/**
+ * @details
+ *
+ * @note Can be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::message_buffer::name()
+ */
+const char*
+os_mbuffer_get_name (os_mbuffer_t* mbuffer)
+{
+  assert (mbuffer != nullptr);
+  return (reinterpret_cast<message_buffer&> (*mbuffer)).name ();
+}
+
+/**
+ * @details
+ *
+ * @warning Cannot be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::message_buffer::send()
+ */
+os_result_t
+os_mbuffer_send (os_mbuffer_t* mbuffer, const void* msg, size_t nbytes)
+{
+  assert (mbuffer != nullptr);
+  return (os_result_t) (reinterpret_cast<message_buffer&> (*mbuffer)).send (msg, nbytes);
+}
+
+/**
+ * @details
+ *
+ * @note Can be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::message_buffer::try_send()
+ */
+os_result_t
+os_mbuffer_try_send (os_mbuffer_t* mbuffer, const void* msg, size_t nbytes)
+{
+  assert (mbuffer != nullptr);
+  return (os_result_t) (reinterpret_cast<message_buffer&> (*mbuffer)).try_send (msg,
+                                                                       nbytes);
+}
+
+/**
+ * @details
+ *
+ * @warning Cannot be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::message_buffer::timed_send()
+ */
+os_result_t
+os_mbuffer_timed_send (os_mbuffer_t* mbuffer, const void* msg, size_t nbytes,
+                       os_clock_duration_t timeout)
+{
+  assert (mbuffer != nullptr);
+  return (os_result_t) (reinterpret_cast<message_buffer&> (*mbuffer)).timed_send (
+      msg, nbytes, timeout);
+}
+
+/**
+ * @details
+ *
+ * @warning Cannot be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::message_buffer::receive()
+ */
+os_result_t
+os_mbuffer_receive (os_mbuffer_t* mbuffer, void* msg, size_t nbytes,
+                    size_t* rbytes)
+{
+  assert (mbuffer != nullptr);
+  return (os_result_t) (reinterpret_cast<message_buffer&> (*mbuffer)).receive (
+      msg, nbytes, rbytes);
+}
+
+/**
+ * @details
+ *
+ * @note Can be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::message_buffer::try_receive()
+ */
+os_result_t
+os_mbuffer_try_receive (os_mbuffer_t* mbuffer, void* msg, size_t nbytes,
+                        size_t* rbytes)
+{
+  assert (mbuffer != nullptr);
+  return (os_result_t) (reinterpret_cast<message_buffer&> (*mbuffer)).try_receive (
+      msg, nbytes, rbytes);
+}
+
+/**
+ * @details
+ *
+ * @warning Cannot be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::message_buffer::timed_receive()
+ */
+os_result_t
+os_mbuffer_timed_receive (os_mbuffer_t* mbuffer, void* msg, size_t nbytes,
+                          os_clock_duration_t timeout, size_t* rbytes)
+{
+  assert (mbuffer != nullptr);
+  return (os_result_t) (reinterpret_cast<message_buffer&> (*mbuffer)).timed_receive (
+      msg, nbytes, timeout, rbytes);
+}
+
+/**
+ * @details
+ *
+ * @note Can be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::message_buffer::capacity()
+ */
+size_t
+os_mbuffer_get_capacity (os_mbuffer_t* mbuffer)
+{
+  assert (mbuffer != nullptr);
+  return (reinterpret_cast<message_buffer&> (*mbuffer)).capacity ();
+}
+
+/**
+ * @details
+ *
+ * @note Can be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::message_buffer::length()
+ */
+size_t
+os_mbuffer_get_length (os_mbuffer_t* mbuffer)
+{
+  assert (mbuffer != nullptr);
+  return (reinterpret_cast<message_buffer&> (*mbuffer)).length ();
+}
+
+/**
+ * @details
+ *
+ * @note Can be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::message_buffer::available()
+ */
+size_t
+os_mbuffer_get_available (os_mbuffer_t* mbuffer)
+{
+  assert (mbuffer != nullptr);
+  return (reinterpret_cast<message_buffer&> (*mbuffer)).available ();
+}
+
+/**
+ * @details
+ *
+ * @note Can be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::message_buffer::empty()
+ */
+bool
+os_mbuffer_is_empty (os_mbuffer_t* mbuffer)
+{
+  assert (mbuffer != nullptr);
+  return (reinterpret_cast<message_buffer&> (*mbuffer)).empty ();
+}
+
+/**
+ * @details
+ *
+ * @warning Cannot be invoked from Interrupt Service Routines.
+ *
+ * @par For the complete definition, see
+ *  @ref os::rtos::message_buffer::reset()
+ */
+os_result_t
+os_mbuffer_reset (os_mbuffer_t* mbuffer)
+{
+  assert (mbuffer != nullptr);
+  return (os_result_t) (reinterpret_cast<message_buffer&> (*mbuffer)).reset ();
+}
+
+// --------------------------------------------------------------------------
+
 /**
  * @details
  *
@@ -3459,6 +3912,60 @@ os_memory_get_free_chunks (os_memory_t* memory)
   return (reinterpret_cast<rtos::memory::memory_resource&> (*memory)).free_chunks ();
 }
 
+// ----------------------------------------------------------------------------
+
+/**
+ * @cond ignore
+ */
+
+// Used by the header only variants, which check the arguments.
+
+os_thread_t*
+os_internal_this_thread (void)
+{
+  return (os_thread_t*) &this_thread::thread ();
+}
+
+os_result_t
+os_internal_mutex_lock (os_mutex_t* mutex)
+{
+  return (os_result_t) (reinterpret_cast<rtos::mutex&> (*mutex)).lock ();
+}
+
+os_result_t
+os_internal_mutex_try_lock (os_mutex_t* mutex)
+{
+  return (os_result_t) (reinterpret_cast<rtos::mutex&> (*mutex)).try_lock ();
+}
+
+os_result_t
+os_internal_mutex_unlock (os_mutex_t* mutex)
+{
+  return (os_result_t) (reinterpret_cast<rtos::mutex&> (*mutex)).unlock ();
+}
+
+os_result_t
+os_internal_semaphore_post (os_semaphore_t* semaphore)
+{
+  return (os_result_t) (reinterpret_cast<rtos::semaphore&> (*semaphore)).post ();
+}
+
+os_result_t
+os_internal_semaphore_wait (os_semaphore_t* semaphore)
+{
+  return (os_result_t) (reinterpret_cast<rtos::semaphore&> (*semaphore)).wait ();
+}
+
+os_result_t
+os_internal_semaphore_try_wait (os_semaphore_t* semaphore)
+{
+  return (os_result_t) (reinterpret_cast<rtos::semaphore&> (*semaphore)).try_wait ();
+}
+
+/**
+ * @endcond
+ */
+
 // ****************************************************************************
 // ***** Legacy CMSIS RTOS implementation *****
 
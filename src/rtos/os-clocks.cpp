@@ -34,6 +34,18 @@ using namespace os::rtos;
 
 // ----------------------------------------------------------------------------
 
+#if !defined(OS_INCLUDE_RTOS_REALTIME_CLOCK_DRIVER)
+
+namespace
+{
+  // Count down the SysTick ticks until the next simulated RTC second.
+  uint32_t rtc_simulation_ticks_ = clock_systick::frequency_hz;
+}
+
+#endif /* !defined(OS_INCLUDE_RTOS_REALTIME_CLOCK_DRIVER) */
+
+// ----------------------------------------------------------------------------
+
 /**
  * @details
  * Must be called from the physical interrupt handler.
@@ -66,14 +78,16 @@ os_systick_handler (void)
   sysclock.internal_check_timestamps ();
   hrclock.internal_check_timestamps ();
 
+#if defined(OS_USE_RTOS_PROFILER)
+  profiler::internal_tick_ ();
+#endif
+
 #if !defined(OS_INCLUDE_RTOS_REALTIME_CLOCK_DRIVER)
 
   // Simulate an RTC driver.
-  static uint32_t ticks = clock_systick::frequency_hz;
-
-  if (--ticks == 0)
+  if (--rtc_simulation_ticks_ == 0)
     {
-      ticks = clock_systick::frequency_hz;
+      rtc_simulation_ticks_ = clock_systick::frequency_hz;
 
       os_rtc_handler ();
     }
@@ -603,6 +617,125 @@ namespace os
 
 #endif /* defined(OS_USE_RTOS_PORT_CLOCK_SYSTICK_WAIT_FOR) */
 
+    // ------------------------------------------------------------------------
+
+#if defined(OS_USE_RTOS_TICKLESS_IDLE)
+
+    /**
+     * @details
+     * Called by the idle thread when there is nothing else to run.
+     *
+     * The earliest deadline is the head of the system clock list
+     * (thread timeouts and timers), possibly closer deadlines in
+     * the high resolution clock list, and, if the RTC is simulated
+     * from SysTick and there are threads waiting for it, the next
+     * simulated second.
+     *
+     * If the deadline is at least `OS_INTEGER_RTOS_TICKLESS_IDLE_MIN_TICKS`
+     * away, the port is asked to suppress the periodic tick and
+     * sleep until the deadline. On wake-up, the lost ticks are added
+     * to the clocks, which also run the actions of all expired
+     * timestamps, so the idle thread can yield to the resumed threads.
+     *
+     * The entire sequence is performed with interrupts disabled,
+     * otherwise an interrupt occurring after computing the deadline
+     * might link an earlier timestamp which would be missed.
+     *
+     * @warning Cannot be invoked from Interrupt Service Routines.
+     */
+    bool
+    clock_systick::internal_sleep_tickless (void)
+    {
+      // ----- Enter critical section -----------------------------------------
+      interrupts::critical_section ics;
+
+      duration_t max_ticks = static_cast<duration_t> (~0u);
+
+      if (!steady_list_.empty ())
+        {
+          timestamp_t head_ts = steady_list_.head ()->timestamp;
+          if (head_ts <= steady_count_)
+            {
+              return false;
+            }
+          if (head_ts - steady_count_ < max_ticks)
+            {
+              max_ticks = static_cast<duration_t> (head_ts - steady_count_);
+            }
+        }
+
+      if (!hrclock.steady_list ().empty ())
+        {
+          timestamp_t head_ts = hrclock.steady_list ().head ()->timestamp;
+          timestamp_t nw = hrclock.steady_now ();
+          if (head_ts <= nw)
+            {
+              return false;
+            }
+          // Truncate, the high resolution deadline must not be overrun.
+          timestamp_t ticks = (head_ts - nw)
+              / port::clock_highres::cycles_per_tick ();
+          if (ticks < max_ticks)
+            {
+              max_ticks = static_cast<duration_t> (ticks);
+            }
+        }
+
+#if !defined(OS_INCLUDE_RTOS_REALTIME_CLOCK_DRIVER)
+
+      if (!rtclock.steady_list ().empty () || !rtclock.adjusted_list ().empty ())
+        {
+          if (rtc_simulation_ticks_ < max_ticks)
+            {
+              max_ticks = rtc_simulation_ticks_;
+            }
+        }
+
+#endif /* !defined(OS_INCLUDE_RTOS_REALTIME_CLOCK_DRIVER) */
+
+      if (max_ticks < OS_INTEGER_RTOS_TICKLESS_IDLE_MIN_TICKS)
+        {
+          return false;
+        }
+
+      // The last tick is delivered by the regular interrupt.
+      duration_t slept = port::clock_systick::sleep_tickless (max_ticks - 1);
+
+#if defined(OS_TRACE_RTOS_CLOCKS)
+      trace::printf ("clock_systick::%s() %u/%u\n", __func__,
+                     static_cast<unsigned int> (slept),
+                     static_cast<unsigned int> (max_ticks));
+#endif
+
+      if (slept > 0)
+        {
+          update_for_slept_time (slept);
+          hrclock.update_for_slept_time (
+              slept * port::clock_highres::cycles_per_tick ());
+
+#if !defined(OS_INCLUDE_RTOS_REALTIME_CLOCK_DRIVER)
+
+          if (slept < rtc_simulation_ticks_)
+            {
+              rtc_simulation_ticks_ -= slept;
+            }
+          else
+            {
+              slept -= rtc_simulation_ticks_;
+              rtc_simulation_ticks_ = frequency_hz - slept % frequency_hz;
+              rtclock.update_for_slept_time (1 + slept / frequency_hz);
+              rtclock.internal_check_timestamps ();
+            }
+
+#endif /* !defined(OS_INCLUDE_RTOS_REALTIME_CLOCK_DRIVER) */
+        }
+
+      return true;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+#endif /* defined(OS_USE_RTOS_TICKLESS_IDLE) */
+
     // ========================================================================
 
     /**
@@ -29,6 +29,14 @@
 
 // ----------------------------------------------------------------------------
 
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES) \
+  && defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD) \
+  && !defined(OS_USE_RTOS_PORT_SCHEDULER)
+
+extern os::rtos::thread* os_idle_thread;
+
+#endif
+
 namespace
 {
 #if defined(OS_HAS_INTERRUPTS_STACK)
@@ -437,6 +445,13 @@ namespace os
         clock::timestamp_t switch_timestamp_;
         rtos::statistics::duration_t cpu_cycles_;
 
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD)
+
+        rtos::statistics::duration_t window_cpu_cycles_;
+        clock::duration_t window_ticks_;
+
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD) */
+
 #endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES) */
 
       } /* namespace statistics */
@@ -445,6 +460,394 @@ namespace os
      * @endcond
      */
 
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES) \
+  && defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD)
+
+      namespace statistics
+      {
+        /**
+         * @cond ignore
+         */
+
+        namespace
+        {
+          // The totals of the most recent load windows, in a ring.
+          typedef struct window_s
+          {
+            rtos::statistics::duration_t cpu_cycles;
+            rtos::statistics::duration_t idle_cycles;
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+            rtos::statistics::counter_t context_switches;
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+            clock::duration_t ticks;
+          } window_t;
+
+          window_t windows_[OS_INTEGER_RTOS_STATISTICS_LOAD_WINDOWS];
+          std::size_t windows_next_;
+          std::size_t windows_count_;
+
+          // Counter values at the beginning of the current window.
+          rtos::statistics::duration_t load_cpu_cycles_;
+          rtos::statistics::duration_t load_idle_cycles_;
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+          rtos::statistics::counter_t load_context_switches_;
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+          clock::timestamp_t load_timestamp_;
+
+          // Add the most recent `windows` entries of the ring.
+          window_t
+          sum (std::size_t windows)
+          {
+            window_t total
+              { };
+
+            if (windows > windows_count_)
+              {
+                windows = windows_count_;
+              }
+
+            std::size_t ix = windows_next_;
+            for (std::size_t i = 0; i < windows; ++i)
+              {
+                ix = (ix == 0) ? OS_INTEGER_RTOS_STATISTICS_LOAD_WINDOWS - 1 : ix - 1;
+
+                total.cpu_cycles += windows_[ix].cpu_cycles;
+                total.idle_cycles += windows_[ix].idle_cycles;
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+                total.context_switches += windows_[ix].context_switches;
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+                total.ticks += windows_[ix].ticks;
+              }
+            return total;
+          }
+
+          // A row of the threads table, copied with the scheduler locked
+          // and printed later.
+          typedef struct top_row_s
+          {
+            char name[16];
+            thread::priority_t priority;
+            rtos::statistics::load_t load;
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+            uint32_t context_switches_rate;
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+            int depth;
+          } top_row_t;
+
+          // Must be called with the scheduler locked.
+          void
+          top_collect (thread* th, int depth, top_row_t* rows,
+                       std::size_t& count, std::size_t& total)
+          {
+            for (auto&& p : scheduler::children_threads (th))
+              {
+                if (count < OS_INTEGER_RTOS_STATISTICS_TOP_THREADS)
+                  {
+                    top_row_t& r = rows[count++];
+
+                    std::strncpy (r.name, p.name (), sizeof(r.name) - 1);
+                    r.name[sizeof(r.name) - 1] = '\0';
+                    r.priority = p.priority ();
+                    r.load = p.statistics ().cpu_load ();
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+                    r.context_switches_rate =
+                        p.statistics ().context_switches_rate ();
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+                    r.depth = depth;
+                  }
+                ++total;
+
+                top_collect (&p, depth + 1, rows, count, total);
+              }
+          }
+
+        } /* namespace */
+
+        /**
+         * @endcond
+         */
+
+        /**
+         * @details
+         * The load is computed on windows; this function closes the
+         * current window, computing the CPU cycles (and context switches)
+         * used by each thread since the previous call, and starts a
+         * new window.
+         *
+         * The window length is given by the interval between calls;
+         * call it periodically, for example once a second, from a
+         * monitoring thread. The system totals of the last
+         * `OS_INTEGER_RTOS_STATISTICS_LOAD_WINDOWS` windows are kept,
+         * so the system load can also be averaged over longer intervals.
+         *
+         * @note This function is available only when
+         * @ref OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD
+         * is defined.
+         *
+         * @warning Cannot be invoked from Interrupt Service Routines.
+         */
+        void
+        update_load (void)
+        {
+          assert(!interrupts::in_handler_mode ());
+
+          // ----- Enter critical section -------------------------------------
+          scheduler::critical_section scs;
+
+          window_t& w = windows_[windows_next_];
+
+            {
+              // ----- Enter critical section ---------------------------------
+              interrupts::critical_section ics;
+
+              // Charge the running thread for the time since the last
+              // context switch, otherwise a thread that does not yield
+              // would appear idle.
+              clock::timestamp_t now = hrclock.now ();
+              rtos::statistics::duration_t delta =
+                  static_cast<rtos::statistics::duration_t> (now
+                      - switch_timestamp_);
+              cpu_cycles_ += delta;
+              scheduler::current_thread_->statistics ().cpu_cycles_ += delta;
+              switch_timestamp_ = now;
+
+              w.cpu_cycles = cpu_cycles_ - load_cpu_cycles_;
+              load_cpu_cycles_ = cpu_cycles_;
+
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+              w.context_switches = context_switches_ - load_context_switches_;
+              load_context_switches_ = context_switches_;
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+              // ----- Exit critical section ----------------------------------
+            }
+
+#if !defined(OS_USE_RTOS_PORT_SCHEDULER)
+          rtos::statistics::duration_t idle_cycles =
+              os_idle_thread->statistics ().cpu_cycles ();
+          w.idle_cycles = idle_cycles - load_idle_cycles_;
+          load_idle_cycles_ = idle_cycles;
+#else
+          w.idle_cycles = 0;
+#endif /* !defined(OS_USE_RTOS_PORT_SCHEDULER) */
+
+          clock::timestamp_t ticks = sysclock.now ();
+          w.ticks = static_cast<clock::duration_t> (ticks - load_timestamp_);
+          load_timestamp_ = ticks;
+
+          window_cpu_cycles_ = w.cpu_cycles;
+          window_ticks_ = w.ticks;
+
+          windows_next_ = (windows_next_ + 1)
+              % OS_INTEGER_RTOS_STATISTICS_LOAD_WINDOWS;
+          if (windows_count_ < OS_INTEGER_RTOS_STATISTICS_LOAD_WINDOWS)
+            {
+              ++windows_count_;
+            }
+
+          internal_update_load_ (nullptr);
+          // ----- Exit critical section --------------------------------------
+        }
+
+        /**
+         * @cond ignore
+         */
+
+        void
+        internal_update_load_ (thread* th)
+        {
+          for (auto&& p : scheduler::children_threads (th))
+            {
+              class thread::statistics& st = p.statistics ();
+
+              st.window_cpu_cycles_ = st.cpu_cycles_ - st.load_cpu_cycles_;
+              st.load_cpu_cycles_ = st.cpu_cycles_;
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+              st.window_context_switches_ = st.context_switches_
+                  - st.load_context_switches_;
+              st.load_context_switches_ = st.context_switches_;
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+
+              internal_update_load_ (&p);
+            }
+        }
+
+        /**
+         * @endcond
+         */
+
+        /**
+         * @details
+         * If fewer windows were recorded, the average is computed
+         * on the available ones.
+         *
+         * @note This function is available only when
+         * @ref OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD
+         * is defined.
+         */
+        rtos::statistics::load_t
+        cpu_load (std::size_t windows)
+        {
+          window_t total = sum (windows);
+          if (total.cpu_cycles == 0)
+            {
+              return 0;
+            }
+          return static_cast<rtos::statistics::load_t> ((total.cpu_cycles
+              - total.idle_cycles) * 1000 / total.cpu_cycles);
+        }
+
+        /**
+         * @details
+         * The idle load is a measure of the capacity headroom.
+         *
+         * @note This function is available only when
+         * @ref OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD
+         * is defined.
+         */
+        rtos::statistics::load_t
+        idle_load (std::size_t windows)
+        {
+          window_t total = sum (windows);
+          if (total.cpu_cycles == 0)
+            {
+              return 0;
+            }
+          return static_cast<rtos::statistics::load_t> (total.idle_cycles
+              * 1000 / total.cpu_cycles);
+        }
+
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+
+        /**
+         * @details
+         *
+         * @note This function is available only when
+         * @ref OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD
+         * and @ref OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES
+         * are defined.
+         */
+        uint32_t
+        context_switches_rate (std::size_t windows)
+        {
+          window_t total = sum (windows);
+          if (total.ticks == 0)
+            {
+              return 0;
+            }
+          return static_cast<uint32_t> (total.context_switches
+              * clock_systick::frequency_hz / total.ticks);
+        }
+
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+
+        /**
+         * @details
+         * Print the system load for the last window and for all
+         * recorded windows, followed by the load of each thread
+         * in the last window, with children threads indented
+         * below their parents.
+         *
+         * @code{.unparsed}
+         * cpu 12.5% (9.8%), idle 87.5% (90.2%), 1200 sw/s, 1000 ms
+         * THREAD           PRIO   CPU%     SW/s
+         * main              128   0.3%        1
+         * idle                1  87.5%     1100
+         * ...
+         * @endcode
+         *
+         * The values are copied with the scheduler locked, and
+         * printed after the scheduler is unlocked; at most
+         * `OS_INTEGER_RTOS_STATISTICS_TOP_THREADS` threads are listed,
+         * with the names truncated to 15 characters.
+         *
+         * @note This function is available only when
+         * @ref OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD
+         * is defined.
+         *
+         * @warning Cannot be invoked from Interrupt Service Routines.
+         */
+        void
+        top (void)
+        {
+          assert(!interrupts::in_handler_mode ());
+
+          top_row_t rows[OS_INTEGER_RTOS_STATISTICS_TOP_THREADS];
+          std::size_t count = 0;
+          std::size_t total = 0;
+
+          rtos::statistics::load_t cpu;
+          rtos::statistics::load_t cpu_all;
+          rtos::statistics::load_t idle;
+          rtos::statistics::load_t idle_all;
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+          uint32_t context_switches;
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+          clock::duration_t ticks;
+
+            {
+              // Take a consistent snapshot, but do not keep the
+              // scheduler locked while printing.
+
+              // ----- Enter critical section ---------------------------------
+              scheduler::critical_section scs;
+
+              cpu = cpu_load (1);
+              cpu_all = cpu_load (OS_INTEGER_RTOS_STATISTICS_LOAD_WINDOWS);
+              idle = idle_load (1);
+              idle_all = idle_load (OS_INTEGER_RTOS_STATISTICS_LOAD_WINDOWS);
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+              context_switches = context_switches_rate (1);
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+              ticks = window_ticks_;
+
+              top_collect (nullptr, 0, rows, count, total);
+              // ----- Exit critical section ----------------------------------
+            }
+
+          trace::printf ("cpu %u.%u%% (%u.%u%%), idle %u.%u%% (%u.%u%%)",
+                         cpu / 10, cpu % 10, cpu_all / 10, cpu_all % 10,
+                         idle / 10, idle % 10, idle_all / 10, idle_all % 10);
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+          trace::printf (", %u sw/s",
+                         static_cast<unsigned int> (context_switches));
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+          trace::printf (
+              ", %u ms\n",
+              static_cast<unsigned int> (ticks * 1000u
+                  / clock_systick::frequency_hz));
+
+          trace::printf ("%-16s %4s %6s", "THREAD", "PRIO", "CPU%");
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+          trace::printf (" %8s", "SW/s");
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+          trace::printf ("\n");
+
+          for (std::size_t i = 0; i < count; ++i)
+            {
+              top_row_t& r = rows[i];
+
+              trace::printf ("%*s%-*s %4u %3u.%u%%", r.depth, "",
+                             16 - r.depth, r.name,
+                             static_cast<unsigned int> (r.priority),
+                             r.load / 10, r.load % 10);
+#if defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES)
+              trace::printf (
+                  " %8u", static_cast<unsigned int> (r.context_switches_rate));
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES) */
+              trace::printf ("\n");
+            }
+
+          if (total > count)
+            {
+              trace::printf ("... %u more\n",
+                             static_cast<unsigned int> (total - count));
+            }
+        }
+
+      } /* namespace statistics */
+
+#endif /* defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES) && defined(OS_INCLUDE_RTOS_STATISTICS_THREAD_LOAD) */
+
     } /* namespace scheduler */
 
     /**
@@ -268,8 +268,8 @@ namespace os
       // Prepare a list node pointing to the current thread.
       // Do not worry for being on stack, it is temporarily linked to the
       // list and guaranteed to be removed before this function returns.
-      internal::waiting_thread_node node
-        { crt_thread };
+      internal::waiting_flags_node node
+        { crt_thread, mask, mode };
 
       for (;;)
         {
@@ -304,6 +304,20 @@ namespace os
               // ----- Exit critical section ----------------------------------
             }
 
+          if (node.satisfied_)
+            {
+              // The flags were checked and consumed by raise().
+              if (oflags != nullptr)
+                {
+                  *oflags = node.raised_;
+                }
+#if defined(OS_TRACE_RTOS_EVFLAGS)
+              trace::printf ("%s(0x%X,%u) @%p %s >0x%X\n", __func__, mask,
+                             mode, this, name (), event_flags_.mask ());
+#endif
+              return result::ok;
+            }
+
           if (crt_thread.interrupted ())
             {
 #if defined(OS_TRACE_RTOS_EVFLAGS)
@@ -453,8 +467,8 @@ namespace os
       // Prepare a list node pointing to the current thread.
       // Do not worry for being on stack, it is temporarily linked to the
       // list and guaranteed to be removed before this function returns.
-      internal::waiting_thread_node node
-        { crt_thread };
+      internal::waiting_flags_node node
+        { crt_thread, mask, mode };
 
       internal::clock_timestamps_list& clock_list = clock_->steady_list ();
       clock::timestamp_t timeout_timestamp = clock_->steady_now () + timeout;
@@ -494,6 +508,21 @@ namespace os
           // timeout list, if not already removed by the timer.
           scheduler::internal_unlink_node (node, timeout_node);
 
+          if (node.satisfied_)
+            {
+              // The flags were checked and consumed by raise().
+              if (oflags != nullptr)
+                {
+                  *oflags = node.raised_;
+                }
+#if defined(OS_TRACE_RTOS_EVFLAGS)
+              trace::printf ("%s(0x%X,%u,%u) @%p %s >0x%X\n", __func__, mask,
+                             timeout, mode, this, name (),
+                             event_flags_.mask ());
+#endif
+              return result::ok;
+            }
+
           if (crt_thread.interrupted ())
             {
 #if defined(OS_TRACE_RTOS_EVFLAGS)
@@ -523,7 +552,9 @@ namespace os
      * @details
      * Set more bits in the thread current signal mask.
      * Use OR at bit-mask level.
-     * Wake-up all waiting threads, if any.
+     * Wake-up the waiting threads whose condition is satisfied,
+     * if any, in priority order; the flags requested with
+     * `flags::mode::clear` are consumed on their behalf.
      *
      * @note Can be invoked from Interrupt Service Routines.
      */
@@ -545,10 +576,8 @@ namespace os
 
       result_t res = event_flags_.raise (mask, oflags);
 
-      // Wake-up all threads, if any.
-      // Need not be inside the critical section,
-      // the list is protected by inner `resume_one()`.
-      list_.resume_all ();
+      // Wake-up only the threads whose condition is satisfied.
+      internal_resume_satisfied_ ();
 
 #if defined(OS_TRACE_RTOS_EVFLAGS)
       trace::printf ("%s(0x%X) @%p %s >0x%X\n", __func__, mask, this, name (),
@@ -559,6 +588,62 @@ namespace os
 #endif
     }
 
+#if !defined(OS_USE_RTOS_PORT_EVENT_FLAGS)
+
+    /**
+     * @details
+     * Walk the waiting list in priority order and check the
+     * condition of each thread, as if it was running; the first
+     * satisfied thread is removed from the list and resumed, with
+     * the flags already consumed (if `flags::mode::clear` was
+     * requested), so lower priority threads waiting for the same
+     * flags are not resumed in vain. Repeat until no more threads
+     * are satisfied.
+     *
+     * Each step is performed in a separate critical section, to
+     * keep the interrupt latency bounded.
+     */
+    void
+    event_flags::internal_resume_satisfied_ (void)
+    {
+      for (;;)
+        {
+          thread* th = nullptr;
+            {
+              // ----- Enter critical section ---------------------------------
+              interrupts::critical_section ics;
+
+              for (auto it = list_.begin (); it != list_.end (); ++it)
+                {
+                  internal::waiting_flags_node* node =
+                      static_cast<internal::waiting_flags_node*> (it.get_iterator_pointer ());
+
+                  if (event_flags_.check_raised (node->mask_, &node->raised_,
+                                                 node->mode_))
+                    {
+                      node->satisfied_ = true;
+                      th = node->thread_;
+                      node->unlink ();
+                      break;
+                    }
+                }
+              // ----- Exit critical section ----------------------------------
+            }
+
+          if (th == nullptr)
+            {
+              return;
+            }
+
+          if (th->state () != thread::state::destroyed)
+            {
+              th->resume ();
+            }
+        }
+    }
+
+#endif
+
     /**
      * @details
      *
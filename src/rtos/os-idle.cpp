@@ -27,6 +27,10 @@
 
 #include <cmsis-plus/rtos/os.h>
 
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+#include <cmsis-plus/arm/semihosting-buffer.h>
+#endif
+
 // ----------------------------------------------------------------------------
 
 using namespace os;
@@ -85,12 +89,40 @@ os_rtos_idle_actions (void)
       this_thread::yield ();
     }
 
+#if defined(TRACE) && defined(OS_USE_TRACE_BUFFER)
+  // Move the buffered trace messages to the physical channel.
+  trace::drain ();
+#endif /* defined(TRACE) && defined(OS_USE_TRACE_BUFFER) */
+
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+  // Write the semihosting output kept in buffers for too long.
+  semihosting::buffer::flush_all (true);
+#endif /* defined(OS_INCLUDE_SEMIHOSTING_BUFFERS) */
+
+#if defined(OS_INCLUDE_STARTUP_DEFERRED_BSS)
+  // Clear the deferred .bss, a chunk at a time.
+  os_startup_initialize_bss_deferred (
+      OS_INTEGER_STARTUP_DEFERRED_BSS_CHUNK_BYTES);
+#endif /* defined(OS_INCLUDE_STARTUP_DEFERRED_BSS) */
+
+#if defined(OS_USE_RTOS_THREAD_STACK_WATERMARK)
+  // Advance the stack high-water marks, a few words at a time.
+  thread::stack::internal_track_all_ (nullptr);
+#endif /* defined(OS_USE_RTOS_THREAD_STACK_WATERMARK) */
+
 #if defined(OS_HAS_INTERRUPTS_STACK)
   // Simple test to verify that the interrupts
   // did not underflow the stack.
   assert(rtos::interrupts::stack ()->check_bottom_magic ());
 #endif
 
+#if defined(OS_USE_RTOS_TICKLESS_IDLE)
+  if (sysclock.internal_sleep_tickless ())
+    {
+      return;
+    }
+#endif /* defined(OS_USE_RTOS_TICKLESS_IDLE) */
+
   if (!os_rtos_idle_enter_power_saving_mode_hook ())
     {
       port::scheduler::wait_for_interrupt ();
@@ -0,0 +1,330 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/rtos/os.h>
+#include <cmsis-plus/diag/trace.h>
+
+#include <cassert>
+
+// ----------------------------------------------------------------------------
+
+#if defined(OS_USE_RTOS_LAZY_INIT)
+
+namespace os
+{
+  namespace rtos
+  {
+    // ------------------------------------------------------------------------
+
+    /**
+     * @cond ignore
+     */
+
+    lazy_init* lazy_init::list__;
+
+    namespace
+    {
+      // Serialises the constructions; recursive, since the
+      // constructors may use other lazy objects.
+      mutex_recursive lazy_mutex
+        { "lazy-init" };
+
+      thread* background_thread;
+      std::aligned_storage<sizeof(thread), alignof(thread)>::type background_thread_storage;
+      bool background_joined;
+
+#if defined(OS_EXCLUDE_DYNAMIC_MEMORY_ALLOCATIONS)
+
+      static_assert(OS_INTEGER_RTOS_LAZY_INIT_STACK_SIZE_BYTES > 0,
+          "OS_INTEGER_RTOS_LAZY_INIT_STACK_SIZE_BYTES must be defined.");
+
+      thread::stack::allocation_element_t background_stack[(OS_INTEGER_RTOS_LAZY_INIT_STACK_SIZE_BYTES
+          + sizeof(thread::stack::allocation_element_t) - 1)
+          / sizeof(thread::stack::allocation_element_t)];
+
+#endif /* defined(OS_EXCLUDE_DYNAMIC_MEMORY_ALLOCATIONS) */
+    } /* namespace */
+
+    /**
+     * @endcond
+     */
+
+    // ------------------------------------------------------------------------
+
+    /**
+     * @details
+     * Usually called from static constructors, before `main()`.
+     */
+    lazy_init::lazy_init (stage_t stage, func_t func, void* storage) :
+        func_ (func), //
+        storage_ (storage), //
+        stage_ (stage), //
+        state_ (pending)
+    {
+      // ----- Enter critical section -----------------------------------------
+      scheduler::critical_section scs;
+
+      next_ = list__;
+      list__ = this;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /**
+     * @details
+     * The objects may have automatic or dynamic storage; they are
+     * unlinked under the scheduler lock, and the stages restart
+     * the list walk after each construction.
+     *
+     * @warning The object must not be destroyed while it is
+     *  being constructed.
+     */
+    lazy_init::~lazy_init ()
+    {
+      // ----- Enter critical section -----------------------------------------
+      scheduler::critical_section scs;
+
+      assert (state_ != constructing);
+
+      for (lazy_init** p = &list__; *p != nullptr; p = &(*p)->next_)
+        {
+          if (*p == this)
+            {
+              *p = next_;
+              break;
+            }
+        }
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /**
+     * @details
+     * Before the scheduler starts there is a single thread, and
+     * the object is constructed directly.
+     *
+     * @warning Cannot be invoked from Interrupt Service Routines;
+     *  objects used by interrupts must be in the `stage::main` stage.
+     */
+    void
+    lazy_init::run_stage (stage_t stage)
+    {
+#if defined(OS_TRACE_RTOS_LAZY_INIT)
+      trace::printf ("lazy_init::%s(%u)\n", __func__, stage);
+#endif
+
+      while (internal_construct_next_ (stage))
+        {
+          ;
+        }
+    }
+
+    void
+    lazy_init::start (void)
+    {
+      run_stage (stage::main);
+
+      bool background = false;
+        {
+          // ----- Enter critical section -------------------------------------
+          scheduler::critical_section scs;
+
+          for (lazy_init* p = list__; p != nullptr; p = p->next_)
+            {
+              if ((p->stage_ != stage::main) && (p->stage_ != stage::on_demand)
+                  && (p->state_ == pending))
+                {
+                  background = true;
+                  break;
+                }
+            }
+          // ----- Exit critical section --------------------------------------
+        }
+
+      if (!background)
+        {
+          return;
+        }
+
+      thread::attributes attr = thread::initializer;
+      attr.th_priority = OS_INTEGER_RTOS_LAZY_INIT_PRIORITY;
+#if defined(OS_EXCLUDE_DYNAMIC_MEMORY_ALLOCATIONS)
+      attr.th_stack_address = background_stack;
+      attr.th_stack_size_bytes = sizeof(background_stack);
+#else
+      attr.th_stack_size_bytes = OS_INTEGER_RTOS_LAZY_INIT_STACK_SIZE_BYTES;
+#endif /* defined(OS_EXCLUDE_DYNAMIC_MEMORY_ALLOCATIONS) */
+
+      // Never destroyed, like the main thread.
+      background_thread = new (&background_thread_storage) thread
+        { "lazy-init", internal_run_background_, nullptr, attr };
+    }
+
+    /**
+     * @details
+     * Returns immediately if there is no background stage.
+     */
+    void
+    lazy_init::join (void)
+    {
+      if ((background_thread != nullptr) && !background_joined)
+        {
+          background_thread->join ();
+          background_joined = true;
+        }
+    }
+
+    /**
+     * @cond ignore
+     */
+
+    void
+    lazy_init::internal_construct_ (void)
+    {
+      assert (!interrupts::in_handler_mode ());
+
+      if (!scheduler::started ())
+        {
+          // A constructor which uses its own object.
+          assert (state_ != constructing);
+
+          state_ = constructing;
+          func_ (storage_);
+          state_ = constructed;
+          return;
+        }
+
+      lazy_mutex.lock ();
+
+      if (state_ == pending)
+        {
+          state_ = constructing;
+          func_ (storage_);
+          state_ = constructed;
+        }
+      // Otherwise constructing means a constructor which uses
+      // its own object, since the other threads wait for the mutex.
+      assert (state_ == constructed);
+
+      lazy_mutex.unlock ();
+    }
+
+    /*
+     * Construct the first pending object of the stage. The walk
+     * restarts from the list head after each construction, since
+     * objects may be destroyed and unlinked while the constructors
+     * run; the constructed objects are skipped.
+     *
+     * The mutex is taken before the object is selected, so another
+     * thread cannot construct it meanwhile, and the object is marked
+     * under the scheduler lock, so its destructor can detect it.
+     */
+    bool
+    lazy_init::internal_construct_next_ (stage_t stage)
+    {
+      assert (!interrupts::in_handler_mode ());
+
+      bool started = scheduler::started ();
+      if (started)
+        {
+          lazy_mutex.lock ();
+        }
+
+      lazy_init* obj = nullptr;
+        {
+          // ----- Enter critical section -------------------------------------
+          scheduler::critical_section scs;
+
+          for (lazy_init* p = list__; p != nullptr; p = p->next_)
+            {
+              if ((p->stage_ == stage) && (p->state_ == pending))
+                {
+                  obj = p;
+                  obj->state_ = constructing;
+                  break;
+                }
+            }
+          // ----- Exit critical section --------------------------------------
+        }
+
+      if (obj != nullptr)
+        {
+          obj->func_ (obj->storage_);
+          obj->state_ = constructed;
+        }
+
+      if (started)
+        {
+          lazy_mutex.unlock ();
+        }
+
+      return obj != nullptr;
+    }
+
+    void*
+    lazy_init::internal_run_background_ (void* args __attribute__((unused)))
+    {
+      while (true)
+        {
+          // The lowest stage with objects not yet constructed.
+          stage_t next = stage::on_demand;
+            {
+              // ----- Enter critical section ---------------------------------
+              scheduler::critical_section scs;
+
+              for (lazy_init* p = list__; p != nullptr; p = p->next_)
+                {
+                  if ((p->state_ == pending) && (p->stage_ != stage::main)
+                      && (p->stage_ < next))
+                    {
+                      next = p->stage_;
+                    }
+                }
+              // ----- Exit critical section ----------------------------------
+            }
+          if (next == stage::on_demand)
+            {
+              break;
+            }
+          run_stage (next);
+        }
+
+#if defined(OS_TRACE_RTOS_LAZY_INIT)
+      trace::printf ("lazy_init::%s() done\n", __func__);
+#endif
+      return nullptr;
+    }
+
+  /**
+   * @endcond
+   */
+
+  // --------------------------------------------------------------------------
+  } /* namespace rtos */
+} /* namespace os */
+
+#endif /* defined(OS_USE_RTOS_LAZY_INIT) */
+
+// ----------------------------------------------------------------------------
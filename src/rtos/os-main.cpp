@@ -68,9 +68,30 @@ namespace
   [[noreturn]] static void
   _main_trampoline (void)
   {
+#if defined(OS_INCLUDE_STARTUP_TIMESTAMPS)
+    os_startup_timestamps.os_main = os_startup_timestamp ();
+
+    trace::printf (
+        "Startup cycles: data %u, bss %u, hardware %u, free store %u, "
+        "init array %u, main %u, os_main %u.\n",
+        static_cast<unsigned int> (os_startup_timestamps.data),
+        static_cast<unsigned int> (os_startup_timestamps.bss),
+        static_cast<unsigned int> (os_startup_timestamps.hardware),
+        static_cast<unsigned int> (os_startup_timestamps.free_store),
+        static_cast<unsigned int> (os_startup_timestamps.init_array),
+        static_cast<unsigned int> (os_startup_timestamps.main),
+        static_cast<unsigned int> (os_startup_timestamps.os_main));
+#endif /* defined(OS_INCLUDE_STARTUP_TIMESTAMPS) */
+
     trace::puts ("");
     trace::dump_args (main_args.argc, main_args.argv);
 
+#if defined(OS_USE_RTOS_LAZY_INIT)
+    // Construct the objects needed by os_main(), and start
+    // the thread which constructs the others.
+    rtos::lazy_init::start ();
+#endif /* defined(OS_USE_RTOS_LAZY_INIT) */
+
     int code = os_main (main_args.argc, main_args.argv);
     trace::printf ("%s() exit = %d\n", __func__, code);
 
@@ -0,0 +1,1008 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/rtos/os.h>
+
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace rtos
+  {
+    // ------------------------------------------------------------------------
+
+    /**
+     * @class message_buffer::attributes
+     * @details
+     * Allow to assign a name and custom attributes (like a static
+     * address) to the message buffer.
+     *
+     * To simplify access, the member variables are public and do not
+     * require accessors or mutators.
+     */
+
+    /**
+     * @var void* message_buffer::attributes::mb_buffer_address
+     * @details
+     * Set this variable to a user defined memory area large enough
+     * to store the message buffer. Usually this is a statically
+     * allocated byte array.
+     *
+     * The default value is `nullptr`, which means there is no
+     * user defined message buffer.
+     */
+
+    /**
+     * @var std::size_t message_buffer::attributes::mb_buffer_size_bytes
+     * @details
+     * The message buffer size must match the capacity requested
+     * in the constructor.
+     *
+     * The default value is `0`, which means there is no
+     * user defined message buffer.
+     */
+
+    /**
+     * @details
+     * This variable is used by the default constructor.
+     */
+    const message_buffer::attributes message_buffer::initializer;
+
+    // ------------------------------------------------------------------------
+
+    /**
+     * @class message_buffer
+     * @details
+     * A message buffer is a contiguous ring of bytes, where each
+     * message is stored as a `msg_size_t` length prefix followed
+     * by the message content. Unlike message queues, which reserve
+     * a fixed size slot for each message, message buffers store
+     * messages of variable length without wasting space, which
+     * makes them suitable for byte streams produced by
+     * interrupt handlers (like serial lines or packet receivers)
+     * and consumed by threads.
+     *
+     * Messages are received in the same order they were sent; there
+     * are no priorities.
+     *
+     * Sending and receiving messages copy the content inside an
+     * interrupts critical section, so very large messages may increase
+     * the interrupt latency.
+     *
+     * @par Example
+     *
+     * @code{.cpp}
+     * message_buffer mb { 256 };
+     *
+     * void
+     * uart_rx_handler (void)
+     * {
+     *   char frame[32];
+     *   std::size_t len = uart_read_frame (frame, sizeof(frame));
+     *
+     *   // In ISRs only the try_*() variant is allowed.
+     *   mb.try_send (frame, len);
+     * }
+     *
+     * void
+     * consumer (void)
+     * {
+     *   char frame[32];
+     *   std::size_t len;
+     *
+     *   for (;;)
+     *     {
+     *       mb.receive (frame, sizeof(frame), &len);
+     *       process_frame (frame, len);
+     *     }
+     * }
+     * @endcode
+     */
+
+    /**
+     * @cond ignore
+     */
+
+    message_buffer::message_buffer (const char* name) :
+        object_named_system
+          { name }
+    {
+#if defined(OS_TRACE_RTOS_MBUFFER)
+      trace::printf ("%s() @%p %s\n", __func__, this, this->name ());
+#endif
+    }
+
+    /**
+     * @endcond
+     */
+
+    /**
+     * @details
+     * This constructor shall initialise a message buffer object
+     * with attributes referenced by _attr_.
+     * If the attributes specified by _attr_ are modified later,
+     * the message buffer attributes shall not be affected.
+     * Upon successful initialisation, the state of the
+     * message buffer object shall become initialised.
+     *
+     * Only the message buffer itself may be used for performing
+     * synchronisation. It is not allowed to make copies of
+     * message buffer objects.
+     *
+     * If the attributes define a storage area (via `mb_buffer_address` and
+     * `mb_buffer_size_bytes`), that storage is used, otherwise
+     * the storage is dynamically allocated using the RTOS specific allocator
+     * (`rtos::memory::allocator`).
+     *
+     * @warning Cannot be invoked from Interrupt Service Routines.
+     */
+    message_buffer::message_buffer (std::size_t size_bytes,
+                                    const attributes& attr,
+                                    const allocator_type& allocator) :
+        message_buffer
+          { nullptr, size_bytes, attr, allocator }
+    {
+      ;
+    }
+
+    /**
+     * @details
+     * This constructor shall initialise a named message buffer object
+     * with attributes referenced by _attr_.
+     * If the attributes specified by _attr_ are modified later,
+     * the message buffer attributes shall not be affected.
+     * Upon successful initialisation, the state of the
+     * message buffer object shall become initialised.
+     *
+     * Only the message buffer itself may be used for performing
+     * synchronisation. It is not allowed to make copies of
+     * message buffer objects.
+     *
+     * If the attributes define a storage area (via `mb_buffer_address` and
+     * `mb_buffer_size_bytes`), that storage is used, otherwise
+     * the storage is dynamically allocated using the RTOS specific allocator
+     * (`rtos::memory::allocator`).
+     *
+     * @warning Cannot be invoked from Interrupt Service Routines.
+     */
+    message_buffer::message_buffer (const char* name, std::size_t size_bytes,
+                                    const attributes& attr,
+                                    const allocator_type& allocator) :
+        object_named_system
+          { name }
+    {
+#if defined(OS_TRACE_RTOS_MBUFFER)
+      trace::printf ("%s() @%p %s %u\n", __func__, this, this->name (),
+                     size_bytes);
+#endif
+
+      if (attr.mb_buffer_address != nullptr)
+        {
+          // Do not use any allocator at all.
+          internal_construct_ (size_bytes, attr, nullptr, 0);
+        }
+      else
+        {
+          allocator_ = &allocator;
+
+          // If no user storage was provided via attributes,
+          // allocate it dynamically via the allocator.
+          allocated_buffer_size_elements_ = (size_bytes
+              + sizeof(typename allocator_type::value_type) - 1)
+              / sizeof(typename allocator_type::value_type);
+
+          allocated_buffer_addr_ =
+              const_cast<allocator_type&> (allocator).allocate (
+                  allocated_buffer_size_elements_);
+
+          internal_construct_ (
+              size_bytes,
+              attr,
+              allocated_buffer_addr_,
+              allocated_buffer_size_elements_
+                  * sizeof(typename allocator_type::value_type));
+        }
+    }
+
+    /**
+     * @details
+     * This destructor shall destroy the message buffer object; the object
+     * becomes, in effect, uninitialised. An implementation may cause
+     * the destructor to set the object to an invalid value.
+     *
+     * It shall be safe to destroy an initialised message buffer object
+     * upon which no threads are currently blocked. Attempting to
+     * destroy a message buffer object upon which other threads are
+     * currently blocked results in undefined behaviour.
+     *
+     * If the storage for the message buffer was dynamically allocated,
+     * it is deallocated using the same allocator.
+     */
+    message_buffer::~message_buffer ()
+    {
+#if defined(OS_TRACE_RTOS_MBUFFER)
+      trace::printf ("%s() @%p %s\n", __func__, this, name ());
+#endif
+
+      assert(send_list_.empty ());
+      assert(receive_list_.empty ());
+
+      if (allocated_buffer_addr_ != nullptr)
+        {
+          typedef typename std::allocator_traits<allocator_type>::pointer pointer;
+
+          static_cast<allocator_type*> (const_cast<void*> (allocator_))->deallocate (
+              reinterpret_cast<pointer> (allocated_buffer_addr_),
+              allocated_buffer_size_elements_);
+        }
+    }
+
+    /**
+     * @cond ignore
+     */
+
+    void
+    message_buffer::internal_construct_ (std::size_t size_bytes,
+                                         const attributes& attr,
+                                         void* buffer_address,
+                                         std::size_t buffer_size_bytes)
+    {
+      os_assert_throw(!interrupts::in_handler_mode (), EPERM);
+
+      clock_ = attr.clock != nullptr ? attr.clock : &sysclock;
+
+      // The buffer must be able to store at least one non empty message.
+      os_assert_throw(size_bytes > sizeof(msg_size_t), EINVAL);
+
+      // If the storage is given explicitly, override attributes.
+      if (buffer_address != nullptr)
+        {
+          // The attributes should not define any storage in this case.
+          assert(attr.mb_buffer_address == nullptr);
+
+          buffer_addr_ = static_cast<char*> (buffer_address);
+          buffer_size_bytes_ = buffer_size_bytes;
+        }
+      else
+        {
+          buffer_addr_ = static_cast<char*> (attr.mb_buffer_address);
+          buffer_size_bytes_ = attr.mb_buffer_size_bytes;
+        }
+
+#if defined(OS_TRACE_RTOS_MBUFFER)
+      trace::printf ("%s() @%p %s %u %p %u\n", __func__, this, name (),
+                     size_bytes, buffer_addr_, buffer_size_bytes_);
+#endif
+
+      os_assert_throw(buffer_addr_ != nullptr, ENOMEM);
+      os_assert_throw(buffer_size_bytes_ >= size_bytes, EINVAL);
+
+      // Use only the requested size, even if more storage is available
+      // (the allocator rounds up to the element size).
+      buffer_size_bytes_ = size_bytes;
+
+      head_ = 0;
+      used_bytes_ = 0;
+      count_ = 0;
+    }
+
+    /*
+     * Internal function.
+     * Should be called from an interrupts critical section.
+     */
+    std::size_t
+    message_buffer::internal_copy_in_ (std::size_t offset, const void* src,
+                                       std::size_t nbytes)
+    {
+      const char* p = static_cast<const char*> (src);
+
+      // The ring may wrap around; copy in at most two chunks.
+      std::size_t chunk = buffer_size_bytes_ - offset;
+      if (nbytes < chunk)
+        {
+          chunk = nbytes;
+        }
+      std::memcpy (buffer_addr_ + offset, p, chunk);
+      if (chunk < nbytes)
+        {
+          std::memcpy (buffer_addr_, p + chunk, nbytes - chunk);
+        }
+
+      offset += nbytes;
+      if (offset >= buffer_size_bytes_)
+        {
+          offset -= buffer_size_bytes_;
+        }
+      return offset;
+    }
+
+    /*
+     * Internal function.
+     * Should be called from an interrupts critical section.
+     */
+    std::size_t
+    message_buffer::internal_copy_out_ (std::size_t offset, void* dest,
+                                        std::size_t nbytes) const
+    {
+      char* p = static_cast<char*> (dest);
+
+      std::size_t chunk = buffer_size_bytes_ - offset;
+      if (nbytes < chunk)
+        {
+          chunk = nbytes;
+        }
+      if (p != nullptr)
+        {
+          std::memcpy (p, buffer_addr_ + offset, chunk);
+          if (chunk < nbytes)
+            {
+              std::memcpy (p + chunk, buffer_addr_, nbytes - chunk);
+            }
+        }
+
+      offset += nbytes;
+      if (offset >= buffer_size_bytes_)
+        {
+          offset -= buffer_size_bytes_;
+        }
+      return offset;
+    }
+
+    /*
+     * Internal function.
+     * Should be called from an interrupts critical section.
+     */
+    bool
+    message_buffer::internal_try_send_ (const void* msg, std::size_t nbytes)
+    {
+      std::size_t record_bytes = sizeof(msg_size_t) + nbytes;
+      if (buffer_size_bytes_ - used_bytes_ < record_bytes)
+        {
+          // No available space to send the message.
+          return false;
+        }
+
+      // The tail is where the new record begins.
+      std::size_t tail = head_ + used_bytes_;
+      if (tail >= buffer_size_bytes_)
+        {
+          tail -= buffer_size_bytes_;
+        }
+
+      // First the length prefix, then the content.
+      msg_size_t len = static_cast<msg_size_t> (nbytes);
+      tail = internal_copy_in_ (tail, &len, sizeof(len));
+      internal_copy_in_ (tail, msg, nbytes);
+
+      used_bytes_ += record_bytes;
+
+      // One more message added to the buffer.
+      ++count_;
+
+      // Wake-up one thread, if any.
+      receive_list_.resume_one ();
+
+      return true;
+    }
+
+    /*
+     * Internal function.
+     * Should be called from an interrupts critical section.
+     */
+    result_t
+    message_buffer::internal_try_receive_ (void* msg, std::size_t nbytes,
+                                           std::size_t* rbytes)
+    {
+      if (count_ == 0)
+        {
+          return EWOULDBLOCK;
+        }
+
+      msg_size_t len;
+      std::size_t offset = internal_copy_out_ (head_, &len, sizeof(len));
+
+      if (len > nbytes)
+        {
+          // Do not truncate, leave the message in the buffer.
+          return EMSGSIZE;
+        }
+
+      head_ = internal_copy_out_ (offset, msg, len);
+      used_bytes_ -= sizeof(msg_size_t) + len;
+
+      --count_;
+      if (count_ == 0)
+        {
+          // Restart from the beginning, to keep records contiguous
+          // and reduce the number of wrapped copies.
+          head_ = 0;
+        }
+
+      if (rbytes != nullptr)
+        {
+          *rbytes = len;
+        }
+
+      // Senders may wait for different amounts of space, so wake-up
+      // all of them and let each one check again.
+      send_list_.resume_all ();
+
+      return result::ok;
+    }
+
+    /**
+     * @endcond
+     */
+
+    /**
+     * @details
+     * The `send()` function shall add the message
+     * pointed to by the argument
+     * _msg_ to the message buffer. The _nbytes_ argument specifies the length
+     * of the message, in bytes, pointed to by _msg_.
+     *
+     * If the message buffer has enough free space, the message is
+     * copied in the buffer, preceded by its length.
+     *
+     * If there is not enough free space, `send()`
+     * shall block
+     * until space becomes available to enqueue the message, or
+     * until `send()` is cancelled/interrupted.
+     *
+     * Messages larger than the buffer capacity (including
+     * the length prefix) or than `max_msg_size` can never be
+     * sent, and `send()` fails with EMSGSIZE.
+     *
+     * @warning Cannot be invoked from Interrupt Service Routines.
+     */
+    result_t
+    message_buffer::send (const void* msg, std::size_t nbytes)
+    {
+#if defined(OS_TRACE_RTOS_MBUFFER)
+      trace::printf ("%s(%p,%u) @%p %s\n", __func__, msg, nbytes, this,
+                     name ());
+#endif
+
+      os_assert_err(!interrupts::in_handler_mode (), EPERM);
+      os_assert_err(!scheduler::locked (), EPERM);
+      os_assert_err(msg != nullptr || nbytes == 0, EINVAL);
+      os_assert_err(nbytes <= max_msg_size, EMSGSIZE);
+      os_assert_err(sizeof(msg_size_t) + nbytes <= buffer_size_bytes_,
+                    EMSGSIZE);
+
+        {
+          // ----- Enter critical section -------------------------------------
+          interrupts::critical_section ics;
+
+          if (internal_try_send_ (msg, nbytes))
+            {
+              return result::ok;
+            }
+          // ----- Exit critical section --------------------------------------
+        }
+
+      thread& crt_thread = this_thread::thread ();
+
+      // Prepare a list node pointing to the current thread.
+      // Do not worry for being on stack, it is temporarily linked to the
+      // list and guaranteed to be removed before this function returns.
+      internal::waiting_thread_node node
+        { crt_thread };
+
+      for (;;)
+        {
+            {
+              // ----- Enter critical section ---------------------------------
+              interrupts::critical_section ics;
+
+              if (internal_try_send_ (msg, nbytes))
+                {
+                  return result::ok;
+                }
+
+              // Add this thread to the message buffer send waiting list.
+              scheduler::internal_link_node (send_list_, node);
+              // state::suspended set in above link().
+              // ----- Exit critical section ----------------------------------
+            }
+
+          port::scheduler::reschedule ();
+
+          // Remove the thread from the message buffer send waiting list,
+          // if not already removed by receive().
+          scheduler::internal_unlink_node (node);
+
+          if (crt_thread.interrupted ())
+            {
+#if defined(OS_TRACE_RTOS_MBUFFER)
+              trace::printf ("%s(%p,%u) EINTR @%p %s\n", __func__, msg, nbytes,
+                             this, name ());
+#endif
+              return EINTR;
+            }
+        }
+
+      /* NOTREACHED */
+      return ENOTRECOVERABLE;
+    }
+
+    /**
+     * @details
+     * The `try_send()` function shall try to add the message
+     * pointed to by the argument
+     * _msg_ to the message buffer. The _nbytes_ argument specifies the length
+     * of the message, in bytes, pointed to by _msg_.
+     *
+     * If there is not enough free space, the message shall
+     * not be queued and `try_send()` shall return an error.
+     *
+     * @note Can be invoked from Interrupt Service Routines.
+     */
+    result_t
+    message_buffer::try_send (const void* msg, std::size_t nbytes)
+    {
+#if defined(OS_TRACE_RTOS_MBUFFER)
+      trace::printf ("%s(%p,%u) @%p %s\n", __func__, msg, nbytes, this,
+                     name ());
+#endif
+
+      os_assert_err(msg != nullptr || nbytes == 0, EINVAL);
+      os_assert_err(nbytes <= max_msg_size, EMSGSIZE);
+      os_assert_err(sizeof(msg_size_t) + nbytes <= buffer_size_bytes_,
+                    EMSGSIZE);
+
+      assert(port::interrupts::is_priority_valid ());
+
+        {
+          // ----- Enter critical section -------------------------------------
+          interrupts::critical_section ics;
+
+          if (internal_try_send_ (msg, nbytes))
+            {
+              return result::ok;
+            }
+          else
+            {
+              return EWOULDBLOCK;
+            }
+          // ----- Exit critical section --------------------------------------
+        }
+    }
+
+    /**
+     * @details
+     * The `timed_send()` function shall add the message
+     * pointed to by the argument
+     * _msg_ to the message buffer. The _nbytes_ argument specifies the length
+     * of the message, in bytes, pointed to by _msg_.
+     *
+     * If there is not enough free space, the wait for sufficient
+     * room in the buffer shall be terminated when the specified timeout
+     * expires.
+     *
+     * The timeout shall expire after the number of time units (that
+     * is when the value of that clock equals or exceeds (now()+timeout).
+     * The resolution of the timeout shall be the resolution of the
+     * clock on which it is based.
+     *
+     * Under no circumstance shall the operation fail with a timeout
+     * if there is sufficient room in the buffer to add the message
+     * immediately.
+     *
+     * The clock used for timeouts can be specified via the `clock`
+     * attribute. By default, the clock derived from the scheduler
+     * timer is used, and the durations are expressed in ticks.
+     *
+     * @warning Cannot be invoked from Interrupt Service Routines.
+     */
+    result_t
+    message_buffer::timed_send (const void* msg, std::size_t nbytes,
+                                clock::duration_t timeout)
+    {
+#if defined(OS_TRACE_RTOS_MBUFFER)
+      trace::printf ("%s(%p,%u,%u) @%p %s\n", __func__, msg, nbytes, timeout,
+                     this, name ());
+#endif
+
+      os_assert_err(!interrupts::in_handler_mode (), EPERM);
+      os_assert_err(!scheduler::locked (), EPERM);
+      os_assert_err(msg != nullptr || nbytes == 0, EINVAL);
+      os_assert_err(nbytes <= max_msg_size, EMSGSIZE);
+      os_assert_err(sizeof(msg_size_t) + nbytes <= buffer_size_bytes_,
+                    EMSGSIZE);
+
+      // Extra test before entering the loop, with its inherent weight.
+      // Trade size for speed.
+        {
+          // ----- Enter critical section -------------------------------------
+          interrupts::critical_section ics;
+
+          if (internal_try_send_ (msg, nbytes))
+            {
+              return result::ok;
+            }
+          // ----- Exit critical section --------------------------------------
+        }
+
+      thread& crt_thread = this_thread::thread ();
+
+      // Prepare a list node pointing to the current thread.
+      // Do not worry for being on stack, it is temporarily linked to the
+      // list and guaranteed to be removed before this function returns.
+      internal::waiting_thread_node node
+        { crt_thread };
+
+      internal::clock_timestamps_list& clock_list = clock_->steady_list ();
+
+      clock::timestamp_t timeout_timestamp = clock_->steady_now () + timeout;
+
+      // Prepare a timeout node pointing to the current thread.
+      internal::timeout_thread_node timeout_node
+        { timeout_timestamp, crt_thread };
+
+      for (;;)
+        {
+            {
+              // ----- Enter critical section ---------------------------------
+              interrupts::critical_section ics;
+
+              if (internal_try_send_ (msg, nbytes))
+                {
+                  return result::ok;
+                }
+
+              // Add this thread to the message buffer send waiting list,
+              // and the clock timeout list.
+              scheduler::internal_link_node (send_list_, node, clock_list,
+                                             timeout_node);
+              // state::suspended set in above link().
+              // ----- Exit critical section ----------------------------------
+            }
+
+          port::scheduler::reschedule ();
+
+          // Remove the thread from the message buffer send waiting list,
+          // if not already removed by receive() and from the clock timeout
+          // list, if not already removed by the timer.
+          scheduler::internal_unlink_node (node, timeout_node);
+
+          if (crt_thread.interrupted ())
+            {
+#if defined(OS_TRACE_RTOS_MBUFFER)
+              trace::printf ("%s(%p,%u,%u) EINTR @%p %s\n", __func__, msg,
+                             nbytes, timeout, this, name ());
+#endif
+              return EINTR;
+            }
+
+          if (clock_->steady_now () >= timeout_timestamp)
+            {
+#if defined(OS_TRACE_RTOS_MBUFFER)
+              trace::printf ("%s(%p,%u,%u) ETIMEDOUT @%p %s\n", __func__, msg,
+                             nbytes, timeout, this, name ());
+#endif
+              return ETIMEDOUT;
+            }
+        }
+
+      /* NOTREACHED */
+      return ENOTRECOVERABLE;
+    }
+
+    /**
+     * @details
+     * The `receive()` function shall receive the oldest message
+     * from the message buffer.
+     *
+     * If the size of the buffer in bytes, specified by the
+     * _nbytes_ argument, is less than the length of the next message,
+     * the function shall fail with EMSGSIZE and the message shall be left
+     * in the buffer, so that it can be retrieved with a larger
+     * destination buffer. Otherwise, the message is removed from
+     * the buffer and copied to the buffer pointed to by the
+     * _msg_ argument; if _rbytes_ is not `nullptr`, the message length
+     * is stored there.
+     *
+     * If the message buffer is empty, `receive()` shall block
+     * until a message is enqueued on the message buffer or until
+     * `receive()` is cancelled/interrupted.
+     *
+     * @warning Cannot be invoked from Interrupt Service Routines.
+     */
+    result_t
+    message_buffer::receive (void* msg, std::size_t nbytes,
+                             std::size_t* rbytes)
+    {
+#if defined(OS_TRACE_RTOS_MBUFFER)
+      trace::printf ("%s(%p,%u) @%p %s\n", __func__, msg, nbytes, this,
+                     name ());
+#endif
+
+      os_assert_err(!interrupts::in_handler_mode (), EPERM);
+      os_assert_err(!scheduler::locked (), EPERM);
+      os_assert_err(msg != nullptr || nbytes == 0, EINVAL);
+
+      result_t res;
+
+        {
+          // ----- Enter critical section -------------------------------------
+          interrupts::critical_section ics;
+
+          res = internal_try_receive_ (msg, nbytes, rbytes);
+          if (res != EWOULDBLOCK)
+            {
+              return res;
+            }
+          // ----- Exit critical section --------------------------------------
+        }
+
+      thread& crt_thread = this_thread::thread ();
+
+      // Prepare a list node pointing to the current thread.
+      // Do not worry for being on stack, it is temporarily linked to the
+      // list and guaranteed to be removed before this function returns.
+      internal::waiting_thread_node node
+        { crt_thread };
+
+      for (;;)
+        {
+            {
+              // ----- Enter critical section ---------------------------------
+              interrupts::critical_section ics;
+
+              res = internal_try_receive_ (msg, nbytes, rbytes);
+              if (res != EWOULDBLOCK)
+                {
+                  return res;
+                }
+
+              // Add this thread to the message buffer receive waiting list.
+              scheduler::internal_link_node (receive_list_, node);
+              // state::suspended set in above link().
+              // ----- Exit critical section ----------------------------------
+            }
+
+          port::scheduler::reschedule ();
+
+          // Remove the thread from the message buffer receive waiting list,
+          // if not already removed by send().
+          scheduler::internal_unlink_node (node);
+
+          if (crt_thread.interrupted ())
+            {
+#if defined(OS_TRACE_RTOS_MBUFFER)
+              trace::printf ("%s(%p,%u) EINTR @%p %s\n", __func__, msg, nbytes,
+                             this, name ());
+#endif
+              return EINTR;
+            }
+        }
+
+      /* NOTREACHED */
+      return ENOTRECOVERABLE;
+    }
+
+    /**
+     * @details
+     * The `try_receive()` function shall try to receive the
+     * oldest message from the message buffer.
+     *
+     * If the size of the buffer in bytes, specified by the
+     * _nbytes_ argument, is less than the length of the next message,
+     * the function shall fail with EMSGSIZE and the message shall be left
+     * in the buffer.
+     *
+     * If the message buffer is empty, no message is removed from the
+     * buffer, and `try_receive()` returns an error.
+     *
+     * @note Can be invoked from Interrupt Service Routines.
+     */
+    result_t
+    message_buffer::try_receive (void* msg, std::size_t nbytes,
+                                 std::size_t* rbytes)
+    {
+#if defined(OS_TRACE_RTOS_MBUFFER)
+      trace::printf ("%s(%p,%u) @%p %s\n", __func__, msg, nbytes, this,
+                     name ());
+#endif
+
+      os_assert_err(msg != nullptr || nbytes == 0, EINVAL);
+
+      assert(port::interrupts::is_priority_valid ());
+
+        {
+          // ----- Enter critical section -------------------------------------
+          interrupts::critical_section ics;
+
+          return internal_try_receive_ (msg, nbytes, rbytes);
+          // ----- Exit critical section --------------------------------------
+        }
+    }
+
+    /**
+     * @details
+     * The `timed_receive()` function shall receive the
+     * oldest message from the message buffer.
+     *
+     * If the size of the buffer in bytes, specified by the
+     * _nbytes_ argument, is less than the length of the next message,
+     * the function shall fail with EMSGSIZE and the message shall be left
+     * in the buffer.
+     *
+     * If the message buffer is empty, the wait for a message
+     * shall be terminated when the specified timeout
+     * expires.
+     *
+     * The timeout shall expire after the number of time units (that
+     * is when the value of that clock equals or exceeds (now()+timeout).
+     * The resolution of the timeout shall be the resolution of the
+     * clock on which it is based.
+     *
+     * Under no circumstance shall the operation fail with a timeout
+     * if a message can be removed from the message buffer immediately.
+     *
+     * The clock used for timeouts can be specified via the `clock`
+     * attribute. By default, the clock derived from the scheduler
+     * timer is used, and the durations are expressed in ticks.
+     *
+     * @warning Cannot be invoked from Interrupt Service Routines.
+     */
+    result_t
+    message_buffer::timed_receive (void* msg, std::size_t nbytes,
+                                   clock::duration_t timeout,
+                                   std::size_t* rbytes)
+    {
+#if defined(OS_TRACE_RTOS_MBUFFER)
+      trace::printf ("%s(%p,%u,%u) @%p %s\n", __func__, msg, nbytes, timeout,
+                     this, name ());
+#endif
+
+      os_assert_err(!interrupts::in_handler_mode (), EPERM);
+      os_assert_err(!scheduler::locked (), EPERM);
+      os_assert_err(msg != nullptr || nbytes == 0, EINVAL);
+
+      result_t res;
+
+      // Extra test before entering the loop, with its inherent weight.
+      // Trade size for speed.
+        {
+          // ----- Enter critical section -------------------------------------
+          interrupts::critical_section ics;
+
+          res = internal_try_receive_ (msg, nbytes, rbytes);
+          if (res != EWOULDBLOCK)
+            {
+              return res;
+            }
+          // ----- Exit critical section --------------------------------------
+        }
+
+      thread& crt_thread = this_thread::thread ();
+
+      // Prepare a list node pointing to the current thread.
+      // Do not worry for being on stack, it is temporarily linked to the
+      // list and guaranteed to be removed before this function returns.
+      internal::waiting_thread_node node
+        { crt_thread };
+
+      internal::clock_timestamps_list& clock_list = clock_->steady_list ();
+      clock::timestamp_t timeout_timestamp = clock_->steady_now () + timeout;
+
+      // Prepare a timeout node pointing to the current thread.
+      internal::timeout_thread_node timeout_node
+        { timeout_timestamp, crt_thread };
+
+      for (;;)
+        {
+            {
+              // ----- Enter critical section ---------------------------------
+              interrupts::critical_section ics;
+
+              res = internal_try_receive_ (msg, nbytes, rbytes);
+              if (res != EWOULDBLOCK)
+                {
+                  return res;
+                }
+
+              // Add this thread to the message buffer receive waiting list,
+              // and the clock timeout list.
+              scheduler::internal_link_node (receive_list_, node, clock_list,
+                                             timeout_node);
+              // state::suspended set in above link().
+              // ----- Exit critical section ----------------------------------
+            }
+
+          port::scheduler::reschedule ();
+
+          // Remove the thread from the message buffer receive waiting list,
+          // if not already removed by send() and from the clock
+          // timeout list, if not already removed by the timer.
+          scheduler::internal_unlink_node (node, timeout_node);
+
+          if (crt_thread.interrupted ())
+            {
+#if defined(OS_TRACE_RTOS_MBUFFER)
+              trace::printf ("%s(%p,%u,%u) EINTR @%p %s\n", __func__, msg,
+                             nbytes, timeout, this, name ());
+#endif
+              return EINTR;
+            }
+
+          if (clock_->steady_now () >= timeout_timestamp)
+            {
+#if defined(OS_TRACE_RTOS_MBUFFER)
+              trace::printf ("%s(%p,%u,%u) ETIMEDOUT @%p %s\n", __func__, msg,
+                             nbytes, timeout, this, name ());
+#endif
+              return ETIMEDOUT;
+            }
+        }
+
+      /* NOTREACHED */
+      return ENOTRECOVERABLE;
+    }
+
+    /**
+     * @details
+     * Return the message buffer
+     * to the initial state. All messages are discarded and
+     * the waiting senders are resumed.
+     *
+     * @warning Cannot be invoked from Interrupt Service Routines.
+     */
+    result_t
+    message_buffer::reset (void)
+    {
+#if defined(OS_TRACE_RTOS_MBUFFER)
+      trace::printf ("%s() @%p %s\n", __func__, this, name ());
+#endif
+
+      os_assert_err(!interrupts::in_handler_mode (), EPERM);
+
+        {
+          // ----- Enter critical section -------------------------------------
+          interrupts::critical_section ics;
+
+          head_ = 0;
+          used_bytes_ = 0;
+          count_ = 0;
+
+          // Wake-up all threads, if any.
+          send_list_.resume_all ();
+          receive_list_.resume_all ();
+
+          return result::ok;
+          // ----- Exit critical section --------------------------------------
+        }
+    }
+
+  // --------------------------------------------------------------------------
+
+  } /* namespace rtos */
+} /* namespace os */
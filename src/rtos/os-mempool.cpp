@@ -35,6 +35,28 @@ namespace os
   namespace rtos
   {
 
+#if defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE)
+
+    /**
+     * @cond ignore
+     */
+
+    namespace
+    {
+      // The free list head is a tagged index: the block index plus one
+      // in the low bits and a change counter above, updated together
+      // with a single compare-and-swap, so a block popped and pushed
+      // back between the load and the CAS (the ABA problem) is detected.
+      constexpr std::uintptr_t index_mask = 0xFFFF;
+      constexpr std::uintptr_t tag_increment = index_mask + 1;
+    }
+
+    /**
+     * @endcond
+     */
+
+#endif /* defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE) */
+
     // ------------------------------------------------------------------------
 
     /**
@@ -321,6 +343,10 @@ namespace os
       blocks_ = static_cast<memory_pool::size_t> (blocks);
       assert(blocks_ == blocks);
       assert(blocks_ > 0);
+#if defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE)
+      // One index value is reserved for the end of list.
+      assert(blocks_ < index_mask);
+#endif /* defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE) */
 
       // Adjust block size to multiple of pointer.
       // Blocks must be large enough to store a pointer, used
@@ -420,6 +446,25 @@ namespace os
     void
     memory_pool::internal_init_ (void)
     {
+#if defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE)
+
+      // Each free block holds the index of the next free block,
+      // plus one, or 0 at the end.
+      char* p = static_cast<char*> (pool_addr_);
+      for (std::size_t i = 1; i < blocks_; ++i)
+        {
+          *(static_cast<std::uintptr_t*> (static_cast<void*> (p))) = i + 1;
+          p += block_size_bytes_;
+        }
+      *(static_cast<std::uintptr_t*> (static_cast<void*> (p))) = 0;
+
+      // First block, with a new tag.
+      first_ = ((first_ & ~index_mask) + tag_increment) | 1;
+
+      count_ = 0; // No allocated blocks.
+
+#else
+
       // Construct a linked list of blocks. Store the pointer at
       // the beginning of each block. Each block
       // will hold the address of the next free block, or nullptr at the end.
@@ -441,16 +486,51 @@ namespace os
       first_ = pool_addr_; // Pointer to first block.
 
       count_ = 0; // No allocated blocks.
+
+#endif /* defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE) */
     }
 
     /*
      * Internal function used to return the first block in the
      * free list.
-     * Should be called from an interrupts critical section.
+     * Should be called from an interrupts critical section,
+     * unless the lock-free implementation is used.
      */
     void*
     memory_pool::internal_try_first_ (void)
     {
+#if defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE)
+
+      std::uintptr_t head = __atomic_load_n (&first_, __ATOMIC_ACQUIRE);
+      for (;;)
+        {
+          std::uintptr_t index = head & index_mask;
+          if (index == 0)
+            {
+              return nullptr;
+            }
+
+          void* p = static_cast<char*> (pool_addr_)
+              + (index - 1) * block_size_bytes_;
+
+          // If the block was taken meanwhile, this value may be stale,
+          // but then the tag changed too and the exchange fails.
+          std::uintptr_t next = __atomic_load_n (
+              static_cast<std::uintptr_t*> (p), __ATOMIC_RELAXED);
+
+          std::uintptr_t tagged = ((head & ~index_mask) + tag_increment)
+              | (next & index_mask);
+          if (__atomic_compare_exchange_n (&first_, &head, tagged, true,
+          __ATOMIC_ACQ_REL,
+                                           __ATOMIC_ACQUIRE))
+            {
+              __atomic_fetch_add (&count_, 1, __ATOMIC_RELAXED);
+              return p;
+            }
+        }
+
+#else
+
       if (first_ != nullptr)
         {
           void* p = static_cast<void*> (first_);
@@ -460,6 +540,8 @@ namespace os
         }
 
       return nullptr;
+
+#endif /* defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE) */
     }
 
     /**
@@ -500,8 +582,10 @@ namespace os
       // Extra test before entering the loop, with its inherent weight.
       // Trade size for speed.
         {
+#if !defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE)
           // ----- Enter critical section -------------------------------------
           interrupts::critical_section ics;
+#endif /* !defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE) */
 
           p = internal_try_first_ ();
           if (p != nullptr)
@@ -511,7 +595,9 @@ namespace os
 #endif
               return p;
             }
+#if !defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE)
           // ----- Exit critical section --------------------------------------
+#endif /* !defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE) */
         }
 
       thread& crt_thread = this_thread::thread ();
@@ -575,7 +661,9 @@ namespace os
      * immediately return 'nullptr'.
      *
      * This function uses a critical section to protect against simultaneous
-     * access from other threads or interrupts.
+     * access from other threads or interrupts; with
+     * `OS_USE_RTOS_MEMORY_POOL_LOCK_FREE` it uses an atomic
+     * compare-and-swap instead, without disabling interrupts.
      *
      * @note Can be invoked from Interrupt Service Routines.
      */
@@ -589,6 +677,9 @@ namespace os
       assert(port::interrupts::is_priority_valid ());
 
       void* p;
+#if defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE)
+      p = internal_try_first_ ();
+#else
         {
           // ----- Enter critical section -------------------------------------
           interrupts::critical_section ics;
@@ -596,6 +687,7 @@ namespace os
           p = internal_try_first_ ();
           // ----- Exit critical section --------------------------------------
         }
+#endif /* defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE) */
 
 #if defined(OS_TRACE_RTOS_MEMPOOL)
       trace::printf ("%s()=%p @%p %s\n", __func__, p, this, name ());
@@ -660,8 +752,10 @@ namespace os
       // Extra test before entering the loop, with its inherent weight.
       // Trade size for speed.
         {
+#if !defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE)
           // ----- Enter critical section -------------------------------------
           interrupts::critical_section ics;
+#endif /* !defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE) */
 
           p = internal_try_first_ ();
           if (p != nullptr)
@@ -671,7 +765,9 @@ namespace os
 #endif
               return p;
             }
+#if !defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE)
           // ----- Exit critical section --------------------------------------
+#endif /* !defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE) */
         }
 
       thread& crt_thread = this_thread::thread ();
@@ -746,7 +842,9 @@ namespace os
      * back to the memory pool.
      *
      * It uses a critical section to protect simultaneous access from
-     * other threads or interrupts.
+     * other threads or interrupts; with `OS_USE_RTOS_MEMORY_POOL_LOCK_FREE`
+     * the block is returned with an atomic compare-and-swap, and the
+     * waiting list is checked only if not empty.
      *
      * @note Can be invoked from Interrupt Service Routines.
      */
@@ -771,6 +869,36 @@ namespace os
           return EINVAL;
         }
 
+#if defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE)
+
+      std::uintptr_t index = static_cast<std::uintptr_t> (static_cast<char*> (block)
+          - static_cast<char*> (pool_addr_)) / block_size_bytes_ + 1;
+
+      // Perform a push_front() on the single linked LIFO list.
+      std::uintptr_t head = __atomic_load_n (&first_, __ATOMIC_RELAXED);
+      std::uintptr_t tagged;
+      do
+        {
+          __atomic_store_n (static_cast<std::uintptr_t*> (block),
+                            head & index_mask, __ATOMIC_RELAXED);
+          tagged = ((head & ~index_mask) + tag_increment) | index;
+        }
+      while (!__atomic_compare_exchange_n (&first_, &head, tagged, true,
+      __ATOMIC_RELEASE,
+                                           __ATOMIC_RELAXED));
+
+      __atomic_fetch_sub (&count_, 1, __ATOMIC_RELAXED);
+
+      // Waiters link themselves after a failed allocation, inside
+      // a critical section, so if the list is seen empty after the
+      // push, the block will be found by the next allocation.
+      if (list_.empty ())
+        {
+          return result::ok;
+        }
+
+#else
+
         {
           // ----- Enter critical section -------------------------------------
           interrupts::critical_section ics;
@@ -789,6 +917,8 @@ namespace os
           // ----- Exit critical section --------------------------------------
         }
 
+#endif /* defined(OS_USE_RTOS_MEMORY_POOL_LOCK_FREE) */
+
       // Wake-up one thread, if any.
       list_.resume_one ();
 
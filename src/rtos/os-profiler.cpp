@@ -0,0 +1,307 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/rtos/os.h>
+#include <cmsis-plus/diag/trace.h>
+
+// ----------------------------------------------------------------------------
+
+#if defined(OS_USE_RTOS_PROFILER)
+
+namespace os
+{
+  namespace rtos
+  {
+    namespace profiler
+    {
+      // ----------------------------------------------------------------------
+
+      /**
+       * @cond ignore
+       */
+
+      namespace
+      {
+        static_assert((OS_INTEGER_RTOS_PROFILER_BUCKETS & (OS_INTEGER_RTOS_PROFILER_BUCKETS - 1)) == 0,
+            "OS_INTEGER_RTOS_PROFILER_BUCKETS must be a power of 2");
+
+        // How many consecutive buckets are checked before giving up;
+        // keeps the time spent in the interrupt bounded.
+        constexpr std::size_t max_probes = 8;
+
+        typedef struct entry_s
+        {
+          const void* pc;
+          const void* lr;
+          const char* name;
+          uint32_t count;
+        } entry_t;
+
+        entry_t histogram_[OS_INTEGER_RTOS_PROFILER_BUCKETS];
+
+        std::size_t samples_;
+        std::size_t dropped_;
+        bool volatile running_;
+
+        uint32_t ticks_;
+
+        inline std::size_t
+        hash (const void* pc, const void* lr, const char* name)
+        {
+          uint32_t h =
+              static_cast<uint32_t> (reinterpret_cast<std::uintptr_t> (pc)
+                  ^ (reinterpret_cast<std::uintptr_t> (lr) << 7)
+                  ^ (reinterpret_cast<std::uintptr_t> (name) >> 2));
+          // Knuth multiplicative hash.
+          h *= 2654435761u;
+          return (h ^ (h >> 16)) & (OS_INTEGER_RTOS_PROFILER_BUCKETS - 1);
+        }
+
+      } /* namespace */
+
+      /**
+       * @endcond
+       */
+
+      // ----------------------------------------------------------------------
+
+      /**
+       * @details
+       * Samples are recorded only after `start()`; initially the
+       * profiler is stopped.
+       */
+      void
+      start (void)
+      {
+        running_ = true;
+      }
+
+      void
+      stop (void)
+      {
+        running_ = false;
+      }
+
+      bool
+      running (void)
+      {
+        return running_;
+      }
+
+      /**
+       * @details
+       * Remove all entries from the histogram and reset the counters.
+       */
+      void
+      clear (void)
+      {
+        // ----- Enter critical section -------------------------------------
+        interrupts::critical_section ics;
+
+        for (auto& e : histogram_)
+          {
+            e.count = 0;
+          }
+        samples_ = 0;
+        dropped_ = 0;
+        // ----- Exit critical section --------------------------------------
+      }
+
+      /**
+       * @details
+       * Identical samples (same program counter, link register and
+       * thread) are counted in the same histogram entry.
+       *
+       * The link register helps to tell apart calls of the same
+       * function from different places, but it is accurate only if
+       * the sample was taken in a leaf function, before the link
+       * register was reused.
+       *
+       * If no free entry is found within a few probes, the sample
+       * is counted as dropped.
+       */
+      void
+      sample (const void* pc, const void* lr)
+      {
+        if (!running_)
+          {
+            return;
+          }
+
+        // ----- Enter critical section ---------------------------------------
+        interrupts::critical_section ics;
+
+        const char* name = nullptr;
+        if (scheduler::started () && scheduler::current_thread_ != nullptr)
+          {
+            name = scheduler::current_thread_->name ();
+          }
+
+        ++samples_;
+
+        std::size_t ix = hash (pc, lr, name);
+        for (std::size_t i = 0; i < max_probes; ++i)
+          {
+            entry_t& e = histogram_[ix];
+            if (e.count == 0)
+              {
+                e.pc = pc;
+                e.lr = lr;
+                e.name = name;
+                e.count = 1;
+                return;
+              }
+            if (e.pc == pc && e.lr == lr && e.name == name)
+              {
+                ++e.count;
+                return;
+              }
+            ix = (ix + 1) & (OS_INTEGER_RTOS_PROFILER_BUCKETS - 1);
+          }
+
+        ++dropped_;
+        // ----- Exit critical section ----------------------------------------
+      }
+
+      std::size_t
+      samples (void)
+      {
+        return samples_;
+      }
+
+      std::size_t
+      dropped (void)
+      {
+        return dropped_;
+      }
+
+      /**
+       * @details
+       * The output is a header line followed by one line for each
+       * histogram entry, with the program counter, the link register,
+       * the number of samples and the thread name:
+       *
+       * @code{.unparsed}
+       * # profiler samples=1234 dropped=0
+       * 08001A2C 08001B07 57 main
+       * ...
+       * # end
+       * @endcode
+       *
+       * Save the output in a file and pass it to
+       * `scripts/profiler-flamegraph.py`.
+       */
+      void
+      dump (void)
+      {
+        bool was_running = running_;
+        running_ = false;
+
+        trace::printf ("# profiler samples=%u dropped=%u\n",
+                       static_cast<unsigned int> (samples_),
+                       static_cast<unsigned int> (dropped_));
+
+        for (const auto& e : histogram_)
+          {
+            if (e.count != 0)
+              {
+                trace::printf (
+                    "%08X %08X %u %s\n",
+                    static_cast<unsigned int> (reinterpret_cast<std::uintptr_t> (e.pc)),
+                    static_cast<unsigned int> (reinterpret_cast<std::uintptr_t> (e.lr)),
+                    static_cast<unsigned int> (e.count),
+                    e.name != nullptr ? e.name : "-");
+              }
+          }
+        trace::printf ("# end\n");
+
+        running_ = was_running;
+      }
+
+      /**
+       * @cond ignore
+       */
+
+      void
+      internal_tick_ (void)
+      {
+        if (!running_ || !scheduler::started ())
+          {
+            return;
+          }
+
+        if (++ticks_ < OS_INTEGER_RTOS_PROFILER_TICKS_PER_SAMPLE)
+          {
+            return;
+          }
+        ticks_ = 0;
+
+#if defined(__ARM_EABI__) \
+  && (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) \
+      || defined(__ARM_ARCH_6M__))
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+        // ICSR.RETTOBASE is set when there is no other active
+        // exception; if the SysTick preempted another handler,
+        // the frame on the thread stack is not the interrupted one.
+        if (((*reinterpret_cast<uint32_t volatile*> (0xE000ED04)) & (1UL << 11))
+            == 0)
+          {
+            sample (nullptr, nullptr);
+            return;
+          }
+#endif
+
+        // Threads run on the process stack; the exception entry pushed
+        // R0-R3, R12, LR, PC, xPSR at the current PSP.
+        uint32_t* frame;
+        asm volatile ("mrs %0, psp" : "=r" (frame));
+
+        sample (reinterpret_cast<const void*> (frame[6]),
+                reinterpret_cast<const void*> (frame[5]));
+
+#else
+
+        // There is no portable way to get the interrupted context,
+        // record only the thread.
+        sample (nullptr, nullptr);
+
+#endif
+      }
+
+      /**
+       * @endcond
+       */
+
+    // ------------------------------------------------------------------------
+    } /* namespace profiler */
+  } /* namespace rtos */
+} /* namespace os */
+
+#endif /* defined(OS_USE_RTOS_PROFILER) */
+
+// ----------------------------------------------------------------------------
@@ -45,6 +45,31 @@ namespace os
     std::size_t thread::stack::default_size_bytes_ =
         port::stack::default_size_bytes;
 
+#if defined(OS_USE_RTOS_THREAD_STACK_WATERMARK)
+
+    thread::stack::proximity_callback_t thread::stack::proximity_callback_ =
+        nullptr;
+
+    std::size_t thread::stack::proximity_threshold_bytes_ = 0;
+
+#endif /* defined(OS_USE_RTOS_THREAD_STACK_WATERMARK) */
+
+#if defined(OS_USE_RTOS_THREAD_STACK_CACHE)
+
+    namespace
+    {
+      // Free stacks, linked via the first word, one list per size class.
+      struct stack_cache_class_s
+      {
+        void* first;
+        std::size_t count;
+      };
+
+      stack_cache_class_s stack_cache_[OS_INTEGER_RTOS_THREAD_STACK_CACHE_CLASSES];
+    }
+
+#endif
+
     /**
      * @endcond
      */
@@ -150,7 +175,7 @@ namespace os
      */
 
     void
-    thread::stack::initialize (void)
+    thread::stack::initialize (bool paint)
     {
       // Align the bottom of the stack.
       void* pa = bottom_address_;
@@ -164,21 +189,273 @@ namespace os
       element_t* p = bottom_address_;
       element_t* pend = top ();
 
-      // Initialise the entire stack with the magic word.
-      for (; p < pend; ++p)
+#if defined(OS_USE_RTOS_THREAD_STACK_LAZY_PAINT)
+      // Paint only the guard band and the top magic word; the rest
+      // of the stack is left as is.
+      element_t* painted = bottom_address_
+          + OS_INTEGER_RTOS_THREAD_STACK_GUARD_SIZE_BYTES / sizeof(element_t);
+      if (painted > pend - 1)
         {
-          *p = magic;
+          painted = pend - 1;
         }
 
+      if (paint)
+        {
+          for (; p < painted; ++p)
+            {
+              *p = magic;
+            }
+          *(pend - 1) = magic;
+        }
+      p = pend;
+#else
+      if (paint)
+        {
+          // Initialise the entire stack with the magic word.
+          for (; p < pend; ++p)
+            {
+              *p = magic;
+            }
+        }
+      else
+        {
+          p = pend;
+        }
+#endif /* defined(OS_USE_RTOS_THREAD_STACK_LAZY_PAINT) */
+
       // Compute the actual size. The -1 is to leave space for the magic.
       size_bytes_ = ((static_cast<std::size_t> (p - bottom_address_) - 1)
           * sizeof(element_t));
+
+#if defined(OS_USE_RTOS_THREAD_STACK_WATERMARK)
+      // Nothing above the painted area is known to be unused.
+#if defined(OS_USE_RTOS_THREAD_STACK_LAZY_PAINT)
+      low_ = paint ? painted : top ();
+#else
+      low_ = top ();
+#endif /* defined(OS_USE_RTOS_THREAD_STACK_LAZY_PAINT) */
+      scan_ = bottom_address_;
+#endif /* defined(OS_USE_RTOS_THREAD_STACK_WATERMARK) */
     }
 
     /**
      * @endcond
      */
 
+#if defined(OS_USE_RTOS_THREAD_STACK_CACHE)
+
+    /**
+     * @details
+     * The size classes are powers of two, starting with
+     * `OS_INTEGER_RTOS_THREAD_STACK_CACHE_MIN_SIZE_BYTES`;
+     * the size is rounded up to the class size.
+     *
+     * @return The class index, or the number of classes if the
+     *  size is too large to be cached.
+     */
+    std::size_t
+    thread::stack::internal_cache_class_ (std::size_t& size_elements)
+    {
+      std::size_t bytes = size_elements * sizeof(allocation_element_t);
+      std::size_t class_bytes =
+      OS_INTEGER_RTOS_THREAD_STACK_CACHE_MIN_SIZE_BYTES;
+
+      for (std::size_t i = 0; i < OS_INTEGER_RTOS_THREAD_STACK_CACHE_CLASSES;
+          ++i, class_bytes <<= 1)
+        {
+          if (bytes <= class_bytes)
+            {
+              size_elements = class_bytes / sizeof(allocation_element_t);
+              return i;
+            }
+        }
+
+      return OS_INTEGER_RTOS_THREAD_STACK_CACHE_CLASSES;
+    }
+
+    /**
+     * @details
+     * Any cached stack of the request class can be reused, since
+     * it is at least as large as requested; in this case the size
+     * is updated to the class size.
+     *
+     * The returned stack is already filled with the magic word.
+     *
+     * @return The stack address, or `nullptr` if there is no cached
+     *  stack of this size class.
+     */
+    thread::stack::element_t*
+    thread::stack::internal_cache_get_ (std::size_t& size_elements)
+    {
+      std::size_t class_elements = size_elements;
+      std::size_t cls = internal_cache_class_ (class_elements);
+      if (cls >= OS_INTEGER_RTOS_THREAD_STACK_CACHE_CLASSES)
+        {
+          return nullptr;
+        }
+
+      element_t* p;
+        {
+          // ----- Enter critical section -------------------------------------
+          scheduler::critical_section scs;
+
+          p = static_cast<element_t*> (stack_cache_[cls].first);
+          if (p == nullptr)
+            {
+              return nullptr;
+            }
+          stack_cache_[cls].first = *reinterpret_cast<void**> (p);
+          --stack_cache_[cls].count;
+          // ----- Exit critical section --------------------------------------
+        }
+
+      size_elements = class_elements;
+
+      // Restore the words used for the link.
+      element_t* pend = p
+          + (sizeof(void*) + sizeof(element_t) - 1) / sizeof(element_t);
+      for (element_t* q = p; q < pend; ++q)
+        {
+          *q = magic;
+        }
+
+      return p;
+    }
+
+    /**
+     * @details
+     * Only stacks with the exact size of a class are cached;
+     * repaint the used part of the stack, between _used_ and the
+     * end of the allocated area, and add it to the cache.
+     *
+     * @retval true The stack was cached.
+     * @retval false The stack cannot be cached and must be deallocated.
+     */
+    bool
+    thread::stack::internal_cache_put_ (element_t* address,
+                                        std::size_t size_elements,
+                                        element_t* used)
+    {
+      std::size_t requested = size_elements;
+      std::size_t cls = internal_cache_class_ (size_elements);
+      if (cls >= OS_INTEGER_RTOS_THREAD_STACK_CACHE_CLASSES
+          || size_elements != requested)
+        {
+          return false;
+        }
+
+      if (stack_cache_[cls].count >= OS_INTEGER_RTOS_THREAD_STACK_CACHE_DEPTH)
+        {
+          return false;
+        }
+
+      element_t* pend = address
+          + (size_elements * sizeof(allocation_element_t)) / sizeof(element_t);
+      for (element_t* p = (used != nullptr) ? used : address; p < pend; ++p)
+        {
+          *p = magic;
+        }
+
+      // ----- Enter critical section -----------------------------------------
+      scheduler::critical_section scs;
+
+      if (stack_cache_[cls].count >= OS_INTEGER_RTOS_THREAD_STACK_CACHE_DEPTH)
+        {
+          return false;
+        }
+
+      *reinterpret_cast<void**> (address) = stack_cache_[cls].first;
+      stack_cache_[cls].first = address;
+      ++stack_cache_[cls].count;
+
+      return true;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /**
+     * @details
+     * Pre-warm the cache at startup, so that the first threads
+     * of a given size do not wait for the allocator; the stacks
+     * are allocated with the class size, and the number of
+     * stacks per class is limited to
+     * `OS_INTEGER_RTOS_THREAD_STACK_CACHE_DEPTH`.
+     */
+    std::size_t
+    thread::stack::cache_reserve (std::size_t size_bytes, std::size_t count)
+    {
+      os_assert_err(!interrupts::in_handler_mode (), 0);
+
+      std::size_t size_elements = (size_bytes + sizeof(allocation_element_t)
+          - 1) / sizeof(allocation_element_t);
+      std::size_t cls = internal_cache_class_ (size_elements);
+      if (cls >= OS_INTEGER_RTOS_THREAD_STACK_CACHE_CLASSES)
+        {
+          return 0;
+        }
+
+      using allocator_type = memory::allocator<allocation_element_t>;
+      allocator_type allocator;
+
+      for (std::size_t i = 0; i < count; ++i)
+        {
+          element_t* p = reinterpret_cast<element_t*> (allocator.allocate (
+              size_elements));
+          if (p == nullptr)
+            {
+              break;
+            }
+
+          if (!internal_cache_put_ (p, size_elements, nullptr))
+            {
+              allocator.deallocate (
+                  reinterpret_cast<allocation_element_t*> (p), size_elements);
+              break;
+            }
+        }
+
+      return stack_cache_[cls].count;
+    }
+
+    void
+    thread::stack::cache_release (void)
+    {
+      os_assert_throw(!interrupts::in_handler_mode (), EPERM);
+
+      using allocator_type = memory::allocator<allocation_element_t>;
+      allocator_type allocator;
+
+      std::size_t size_elements =
+      OS_INTEGER_RTOS_THREAD_STACK_CACHE_MIN_SIZE_BYTES
+          / sizeof(allocation_element_t);
+
+      for (std::size_t cls = 0; cls < OS_INTEGER_RTOS_THREAD_STACK_CACHE_CLASSES;
+          ++cls, size_elements <<= 1)
+        {
+          for (;;)
+            {
+              void* p;
+                {
+                  // ----- Enter critical section -----------------------------
+                  scheduler::critical_section scs;
+
+                  p = stack_cache_[cls].first;
+                  if (p == nullptr)
+                    {
+                      break;
+                    }
+                  stack_cache_[cls].first = *static_cast<void**> (p);
+                  --stack_cache_[cls].count;
+                  // ----- Exit critical section ------------------------------
+                }
+
+              allocator.deallocate (static_cast<allocation_element_t*> (p),
+                                    size_elements);
+            }
+        }
+    }
+
+#endif
+
     /**
      * @details
      * Count the number of words where the magic is still there.
@@ -201,6 +478,114 @@ namespace os
       return count;
     }
 
+#if defined(OS_USE_RTOS_THREAD_STACK_WATERMARK)
+
+    /**
+     * @details
+     * The callback is invoked by the idle thread, with the scheduler
+     * locked, each time the high-water mark of a thread stack moves
+     * and leaves less than _threshold_bytes_ available;
+     * it must not block.
+     *
+     * @warning Cannot be invoked from Interrupt Service Routines.
+     */
+    thread::stack::proximity_callback_t
+    thread::stack::proximity_callback (proximity_callback_t callback,
+                                       std::size_t threshold_bytes)
+    {
+      // ----- Enter critical section -----------------------------------------
+      scheduler::critical_section scs;
+
+      proximity_callback_t tmp = proximity_callback_;
+      proximity_callback_ = callback;
+      proximity_threshold_bytes_ = threshold_bytes;
+
+      return tmp;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /**
+     * @cond ignore
+     */
+
+    /**
+     * @details
+     * Scan at most _words_ words, upwards from where the previous call
+     * stopped; when a used word is found below the current mark, the
+     * mark is lowered and the scan restarts from the bottom, since
+     * words already checked might have been used in the meantime.
+     *
+     * @retval true The high-water mark moved.
+     * @retval false No new usage was found.
+     */
+    bool
+    thread::stack::internal_track_ (std::size_t words)
+    {
+      if (low_ == nullptr)
+        {
+          return false;
+        }
+
+      element_t* p = scan_;
+      element_t* pend = low_;
+      if (static_cast<std::size_t> (pend - p) > words)
+        {
+          pend = p + words;
+        }
+
+      for (; p < pend; ++p)
+        {
+          if (*p != magic)
+            {
+              low_ = p;
+              scan_ = bottom_address_;
+              return true;
+            }
+        }
+
+      // Start a new round when the mark is reached.
+      scan_ = (p >= low_) ? bottom_address_ : p;
+      return false;
+    }
+
+    /**
+     * @details
+     * Called by the idle thread on each iteration, with _th_ `nullptr`;
+     * it walks the thread tree with the scheduler locked and scans
+     * a limited number of words in each stack.
+     */
+    void
+    thread::stack::internal_track_all_ (thread* th)
+    {
+      // ----- Enter critical section -----------------------------------------
+      scheduler::critical_section scs;
+
+      for (auto&& p : scheduler::children_threads (th))
+        {
+          class stack& stk = p.stack ();
+          if (stk.internal_track_ (
+          OS_INTEGER_RTOS_THREAD_STACK_WATERMARK_STEP_WORDS))
+            {
+              std::size_t avail = static_cast<std::size_t> (stk.low_
+                  - stk.bottom_address_) * sizeof(element_t);
+              if (proximity_callback_ != nullptr
+                  && avail < proximity_threshold_bytes_)
+                {
+                  proximity_callback_ (&p, avail);
+                }
+            }
+
+          internal_track_all_ (&p);
+        }
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /**
+     * @endcond
+     */
+
+#endif /* defined(OS_USE_RTOS_THREAD_STACK_WATERMARK) */
+
     /**
      * @cond ignore
      */
@@ -366,9 +751,21 @@ namespace os
                   / sizeof(stack::allocation_element_t);
             }
 
-          allocated_stack_address_ =
-              reinterpret_cast<stack::element_t*> (const_cast<allocator_type&> (allocator).allocate (
-                  allocated_stack_size_elements_));
+#if defined(OS_USE_RTOS_THREAD_STACK_CACHE)
+
+          // Fresh stacks are allocated with the exact size; a cached
+          // stack may be larger, and updates the size.
+          allocated_stack_address_ = stack::internal_cache_get_ (
+              allocated_stack_size_elements_);
+          stack_recycled_ = (allocated_stack_address_ != nullptr);
+
+          if (allocated_stack_address_ == nullptr)
+#endif
+            {
+              allocated_stack_address_ =
+                  reinterpret_cast<stack::element_t*> (const_cast<allocator_type&> (allocator).allocate (
+                      allocated_stack_size_elements_));
+            }
 
           assert (allocated_stack_address_ != nullptr);
 
@@ -442,7 +839,12 @@ namespace os
               scheduler::top_threads_list_.link (*this);
             }
 
+#if defined(OS_USE_RTOS_THREAD_STACK_CACHE)
+          // Recycled stacks were painted when they were released.
+          stack ().initialize (!stack_recycled_);
+#else
           stack ().initialize ();
+#endif
 
 #if defined(OS_USE_RTOS_PORT_SCHEDULER)
 
@@ -1026,8 +1428,28 @@ namespace os
       trace::printf ("%s() @%p %s\n", __func__, this, name ());
 #endif
 
+#if defined(OS_USE_RTOS_THREAD_STACK_CACHE)
+      // Remember the lowest used word, before the stack is cleared;
+      // only the part above it must be repainted.
+      stack::element_t* used = nullptr;
+      if (allocated_stack_address_ != nullptr && stack ().size () > 0)
+        {
+          used = stack ().bottom ()
+              + stack ().available () / sizeof(stack::element_t);
+        }
+#endif
+
       internal_check_stack_ ();
 
+#if defined(OS_USE_RTOS_THREAD_STACK_CACHE)
+      if (allocated_stack_address_ != nullptr
+          && stack::internal_cache_put_ (allocated_stack_address_,
+                                         allocated_stack_size_elements_, used))
+        {
+          allocated_stack_address_ = nullptr;
+        }
+#endif
+
       if (allocated_stack_address_ != nullptr)
         {
           typedef typename std::allocator_traits<allocator_type>::pointer pointer;
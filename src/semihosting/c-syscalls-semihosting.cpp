@@ -37,10 +37,15 @@
 #include <cmsis-plus/arm/semihosting.h>
 #include <cmsis-plus/diag/trace.h>
 
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+#include <cmsis-plus/arm/semihosting-buffer.h>
+#endif
+
 #include <cmsis-plus/posix-io/types.h>
 
 #include <cmsis-plus/posix/dirent.h>
 #include <cmsis-plus/posix/sys/socket.h>
+#include <cmsis-plus/posix/sys/mman.h>
 
 #include "cmsis_device.h"
 
@@ -112,6 +117,21 @@ struct fdent
 
 static struct fdent openfiles[OS_INTEGER_SEMIHOSTING_MAX_OPEN_FILES];
 
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+
+// The standard input, output and error have buffers, to reduce
+// the number of operations, each one a round trip through the debugger.
+// Constant initialised, they can be used before the static constructors.
+static char buffers_storage[3][OS_INTEGER_SEMIHOSTING_BUFFER_SIZE];
+
+static os::semihosting::buffer buffers[3] =
+  {
+    { buffers_storage[0], sizeof(buffers_storage[0]) },
+    { buffers_storage[1], sizeof(buffers_storage[1]) },
+    { buffers_storage[2], sizeof(buffers_storage[2]) } };
+
+#endif /* defined(OS_INCLUDE_SEMIHOSTING_BUFFERS) */
+
 // ----------------------------------------------------------------------------
 // Support functions.
 
@@ -158,6 +178,23 @@ __semihosting_newslot (void)
   return i;
 }
 
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+
+// Return a pointer to the buffer of the user file
+// descriptor fd, or null if not buffered.
+static os::semihosting::buffer*
+__semihosting_findbuffer (int fd)
+{
+  if ((unsigned int) fd >= sizeof(buffers) / sizeof(buffers[0]))
+    {
+      return nullptr;
+    }
+
+  return &buffers[fd];
+}
+
+#endif /* defined(OS_INCLUDE_SEMIHOSTING_BUFFERS) */
+
 static int
 __semihosting_get_errno (void)
 {
@@ -205,6 +242,20 @@ __semihosting_lseek (int fd, int ptr, int dir)
       return -1;
     }
 
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+  // The position excludes the bytes read ahead, and includes
+  // the buffered output, which must be written before.
+  os::semihosting::buffer* pbuf = __semihosting_findbuffer (fd);
+  if (pbuf != nullptr)
+    {
+      pbuf->discard ();
+      if (pbuf->flush () < 0)
+        {
+          return __semihosting_error (-1);
+        }
+    }
+#endif /* defined(OS_INCLUDE_SEMIHOSTING_BUFFERS) */
+
   /* Convert SEEK_CUR to SEEK_SET */
   if (dir == SEEK_CUR)
     {
@@ -264,6 +315,15 @@ __semihosting_stat (int fd, struct stat* st)
       return -1;
     }
 
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+  // Write the buffered output, so the length is up to date.
+  os::semihosting::buffer* pbuf = __semihosting_findbuffer (fd);
+  if (pbuf != nullptr)
+    {
+      pbuf->flush ();
+    }
+#endif /* defined(OS_INCLUDE_SEMIHOSTING_BUFFERS) */
+
   /* Always assume a character device,
    with 1024 byte blocks. */
   st->st_mode |= S_IFCHR;
@@ -359,6 +419,13 @@ __posix_open (const char* path, int oflag, ...)
     {
       openfiles[fd].handle = fh;
       openfiles[fd].pos = 0;
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+      os::semihosting::buffer* pbuf = __semihosting_findbuffer (fd);
+      if (pbuf != nullptr)
+        {
+          pbuf->bind (fh);
+        }
+#endif /* defined(OS_INCLUDE_SEMIHOSTING_BUFFERS) */
       return fd;
     }
   else
@@ -378,6 +445,15 @@ __posix_close (int fildes)
       return -1;
     }
 
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+  // Write the buffered output before closing.
+  os::semihosting::buffer* pbuf = __semihosting_findbuffer (fildes);
+  if (pbuf != nullptr)
+    {
+      pbuf->bind (os::semihosting::buffer::no_handle);
+    }
+#endif /* defined(OS_INCLUDE_SEMIHOSTING_BUFFERS) */
+
   // Handle stderr == stdout.
   if ((fildes == 1 || fildes == 2)
       && (openfiles[1].handle == openfiles[2].handle))
@@ -419,6 +495,22 @@ __posix_read (int fildes, void* buf, size_t nbyte)
       return -1;
     }
 
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+  os::semihosting::buffer* pbuf = __semihosting_findbuffer (fildes);
+  if (pbuf != nullptr)
+    {
+      // Read ahead a buffer, and return the next reads from it.
+      ssize_t n = pbuf->read (buf, nbyte);
+      if (n < 0)
+        {
+          return __semihosting_error (-1);
+        }
+
+      pfd->pos += n;
+      return n;
+    }
+#endif /* defined(OS_INCLUDE_SEMIHOSTING_BUFFERS) */
+
   int block[3];
   block[0] = pfd->handle;
   block[1] = (int) buf;
@@ -450,6 +542,33 @@ __posix_write (int fildes, const void* buf, size_t nbyte)
       return -1;
     }
 
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+  os::semihosting::buffer* pbuf = __semihosting_findbuffer (fildes);
+  if (pbuf != nullptr)
+    {
+      if (pbuf->unread () > 0)
+        {
+          // Move the host position back over the bytes read ahead.
+          if (__semihosting_lseek (fildes, 0, SEEK_CUR) < 0)
+            {
+              return -1;
+            }
+        }
+
+      // Keep the order of the output sent to the same terminal.
+      os::semihosting::buffer::flush_all (false, pbuf);
+
+      ssize_t n = pbuf->write (buf, nbyte);
+      if (n < 0)
+        {
+          return __semihosting_error (-1);
+        }
+
+      pfd->pos += n;
+      return n;
+    }
+#endif /* defined(OS_INCLUDE_SEMIHOSTING_BUFFERS) */
+
   int block[3];
 
   block[0] = pfd->handle;
@@ -931,6 +1050,13 @@ __posix_writev (int fildes, const struct iovec* iov, int iovcnt)
   return -1;
 }
 
+ssize_t
+__posix_sendfile (int out_fd, int in_fd, off_t* offset, size_t count)
+{
+  errno = ENOSYS; // Not implemented
+  return -1;
+}
+
 int
 __posix_ioctl (int fildes, int request, ...)
 {
@@ -959,6 +1085,21 @@ __posix_fsync (int fildes)
   return -1;
 }
 
+void*
+__posix_mmap (void* addr, size_t len, int prot, int flags, int fildes,
+              off_t off)
+{
+  errno = ENOSYS; // Not implemented
+  return MAP_FAILED;
+}
+
+int
+__posix_munmap (void* addr, size_t len)
+{
+  errno = ENOSYS; // Not implemented
+  return -1;
+}
+
 int
 __posix_chmod (const char* path, mode_t mode)
 {
@@ -1073,6 +1214,10 @@ os_terminate (int code __attribute__((unused)))
    signum, so that the SWI handler can distinguish the two calls.
    Note: The RDI implementation of _kill throws away both its
    arguments.  */
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+  os::semihosting::buffer::flush_all ();
+#endif /* defined(OS_INCLUDE_SEMIHOSTING_BUFFERS) */
+
   report_exception (
       code == 0 ? ADP_Stopped_ApplicationExit : ADP_Stopped_RunTimeError);
   /* NOTREACHED */
@@ -1238,6 +1383,12 @@ initialise_monitor_handles (void)
   openfiles[1].pos = 0;
   openfiles[2].handle = monitor_stderr;
   openfiles[2].pos = 0;
+
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+  buffers[0].bind (monitor_stdin);
+  buffers[1].bind (monitor_stdout);
+  buffers[2].bind (monitor_stderr);
+#endif /* defined(OS_INCLUDE_SEMIHOSTING_BUFFERS) */
 }
 
 // ----------------------------------------------------------------------------
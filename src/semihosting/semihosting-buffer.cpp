@@ -0,0 +1,637 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/os-app-config.h>
+
+#if defined(OS_INCLUDE_SEMIHOSTING_BUFFERS)
+
+#include <cmsis-plus/arm/semihosting-buffer.h>
+#include <cmsis-plus/arm/semihosting.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+
+extern os::rtos::thread* os_idle_thread;
+
+// ----------------------------------------------------------------------------
+
+namespace os
+{
+  namespace semihosting
+  {
+    // ------------------------------------------------------------------------
+
+    /**
+     * @cond ignore
+     */
+
+    buffer* buffer::list__;
+
+    /**
+     * @endcond
+     */
+
+    // ------------------------------------------------------------------------
+
+    /**
+     * @class buffer
+     * @details
+     * The buffers are usually statically allocated, and are
+     * constructed before the static constructors run, so they can
+     * be used very early during startup.
+     *
+     * @par Example
+     *
+     * @code{.cpp}
+     * static char storage[OS_INTEGER_SEMIHOSTING_BUFFER_SIZE];
+     * static os::semihosting::buffer out
+     *   { storage, sizeof(storage) };
+     *
+     * out.bind (handle);
+     * out.write ("abc", 3);
+     * out.flush ();
+     * @endcode
+     */
+
+    /**
+     * @details
+     * On the first call, the buffer is added to the list of buffers
+     * written by `flush_all()`.
+     */
+    void
+    buffer::bind (int handle)
+    {
+      if (!internal_acquire_ (true))
+        {
+          // Used by another context, and cannot wait.
+          assert (false);
+          return;
+        }
+
+      internal_flush_ ();
+
+        {
+          // ----- Enter critical section -------------------------------------
+          rtos::interrupts::critical_section ics;
+
+          length_ = 0;
+          position_ = 0;
+          is_input_ = false;
+          has_error_ = false;
+          handle_ = handle;
+
+          if (!is_listed_)
+            {
+              next_ = list__;
+              list__ = this;
+              is_listed_ = true;
+            }
+          // ----- Exit critical section --------------------------------------
+        }
+
+      internal_release_ ();
+    }
+
+    /**
+     * @details
+     * Writes larger than the buffer are passed directly to the
+     * host, after the buffered bytes (except for the debug channel,
+     * which needs the terminator, and is always written from the
+     * buffer).
+     *
+     * If the buffer is full while another context writes it to the
+     * host, the threads wait; the interrupt handlers and the idle
+     * thread cannot wait, and the bytes which do not fit are
+     * dropped, with `EWOULDBLOCK`.
+     */
+    ssize_t
+    buffer::write (const void* buf, std::size_t nbyte)
+    {
+      if (handle_ == no_handle)
+        {
+          errno = EBADF;
+          return -1;
+        }
+
+      if (nbyte == 0)
+        {
+          return 0;
+        }
+
+        {
+          // ----- Enter critical section -------------------------------------
+          rtos::interrupts::critical_section ics;
+
+          if (has_error_)
+            {
+              // Report the error of a previous flush.
+              has_error_ = false;
+              errno = EIO;
+              return -1;
+            }
+          // ----- Exit critical section --------------------------------------
+        }
+
+      // The debug channel needs one more byte for the terminator.
+      std::size_t capacity =
+          (handle_ == debug_channel) ? (size_ - 1) : size_;
+      const char* cbuf = static_cast<const char*> (buf);
+
+      if (handle_ != debug_channel && nbyte >= capacity)
+        {
+          if (!internal_acquire_ (true))
+            {
+              errno = EWOULDBLOCK;
+              return -1;
+            }
+
+          ssize_t res = internal_flush_ ();
+          if (res == 0)
+            {
+              res = internal_call_ (SEMIHOSTING_SYS_WRITE,
+                                    const_cast<char*> (cbuf), nbyte);
+            }
+
+          internal_release_ ();
+          return res;
+        }
+
+      rtos::clock::timestamp_t now = rtos::sysclock.now ();
+      bool newline = flush_on_newline_
+          && (std::memchr (buf, '\n', nbyte) != nullptr);
+
+      std::size_t count = 0;
+      while (true)
+        {
+          bool owner = false;
+            {
+              // ----- Enter critical section ---------------------------------
+              rtos::interrupts::critical_section ics;
+
+              if (is_input_ && !busy_)
+                {
+                  // The owner moved the host position back.
+                  length_ = 0;
+                  position_ = 0;
+                  is_input_ = false;
+                }
+
+              if (!is_input_)
+                {
+                  if (length_ == sending_)
+                    {
+                      since_ = now;
+                    }
+
+                  // Append after the bytes being sent, if any.
+                  std::size_t n =
+                      (length_ < capacity) ? (capacity - length_) : 0;
+                  if (n > nbyte - count)
+                    {
+                      n = nbyte - count;
+                    }
+                  std::memcpy (storage_ + length_, cbuf + count, n);
+                  length_ += n;
+                  count += n;
+                }
+
+              if (count == nbyte && !newline && !internal_is_expired_ (now))
+                {
+                  return static_cast<ssize_t> (nbyte);
+                }
+
+              if (!busy_)
+                {
+                  busy_ = true;
+                  internal_detach_ ();
+                  owner = true;
+                }
+              else if (count == nbyte)
+                {
+                  // They will be sent after the current transfer.
+                  return static_cast<ssize_t> (nbyte);
+                }
+              // ----- Exit critical section ----------------------------------
+            }
+
+          if (owner)
+            {
+              // With interrupts enabled; the other contexts append
+              // after the detached bytes.
+              int res = internal_send_ ();
+
+                {
+                  // ----- Enter critical section -----------------------------
+                  rtos::interrupts::critical_section ics;
+
+                  internal_complete_ ();
+                  busy_ = false;
+                  // ----- Exit critical section ------------------------------
+                }
+
+              if (res < 0)
+                {
+                  return -1;
+                }
+              if (count == nbyte)
+                {
+                  return static_cast<ssize_t> (nbyte);
+                }
+              newline = false;
+              continue;
+            }
+
+          // The buffer is full, and another context sends it.
+          if (!internal_can_wait_ ())
+            {
+              errno = EWOULDBLOCK;
+              return (count > 0) ? static_cast<ssize_t> (count) : -1;
+            }
+          rtos::sysclock.sleep_for (1);
+        }
+    }
+
+    /**
+     * @details
+     * If the buffer is empty, one `SYS_READ` fills it, and the
+     * bytes are returned by this and the following calls. Requests
+     * larger than the buffer are passed directly to the host.
+     *
+     * Less bytes than requested may be returned, as for terminals.
+     */
+    ssize_t
+    buffer::read (void* buf, std::size_t nbyte)
+    {
+      if (handle_ < 0)
+        {
+          errno = EBADF;
+          return -1;
+        }
+
+      if (nbyte == 0)
+        {
+          return 0;
+        }
+
+      // Display the prompts before waiting for input.
+      flush_all ();
+
+      if (!internal_acquire_ (true))
+        {
+          errno = EWOULDBLOCK;
+          return -1;
+        }
+
+      // The other contexts do not use the buffer while it is owned,
+      // and the host is called with interrupts enabled.
+      while (!is_input_)
+        {
+          if (internal_flush_ () < 0)
+            {
+              // ----- Enter critical section ---------------------------------
+              rtos::interrupts::critical_section ics;
+
+              has_error_ = true;
+              // ----- Exit critical section ----------------------------------
+            }
+
+          // ----- Enter critical section -------------------------------------
+          rtos::interrupts::critical_section ics;
+
+          if (length_ == 0)
+            {
+              position_ = 0;
+              is_input_ = true;
+            }
+          // ----- Exit critical section --------------------------------------
+        }
+
+      ssize_t res;
+      if (position_ == length_)
+        {
+          position_ = 0;
+          length_ = 0;
+
+          if (nbyte >= size_)
+            {
+              res = internal_call_ (SEMIHOSTING_SYS_READ, buf, nbyte);
+              internal_release_ ();
+              return res;
+            }
+
+          res = internal_call_ (SEMIHOSTING_SYS_READ, storage_, size_);
+          if (res <= 0)
+            {
+              internal_release_ ();
+              return res;
+            }
+          length_ = static_cast<std::size_t> (res);
+        }
+
+      std::size_t n = length_ - position_;
+      if (n > nbyte)
+        {
+          n = nbyte;
+        }
+      std::memcpy (buf, storage_ + position_, n);
+      position_ += n;
+
+      internal_release_ ();
+      return static_cast<ssize_t> (n);
+    }
+
+    int
+    buffer::flush (void)
+    {
+      if (!internal_acquire_ (true))
+        {
+          errno = EWOULDBLOCK;
+          return -1;
+        }
+
+      int res = internal_flush_ ();
+
+      internal_release_ ();
+
+      // ----- Enter critical section -----------------------------------------
+      rtos::interrupts::critical_section ics;
+
+      if (has_error_)
+        {
+          has_error_ = false;
+          errno = EIO;
+          res = -1;
+        }
+      return res;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    void
+    buffer::discard (void)
+    {
+      if (!internal_acquire_ (true))
+        {
+          return;
+        }
+
+      if (is_input_)
+        {
+          length_ = 0;
+          position_ = 0;
+        }
+
+      internal_release_ ();
+    }
+
+    /**
+     * @details
+     * The errors are remembered, and reported by the next
+     * `write()` or `flush()` of each buffer.
+     *
+     * With `expired_only`, the buffers used by other contexts
+     * are skipped, so the idle thread never waits.
+     */
+    void
+    buffer::flush_all (bool expired_only, buffer* except)
+    {
+      rtos::clock::timestamp_t now = 0;
+      if (expired_only)
+        {
+          now = rtos::sysclock.now ();
+        }
+
+      for (buffer* p = list__; p != nullptr; p = p->next_)
+        {
+          if (p == except)
+            {
+              continue;
+            }
+          if (!p->internal_acquire_ (!expired_only))
+            {
+              continue;
+            }
+
+          if (!expired_only || p->internal_is_expired_ (now))
+            {
+              if (p->internal_flush_ () < 0)
+                {
+                  // ----- Enter critical section -----------------------------
+                  rtos::interrupts::critical_section ics;
+
+                  p->has_error_ = true;
+                  // ----- Exit critical section ------------------------------
+                }
+            }
+
+          p->internal_release_ ();
+        }
+    }
+
+    /**
+     * @cond ignore
+     */
+
+    /*
+     * Become the only context which passes the buffer to the host.
+     * If it is used by another context, wait, if allowed and
+     * possible. Return true if acquired.
+     */
+    bool
+    buffer::internal_acquire_ (bool wait)
+    {
+      while (true)
+        {
+            {
+              // ----- Enter critical section ---------------------------------
+              rtos::interrupts::critical_section ics;
+
+              if (!busy_)
+                {
+                  busy_ = true;
+                  return true;
+                }
+              // ----- Exit critical section ----------------------------------
+            }
+
+          if (!wait || !internal_can_wait_ ())
+            {
+              return false;
+            }
+          rtos::sysclock.sleep_for (1);
+        }
+    }
+
+    void
+    buffer::internal_release_ (void)
+    {
+      // ----- Enter critical section -----------------------------------------
+      rtos::interrupts::critical_section ics;
+
+      busy_ = false;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /*
+     * Write the buffered output to the host, with interrupts
+     * enabled. Called by the owner.
+     */
+    int
+    buffer::internal_flush_ (void)
+    {
+        {
+          // ----- Enter critical section -------------------------------------
+          rtos::interrupts::critical_section ics;
+
+          if (is_input_ || handle_ == no_handle || internal_detach_ () == 0)
+            {
+              return 0;
+            }
+          // ----- Exit critical section --------------------------------------
+        }
+
+      int res = internal_send_ ();
+
+      // ----- Enter critical section -----------------------------------------
+      rtos::interrupts::critical_section ics;
+
+      internal_complete_ ();
+      return res;
+      // ----- Exit critical section ------------------------------------------
+    }
+
+    /*
+     * Reserve the buffered bytes for the host transfer; the new
+     * bytes are appended after them. Called by the owner, in a
+     * critical section. Return the number of bytes reserved.
+     */
+    std::size_t
+    buffer::internal_detach_ (void)
+    {
+      sending_ = length_;
+      if (handle_ == debug_channel && length_ > 0)
+        {
+          storage_[length_] = '\0';
+          ++length_;
+          sending_ = length_;
+        }
+      return sending_;
+    }
+
+    int
+    buffer::internal_send_ (void)
+    {
+      if (sending_ == 0)
+        {
+          return 0;
+        }
+
+      if (handle_ == debug_channel)
+        {
+          call_host (SEMIHOSTING_SYS_WRITE0, storage_);
+          return 0;
+        }
+
+      if (internal_call_ (SEMIHOSTING_SYS_WRITE, storage_, sending_)
+          != static_cast<ssize_t> (sending_))
+        {
+          errno = EIO;
+          return -1;
+        }
+      return 0;
+    }
+
+    /*
+     * Drop the bytes sent and move the new ones to the beginning.
+     * Called by the owner, in a critical section.
+     */
+    void
+    buffer::internal_complete_ (void)
+    {
+      if (length_ > sending_)
+        {
+          std::memmove (storage_, storage_ + sending_, length_ - sending_);
+        }
+      length_ -= sending_;
+      sending_ = 0;
+    }
+
+    ssize_t
+    buffer::internal_call_ (int reason, void* buf, std::size_t nbyte)
+    {
+      // The parameters are words on the target, and pointer
+      // size on the host stand-in.
+      std::intptr_t block[3];
+      block[0] = handle_;
+      block[1] = reinterpret_cast<std::intptr_t> (buf);
+      block[2] = static_cast<std::intptr_t> (nbyte);
+
+      // Returns the number of bytes *not* transferred.
+      int res = call_host (reason, block);
+      if (res < 0 || static_cast<std::size_t> (res) > nbyte)
+        {
+          // -1 is not a legal value, but SEGGER seems to return it.
+          errno = EIO;
+          return -1;
+        }
+
+      return static_cast<ssize_t> (nbyte - static_cast<std::size_t> (res));
+    }
+
+    bool
+    buffer::internal_is_expired_ (rtos::clock::timestamp_t now) const
+    {
+      return (length_ > sending_) && !is_input_
+          && ((now - since_) >= OS_INTEGER_SEMIHOSTING_FLUSH_TICKS);
+    }
+
+    /*
+     * The threads may wait for the buffer, except the idle thread,
+     * which must always be ready.
+     */
+    bool
+    buffer::internal_can_wait_ (void)
+    {
+      return !rtos::interrupts::in_handler_mode ()
+          && rtos::scheduler::started () && !rtos::scheduler::locked ()
+          && (&rtos::this_thread::thread () != os_idle_thread);
+    }
+
+    /**
+     * @endcond
+     */
+
+  // --------------------------------------------------------------------------
+  } /* namespace semihosting */
+} /* namespace os */
+
+#endif /* defined(OS_INCLUDE_SEMIHOSTING_BUFFERS) */
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,301 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if !defined(__ARM_EABI__)
+
+// ----------------------------------------------------------------------------
+
+#include <cmsis-plus/arm/semihosting.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ----------------------------------------------------------------------------
+
+// A stand-in for the debugger, which services the semihosting
+// operations with the POSIX calls of the host, so that the code using
+// semihosting can be tested and benchmarked on Linux or macOS,
+// without a probe.
+//
+// The special ":tt" file is mapped to the standard input/output/error
+// of the process, and the debug channel (SYS_WRITEC/SYS_WRITE0) to the
+// standard output. The operations are counted, and each one can be
+// made to last a given number of microseconds, to model the round
+// trip through the debugger (usually from tens of microseconds
+// to milliseconds).
+
+unsigned long os_semihosting_host_calls;
+unsigned long os_semihosting_host_call_us;
+
+namespace
+{
+  int host_errno;
+
+  struct timespec start_time;
+
+  unsigned long
+  elapsed_us (const struct timespec& since)
+  {
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return static_cast<unsigned long> ((now.tv_sec - since.tv_sec) * 1000000L
+        + (now.tv_nsec - since.tv_nsec) / 1000L);
+  }
+
+  int
+  check (int res)
+  {
+    if (res < 0)
+      {
+        host_errno = errno;
+        return -1;
+      }
+    return res;
+  }
+
+  // Copy a name with explicit length into a null terminated string.
+  const char*
+  name (std::intptr_t ptr, std::intptr_t len, char* buf, std::size_t size)
+  {
+    std::size_t n = static_cast<std::size_t> (len);
+    if (n >= size)
+      {
+        n = size - 1;
+      }
+    std::memcpy (buf, reinterpret_cast<const char*> (ptr), n);
+    buf[n] = '\0';
+    return buf;
+  }
+
+  int
+  host_open (std::intptr_t* block)
+  {
+    char path[256];
+    name (block[0], block[2], path, sizeof(path));
+    int mode = static_cast<int> (block[1]);
+
+    if (std::strcmp (path, ":tt") == 0)
+      {
+        // "r", "w" and "a" select stdin, stdout and stderr.
+        return (mode < 4) ? STDIN_FILENO :
+               ((mode < 8) ? STDOUT_FILENO : STDERR_FILENO);
+      }
+
+    // The modes are the fopen() ones: r, rb, r+, r+b, w, wb, ... a+b.
+    bool plus = ((mode & 2) != 0);
+    int oflag;
+    switch (mode >> 2)
+      {
+      case 0:
+        oflag = plus ? O_RDWR : O_RDONLY;
+        break;
+      case 1:
+        oflag = (plus ? O_RDWR : O_WRONLY) | O_CREAT | O_TRUNC;
+        break;
+      default:
+        oflag = (plus ? O_RDWR : O_WRONLY) | O_CREAT | O_APPEND;
+        break;
+      }
+    return check (::open (path, oflag, 0644));
+  }
+
+  int
+  host_write (int fd, const char* buf, std::size_t nbyte)
+  {
+    std::size_t done = 0;
+    while (done < nbyte)
+      {
+        ssize_t n = ::write (fd, buf + done, nbyte - done);
+        if (n <= 0)
+          {
+            host_errno = errno;
+            break;
+          }
+        done += static_cast<std::size_t> (n);
+      }
+    // Return the number of bytes *not* written.
+    return static_cast<int> (nbyte - done);
+  }
+
+} /* namespace */
+
+// ----------------------------------------------------------------------------
+
+int
+__attribute__((weak))
+call_host (int reason, void* arg)
+{
+  ++os_semihosting_host_calls;
+
+  if (start_time.tv_sec == 0 && start_time.tv_nsec == 0)
+    {
+      clock_gettime (CLOCK_MONOTONIC, &start_time);
+    }
+
+  if (os_semihosting_host_call_us != 0)
+    {
+      // Model the round trip through the debugger.
+      struct timespec begin;
+      clock_gettime (CLOCK_MONOTONIC, &begin);
+      while (elapsed_us (begin) < os_semihosting_host_call_us)
+        {
+          ;
+        }
+    }
+
+  std::intptr_t* block = static_cast<std::intptr_t*> (arg);
+  char buf[256];
+
+  switch (reason)
+    {
+    case SEMIHOSTING_SYS_OPEN:
+      return host_open (block);
+
+    case SEMIHOSTING_SYS_CLOSE:
+      if (block[0] <= STDERR_FILENO)
+        {
+          return 0;
+        }
+      return check (::close (static_cast<int> (block[0])));
+
+    case SEMIHOSTING_SYS_WRITEC:
+      return host_write (STDOUT_FILENO, static_cast<const char*> (arg), 1);
+
+    case SEMIHOSTING_SYS_WRITE0:
+      host_write (STDOUT_FILENO, static_cast<const char*> (arg),
+                  std::strlen (static_cast<const char*> (arg)));
+      return 0;
+
+    case SEMIHOSTING_SYS_WRITE:
+      return host_write (static_cast<int> (block[0]),
+                         reinterpret_cast<const char*> (block[1]),
+                         static_cast<std::size_t> (block[2]));
+
+    case SEMIHOSTING_SYS_READ:
+      {
+        ssize_t n = ::read (static_cast<int> (block[0]),
+                            reinterpret_cast<void*> (block[1]),
+                            static_cast<std::size_t> (block[2]));
+        if (n < 0)
+          {
+            host_errno = errno;
+            return -1;
+          }
+        // Return the number of bytes *not* read.
+        return static_cast<int> (block[2] - n);
+      }
+
+    case SEMIHOSTING_SYS_READC:
+      {
+        unsigned char c;
+        if (::read (STDIN_FILENO, &c, 1) != 1)
+          {
+            host_errno = errno;
+            return -1;
+          }
+        return c;
+      }
+
+    case SEMIHOSTING_SYS_ISERROR:
+      return (block[0] < 0) ? 1 : 0;
+
+    case SEMIHOSTING_SYS_ISTTY:
+      {
+        int res = ::isatty (static_cast<int> (block[0]));
+        host_errno = errno;
+        return res;
+      }
+
+    case SEMIHOSTING_SYS_SEEK:
+      return (check (
+          static_cast<int> (::lseek (static_cast<int> (block[0]),
+                                     static_cast<off_t> (block[1]), SEEK_SET)))
+          < 0) ? -1 : 0;
+
+    case SEMIHOSTING_SYS_FLEN:
+      {
+        struct stat st;
+        if (check (::fstat (static_cast<int> (block[0]), &st)) < 0)
+          {
+            return -1;
+          }
+        return static_cast<int> (st.st_size);
+      }
+
+    case SEMIHOSTING_SYS_REMOVE:
+      return check (::unlink (name (block[0], block[1], buf, sizeof(buf))));
+
+    case SEMIHOSTING_SYS_RENAME:
+      {
+        char to[256];
+        return check (
+            std::rename (name (block[0], block[1], buf, sizeof(buf)),
+                      name (block[2], block[3], to, sizeof(to))));
+      }
+
+    case SEMIHOSTING_SYS_CLOCK:
+      // Centiseconds since the first operation.
+      return static_cast<int> (elapsed_us (start_time) / 10000);
+
+    case SEMIHOSTING_SYS_TIME:
+      return static_cast<int> (std::time (nullptr));
+
+    case SEMIHOSTING_SYS_SYSTEM:
+      return std::system (name (block[0], block[1], buf, sizeof(buf)));
+
+    case SEMIHOSTING_SYS_ERRNO:
+      return host_errno;
+
+    case SEMIHOSTING_SYS_GET_CMDLINE:
+      // The block is {char* buffer, int size}; return an empty line.
+      *reinterpret_cast<char*> (block[0]) = '\0';
+      return 0;
+
+    case SEMIHOSTING_ReportException:
+      std::exit (
+          (reinterpret_cast<std::intptr_t> (arg) == ADP_Stopped_ApplicationExit) ?
+              0 : 1);
+
+    default:
+      host_errno = ENOSYS;
+      return -1;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+#endif /* !defined(__ARM_EABI__) */
+
+// ----------------------------------------------------------------------------
@@ -33,6 +33,8 @@
 #include <cmsis-plus/memory/first-fit-top.h>
 #include <cmsis-plus/memory/lifo.h>
 #include <cmsis-plus/memory/block-pool.h>
+#include <cmsis-plus/memory/slab.h>
+#include <cmsis-plus/memory/alloc-profiler.h>
 #include <cmsis-plus/estd/memory_resource>
 
 // ----------------------------------------------------------------------------
@@ -271,6 +273,83 @@ os_startup_initialize_free_store (void* heap_address,
 
 #endif /* defined(OS_INTEGER_RTOS_ALLOC_TIMER_POOL_SIZE) */
 
+#if defined(OS_INTEGER_MEMORY_SLAB_BLOCKS)
+
+    {
+      static_assert(OS_INTEGER_MEMORY_SLAB_BLOCKS > 1,
+          "Slab blocks per class must be >1.");
+
+      // Size classes are powers of two, starting with the min size.
+      memory::slab::size_class classes[OS_INTEGER_MEMORY_SLAB_CLASSES];
+      for (std::size_t i = 0; i < OS_INTEGER_MEMORY_SLAB_CLASSES; ++i)
+        {
+          classes[i].block_size_bytes =
+          OS_INTEGER_MEMORY_SLAB_MIN_BLOCK_SIZE_BYTES << i;
+          classes[i].blocks = OS_INTEGER_MEMORY_SLAB_BLOCKS;
+        }
+
+      rtos::memory::memory_resource* upstream =
+          reinterpret_cast<rtos::memory::memory_resource*> (&application_free_store);
+
+      // Allocate the slab arena on the application free store.
+      std::size_t slab_bytes = memory::slab::arena_size (
+          classes, OS_INTEGER_MEMORY_SLAB_CLASSES);
+      void* slab_arena = upstream->allocate (slab_bytes);
+
+      // Allocate & construct the slab; larger requests go to the
+      // application free store.
+      rtos::memory::memory_resource* mr = new memory::slab
+        { "slab", classes, OS_INTEGER_MEMORY_SLAB_CLASSES, slab_arena,
+            slab_bytes, upstream };
+
+      // Small objects allocated via `operator new` and `malloc()`
+      // will use the slab, in constant time.
+      estd::pmr::set_default_resource (mr);
+    }
+
+#endif /* defined(OS_INTEGER_MEMORY_SLAB_BLOCKS) */
+
+#if defined(OS_USE_MEMORY_ALLOCATION_PROFILER)
+
+    {
+      rtos::memory::memory_resource* app = estd::pmr::get_default_resource ();
+      rtos::memory::memory_resource* sys =
+          rtos::memory::get_default_resource ();
+
+      // Allocate the tables on the application free store.
+      std::size_t prof_bytes = memory::alloc_profiler::arena_size (
+          OS_INTEGER_MEMORY_ALLOC_PROFILER_LIVE,
+          OS_INTEGER_MEMORY_ALLOC_PROFILER_SITES);
+
+      // Allocate & construct the profiler, decorating the
+      // application memory resource.
+      rtos::memory::memory_resource* mr = new memory::alloc_profiler
+        { "prof-app", app, OS_INTEGER_MEMORY_ALLOC_PROFILER_LIVE,
+        OS_INTEGER_MEMORY_ALLOC_PROFILER_SITES, app->allocate (prof_bytes),
+            prof_bytes };
+
+      // The out of memory condition is handled by the upstream resource.
+      estd::pmr::set_default_resource (mr);
+
+      if (sys == app)
+        {
+          // The RTOS uses the same memory resource, profile it too.
+          rtos::memory::set_default_resource (mr);
+        }
+      else
+        {
+          // The RTOS has its own memory resource, profile it separately.
+          mr = new memory::alloc_profiler
+            { "prof-sys", sys, OS_INTEGER_MEMORY_ALLOC_PROFILER_LIVE,
+            OS_INTEGER_MEMORY_ALLOC_PROFILER_SITES, app->allocate (
+                prof_bytes), prof_bytes };
+
+          rtos::memory::set_default_resource (mr);
+        }
+    }
+
+#endif /* defined(OS_USE_MEMORY_ALLOCATION_PROFILER) */
+
 #endif /* !defined(OS_EXCLUDE_DYNAMIC_MEMORY_ALLOCATIONS) */
 }
 
@@ -62,6 +62,29 @@
 // If OS_INCLUDE_STARTUP_INIT_MULTIPLE_RAM_SECTIONS is defined, the
 // code is capable of initialising multiple regions.
 //
+// If OS_INCLUDE_STARTUP_COMPRESSED_DATA is defined, the initialisation
+// values of each data region are an LZ4 block, which is decompressed
+// directly in the region. The ELF file must be processed after linking
+// with scripts/startup-compress-data.py.
+//
+// If OS_INCLUDE_STARTUP_DEFERRED_BSS is defined, the objects placed
+// in the `.bss_deferred` section (with OS_ATTRIBUTE_BSS_DEFERRED) are
+// not cleared here, but later, in small chunks, by the idle thread,
+// or by the application, with os_startup_initialize_bss_deferred().
+// The linker script must define the section, for example:
+//
+//  .bss_deferred (NOLOAD) : ALIGN(4)
+//  {
+//    __bss_deferred_start__ = .;
+//    *(.bss_deferred .bss_deferred.*)
+//    . = ALIGN(4);
+//    __bss_deferred_end__ = .;
+//  } >RAM
+//
+// If OS_INCLUDE_STARTUP_TIMESTAMPS is defined, the duration of each
+// startup phase is measured with the DWT cycle counter and stored
+// in os_startup_timestamps.
+//
 // The normal configuration is standalone, with all support
 // functions implemented locally.
 //
@@ -101,6 +124,16 @@ extern unsigned int __bss_regions_array_start;
 extern unsigned int __bss_regions_array_end;
 #endif
 
+#if defined(OS_INCLUDE_STARTUP_DEFERRED_BSS)
+// The region cleared after startup; defined in linker script.
+extern unsigned int __bss_deferred_start__;
+extern unsigned int __bss_deferred_end__;
+#endif /* defined(OS_INCLUDE_STARTUP_DEFERRED_BSS) */
+
+#if defined(OS_INCLUDE_STARTUP_TIMESTAMPS) && (__CORTEX_M < 3)
+#error "OS_INCLUDE_STARTUP_TIMESTAMPS requires the DWT cycle counter."
+#endif
+
 extern unsigned int _Heap_Begin;
 extern unsigned long int _Heap_Limit;
 extern unsigned long int __stack;
@@ -134,27 +167,120 @@ os_run_fini_array (void);
 
 // ----------------------------------------------------------------------------
 
+#if defined(OS_INCLUDE_STARTUP_COMPRESSED_DATA)
+
+// Decompress an LZ4 block (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md).
+// The block is trusted, it was generated from the application image;
+// the decompression ends when the region is full.
+inline __attribute__((always_inline))
+void
+os_initialize_data (unsigned int* from, unsigned int* region_begin,
+                    unsigned int* region_end)
+{
+  const uint8_t* src = (const uint8_t*) from;
+  uint8_t* dst = (uint8_t*) region_begin;
+  uint8_t* end = (uint8_t*) region_end;
+
+  while (dst < end)
+    {
+      unsigned int token = *src++;
+
+      // Copy the literals.
+      size_t length = token >> 4;
+      if (length == 15)
+        {
+          unsigned int b;
+          do
+            {
+              b = *src++;
+              length += b;
+            }
+          while (b == 255);
+        }
+      for (; length > 0; --length)
+        {
+          *dst++ = *src++;
+        }
+
+      if (dst >= end)
+        {
+          // The last sequence has only literals.
+          break;
+        }
+
+      // Copy the match, from the already decompressed bytes;
+      // it may overlap the destination.
+      size_t offset = (size_t) (src[0] | (src[1] << 8));
+      src += 2;
+      length = token & 0x0F;
+      if (length == 15)
+        {
+          unsigned int b;
+          do
+            {
+              b = *src++;
+              length += b;
+            }
+          while (b == 255);
+        }
+      length += 4;
+
+      const uint8_t* match = dst - offset;
+      for (; length > 0; --length)
+        {
+          *dst++ = *match++;
+        }
+    }
+}
+
+#else
+
 inline __attribute__((always_inline))
 void
 os_initialize_data (unsigned int* from, unsigned int* region_begin,
                     unsigned int* region_end)
 {
-  // Iterate and copy word by word.
+  // Iterate and copy four words at a time (the compiler
+  // uses LDM/STM), then the remaining words one by one.
   // It is assumed that the pointers are word aligned.
   unsigned int *p = region_begin;
+  while (p + 4 <= region_end)
+    {
+      unsigned int w0 = from[0];
+      unsigned int w1 = from[1];
+      unsigned int w2 = from[2];
+      unsigned int w3 = from[3];
+      p[0] = w0;
+      p[1] = w1;
+      p[2] = w2;
+      p[3] = w3;
+      p += 4;
+      from += 4;
+    }
   while (p < region_end)
     {
       *p++ = *from++;
     }
 }
 
+#endif /* defined(OS_INCLUDE_STARTUP_COMPRESSED_DATA) */
+
 inline __attribute__((always_inline))
 void
 os_initialize_bss (unsigned int* region_begin, unsigned int* region_end)
 {
-  // Iterate and clear word by word.
+  // Iterate and clear four words at a time, then the
+  // remaining words one by one.
   // It is assumed that the pointers are word aligned.
   unsigned int *p = region_begin;
+  while (p + 4 <= region_end)
+    {
+      p[0] = 0;
+      p[1] = 0;
+      p[2] = 0;
+      p[3] = 0;
+      p += 4;
+    }
   while (p < region_end)
     {
       *p++ = 0;
@@ -218,6 +344,88 @@ os_run_fini_array (void)
   //_fini(); // DO NOT ENABLE THIS!
 }
 
+#if defined(OS_INCLUDE_STARTUP_TIMESTAMPS)
+
+os_startup_timestamps_t os_startup_timestamps;
+
+uint32_t
+os_startup_timestamp (void)
+{
+  return DWT->CYCCNT;
+}
+
+#endif /* defined(OS_INCLUDE_STARTUP_TIMESTAMPS) */
+
+#if defined(OS_INCLUDE_STARTUP_DEFERRED_BSS)
+
+// The next word to clear; null until the .bss was cleared.
+static unsigned int* os_bss_deferred_next;
+
+/**
+ * @details
+ * The region is cleared in chunks of
+ * `OS_INTEGER_STARTUP_DEFERRED_BSS_CHUNK_BYTES`, each with the
+ * scheduler locked, so the function can be called concurrently
+ * by several threads; when it returns `true`, the region is
+ * completely cleared.
+ *
+ * To wait for the entire region, use `SIZE_MAX`.
+ */
+bool
+os_startup_initialize_bss_deferred (size_t max_bytes)
+{
+  while (true)
+    {
+      // ----- Enter critical section -----------------------------------------
+      os::rtos::scheduler::critical_section scs;
+
+      unsigned int* p = os_bss_deferred_next;
+      if (p == nullptr)
+        {
+          return false;
+        }
+      if (p >= &__bss_deferred_end__)
+        {
+          return true;
+        }
+      if (max_bytes == 0)
+        {
+          return false;
+        }
+
+      size_t words = OS_INTEGER_STARTUP_DEFERRED_BSS_CHUNK_BYTES
+          / sizeof(unsigned int);
+      if (words > max_bytes / sizeof(unsigned int))
+        {
+          words = max_bytes / sizeof(unsigned int);
+        }
+      if (words == 0)
+        {
+          words = 1;
+        }
+      if (words > (size_t) (&__bss_deferred_end__ - p))
+        {
+          words = (size_t) (&__bss_deferred_end__ - p);
+        }
+
+      os_initialize_bss (p, p + words);
+      os_bss_deferred_next = p + words;
+
+      size_t bytes = words * sizeof(unsigned int);
+      max_bytes = (bytes < max_bytes) ? (max_bytes - bytes) : 0;
+
+#if defined(OS_INCLUDE_STARTUP_TIMESTAMPS)
+      if (os_bss_deferred_next >= &__bss_deferred_end__)
+        {
+          os_startup_timestamps.bss_deferred = os_startup_timestamp ();
+        }
+#endif /* defined(OS_INCLUDE_STARTUP_TIMESTAMPS) */
+      // ----- Exit critical section ------------------------------------------
+    }
+}
+
+#endif /* defined(OS_INCLUDE_STARTUP_DEFERRED_BSS) */
+
 #if defined(DEBUG) && (OS_BOOL_STARTUP_GUARD_CHECKS)
 
 // These definitions are used to check if the routines used to
@@ -260,6 +468,15 @@ _start (void)
   // After Reset the Cortex-M processor is in Thread mode,
   // priority is Privileged, and the Stack is set to Main.
 
+#if defined(OS_INCLUDE_STARTUP_TIMESTAMPS)
+
+  // Start the cycle counter; all startup timestamps are relative to here.
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+#endif /* defined(OS_INCLUDE_STARTUP_TIMESTAMPS) */
+
   // --------------------------------------------------------------------------
 
   // Initialise hardware right after reset, to switch clock to higher
@@ -273,6 +490,11 @@ _start (void)
 
   os_startup_initialize_hardware_early ();
 
+#if defined(OS_INCLUDE_STARTUP_TIMESTAMPS)
+  // Kept on the stack until the .bss is cleared.
+  uint32_t hardware_early_timestamp = os_startup_timestamp ();
+#endif /* defined(OS_INCLUDE_STARTUP_TIMESTAMPS) */
+
   // Use Old Style DATA and BSS section initialisation,
   // that will manage a single BSS sections.
 
@@ -303,6 +525,10 @@ _start (void)
 
 #endif
 
+#if defined(OS_INCLUDE_STARTUP_TIMESTAMPS)
+  uint32_t data_timestamp = os_startup_timestamp ();
+#endif /* defined(OS_INCLUDE_STARTUP_TIMESTAMPS) */
+
 #if defined(DEBUG) && (OS_BOOL_STARTUP_GUARD_CHECKS)
 
   if ((__data_begin_guard != DATA_BEGIN_GUARD_VALUE)
@@ -353,6 +579,17 @@ _start (void)
 
 #endif
 
+#if defined(OS_INCLUDE_STARTUP_TIMESTAMPS)
+  os_startup_timestamps.hardware_early = hardware_early_timestamp;
+  os_startup_timestamps.data = data_timestamp;
+  os_startup_timestamps.bss = os_startup_timestamp ();
+#endif /* defined(OS_INCLUDE_STARTUP_TIMESTAMPS) */
+
+#if defined(OS_INCLUDE_STARTUP_DEFERRED_BSS)
+  // From now on the deferred region can be cleared.
+  os_bss_deferred_next = &__bss_deferred_start__;
+#endif /* defined(OS_INCLUDE_STARTUP_DEFERRED_BSS) */
+
   // Hook to continue the initialisations. Usually compute and store the
   // clock frequency in the global CMSIS variable, cleared above.
   os_startup_initialize_hardware ();
@@ -363,9 +600,17 @@ _start (void)
 
   trace_printf ("Hardware initialised.\n");
 
+#if defined(OS_INCLUDE_STARTUP_TIMESTAMPS)
+  os_startup_timestamps.hardware = os_startup_timestamp ();
+#endif /* defined(OS_INCLUDE_STARTUP_TIMESTAMPS) */
+
   os_startup_initialize_free_store (
       &_Heap_Begin, (size_t) ((char*) (&_Heap_Limit) - (char*) (&_Heap_Begin)));
 
+#if defined(OS_INCLUDE_STARTUP_TIMESTAMPS)
+  os_startup_timestamps.free_store = os_startup_timestamp ();
+#endif /* defined(OS_INCLUDE_STARTUP_TIMESTAMPS) */
+
   // Get the argc/argv (useful in semihosting configurations).
   int argc;
   char** argv;
@@ -375,10 +620,18 @@ _start (void)
   // execute the constructors for the static objects).
   os_run_init_array ();
 
+#if defined(OS_INCLUDE_STARTUP_TIMESTAMPS)
+  os_startup_timestamps.init_array = os_startup_timestamp ();
+#endif /* defined(OS_INCLUDE_STARTUP_TIMESTAMPS) */
+
 #if defined(OS_HAS_INTERRUPTS_STACK)
   os::rtos::interrupts::stack ()->set(&_Heap_Limit,  (size_t) ((char*) (&__stack) - (char*) (&_Heap_Limit)));
 #endif /* defined(OS_HAS_INTERRUPTS_STACK) */
 
+#if defined(OS_INCLUDE_STARTUP_TIMESTAMPS)
+  os_startup_timestamps.main = os_startup_timestamp ();
+#endif /* defined(OS_INCLUDE_STARTUP_TIMESTAMPS) */
+
   // Call the main entry point, and save the exit code.
   int code = main (argc, argv);
 
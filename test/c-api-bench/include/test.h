@@ -0,0 +1,73 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <stdint.h>
+
+#ifdef  __cplusplus
+extern "C"
+{
+#endif
+
+  /**
+   * @brief The measured primitives.
+   */
+  enum
+  {
+    bench_this_thread,
+    bench_mutex_lock_unlock,
+    bench_mutex_try_lock_unlock,
+    bench_semaphore_post_try_wait,
+    bench_semaphore_get_value,
+    bench_count
+  };
+
+  /**
+   * @brief Measure the primitives via the out of line C API.
+   * @param [in] iterations Number of calls of each primitive.
+   * @param [out] cycles Array of `bench_count` total durations,
+   *  in `hrclock` cycles.
+   */
+  void
+  bench_run_wrapper (uint32_t iterations, uint64_t* cycles);
+
+  /**
+   * @brief Measure the primitives via the inline C API.
+   * @param [in] iterations Number of calls of each primitive.
+   * @param [out] cycles Array of `bench_count` total durations,
+   *  in `hrclock` cycles.
+   */
+  void
+  bench_run_inline (uint32_t iterations, uint64_t* cycles);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* TEST_H_ */
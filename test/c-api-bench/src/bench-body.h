@@ -0,0 +1,97 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The benchmark body, included by both `bench-wrapper.c` and
+ * `bench-inline.c`, so the same code is compiled with the out of
+ * line and with the inline C API. `BENCH_RUN` is the name of
+ * the function to define.
+ */
+
+#include <test.h>
+
+// ----------------------------------------------------------------------------
+
+void
+BENCH_RUN (uint32_t iterations, uint64_t* cycles)
+{
+  os_clock_t* hrclock = os_clock_get_hrclock ();
+
+  os_mutex_t mx;
+  os_mutex_construct (&mx, "mx", NULL);
+
+  os_semaphore_t sm;
+  os_semaphore_construct (&sm, "sm", NULL);
+
+  os_clock_timestamp_t begin;
+  volatile uint32_t sink = 0;
+
+  begin = os_clock_now (hrclock);
+  for (uint32_t i = 0; i < iterations; ++i)
+    {
+      sink += (uint32_t) (uintptr_t) os_this_thread ();
+    }
+  cycles[bench_this_thread] = os_clock_now (hrclock) - begin;
+
+  begin = os_clock_now (hrclock);
+  for (uint32_t i = 0; i < iterations; ++i)
+    {
+      os_mutex_lock (&mx);
+      os_mutex_unlock (&mx);
+    }
+  cycles[bench_mutex_lock_unlock] = os_clock_now (hrclock) - begin;
+
+  begin = os_clock_now (hrclock);
+  for (uint32_t i = 0; i < iterations; ++i)
+    {
+      os_mutex_try_lock (&mx);
+      os_mutex_unlock (&mx);
+    }
+  cycles[bench_mutex_try_lock_unlock] = os_clock_now (hrclock) - begin;
+
+  begin = os_clock_now (hrclock);
+  for (uint32_t i = 0; i < iterations; ++i)
+    {
+      os_semaphore_post (&sm);
+      os_semaphore_try_wait (&sm);
+    }
+  cycles[bench_semaphore_post_try_wait] = os_clock_now (hrclock) - begin;
+
+  begin = os_clock_now (hrclock);
+  for (uint32_t i = 0; i < iterations; ++i)
+    {
+      sink += (uint32_t) os_semaphore_get_value (&sm);
+    }
+  cycles[bench_semaphore_get_value] = os_clock_now (hrclock) - begin;
+
+  (void) sink;
+
+  os_semaphore_destruct (&sm);
+  os_mutex_destruct (&mx);
+}
+
+// ----------------------------------------------------------------------------
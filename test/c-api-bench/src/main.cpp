@@ -0,0 +1,93 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/rtos/os.h>
+#include <cmsis-plus/diag/trace.h>
+
+#include <test.h>
+
+#include <stdio.h>
+
+using namespace os;
+
+// ----------------------------------------------------------------------------
+
+namespace
+{
+  constexpr uint32_t iterations = 10000;
+
+  const char* const names[bench_count] =
+    { "os_this_thread", "os_mutex_lock/unlock", "os_mutex_try_lock/unlock",
+        "os_semaphore_post/try_wait", "os_semaphore_get_value" };
+}
+
+/*
+ * Compare the per call duration of the hot C API primitives,
+ * via the out of line wrappers and via the inline C API.
+ * The durations are in `hrclock` cycles (CPU cycles on Cortex-M).
+ */
+int
+os_main (int argc __attribute__((unused)), char* argv[] __attribute__((unused)))
+{
+  printf ("\nC API inline benchmark.\n");
+#if defined(__clang__)
+  printf ("Built with clang " __VERSION__ ".\n");
+#else
+  printf ("Built with GCC " __VERSION__ ".\n");
+#endif
+
+  uint64_t wrapper[bench_count];
+  uint64_t inlined[bench_count];
+
+  // Warm up the caches, then measure.
+  bench_run_wrapper (iterations / 10, wrapper);
+  bench_run_inline (iterations / 10, inlined);
+
+  bench_run_wrapper (iterations, wrapper);
+  bench_run_inline (iterations, inlined);
+
+  printf ("\n%-28s %10s %10s %10s\n", "primitive", "wrapper", "inline",
+          "saved");
+  for (int i = 0; i < bench_count; ++i)
+    {
+      // Hundredths of cycles per iteration.
+      uint32_t w = static_cast<uint32_t> (wrapper[i] * 100 / iterations);
+      uint32_t n = static_cast<uint32_t> (inlined[i] * 100 / iterations);
+      uint32_t saved = (w >= n) ? (w - n) : (n - w);
+      printf ("%-28s %7lu.%02lu %7lu.%02lu %6c%lu.%02lu\n", names[i],
+              static_cast<unsigned long> (w / 100),
+              static_cast<unsigned long> (w % 100),
+              static_cast<unsigned long> (n / 100),
+              static_cast<unsigned long> (n % 100), (w >= n) ? ' ' : '-',
+              static_cast<unsigned long> (saved / 100),
+              static_cast<unsigned long> (saved % 100));
+    }
+
+  return 0;
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,311 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/posix-io/page-cache.h>
+#include <cmsis-plus/rtos/os.h>
+#include <cmsis-plus/diag/trace.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+using namespace os;
+
+// ----------------------------------------------------------------------------
+
+namespace
+{
+  constexpr std::size_t block_size = 512;
+  constexpr std::size_t blocks_count = 256;
+
+  /*
+   * RAM disk which counts the device calls.
+   */
+  class ram_disk : public posix::device_block
+  {
+  public:
+
+    ram_disk () :
+        device_block
+          { block_size, blocks_count }
+    {
+      std::memset (storage_, 0, sizeof(storage_));
+    }
+
+    char*
+    block (blknum_t blknum)
+    {
+      return storage_ + blknum * block_size;
+    }
+
+    std::size_t reads = 0;
+    std::size_t writes = 0;
+    std::size_t syncs = 0;
+    // When set, the writes fail with EIO.
+    bool failing = false;
+
+  protected:
+
+    virtual ssize_t
+    do_read_block (void* buf, blknum_t blknum, std::size_t nblocks) override
+    {
+      ++reads;
+      std::memcpy (buf, block (blknum), nblocks * block_size);
+      return static_cast<ssize_t> (nblocks);
+    }
+
+    virtual ssize_t
+    do_write_block (const void* buf, blknum_t blknum, std::size_t nblocks)
+        override
+    {
+      ++writes;
+      if (failing)
+        {
+          errno = EIO;
+          return -1;
+        }
+      std::memcpy (block (blknum), buf, nblocks * block_size);
+      return static_cast<ssize_t> (nblocks);
+    }
+
+    virtual int
+    do_sync (void) override
+    {
+      ++syncs;
+      return 0;
+    }
+
+  private:
+
+    char storage_[blocks_count * block_size];
+  };
+
+  ram_disk disk;
+
+  char buf[4 * block_size];
+
+  // --------------------------------------------------------------------------
+
+  void
+  test_write_behind (posix::page_cache& cache)
+  {
+    // 1000 small log records, in 16 bytes appends.
+    std::size_t writes = disk.writes;
+    off_t offset = 0;
+    for (int i = 0; i < 1000; ++i)
+      {
+        std::snprintf (buf, sizeof(buf), "record %7d\n", i);
+        ssize_t ret = cache.pwrite (&disk, buf, 16, offset);
+        assert(ret == 16);
+        offset += 16;
+
+        // The dirty pages remain bounded.
+        assert(cache.dirty () <= cache.pages () / 2);
+      }
+
+    assert(cache.sync (&disk) == 0);
+    assert(cache.dirty () == 0);
+    assert(disk.syncs == 1);
+
+    // 16000 bytes are 32 blocks; they reach the device
+    // in fewer device calls, not one per append.
+    std::printf ("1000 appends: %lu device writes, %lu blocks\n",
+                 static_cast<unsigned long> (disk.writes - writes),
+                 static_cast<unsigned long> (cache.counters ().written_blocks));
+    assert(disk.writes - writes <= 32);
+    assert(std::memcmp (disk.block (0), "record       0\n", 15) == 0);
+    assert(std::memcmp (disk.block (31) + 112, "record     999\n", 15) == 0);
+
+    // Read back through the cache.
+    assert(cache.pread (&disk, buf, 16, 999 * 16) == 16);
+    assert(std::memcmp (buf, "record     999\n", 15) == 0);
+
+    // Across block boundaries.
+    std::memset (buf, 'z', 1000);
+    assert(cache.pwrite (&disk, buf, 1000, 500) == 1000);
+    std::memset (buf, 0, 1004);
+    assert(cache.pread (&disk, buf, 1004, 496) == 1004);
+    assert(std::memcmp (buf, "reco", 4) == 0);
+    assert(buf[4] == 'z' && buf[1003] == 'z');
+    assert(cache.sync (&disk) == 0);
+    assert(disk.block (1)[0] == 'z' && disk.block (2)[475] == 'z');
+  }
+
+  void
+  test_read_ahead (posix::page_cache& cache)
+  {
+    assert(cache.invalidate (&disk) == 0);
+
+    for (std::size_t i = 0; i < blocks_count; ++i)
+      {
+        std::memset (disk.block (i), static_cast<int> (i), block_size);
+      }
+
+    std::size_t reads = disk.reads;
+    std::size_t misses = cache.counters ().misses;
+
+    // Sequential reads, in quarter blocks.
+    for (std::size_t i = 0; i < 64 * 4; ++i)
+      {
+        off_t offset = static_cast<off_t> (i * block_size / 4);
+        assert(cache.pread (&disk, buf, block_size / 4, offset)
+            == block_size / 4);
+        assert(buf[0] == static_cast<char> (i / 4));
+      }
+
+    std::printf ("64 sequential blocks: %lu device reads, %lu read ahead, "
+                 "%lu on demand\n",
+                 static_cast<unsigned long> (disk.reads - reads),
+                 static_cast<unsigned long> (cache.counters ().read_ahead),
+                 static_cast<unsigned long> (cache.counters ().misses - misses));
+    assert(cache.counters ().read_ahead > 0);
+    assert(disk.reads - reads < 64);
+
+    // Past the end.
+    off_t end = static_cast<off_t> (blocks_count * block_size);
+    assert(cache.pread (&disk, buf, 10, end) == 0);
+    assert(cache.pread (&disk, buf, 10, end - 4) == 4);
+    errno = 0;
+    assert(cache.pwrite (&disk, buf, 10, end) == -1 && errno == ENOSPC);
+  }
+
+  void
+  test_eviction (posix::page_cache& cache)
+  {
+    // Write more blocks than pages; all must reach the device.
+    for (std::size_t i = 0; i < blocks_count; ++i)
+      {
+        std::memset (buf, static_cast<int> (255 - i), block_size);
+        assert(cache.pwrite (&disk, buf, block_size,
+                             static_cast<off_t> (i * block_size))
+            == block_size);
+      }
+    assert(cache.sync (&disk) == 0);
+
+    for (std::size_t i = 0; i < blocks_count; ++i)
+      {
+        assert(disk.block (i)[block_size - 1] == static_cast<char> (255 - i));
+      }
+  }
+
+  void
+  test_write_error (posix::page_cache& cache)
+  {
+    assert(cache.invalidate (&disk) == 0);
+
+    // With the device failing, the writers must not wait forever
+    // for the flusher; once over the limit, they get the error.
+    disk.failing = true;
+    std::memset (buf, 'e', block_size);
+    ssize_t ret = 0;
+    std::size_t i;
+    for (i = 0; i < blocks_count; ++i)
+      {
+        errno = 0;
+        ret = cache.pwrite (&disk, buf, block_size,
+                            static_cast<off_t> (i * block_size));
+        if (ret != block_size)
+          {
+            break;
+          }
+      }
+    assert(ret == -1 && errno == EIO);
+    assert(i < cache.pages ());
+    assert(cache.dirty () > 0);
+
+    errno = 0;
+    assert(cache.sync (&disk) == -1 && errno == EIO);
+
+    // When the device recovers, the kept pages are written.
+    disk.failing = false;
+    assert(cache.sync (&disk) == 0);
+    assert(cache.dirty () == 0);
+    assert(disk.block (0)[0] == 'e');
+    assert(cache.pwrite (&disk, buf, block_size, 0) == block_size);
+  }
+
+  // --------------------------------------------------------------------------
+
+  void
+  bench_appends (posix::page_cache& cache, std::size_t size)
+  {
+    assert(cache.invalidate (&disk) == 0);
+
+    std::size_t writes = disk.writes;
+    std::size_t total = 64 * block_size;
+
+    rtos::clock::timestamp_t begin = rtos::hrclock.now ();
+    for (std::size_t n = 0; n < total; n += size)
+      {
+        cache.pwrite (&disk, buf, size, static_cast<off_t> (n));
+      }
+    cache.sync (&disk);
+    rtos::clock::timestamp_t end = rtos::hrclock.now ();
+
+    std::printf ("append %4lu: %8lu cycles per call, %lu device writes\n",
+                 static_cast<unsigned long> (size),
+                 static_cast<unsigned long> ((end - begin) / (total / size)),
+                 static_cast<unsigned long> (disk.writes - writes));
+  }
+}
+
+/*
+ * Functional tests for the page cache, using a RAM disk,
+ * followed by the duration of small appends, in `hrclock`
+ * cycles (CPU cycles on Cortex-M), including the final sync.
+ */
+int
+os_main (int argc __attribute__((unused)), char* argv[] __attribute__((unused)))
+{
+  std::printf ("\nPOSIX I/O page cache test.\n");
+
+  {
+    // The flusher must preempt this thread, to read ahead
+    // while it processes the data.
+    rtos::thread::attributes attr;
+    attr.th_priority = rtos::thread::priority::above_normal;
+
+    posix::page_cache cache
+      { "cache", 32, block_size, nullptr, attr };
+
+    test_write_behind (cache);
+    test_read_ahead (cache);
+    test_eviction (cache);
+    test_write_error (cache);
+
+    std::printf ("Functional tests passed.\n\n");
+
+    bench_appends (cache, 16);
+    bench_appends (cache, 128);
+    bench_appends (cache, block_size);
+  }
+
+  return 0;
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,257 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/posix-io/pbuf.h>
+#include <cmsis-plus/posix-io/net-interface.h>
+#include <cmsis-plus/rtos/os.h>
+#include <cmsis-plus/diag/trace.h>
+
+#include <cerrno>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+using namespace os;
+
+// ----------------------------------------------------------------------------
+
+namespace
+{
+  constexpr std::size_t buffers_count = 8;
+  constexpr std::size_t buffer_size = 128;
+  constexpr std::size_t headroom = 32;
+
+  posix::pbuf_pool pbufs
+    { "pbufs", buffers_count, buffer_size, headroom };
+
+  char buf[1024];
+
+  // --------------------------------------------------------------------------
+
+  void
+  test_alloc (void)
+  {
+    posix::pbuf* p = pbufs.alloc (50);
+    assert(p != nullptr && p->next () == nullptr);
+    assert(p->length () == 50 && p->headroom () == headroom);
+    assert(p->tailroom () == buffer_size - headroom - 50);
+    assert(p->ref_count () == 1);
+
+    // The first buffer keeps the headroom, the others are full.
+    posix::pbuf* q = pbufs.alloc (300);
+    assert(q != nullptr && q->total_length () == 300);
+    assert(q->length () == buffer_size - headroom);
+    assert(q->next ()->length () == buffer_size);
+    assert(q->next ()->next ()->length () == 300 - 96 - 128);
+    assert(q->next ()->next ()->next () == nullptr);
+    assert(pbufs.available () == buffers_count - 4);
+
+    // All or nothing.
+    errno = 0;
+    assert(pbufs.alloc (600) == nullptr && errno == ENOBUFS);
+    assert(pbufs.failures () == 1);
+    assert(pbufs.available () == buffers_count - 4);
+
+    p->release ();
+    q->release ();
+    assert(pbufs.available () == buffers_count);
+  }
+
+  void
+  test_headers (void)
+  {
+    posix::pbuf* p = pbufs.alloc (10);
+    assert(p->copy_from ("0123456789", 10) == 10);
+    const uint8_t* data = p->payload ();
+
+    // Add a header in front, without moving the data.
+    assert(p->push_header (8) == 0);
+    std::memcpy (p->payload (), "HEADER01", 8);
+    assert(p->payload () + 8 == data);
+    assert(p->length () == 18 && p->headroom () == headroom - 8);
+    assert(p->copy_to (buf, sizeof(buf)) == 18);
+    assert(std::memcmp (buf, "HEADER010123456789", 18) == 0);
+
+    errno = 0;
+    assert(p->push_header (headroom) == -1 && errno == ENOBUFS);
+
+    // Remove it.
+    assert(p->pull_header (8) == 0 && p->payload () == data);
+    errno = 0;
+    assert(p->pull_header (11) == -1 && errno == EINVAL);
+
+    // Grow at the end.
+    uint8_t* tail = p->put (4);
+    assert(tail == data + 10 && p->length () == 14);
+    errno = 0;
+    assert(p->put (buffer_size) == nullptr && errno == ENOBUFS);
+
+    p->release ();
+    assert(pbufs.available () == buffers_count);
+  }
+
+  void
+  test_chain (void)
+  {
+    posix::pbuf* a = pbufs.alloc (100);
+    posix::pbuf* b = pbufs.alloc (200);
+    a->chain (b);
+    assert(a->total_length () == 300);
+
+    for (std::size_t i = 0; i < 300; ++i)
+      {
+        buf[i] = static_cast<char> (i);
+      }
+    assert(a->copy_from (buf, 300) == 300);
+    std::memset (buf, 0, sizeof(buf));
+
+    // Across the buffer boundaries.
+    assert(a->copy_to (buf, 50, 90) == 50);
+    assert(buf[0] == 90 && buf[49] == static_cast<char> (139));
+    assert(a->copy_to (buf, sizeof(buf), 290) == 10);
+    assert(buf[9] == static_cast<char> (299));
+
+    // The chain holds the reference of b.
+    a->release ();
+    assert(pbufs.available () == buffers_count);
+  }
+
+  void
+  test_refs (void)
+  {
+    posix::pbuf* p = pbufs.alloc (300);
+    assert(p->ref () == p && p->ref_count () == 2);
+    p->release ();
+    assert(pbufs.available () == buffers_count - 3);
+    p->release ();
+    assert(pbufs.available () == buffers_count);
+
+    // A tail shared by two owners survives the head.
+    posix::pbuf* head = pbufs.alloc (10);
+    posix::pbuf* tail = pbufs.alloc (10);
+    head->chain (tail->ref ());
+    head->release ();
+    assert(pbufs.available () == buffers_count - 1);
+    assert(tail->ref_count () == 1);
+    tail->release ();
+    assert(pbufs.available () == buffers_count);
+  }
+
+  void
+  test_loopback (void)
+  {
+    posix::net_interface_loopback lo
+      { "lo", 4 };
+
+    posix::pbuf* sent[5];
+    for (int i = 0; i < 5; ++i)
+      {
+        sent[i] = pbufs.alloc (20);
+        assert(sent[i] != nullptr);
+        sent[i]->push_header (4);
+        std::memcpy (sent[i]->payload (), "HDR", 4);
+        sent[i]->payload ()[3] = static_cast<uint8_t> ('0' + i);
+      }
+
+    // The fifth does not fit in the rx ring and is dropped on receive.
+    for (int i = 0; i < 5; ++i)
+      {
+        assert(lo.output (sent[i]) == 0);
+      }
+    assert(lo.counters ().tx_packets == 5);
+    assert(lo.counters ().rx_packets == 4);
+    assert(lo.counters ().rx_dropped == 1);
+
+    // Received by reference, in order.
+    for (int i = 0; i < 4; ++i)
+      {
+        posix::pbuf* p = lo.rx_dequeue ();
+        assert(p == sent[i]);
+        assert(p->payload ()[3] == '0' + i);
+        assert(p->pull_header (4) == 0 && p->length () == 20);
+        p->release ();
+      }
+    assert(lo.rx_dequeue () == nullptr);
+    assert(pbufs.available () == buffers_count);
+
+    // The packets left in the rings are released with the interface.
+    assert(lo.output (pbufs.alloc (10)) == 0);
+  }
+
+  // --------------------------------------------------------------------------
+
+  void
+  bench_loopback (std::size_t packets)
+  {
+    posix::net_interface_loopback lo
+      { "lo", 4 };
+
+    rtos::clock::timestamp_t begin = rtos::hrclock.now ();
+    for (std::size_t n = 0; n < packets; ++n)
+      {
+        // Payload, then two headers, as the protocol layers would add.
+        posix::pbuf* p = pbufs.alloc (64);
+        p->push_header (20);
+        p->push_header (14);
+        lo.output (p);
+
+        p = lo.rx_dequeue ();
+        p->pull_header (14);
+        p->pull_header (20);
+        p->release ();
+      }
+    rtos::clock::timestamp_t end = rtos::hrclock.now ();
+
+    printf ("%-24s %10lu cycles, %8lu per packet\n", "loopback",
+            static_cast<unsigned long> (end - begin),
+            static_cast<unsigned long> ((end - begin) / packets));
+  }
+
+} /* namespace */
+
+// ----------------------------------------------------------------------------
+
+int
+os_main (int argc __attribute__((unused)), char* argv[] __attribute__((unused)))
+{
+  printf ("\nPOSIX I/O packet buffers test.\n");
+
+  test_alloc ();
+  test_headers ();
+  test_chain ();
+  test_refs ();
+  test_loopback ();
+  assert(pbufs.available () == buffers_count);
+
+  printf ("Functional tests passed.\n\n");
+
+  bench_loopback (10000);
+
+  return 0;
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,258 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/posix-io/socket-local.h>
+#include <cmsis-plus/posix-io/net-stack.h>
+#include <cmsis-plus/posix-io/file-descriptors-manager.h>
+#include <cmsis-plus/posix-io/pool.h>
+#include <cmsis-plus/rtos/os.h>
+#include <cmsis-plus/diag/trace.h>
+
+#include <cerrno>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+using namespace os;
+
+// ----------------------------------------------------------------------------
+
+namespace
+{
+  constexpr std::size_t sockets_count = 4;
+  constexpr std::size_t ring_size = OS_INTEGER_POSIX_IO_SOCKET_LOCAL_BUFFER_SIZE;
+
+  posix::pool_typed<posix::socket_local> sockets_pool
+    { sockets_count };
+
+  posix::net_stack ns
+    { &sockets_pool };
+
+  posix::file_descriptors_manager dm
+    { 8 };
+
+  char buf[ring_size + 16];
+
+  void
+  check_pool_free (void)
+  {
+    for (std::size_t i = 0; i < sockets_count; ++i)
+      {
+        assert(!sockets_pool.in_use (i));
+      }
+  }
+
+  // --------------------------------------------------------------------------
+
+  void
+  test_stream (void)
+  {
+    class posix::socket* sv[2];
+    assert(posix::socketpair (AF_LOCAL, SOCK_STREAM, 0, sv) == 0);
+    assert(sv[0]->file_descriptor () >= 0 && sv[1]->file_descriptor () >= 0);
+
+    // Both directions, with read()/write() and send()/recv().
+    assert(sv[0]->write ("hello", 5) == 5);
+    assert(sv[1]->send ("world", 5, 0) == 5);
+    assert(sv[1]->recv (buf, 2, MSG_PEEK) == 2);
+    assert(sv[1]->read (buf, sizeof(buf)) == 5);
+    assert(std::memcmp (buf, "hello", 5) == 0);
+    assert(sv[0]->recv (buf, sizeof(buf), 0) == 5);
+    assert(std::memcmp (buf, "world", 5) == 0);
+
+    // Nothing to read.
+    errno = 0;
+    assert(sv[1]->recv (buf, 1, MSG_DONTWAIT) == -1 && errno == EAGAIN);
+
+    // Fill the ring of the peer, across the end of the buffer.
+    assert(sv[0]->write ("abc", 3) == 3);
+    assert(sv[1]->read (buf, 1) == 1);
+    std::memset (buf, 'x', sizeof(buf));
+    assert(sv[0]->send (buf, sizeof(buf), MSG_DONTWAIT)
+        == static_cast<ssize_t> (ring_size - 2));
+    errno = 0;
+    assert(sv[0]->send (buf, 1, MSG_DONTWAIT) == -1 && errno == EAGAIN);
+    assert(sv[1]->read (buf, sizeof(buf)) == static_cast<ssize_t> (ring_size));
+    assert(buf[0] == 'b' && buf[1] == 'c' && buf[ring_size - 1] == 'x');
+
+    // After shutdown, the bytes left are read, then end of file.
+    assert(sv[0]->write ("end", 3) == 3);
+    assert(sv[0]->shutdown (SHUT_WR) == 0);
+    errno = 0;
+    assert(sv[0]->write ("x", 1) == -1 && errno == EPIPE);
+    assert(sv[1]->read (buf, sizeof(buf)) == 3);
+    assert(sv[1]->read (buf, sizeof(buf)) == 0);
+
+    // After close, the peer cannot send.
+    assert(sv[0]->close () == 0);
+    errno = 0;
+    assert(sv[1]->write ("x", 1) == -1 && errno == EPIPE);
+    assert(sv[1]->read (buf, sizeof(buf)) == 0);
+    assert(sv[1]->close () == 0);
+
+    check_pool_free ();
+  }
+
+  void
+  test_dgram (void)
+  {
+    class posix::socket* sv[2];
+    assert(posix::socketpair (AF_LOCAL, SOCK_DGRAM, 0, sv) == 0);
+
+    // Message boundaries are kept.
+    assert(sv[0]->send ("one", 3, 0) == 3);
+    assert(sv[0]->send ("three", 5, 0) == 5);
+    assert(sv[0]->send ("", 0, 0) == 0);
+    assert(sv[0]->send ("four", 4, 0) == 4);
+    assert(sv[1]->recv (buf, sizeof(buf), 0) == 3);
+    assert(std::memcmp (buf, "one", 3) == 0);
+    // Truncated, the rest is discarded.
+    assert(sv[1]->recv (buf, 2, 0) == 2);
+    assert(std::memcmp (buf, "th", 2) == 0);
+    assert(sv[1]->recv (buf, sizeof(buf), 0) == 0);
+    assert(sv[1]->recv (buf, sizeof(buf), MSG_PEEK) == 4);
+    assert(sv[1]->recv (buf, sizeof(buf), 0) == 4);
+    assert(std::memcmp (buf, "four", 4) == 0);
+
+    // Too large for the ring.
+    errno = 0;
+    assert(sv[0]->send (buf, ring_size, 0) == -1 && errno == EMSGSIZE);
+
+    // A message that does not fit is not split.
+    assert(sv[0]->send (buf, ring_size / 2, 0)
+        == static_cast<ssize_t> (ring_size / 2));
+    errno = 0;
+    assert(sv[0]->send (buf, ring_size / 2, MSG_DONTWAIT) == -1);
+    assert(errno == EAGAIN);
+
+    assert(sv[0]->close () == 0);
+    assert(sv[1]->recv (buf, sizeof(buf), 0)
+        == static_cast<ssize_t> (ring_size / 2));
+    assert(sv[1]->recv (buf, sizeof(buf), 0) == 0);
+    assert(sv[1]->close () == 0);
+
+    check_pool_free ();
+  }
+
+  void
+  test_errors (void)
+  {
+    class posix::socket* sv[2];
+
+    errno = 0;
+    assert(posix::socketpair (AF_UNSPEC, SOCK_STREAM, 0, sv) == -1);
+    assert(errno == EAFNOSUPPORT);
+    errno = 0;
+    assert(posix::socketpair (AF_LOCAL, 99, 0, sv) == -1);
+    assert(errno == EPROTOTYPE);
+    check_pool_free ();
+
+    // A single socket is not connected.
+    class posix::socket* s = posix::socket (AF_LOCAL, SOCK_STREAM, 0);
+    assert(s != nullptr);
+    errno = 0;
+    assert(s->send ("x", 1, 0) == -1 && errno == ENOTCONN);
+    errno = 0;
+    assert(s->recv (buf, 1, 0) == -1 && errno == ENOTCONN);
+    assert(s->close () == 0);
+
+    check_pool_free ();
+  }
+
+  // --------------------------------------------------------------------------
+
+  constexpr std::size_t bench_total = 64 * 1024;
+  constexpr std::size_t bench_chunk = 128;
+
+  void*
+  producer (void* args)
+  {
+    auto* s = static_cast<class posix::socket*> (args);
+    char chunk[bench_chunk];
+    std::memset (chunk, 'p', sizeof(chunk));
+    for (std::size_t n = 0; n < bench_total; n += sizeof(chunk))
+      {
+        ssize_t ret = s->write (chunk, sizeof(chunk));
+        assert(ret == static_cast<ssize_t> (sizeof(chunk)));
+      }
+    s->shutdown (SHUT_WR);
+    return nullptr;
+  }
+
+  void
+  bench_stream (void)
+  {
+    class posix::socket* sv[2];
+    assert(posix::socketpair (AF_LOCAL, SOCK_STREAM, 0, sv) == 0);
+
+    rtos::clock::timestamp_t begin = rtos::hrclock.now ();
+    std::size_t total = 0;
+      {
+        rtos::thread th
+          { "producer", producer, sv[0] };
+
+        ssize_t ret;
+        while ((ret = sv[1]->read (buf, bench_chunk)) > 0)
+          {
+            total += static_cast<std::size_t> (ret);
+          }
+        th.join ();
+      }
+    rtos::clock::timestamp_t end = rtos::hrclock.now ();
+    assert(total == bench_total);
+
+    printf ("%-24s %10lu cycles, %8lu per %u bytes\n", "stream transfer",
+            static_cast<unsigned long> (end - begin),
+            static_cast<unsigned long> ((end - begin) / (total / bench_chunk)),
+            static_cast<unsigned int> (bench_chunk));
+
+    assert(sv[0]->close () == 0);
+    assert(sv[1]->close () == 0);
+    check_pool_free ();
+  }
+
+} /* namespace */
+
+// ----------------------------------------------------------------------------
+
+int
+os_main (int argc __attribute__((unused)), char* argv[] __attribute__((unused)))
+{
+  printf ("\nPOSIX I/O local sockets test.\n");
+
+  test_stream ();
+  test_dgram ();
+  test_errors ();
+
+  printf ("Functional tests passed.\n\n");
+
+  bench_stream ();
+
+  return 0;
+}
+
+// ----------------------------------------------------------------------------
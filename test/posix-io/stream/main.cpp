@@ -0,0 +1,335 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/posix-io/stream.h>
+#include <cmsis-plus/posix-io/device-char.h>
+#include <cmsis-plus/rtos/os.h>
+#include <cmsis-plus/diag/trace.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+using namespace os;
+
+// ----------------------------------------------------------------------------
+
+namespace
+{
+  /*
+   * Character device which keeps the output in memory, serves
+   * the input from a string, and counts the calls.
+   */
+  class sink : public posix::device_char
+  {
+  public:
+
+    sink () :
+        device_char
+          { "sink" }
+    {
+      clear ();
+    }
+
+    void
+    clear (const char* input = "")
+    {
+      length = 0;
+      writes = 0;
+      reads = 0;
+      input_ = input;
+      std::memset (data, 0, sizeof(data));
+    }
+
+    char data[2048];
+    std::size_t length;
+    std::size_t writes;
+    std::size_t reads;
+
+  protected:
+
+    virtual int
+    do_vopen (const char* path __attribute__((unused)),
+              int oflag __attribute__((unused)),
+              std::va_list args __attribute__((unused))) override
+    {
+      return 0;
+    }
+
+    virtual ssize_t
+    do_write (const void* buf, std::size_t nbyte) override
+    {
+      ++writes;
+      if (nbyte > sizeof(data) - length)
+        {
+          // Keep only the counters.
+          length = 0;
+        }
+      std::memcpy (data + length, buf, nbyte);
+      length += nbyte;
+      return static_cast<ssize_t> (nbyte);
+    }
+
+    virtual ssize_t
+    do_read (void* buf, std::size_t nbyte) override
+    {
+      ++reads;
+      std::size_t n = std::strlen (input_);
+      if (n > nbyte)
+        {
+          n = nbyte;
+        }
+      std::memcpy (buf, input_, n);
+      input_ += n;
+      return static_cast<ssize_t> (n);
+    }
+
+    const char* input_;
+  };
+
+  sink dev;
+
+  // --------------------------------------------------------------------------
+
+  void
+  test_full (void)
+  {
+    dev.clear ();
+    posix::stream s
+      { &dev, posix::stream::buffering::full, 64 };
+
+    for (int i = 0; i < 10; ++i)
+      {
+        assert(s.write ("abcde", 5) == 5);
+      }
+    assert(dev.writes == 0);
+    assert(s.flush () == 0);
+    assert(dev.writes == 1 && dev.length == 50);
+
+    // Filling the buffer writes it.
+    for (int i = 0; i < 100; ++i)
+      {
+        assert(s.putc ('0' + i % 10) == '0' + i % 10);
+      }
+    assert(dev.writes == 2 && dev.length == 50 + 64);
+
+    // Larger than the buffer: the pending bytes, then the new ones.
+    char big[200];
+    std::memset (big, 'x', sizeof(big));
+    assert(s.write (big, sizeof(big)) == sizeof(big));
+    assert(dev.writes == 4 && dev.length == 50 + 100 + 200);
+    assert(std::memcmp (dev.data + 50 + 90, "0123456789xxx", 13) == 0);
+
+    // The rest is written by the destructor.
+    assert(s.puts ("end") == 0);
+  }
+
+  void
+  test_line (void)
+  {
+    dev.clear ();
+    {
+      posix::stream s
+        { &dev, posix::stream::buffering::line, 64 };
+
+      assert(s.puts ("abc") == 0);
+      assert(dev.writes == 0);
+      assert(s.putc ('\n') == '\n');
+      assert(dev.writes == 1 && std::strcmp (dev.data, "abc\n") == 0);
+
+      assert(s.printf ("x=%d", 5) == 3);
+      assert(dev.writes == 1);
+      assert(s.printf (", y=%s\n", "text") == 9);
+      assert(dev.writes == 2);
+      assert(std::strcmp (dev.data, "abc\nx=5, y=text\n") == 0);
+
+      // A printf() larger than the buffer.
+      assert(s.printf ("%100s", "right") == 100);
+      assert(dev.writes == 3 && dev.length == 116);
+      assert(std::memcmp (dev.data + 111, "right", 5) == 0);
+
+      // One which fits only in an empty buffer.
+      assert(s.printf ("%50s", "a") == 50);
+      assert(s.printf ("%50s", "b") == 50);
+      assert(dev.writes == 4 && dev.length == 166);
+
+      assert(s.puts ("tail") == 0);
+    }
+    assert(dev.writes == 5 && dev.length == 220);
+  }
+
+  void
+  test_none (void)
+  {
+    dev.clear ();
+    posix::stream s
+      { &dev, posix::stream::buffering::none };
+
+    assert(s.buffer_size_bytes () == 0);
+    s.putc ('a');
+    s.putc ('b');
+    assert(s.printf ("%d", 123) == 3);
+    assert(dev.writes == 3 && std::strcmp (dev.data, "ab123") == 0);
+
+    // Switch to a user buffer.
+    char buf[16];
+    assert(s.set_buffer (buf, sizeof(buf), posix::stream::buffering::full) == 0);
+    assert(s.mode () == posix::stream::buffering::full);
+    s.puts ("buffered");
+    assert(dev.writes == 3 && std::memcmp (buf, "buffered", 8) == 0);
+    assert(s.set_buffer (nullptr, 0, posix::stream::buffering::none) == 0);
+    assert(dev.writes == 4 && std::strcmp (dev.data, "ab123buffered") == 0);
+  }
+
+  void
+  test_read (void)
+  {
+    dev.clear ("first line\nsecond line\n");
+    posix::stream s
+      { &dev, posix::stream::buffering::full, 8 };
+
+    assert(s.getc () == 'f');
+    assert(dev.reads == 1);
+
+    char buf[32];
+    std::memset (buf, 0, sizeof(buf));
+    assert(s.read (buf, 9) == 9);
+    assert(std::strcmp (buf, "irst line") == 0);
+    assert(dev.reads == 2);
+
+    // Larger than the buffer: read directly.
+    std::memset (buf, 0, sizeof(buf));
+    assert(s.read (buf, sizeof(buf)) == 13);
+    assert(std::strcmp (buf, "\nsecond line\n") == 0);
+    assert(s.eof () && !s.error ());
+    assert(s.getc () == EOF);
+
+    s.clear_error ();
+    assert(!s.eof ());
+  }
+
+  void
+  test_lock (void)
+  {
+    dev.clear ();
+    posix::stream s
+      { &dev, posix::stream::buffering::line, 64 };
+
+    // The lock is recursive, the locked calls can be mixed in.
+    s.lock ();
+    s.puts_unlocked ("n=");
+    s.printf ("%d", 42);
+    s.putc_unlocked ('\n');
+    s.unlock ();
+    assert(std::strcmp (dev.data, "n=42\n") == 0);
+  }
+
+  // --------------------------------------------------------------------------
+
+  void
+  report (const char* name, rtos::clock::timestamp_t duration,
+          std::size_t lines)
+  {
+    printf ("%-24s %10lu cycles, %6lu per line, %5u writes\n", name,
+            static_cast<unsigned long> (duration),
+            static_cast<unsigned long> (duration / lines),
+            static_cast<unsigned int> (dev.writes));
+  }
+
+  // Log lines assembled from a few fragments, as the code
+  // which prints them usually does.
+  void
+  bench_log (std::size_t lines)
+  {
+    rtos::clock::timestamp_t begin;
+    char num[12];
+
+    dev.clear ();
+    begin = rtos::hrclock.now ();
+    for (std::size_t i = 0; i < lines; ++i)
+      {
+        dev.write ("[app] ", 6);
+        int n = snprintf (num, sizeof(num), "%u",
+                          static_cast<unsigned int> (i));
+        dev.write (num, static_cast<std::size_t> (n));
+        dev.write (" sample value\n", 14);
+      }
+    report ("io::write()", rtos::hrclock.now () - begin, lines);
+
+    posix::stream s
+      { &dev, posix::stream::buffering::full, 512 };
+
+    dev.clear ();
+    begin = rtos::hrclock.now ();
+    for (std::size_t i = 0; i < lines; ++i)
+      {
+        s.printf ("[app] %u sample value\n", static_cast<unsigned int> (i));
+      }
+    s.flush ();
+    report ("stream::printf()", rtos::hrclock.now () - begin, lines);
+
+    dev.clear ();
+    begin = rtos::hrclock.now ();
+    s.lock ();
+    for (std::size_t i = 0; i < lines; ++i)
+      {
+        s.puts_unlocked ("[app] ");
+        int n = snprintf (num, sizeof(num), "%u",
+                          static_cast<unsigned int> (i));
+        s.write_unlocked (num, static_cast<std::size_t> (n));
+        s.puts_unlocked (" sample value\n");
+      }
+    s.flush_unlocked ();
+    s.unlock ();
+    report ("stream::*_unlocked()", rtos::hrclock.now () - begin, lines);
+  }
+
+} /* namespace */
+
+// ----------------------------------------------------------------------------
+
+int
+os_main (int argc __attribute__((unused)), char* argv[] __attribute__((unused)))
+{
+  printf ("\nPOSIX I/O buffered streams test.\n");
+
+  test_full ();
+  assert(dev.writes == 5 && dev.length == 353);
+  test_line ();
+  test_none ();
+  test_read ();
+  test_lock ();
+
+  printf ("Functional tests passed.\n\n");
+
+  bench_log (1000);
+
+  return 0;
+}
+
+// ----------------------------------------------------------------------------
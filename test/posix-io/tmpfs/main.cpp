@@ -0,0 +1,529 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/posix-io/tmpfs.h>
+#include <cmsis-plus/posix-io/mount-manager.h>
+#include <cmsis-plus/posix-io/file-descriptors-manager.h>
+#include <cmsis-plus/posix-io/pool.h>
+#include <cmsis-plus/rtos/os.h>
+#include <cmsis-plus/diag/trace.h>
+
+#include <cerrno>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+using namespace os;
+
+// ----------------------------------------------------------------------------
+
+namespace
+{
+  constexpr std::size_t files_count = 4;
+  constexpr std::size_t dirs_count = 2;
+
+  posix::pool_typed<posix::tmpfs_file> files_pool
+    { files_count };
+  posix::pool_typed<posix::tmpfs_directory> dirs_pool
+    { dirs_count };
+
+  posix::tmpfs fs
+    { &files_pool, &dirs_pool };
+
+  posix::mount_manager mm
+    { 2 };
+
+  posix::file_descriptors_manager dm
+    { 8 };
+
+  char buf[1024];
+
+  // --------------------------------------------------------------------------
+
+  void
+  test_files (void)
+  {
+    int ret;
+
+    // Create, write, read back.
+    posix::io* io = posix::open ("/tmp/f1", O_CREAT | O_RDWR, 0644);
+    assert(io != nullptr);
+    auto* f = static_cast<posix::file*> (io);
+
+    for (std::size_t i = 0; i < sizeof(buf); ++i)
+      {
+        buf[i] = static_cast<char> (i);
+      }
+    for (int i = 0; i < 10; ++i)
+      {
+        // Odd sizes, to cross the extent boundaries.
+        ret = static_cast<int> (io->write (buf, 333));
+        assert(ret == 333);
+      }
+
+    struct stat st;
+    ret = io->fstat (&st);
+    assert(ret == 0 && st.st_size == 3330 && S_ISREG(st.st_mode));
+    assert(fs.used_bytes () == 3330);
+
+    assert(f->lseek (1000, SEEK_SET) == 1000);
+    ret = static_cast<int> (io->read (buf, 10));
+    assert(ret == 10);
+    // Offset 1000 is at 1000 % 333 = 1 in the source buffer.
+    assert(buf[0] == 1 && buf[9] == 10);
+
+    // Overwrite in the middle, then check the size did not change.
+    assert(f->lseek (60, SEEK_SET) == 60);
+    std::memset (buf, 'x', 200);
+    assert(io->write (buf, 200) == 200);
+    assert(f->lseek (0, SEEK_END) == 3330);
+    assert(f->lseek (59, SEEK_SET) == 59);
+    assert(io->read (buf, 202) == 202);
+    assert(buf[0] == 59 && buf[1] == 'x' && buf[200] == 'x');
+    assert(buf[201] == static_cast<char> (260));
+
+    // Write past the end leaves a zero filled gap.
+    assert(f->lseek (4000, SEEK_SET) == 4000);
+    assert(io->write ("end", 3) == 3);
+    assert(f->lseek (3990, SEEK_SET) == 3990);
+    assert(io->read (buf, sizeof(buf)) == 13);
+    assert(buf[0] == 0 && buf[9] == 0 && std::memcmp (buf + 10, "end", 3) == 0);
+
+    // Shrink, reading stops at the new end.
+    assert(f->ftruncate (100) == 0);
+    assert(f->lseek (0, SEEK_CUR) == 4003);
+    assert(io->read (buf, 10) == 0);
+    assert(fs.used_bytes () == 100);
+
+    assert(io->close () == 0);
+
+    // Open flags.
+    errno = 0;
+    assert(posix::open ("/tmp/f1", O_CREAT | O_EXCL | O_RDWR, 0644) == nullptr);
+    assert(errno == EEXIST);
+    errno = 0;
+    assert(posix::open ("/tmp/none", O_RDONLY) == nullptr);
+    assert(errno == ENOENT);
+    // The failed opens must not leak pool objects.
+    for (std::size_t i = 0; i < files_count; ++i)
+      {
+        assert(!files_pool.in_use (i));
+      }
+
+    io = posix::open ("/tmp/f1", O_RDONLY);
+    assert(io != nullptr);
+    errno = 0;
+    assert(io->write (buf, 1) == -1 && errno == EBADF);
+    assert(io->close () == 0);
+
+    io = posix::open ("/tmp/f1", O_WRONLY | O_TRUNC | O_APPEND);
+    assert(io != nullptr);
+    f = static_cast<posix::file*> (io);
+    assert(io->write ("abc", 3) == 3);
+    assert(f->lseek (0, SEEK_SET) == 0);
+    assert(io->write ("def", 3) == 3);
+    assert(io->fstat (&st) == 0 && st.st_size == 6);
+    assert(io->close () == 0);
+
+    // Unlink while open keeps the content until the last close.
+    io = posix::open ("/tmp/f1", O_RDONLY);
+    assert(io != nullptr);
+    assert(posix::unlink ("/tmp/f1") == 0);
+    errno = 0;
+    assert(posix::stat ("/tmp/f1", &st) == -1 && errno == ENOENT);
+    assert(io->read (buf, sizeof(buf)) == 6);
+    assert(std::memcmp (buf, "abcdef", 6) == 0);
+    assert(io->close () == 0);
+    assert(fs.used_bytes () == 0);
+  }
+
+  void
+  test_mmap (void)
+  {
+    posix::io* io = posix::open ("/tmp/m1", O_CREAT | O_RDWR, 0644);
+    assert(io != nullptr);
+    auto* f = static_cast<posix::file*> (io);
+
+    for (std::size_t i = 0; i < 200; ++i)
+      {
+        buf[i] = static_cast<char> (i);
+      }
+    // Extents of 64, 128 and 256 bytes.
+    assert(io->write (buf, 200) == 200);
+
+    // Inside the second extent, a direct pointer.
+    char* p = static_cast<char*> (
+        f->mmap (64, PROT_READ | PROT_WRITE, MAP_SHARED, 64));
+    assert(p != MAP_FAILED && p[0] == 64 && p[63] == 127);
+    p[0] = 'a';
+    assert(f->lseek (64, SEEK_SET) == 64);
+    assert(io->read (buf, 1) == 1 && buf[0] == 'a');
+
+    // Cannot shrink while mapped.
+    errno = 0;
+    assert(f->ftruncate (10) == -1 && errno == EBUSY);
+
+    // Across extents, a copy, written back when unmapped.
+    char* q = static_cast<char*> (
+        f->mmap (100, PROT_READ | PROT_WRITE, MAP_SHARED, 0));
+    assert(q != MAP_FAILED && q[64] == 'a' && q[99] == 99);
+    q[0] = 'b';
+    assert(f->lseek (0, SEEK_SET) == 0);
+    assert(io->read (buf, 1) == 1 && buf[0] == 0);
+    assert(posix::file::munmap (q, 100) == 0);
+    assert(f->lseek (0, SEEK_SET) == 0);
+    assert(io->read (buf, 1) == 1 && buf[0] == 'b');
+
+    // Private writable mappings are always copies.
+    char* r = static_cast<char*> (
+        f->mmap (16, PROT_READ | PROT_WRITE, MAP_PRIVATE, 0));
+    assert(r != MAP_FAILED);
+    r[1] = 'c';
+    assert(io->read (buf, 1) == 1 && buf[0] == 1);
+
+    // Past the end of file the copy is zero filled.
+    char* s = static_cast<char*> (f->mmap (64, PROT_READ, MAP_PRIVATE, 190));
+    assert(s != MAP_FAILED && s[9] == static_cast<char> (199) && s[10] == 0);
+
+    errno = 0;
+    assert(posix::file::munmap (p, 1) == -1 && errno == EINVAL);
+    assert(posix::file::munmap (p, 64) == 0);
+    assert(f->ftruncate (10) == 0);
+
+    // A shared copy is written back by close(); the mappings
+    // remain valid after it, until removed.
+    q = static_cast<char*> (
+        f->mmap (100, PROT_READ | PROT_WRITE, MAP_SHARED, 0));
+    assert(q != MAP_FAILED);
+    q[2] = 'd';
+    assert(io->close () == 0);
+    assert(r[1] == 'c' && s[9] == static_cast<char> (199) && q[2] == 'd');
+    assert(posix::file::munmap (r, 16) == 0);
+    assert(posix::file::munmap (s, 64) == 0);
+    q[3] = 'e';
+    // The last one writes back and closes the file.
+    assert(posix::file::munmap (q, 100) == 0);
+
+    io = posix::open ("/tmp/m1", O_RDONLY);
+    assert(io != nullptr);
+    f = static_cast<posix::file*> (io);
+    assert(io->read (buf, 4) == 4 && buf[2] == 'd' && buf[3] == 'e');
+    errno = 0;
+    assert(f->mmap (8, PROT_WRITE, MAP_SHARED, 0) == MAP_FAILED);
+    assert(errno == EACCES);
+    // Also for copies.
+    errno = 0;
+    assert(f->mmap (100, PROT_READ | PROT_WRITE, MAP_SHARED, 0) == MAP_FAILED);
+    assert(errno == EACCES);
+    // Private changes do not reach the file.
+    r = static_cast<char*> (
+        f->mmap (16, PROT_READ | PROT_WRITE, MAP_PRIVATE, 0));
+    assert(r != MAP_FAILED);
+    assert(posix::file::munmap (r, 16) == 0);
+    assert(io->close () == 0);
+
+    assert(posix::unlink ("/tmp/m1") == 0);
+    assert(fs.used_bytes () == 0);
+  }
+
+  void
+  test_sendfile (void)
+  {
+    posix::io* in = posix::open ("/tmp/s1", O_CREAT | O_RDWR, 0644);
+    assert(in != nullptr);
+    for (std::size_t i = 0; i < sizeof(buf); ++i)
+      {
+        buf[i] = static_cast<char> (i);
+      }
+    assert(in->write (buf, 500) == 500);
+
+    posix::io* out = posix::open ("/tmp/s2", O_CREAT | O_RDWR, 0644);
+    assert(out != nullptr);
+    auto* f = static_cast<posix::file*> (out);
+
+    // With an offset, the input position does not change.
+    off_t offset = 100;
+    assert(posix::sendfile (out, in, &offset, 50) == 50);
+    assert(offset == 150);
+    assert(static_cast<posix::file*> (in)->lseek (0, SEEK_CUR) == 500);
+
+    // From the current position, up to the end of file.
+    assert(static_cast<posix::file*> (in)->lseek (0, SEEK_SET) == 0);
+    assert(posix::sendfile (out, in, nullptr, 2000) == 500);
+    assert(posix::sendfile (out, in, nullptr, 2000) == 0);
+
+    struct stat st;
+    assert(out->fstat (&st) == 0 && st.st_size == 550);
+    assert(f->lseek (0, SEEK_SET) == 0);
+    assert(out->read (buf, 550) == 550);
+    assert(buf[0] == 100 && buf[49] == static_cast<char> (149));
+    assert(buf[50] == 0 && buf[549] == static_cast<char> (499));
+
+    // Not a file.
+    errno = 0;
+    assert(posix::sendfile (out, nullptr, nullptr, 1) == -1 && errno == EBADF);
+
+    assert(in->close () == 0);
+    assert(out->close () == 0);
+    assert(posix::unlink ("/tmp/s1") == 0);
+    assert(posix::unlink ("/tmp/s2") == 0);
+  }
+
+  void
+  test_directories (void)
+  {
+    struct stat st;
+
+    assert(posix::mkdir ("/tmp/d1", 0755) == 0);
+    errno = 0;
+    assert(posix::mkdir ("/tmp/d1", 0755) == -1 && errno == EEXIST);
+    assert(posix::mkdir ("/tmp/d1/d2", 0755) == 0);
+    assert(posix::stat ("/tmp/d1/d2", &st) == 0 && S_ISDIR(st.st_mode));
+    errno = 0;
+    assert(posix::open ("/tmp/d1", O_RDONLY) == nullptr && errno == EISDIR);
+    errno = 0;
+    assert(posix::open ("/tmp/x/y", O_CREAT | O_RDWR, 0644) == nullptr);
+    assert(errno == ENOENT);
+
+    for (int i = 0; i < 3; ++i)
+      {
+        char name[32];
+        snprintf (name, sizeof(name), "/tmp/d1/f%d", i);
+        posix::io* io = posix::open (name, O_CREAT | O_WRONLY, 0644);
+        assert(io != nullptr);
+        assert(io->close () == 0);
+      }
+
+    // Entries are listed newest first: f2, f1, f0, d2.
+    // Removing f0 while listing must skip it.
+    posix::directory* dir = posix::opendir ("/tmp/d1");
+    assert(dir != nullptr);
+    int count = 0;
+    bool removed = false;
+    struct dirent* de;
+    while ((de = dir->read ()) != nullptr)
+      {
+        ++count;
+        if (!removed)
+          {
+            assert(posix::unlink ("/tmp/d1/f0") == 0);
+            removed = true;
+          }
+      }
+    assert(count == 3);
+
+    errno = 0;
+    assert(posix::rmdir ("/tmp/d1/d2") == 0);
+    assert(posix::rmdir ("/tmp/d1") == -1 && errno == ENOTEMPTY);
+
+    dir->rewind ();
+    count = 0;
+    while (dir->read () != nullptr)
+      {
+        ++count;
+      }
+    assert(count == 2);
+    assert(dir->close () == 0);
+
+    // Rename replaces the destination.
+    assert(posix::rename ("/tmp/d1/f1", "/tmp/d1/f2") == 0);
+    assert(posix::stat ("/tmp/d1/f1", &st) == -1);
+    assert(posix::stat ("/tmp/d1/f2", &st) == 0);
+    errno = 0;
+    assert(posix::rename ("/tmp/d1", "/tmp/d1/sub") == -1 && errno == EINVAL);
+
+    assert(posix::unlink ("/tmp/d1/f2") == 0);
+    assert(posix::rmdir ("/tmp/d1") == 0);
+  }
+
+  // --------------------------------------------------------------------------
+
+  void
+  report (const char* name, rtos::clock::timestamp_t cycles, std::size_t n,
+          const char* unit)
+  {
+    printf ("%-24s %10lu cycles, %8lu per %s\n", name,
+            static_cast<unsigned long> (cycles),
+            static_cast<unsigned long> (cycles / n), unit);
+  }
+
+  void
+  bench_append_read (std::size_t chunk, std::size_t total)
+  {
+    char title[32];
+
+    posix::io* io = posix::open ("/tmp/bench", O_CREAT | O_RDWR | O_TRUNC,
+                                 0644);
+    assert(io != nullptr);
+    auto* f = static_cast<posix::file*> (io);
+
+    rtos::clock::timestamp_t begin = rtos::hrclock.now ();
+    for (std::size_t n = 0; n < total; n += chunk)
+      {
+        io->write (buf, chunk);
+      }
+    rtos::clock::timestamp_t end = rtos::hrclock.now ();
+    snprintf (title, sizeof(title), "append %lu",
+              static_cast<unsigned long> (chunk));
+    report (title, end - begin, total / chunk, "call");
+
+    f->lseek (0, SEEK_SET);
+    begin = rtos::hrclock.now ();
+    for (std::size_t n = 0; n < total; n += chunk)
+      {
+        io->read (buf, chunk);
+      }
+    end = rtos::hrclock.now ();
+    snprintf (title, sizeof(title), "read %lu",
+              static_cast<unsigned long> (chunk));
+    report (title, end - begin, total / chunk, "call");
+
+    io->close ();
+    posix::unlink ("/tmp/bench");
+  }
+
+  void
+  bench_copy (std::size_t total)
+  {
+    posix::io* in = posix::open ("/tmp/bench", O_CREAT | O_RDWR | O_TRUNC,
+                                 0644);
+    assert(in != nullptr);
+    auto* f = static_cast<posix::file*> (in);
+    for (std::size_t n = 0; n < total; n += sizeof(buf))
+      {
+        in->write (buf, sizeof(buf));
+      }
+
+    posix::io* out = posix::open ("/tmp/copy", O_CREAT | O_RDWR | O_TRUNC,
+                                  0644);
+    assert(out != nullptr);
+
+    f->lseek (0, SEEK_SET);
+    rtos::clock::timestamp_t begin = rtos::hrclock.now ();
+    ssize_t ret;
+    while ((ret = in->read (buf, 512)) > 0)
+      {
+        out->write (buf, static_cast<std::size_t> (ret));
+      }
+    rtos::clock::timestamp_t end = rtos::hrclock.now ();
+    report ("copy read/write 512", end - begin, total / 512, "512 bytes");
+
+    static_cast<posix::file*> (out)->ftruncate (0);
+    static_cast<posix::file*> (out)->lseek (0, SEEK_SET);
+    f->lseek (0, SEEK_SET);
+    begin = rtos::hrclock.now ();
+    while (posix::sendfile (out, in, nullptr, total) > 0)
+      {
+        ;
+      }
+    end = rtos::hrclock.now ();
+    report ("copy sendfile", end - begin, total / 512, "512 bytes");
+
+    struct stat st;
+    assert(out->fstat (&st) == 0 && st.st_size == static_cast<off_t> (total));
+
+    in->close ();
+    out->close ();
+    posix::unlink ("/tmp/bench");
+    posix::unlink ("/tmp/copy");
+  }
+
+  void
+  bench_lookup (std::size_t files)
+  {
+    char name[32];
+
+    for (std::size_t i = 0; i < files; ++i)
+      {
+        snprintf (name, sizeof(name), "/tmp/n%lu",
+                  static_cast<unsigned long> (i));
+        posix::io* io = posix::open (name, O_CREAT | O_WRONLY, 0644);
+        assert(io != nullptr);
+        io->close ();
+      }
+
+    struct stat st;
+    rtos::clock::timestamp_t begin = rtos::hrclock.now ();
+    for (std::size_t i = 0; i < files; ++i)
+      {
+        snprintf (name, sizeof(name), "/tmp/n%lu",
+                  static_cast<unsigned long> (i));
+        posix::stat (name, &st);
+      }
+    rtos::clock::timestamp_t end = rtos::hrclock.now ();
+
+    char title[32];
+    snprintf (title, sizeof(title), "stat (%lu files)",
+              static_cast<unsigned long> (files));
+    report (title, end - begin, files, "lookup");
+
+    for (std::size_t i = 0; i < files; ++i)
+      {
+        snprintf (name, sizeof(name), "/tmp/n%lu",
+                  static_cast<unsigned long> (i));
+        posix::unlink (name);
+      }
+  }
+}
+
+/*
+ * Functional tests for the `tmpfs` file system, followed by
+ * the append, sequential read and name lookup durations,
+ * in `hrclock` cycles (CPU cycles on Cortex-M).
+ */
+int
+os_main (int argc __attribute__((unused)), char* argv[] __attribute__((unused)))
+{
+  printf ("\nPOSIX I/O tmpfs test.\n");
+
+  int ret = posix::mount_manager::mount (&fs, "/tmp/", nullptr, 0);
+  assert(ret == 0);
+
+  test_files ();
+  test_mmap ();
+  test_sendfile ();
+  test_directories ();
+
+  printf ("Functional tests passed.\n\n");
+
+  bench_append_read (16, 64 * 1024);
+  bench_append_read (512, 64 * 1024);
+  bench_copy (16 * 1024);
+  bench_lookup (16);
+  bench_lookup (256);
+
+  ret = posix::mount_manager::umount ("/tmp/", 0);
+  assert(ret == 0);
+
+  return 0;
+}
+
+// ----------------------------------------------------------------------------
@@ -69,6 +69,8 @@
 #define OS_INCLUDE_RTOS_STATISTICS_THREAD_CONTEXT_SWITCHES  (1)
 #define OS_INCLUDE_RTOS_STATISTICS_THREAD_CPU_CYCLES        (1)
 
+#define OS_USE_RTOS_LAZY_INIT
+
 // ----------------------------------------------------------------------------
 
 #if defined(USE_FREERTOS)
@@ -34,6 +34,13 @@
 #include <test-iso-api.h>
 
 #include <test-cpp-mem.h>
+#include <test-thread-pool.h>
+#include <test-future.h>
+#include <test-event-flags.h>
+#include <test-memory-pool.h>
+#include <test-slab.h>
+#include <test-message-buffer.h>
+#include <test-lazy.h>
 
 int
 os_main (int argc __attribute__((unused)), char* argv[] __attribute__((unused)))
@@ -75,6 +82,55 @@ os_main (int argc __attribute__((unused)), char* argv[] __attribute__((unused)))
     }
 #endif
 
+#if 1
+  if (ret == 0)
+    {
+      ret = test_thread_pool ();
+    }
+#endif
+
+#if 1
+  if (ret == 0)
+    {
+      ret = test_future ();
+    }
+#endif
+
+#if 1
+  if (ret == 0)
+    {
+      ret = test_event_flags ();
+    }
+#endif
+
+#if 1
+  if (ret == 0)
+    {
+      ret = test_memory_pool ();
+    }
+#endif
+
+#if 1
+  if (ret == 0)
+    {
+      ret = test_slab ();
+    }
+#endif
+
+#if 1
+  if (ret == 0)
+    {
+      ret = test_message_buffer ();
+    }
+#endif
+
+#if 1
+  if (ret == 0)
+    {
+      ret = test_lazy ();
+    }
+#endif
+
   printf ("errno=%d\n", errno);
 
   return ret;
@@ -0,0 +1,179 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstdio>
+
+#include <test-event-flags.h>
+#include <cmsis-plus/rtos/os.h>
+
+// ----------------------------------------------------------------------------
+
+static const char* test_name = "Test event flags";
+
+// ----------------------------------------------------------------------------
+
+using namespace os;
+using namespace os::rtos;
+
+static int failures;
+
+static void
+expect (bool cond, const char* what)
+{
+  if (!cond)
+    {
+      printf ("%s failed\n", what);
+      ++failures;
+    }
+}
+
+struct waiter_s
+{
+  event_flags* evf;
+  flags::mask_t mask;
+  flags::mode_t mode;
+  flags::mask_t oflags;
+  result_t res;
+  bool done;
+};
+
+static void*
+waiter (void* args)
+{
+  waiter_s* w = static_cast<waiter_s*> (args);
+
+  w->res = w->evf->wait (w->mask, &w->oflags, w->mode);
+  w->done = true;
+
+  return nullptr;
+}
+
+static void
+test_timeouts (void)
+{
+  event_flags evf
+    { "evf" };
+
+  expect (evf.try_wait (0x1) == EWOULDBLOCK, "try_wait empty");
+  expect (evf.timed_wait (0x1, 2) == ETIMEDOUT, "timed_wait timeout");
+
+  evf.raise (0x1);
+  flags::mask_t oflags = 0;
+  expect (evf.try_wait (0x1, &oflags) == result::ok && oflags == 0x1,
+          "try_wait raised");
+  expect (evf.get (flags::any) == 0, "try_wait clear");
+}
+
+static void
+test_selective_wake (void)
+{
+  event_flags evf
+    { "evf" };
+
+  waiter_s wa
+    { &evf, 0x1, flags::mode::all | flags::mode::clear, 0, 0, false };
+  waiter_s wb
+    { &evf, 0x6, flags::mode::all | flags::mode::clear, 0, 0, false };
+
+  thread_inclusive<> ta
+    { "wa", waiter, &wa };
+  thread_inclusive<> tb
+    { "wb", waiter, &wb };
+
+  // Let both threads block.
+  sysclock.sleep_for (2);
+  expect (evf.waiting (), "waiting");
+
+  // Only the first mask is satisfied; the waiter consumes its
+  // flag and the unrelated one remains set.
+  evf.raise (0x1 | 0x2);
+  sysclock.sleep_for (2);
+
+  expect (wa.done && wa.res == result::ok && wa.oflags == 0x1,
+          "matching waiter woken");
+  expect (!wb.done, "partial mask not woken");
+  expect (evf.get (flags::any) == 0x2, "only the waiter flags cleared");
+
+  evf.raise (0x4);
+  tb.join ();
+
+  expect (wb.done && wb.res == result::ok && wb.oflags == 0x6,
+          "all mask woken");
+  expect (evf.get (flags::any) == 0, "all mask cleared");
+  expect (!evf.waiting (), "no waiters");
+
+  ta.join ();
+}
+
+static void
+test_any_mode (void)
+{
+  event_flags evf
+    { "evf" };
+
+  waiter_s wa
+    { &evf, 0x3, flags::mode::any, 0, 0, false };
+  waiter_s wb
+    { &evf, 0x4, flags::mode::any, 0, 0, false };
+
+  thread_inclusive<> ta
+    { "wa", waiter, &wa };
+  thread_inclusive<> tb
+    { "wb", waiter, &wb };
+
+  sysclock.sleep_for (2);
+
+  // Without clear, the flags remain set for later waiters.
+  evf.raise (0x2);
+  ta.join ();
+  sysclock.sleep_for (2);
+
+  expect (wa.done && (wa.oflags & 0x3) == 0x2, "any mode woken");
+  expect (!wb.done, "other mask not woken");
+  expect (evf.get (flags::any) == 0x2, "no clear, flags kept");
+
+  evf.raise (0x4);
+  tb.join ();
+  expect (wb.done, "second waiter woken");
+}
+
+int
+test_event_flags (void)
+{
+  printf ("\n%s - Start.\n", test_name);
+
+  failures = 0;
+
+  test_timeouts ();
+  test_selective_wake ();
+  test_any_mode ();
+
+  printf ("\n%s - %s.\n", test_name, (failures == 0) ? "Done" : "Failed");
+  return failures;
+}
+
+// ----------------------------------------------------------------------------
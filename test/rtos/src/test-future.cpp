@@ -0,0 +1,198 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstdio>
+#include <memory>
+
+#include <test-future.h>
+#include <cmsis-plus/estd/future>
+
+// ----------------------------------------------------------------------------
+
+static const char* test_name = "Test futures";
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Waggregate-return"
+
+// ----------------------------------------------------------------------------
+
+using namespace os::estd;
+using namespace os;
+
+static int failures;
+
+static void
+expect (bool cond, const char* what)
+{
+  if (!cond)
+    {
+      printf ("%s failed\n", what);
+      ++failures;
+    }
+}
+
+static int
+twice (std::unique_ptr<int> p)
+{
+  return 2 * *p;
+}
+
+static void
+test_get_wait (void)
+{
+  promise<int> p;
+  future<int> f = p.get_future ();
+
+  expect (f.wait_for (std::chrono::milliseconds (2)) == future_status::timeout,
+          "wait_for timeout");
+
+  p.set_value (42);
+  expect (f.wait_for (std::chrono::milliseconds (0)) == future_status::ready,
+          "wait_for ready");
+  expect (f.get () == 42, "promise get");
+  expect (!f.valid (), "future released");
+
+  packaged_task<int (int)> task
+    { [](int x)
+      { return x + 1;} };
+  future<int> ft = task.get_future ();
+  task (1);
+  expect (ft.get () == 2, "packaged_task get");
+}
+
+static void
+test_async (void)
+{
+  auto fa = async (launch::async, twice, std::unique_ptr<int> (new int (3)));
+  auto fd = async (launch::deferred, twice, std::unique_ptr<int> (new int (4)));
+
+  expect (fa.get () == 6, "async move only argument");
+  expect (fd.get () == 8, "deferred move only argument");
+}
+
+#if defined(__EXCEPTIONS)
+
+static void
+test_exceptions (void)
+{
+  auto f = async (launch::async, []() -> int
+    {
+      throw 7;
+    });
+
+  int caught = 0;
+  try
+    {
+      f.get ();
+    }
+  catch (int e)
+    {
+      caught = e;
+    }
+  expect (caught == 7, "exception propagation");
+
+  future<int> fb;
+    {
+      promise<int> p;
+      fb = p.get_future ();
+    }
+
+  future_errc ec = future_errc::no_state;
+  try
+    {
+      fb.get ();
+    }
+  catch (future_error& e)
+    {
+      ec = e.code ();
+    }
+  expect (ec == future_errc::broken_promise, "broken promise");
+}
+
+#endif /* defined(__EXCEPTIONS) */
+
+#if OS_INTEGER_ESTD_FUTURE_POOL_BLOCKS > 0
+
+static void
+test_pool_fallback (void)
+{
+  // No other shared states are alive, all blocks are available.
+  constexpr int n = OS_INTEGER_ESTD_FUTURE_POOL_BLOCKS;
+
+  for (int round = 0; round < 2; ++round)
+    {
+      promise<int> held[n];
+
+      // The pool is exhausted, the state comes from the default resource.
+      promise<int> extra;
+      future<int> f = extra.get_future ();
+      extra.set_value (round);
+      expect (f.get () == round, "pool exhausted fallback");
+
+      // All blocks are returned, the second round uses the pool again.
+    }
+
+  // Larger than the blocks, always from the default resource.
+  struct big
+  {
+    char data[OS_INTEGER_ESTD_FUTURE_POOL_BLOCK_SIZE_BYTES];
+  };
+
+  promise<big> pb;
+  future<big> fb = pb.get_future ();
+  big b;
+  b.data[0] = 'x';
+  pb.set_value (b);
+  expect (fb.get ().data[0] == 'x', "large state fallback");
+}
+
+#endif
+
+int
+test_future (void)
+{
+  printf ("\n%s - Start.\n", test_name);
+
+  failures = 0;
+
+  test_get_wait ();
+  test_async ();
+
+#if defined(__EXCEPTIONS)
+  test_exceptions ();
+#endif
+#if OS_INTEGER_ESTD_FUTURE_POOL_BLOCKS > 0
+  test_pool_fallback ();
+#endif
+
+  printf ("\n%s - %s.\n", test_name, (failures == 0) ? "Done" : "Failed");
+  return failures;
+}
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
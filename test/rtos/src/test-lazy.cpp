@@ -0,0 +1,193 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstdio>
+
+#include <test-lazy.h>
+#include <cmsis-plus/rtos/os.h>
+
+// ----------------------------------------------------------------------------
+
+static const char* test_name = "Test lazy";
+
+// ----------------------------------------------------------------------------
+
+#if defined(OS_USE_RTOS_LAZY_INIT)
+
+using namespace os;
+
+static int failures;
+
+static void
+expect (bool cond, const char* what)
+{
+  if (!cond)
+    {
+      printf ("%s failed\n", what);
+      ++failures;
+    }
+}
+
+// Incremented by each constructor, to check the order.
+static int sequence;
+
+class recorder
+{
+public:
+
+  recorder () :
+      order (++sequence)
+  {
+    ;
+  }
+
+  int order;
+};
+
+class user
+{
+public:
+
+  user ();
+
+  int dep_order;
+  int order;
+};
+
+static rtos::lazy<recorder> main_obj
+  { rtos::lazy_init::stage::main };
+
+static rtos::lazy<recorder> background_obj
+  { rtos::lazy_init::stage::background };
+
+static rtos::lazy<recorder> background_next_obj
+  { rtos::lazy_init::stage::background + 1 };
+
+static rtos::lazy<recorder> on_demand_obj;
+
+static rtos::lazy<recorder> dep_obj;
+
+static rtos::lazy<user> user_obj;
+
+user::user () :
+    dep_order (dep_obj->order), //
+    order (++sequence)
+{
+  ;
+}
+
+// ----------------------------------------------------------------------------
+
+static void
+test_stages (void)
+{
+  // Constructed by the main thread before os_main().
+  expect (main_obj.is_constructed (), "main stage");
+
+  rtos::lazy_init::join ();
+
+  expect (background_obj.is_constructed (), "background stage");
+  expect (background_next_obj.is_constructed (), "next background stage");
+  expect (main_obj->order < background_obj->order, "main before background");
+  expect (background_obj->order < background_next_obj->order,
+          "background stages order");
+
+  // The second call returns immediately.
+  rtos::lazy_init::join ();
+}
+
+static void
+test_on_demand (void)
+{
+  expect (!on_demand_obj.is_constructed (), "not constructed before use");
+
+  int order = on_demand_obj->order;
+  expect (on_demand_obj.is_constructed (), "constructed on use");
+  expect (order == on_demand_obj->order, "constructed once");
+}
+
+static void
+test_nested (void)
+{
+  expect (!dep_obj.is_constructed (), "dependency not constructed");
+
+  int order = user_obj->order;
+  expect (dep_obj.is_constructed (), "dependency constructed");
+  expect (user_obj->dep_order < order, "dependency first");
+  expect (user_obj->dep_order == dep_obj->order, "dependency constructed once");
+}
+
+static void
+test_automatic (void)
+{
+  constexpr rtos::lazy_init::stage_t stage =
+      rtos::lazy_init::stage::background + 2;
+
+    {
+      rtos::lazy<recorder> local
+        { stage };
+      rtos::lazy_init::run_stage (stage);
+      expect (local.is_constructed (), "automatic object");
+    }
+
+  // The object was unlinked when destroyed.
+    {
+      rtos::lazy<recorder> local
+        { stage };
+      rtos::lazy_init::run_stage (stage);
+      expect (local.is_constructed (), "second automatic object");
+    }
+}
+
+#endif /* defined(OS_USE_RTOS_LAZY_INIT) */
+
+int
+test_lazy (void)
+{
+  printf ("\n%s - Start.\n", test_name);
+
+#if defined(OS_USE_RTOS_LAZY_INIT)
+
+  failures = 0;
+
+  test_stages ();
+  test_on_demand ();
+  test_nested ();
+  test_automatic ();
+
+  printf ("\n%s - %s.\n", test_name, (failures == 0) ? "Done" : "Failed");
+  return failures;
+
+#else
+
+  printf ("\n%s - Skipped, OS_USE_RTOS_LAZY_INIT not defined.\n", test_name);
+  return 0;
+
+#endif /* defined(OS_USE_RTOS_LAZY_INIT) */
+}
+
+// ----------------------------------------------------------------------------
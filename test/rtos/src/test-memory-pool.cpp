@@ -0,0 +1,199 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstdio>
+#include <cstdint>
+
+#include <test-memory-pool.h>
+#include <cmsis-plus/rtos/os.h>
+
+// ----------------------------------------------------------------------------
+
+static const char* test_name = "Test memory pool";
+
+// ----------------------------------------------------------------------------
+
+using namespace os;
+using namespace os::rtos;
+
+static int failures;
+
+static void
+expect (bool cond, const char* what)
+{
+  if (!cond)
+    {
+      printf ("%s failed\n", what);
+      ++failures;
+    }
+}
+
+struct block_s
+{
+  std::uint32_t words[4];
+};
+
+constexpr std::size_t blocks = 4;
+
+using pool_type = memory_pool_inclusive<block_s, blocks>;
+
+// Check that the blocks are distinct and inside the pool.
+static bool
+distinct (pool_type& mp, block_s* b[])
+{
+  auto* first = static_cast<char*> (mp.pool ());
+  for (std::size_t i = 0; i < blocks; ++i)
+    {
+      auto* p = reinterpret_cast<char*> (b[i]);
+      if (p == nullptr || p < first
+          || p >= first + blocks * mp.block_size ())
+        {
+          return false;
+        }
+      for (std::size_t j = 0; j < i; ++j)
+        {
+          if (b[j] == b[i])
+            {
+              return false;
+            }
+        }
+    }
+  return true;
+}
+
+static void
+test_exhaustion (void)
+{
+  pool_type mp
+    { "mp" };
+
+  block_s* b[blocks];
+  for (std::size_t i = 0; i < blocks; ++i)
+    {
+      b[i] = mp.try_alloc ();
+    }
+
+  expect (distinct (mp, b), "distinct blocks");
+  expect (mp.full () && mp.count () == blocks, "full");
+  expect (mp.try_alloc () == nullptr, "try_alloc exhausted");
+  expect (mp.timed_alloc (2) == nullptr, "timed_alloc timeout");
+
+  // Overwrite the blocks, including the free list links.
+  for (std::size_t i = 0; i < blocks; ++i)
+    {
+      for (auto& w : b[i]->words)
+        {
+          w = 0xA5A5A5A5;
+        }
+    }
+
+  // Free in a different order, the list must still hold all blocks.
+  const std::size_t order[blocks] =
+    { 2, 0, 3, 1 };
+  for (std::size_t i = 0; i < blocks; ++i)
+    {
+      expect (mp.free (b[order[i]]) == result::ok, "free");
+    }
+  expect (mp.empty (), "empty");
+
+  block_s* c[blocks];
+  for (std::size_t i = 0; i < blocks; ++i)
+    {
+      c[i] = mp.try_alloc ();
+    }
+  expect (distinct (mp, c), "free list integrity");
+  expect (c[0] == b[1], "last freed allocated first");
+  expect (mp.try_alloc () == nullptr, "exhausted again");
+
+  mp.reset ();
+  expect (mp.empty (), "reset");
+  for (std::size_t i = 0; i < blocks; ++i)
+    {
+      c[i] = mp.alloc ();
+    }
+  expect (distinct (mp, c), "free list after reset");
+}
+
+struct waiter_s
+{
+  pool_type* mp;
+  block_s* block;
+};
+
+static void*
+waiter (void* args)
+{
+  waiter_s* w = static_cast<waiter_s*> (args);
+
+  w->block = w->mp->alloc ();
+
+  return nullptr;
+}
+
+static void
+test_wait (void)
+{
+  pool_type mp
+    { "mp" };
+
+  block_s* b[blocks];
+  for (std::size_t i = 0; i < blocks; ++i)
+    {
+      b[i] = mp.alloc ();
+    }
+
+  waiter_s w
+    { &mp, nullptr };
+  thread_inclusive<> th
+    { "waiter", waiter, &w };
+
+  // Let the thread block, then free one block for it.
+  sysclock.sleep_for (2);
+  expect (w.block == nullptr, "alloc blocks when full");
+
+  mp.free (b[3]);
+  th.join ();
+
+  expect (w.block == b[3], "waiter gets the freed block");
+  expect (mp.full (), "full after hand over");
+}
+
+int
+test_memory_pool (void)
+{
+  printf ("\n%s - Start.\n", test_name);
+
+  failures = 0;
+
+  test_exhaustion ();
+  test_wait ();
+
+  printf ("\n%s - %s.\n", test_name, (failures == 0) ? "Done" : "Failed");
+  return failures;
+}
+
+// ----------------------------------------------------------------------------
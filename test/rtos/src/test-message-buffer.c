@@ -0,0 +1,175 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/rtos/os-c-api.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <test-message-buffer.h>
+
+// ----------------------------------------------------------------------------
+
+static const char* test_name = "Test message buffer";
+
+static int failures;
+
+static void
+expect (bool cond, const char* what)
+{
+  if (!cond)
+    {
+      printf ("%s failed\n", what);
+      ++failures;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+// Each record is a 2 bytes length followed by the content.
+#define BUFFER_SIZE_BYTES (32)
+
+static char storage[BUFFER_SIZE_BYTES];
+
+static const char msg_a[] = "0123456789";
+static const char msg_b[] = "abcdefghij";
+static const char msg_c[] = "ABCDEFGHIJKLMN";
+
+static void
+test_timeouts (os_mbuffer_t* mb)
+{
+  char in[16];
+  size_t n = 0;
+
+  expect (os_mbuffer_try_receive (mb, in, sizeof(in), &n) == EWOULDBLOCK,
+          "try_receive empty");
+  expect (os_mbuffer_timed_receive (mb, in, sizeof(in), 2, &n) == ETIMEDOUT,
+          "timed_receive timeout");
+
+  expect (os_mbuffer_send (mb, msg_a, 10) == os_ok, "send a");
+  expect (os_mbuffer_send (mb, msg_b, 10) == os_ok, "send b");
+  expect (os_mbuffer_get_length (mb) == 2, "length 2");
+  expect (os_mbuffer_get_available (mb) == BUFFER_SIZE_BYTES - 24 - 2,
+          "available");
+
+  expect (os_mbuffer_try_send (mb, msg_c, 7) == EWOULDBLOCK, "try_send full");
+  expect (os_mbuffer_timed_send (mb, msg_c, 7, 2) == ETIMEDOUT,
+          "timed_send timeout");
+
+#if defined(NDEBUG)
+  // In debug builds the parameter checks assert.
+  char large[BUFFER_SIZE_BYTES];
+  memset (large, 0, sizeof(large));
+  expect (os_mbuffer_try_send (mb, large, sizeof(large)) == EMSGSIZE,
+          "message can never fit");
+#endif
+
+  // Too small destination, the message is not lost.
+  expect (os_mbuffer_try_receive (mb, in, 4, &n) == EMSGSIZE,
+          "receive too small");
+  expect (os_mbuffer_get_length (mb) == 2, "message kept");
+}
+
+static void
+test_wraparound (os_mbuffer_t* mb)
+{
+  char in[16];
+  size_t n = 0;
+
+  // Continues from test_timeouts(), with a and b in the buffer.
+  expect (os_mbuffer_receive (mb, in, sizeof(in), &n) == os_ok && n == 10
+              && memcmp (in, msg_a, n) == 0,
+          "receive a");
+
+  // The record of c starts after b and wraps around the end.
+  expect (os_mbuffer_try_send (mb, msg_c, 14) == os_ok, "send c wrapped");
+  expect (os_mbuffer_get_available (mb) == BUFFER_SIZE_BYTES - 28 - 2,
+          "available after wrap");
+  expect (os_mbuffer_try_send (mb, msg_a, 3) == EWOULDBLOCK,
+          "try_send after wrap");
+
+  expect (os_mbuffer_try_receive (mb, in, sizeof(in), &n) == os_ok && n == 10
+              && memcmp (in, msg_b, n) == 0,
+          "receive b");
+  memset (in, 0, sizeof(in));
+  expect (os_mbuffer_timed_receive (mb, in, sizeof(in), 2, &n) == os_ok
+              && n == 14 && memcmp (in, msg_c, n) == 0,
+          "receive c wrapped");
+
+  expect (os_mbuffer_is_empty (mb), "empty");
+  expect (os_mbuffer_get_available (mb) == BUFFER_SIZE_BYTES - 2,
+          "all space available");
+
+  // Zero length messages are valid records.
+  expect (os_mbuffer_send (mb, msg_a, 0) == os_ok, "send empty message");
+  n = 1;
+  expect (os_mbuffer_receive (mb, in, sizeof(in), &n) == os_ok && n == 0,
+          "receive empty message");
+}
+
+int
+test_message_buffer (void)
+{
+  printf ("\n%s - Start.\n", test_name);
+
+  failures = 0;
+
+  os_mbuffer_attr_t attr;
+  os_mbuffer_attr_init (&attr);
+  attr.mb_buffer_addr = storage;
+  attr.mb_buffer_size_bytes = sizeof(storage);
+
+  os_mbuffer_t mb;
+  os_mbuffer_construct (&mb, "mb", BUFFER_SIZE_BYTES, &attr);
+
+  expect (os_mbuffer_get_capacity (&mb) == BUFFER_SIZE_BYTES, "capacity");
+
+  test_timeouts (&mb);
+  test_wraparound (&mb);
+
+  os_mbuffer_send (&mb, msg_a, 10);
+  expect (os_mbuffer_reset (&mb) == os_ok && os_mbuffer_is_empty (&mb),
+          "reset");
+
+  os_mbuffer_destruct (&mb);
+
+  // Dynamically allocated storage.
+  os_mbuffer_t* pmb = os_mbuffer_new ("pmb", 16, NULL);
+  char in[16];
+  size_t n = 0;
+  expect (os_mbuffer_send (pmb, msg_b, 5) == os_ok, "dynamic send");
+  expect (os_mbuffer_receive (pmb, in, sizeof(in), &n) == os_ok && n == 5
+              && memcmp (in, msg_b, n) == 0,
+          "dynamic receive");
+  os_mbuffer_delete (pmb);
+
+  printf ("\n%s - %s.\n", test_name, (failures == 0) ? "Done" : "Failed");
+  return failures;
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,161 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstdio>
+#include <cstddef>
+#include <type_traits>
+
+#include <test-slab.h>
+#include <cmsis-plus/rtos/os.h>
+#include <cmsis-plus/memory/slab.h>
+#include <cmsis-plus/memory/block-pool.h>
+
+// ----------------------------------------------------------------------------
+
+static const char* test_name = "Test slab";
+
+// ----------------------------------------------------------------------------
+
+using namespace os;
+
+static int failures;
+
+static void
+expect (bool cond, const char* what)
+{
+  if (!cond)
+    {
+      printf ("%s failed\n", what);
+      ++failures;
+    }
+}
+
+static const memory::slab::size_class classes[] =
+  {
+    { 16, 4 },
+    { 64, 2 } };
+
+constexpr std::size_t classes_count = sizeof(classes) / sizeof(classes[0]);
+
+static std::aligned_storage<512, alignof(std::max_align_t)>::type arena;
+
+static std::aligned_storage<128, alignof(std::max_align_t)>::type upstream_arena[2];
+
+static void
+test_classes (void)
+{
+  expect (memory::slab::arena_size (classes, classes_count) <= sizeof(arena),
+          "arena size");
+
+  memory::slab sl
+    { "slab", classes, classes_count, &arena, sizeof(arena) };
+
+  void* small[4];
+  for (auto& p : small)
+    {
+      p = sl.allocate (10);
+    }
+  for (std::size_t i = 0; i < 4; ++i)
+    {
+      expect (small[i] != nullptr, "small allocated");
+      for (std::size_t j = 0; j < i; ++j)
+        {
+          expect (small[i] != small[j], "small distinct");
+        }
+    }
+
+  // The small class is exhausted, the next class is used.
+  void* spill = sl.allocate (10);
+  void* large = sl.allocate (64);
+  expect (spill != nullptr && large != nullptr, "larger class used");
+
+  // All pools empty and no upstream.
+  expect (sl.allocate (8) == nullptr, "exhausted");
+  expect (sl.allocate (100) == nullptr, "too large");
+  expect (sl.free_chunks () == 0, "no free chunks");
+
+  // Deallocation is routed by address, the size is not needed.
+  sl.deallocate (small[2], 0);
+  sl.deallocate (spill, 0);
+  void* again = sl.allocate (16);
+  expect (again == small[2], "block returned to its class");
+  void* again2 = sl.allocate (40);
+  expect (again2 == spill, "block returned to the larger class");
+
+  sl.reset ();
+  expect (sl.free_chunks () == 6 && sl.allocated_chunks () == 0, "reset");
+  for (auto& p : small)
+    {
+      p = sl.allocate (16);
+      expect (p != nullptr, "allocate after reset");
+    }
+}
+
+static void
+test_upstream (void)
+{
+  memory::block_pool up
+    { "up", 2, 128, upstream_arena, sizeof(upstream_arena) };
+  memory::slab sl
+    { "slab", classes, classes_count, &arena, sizeof(arena), &up };
+
+  // Larger than the largest class.
+  void* p = sl.allocate (100);
+  expect (p != nullptr && p >= static_cast<void*> (upstream_arena)
+              && p < static_cast<void*> (&upstream_arena[2]),
+          "large request upstream");
+
+  // Over aligned.
+  void* q = sl.allocate (8, 2 * alignof(std::max_align_t));
+  expect (q == nullptr || (q >= static_cast<void*> (upstream_arena)
+              && q < static_cast<void*> (&upstream_arena[2])),
+          "over aligned request upstream");
+
+  sl.deallocate (p, 100);
+  expect (up.allocated_chunks () == ((q != nullptr) ? 1 : 0),
+          "upstream deallocation");
+  if (q != nullptr)
+    {
+      sl.deallocate (q, 8, 2 * alignof(std::max_align_t));
+    }
+}
+
+int
+test_slab (void)
+{
+  printf ("\n%s - Start.\n", test_name);
+
+  failures = 0;
+
+  test_classes ();
+  test_upstream ();
+
+  printf ("\n%s - %s.\n", test_name, (failures == 0) ? "Done" : "Failed");
+  return failures;
+}
+
+// ----------------------------------------------------------------------------
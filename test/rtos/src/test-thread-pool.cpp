@@ -0,0 +1,165 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstdio>
+
+#include <test-thread-pool.h>
+#include <cmsis-plus/estd/thread_pool>
+
+// ----------------------------------------------------------------------------
+
+static const char* test_name = "Test thread pool";
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Waggregate-return"
+
+// ----------------------------------------------------------------------------
+
+using namespace os::estd;
+using namespace os;
+
+static int failures;
+
+static void
+expect (bool cond, const char* what)
+{
+  if (!cond)
+    {
+      printf ("%s failed\n", what);
+      ++failures;
+    }
+}
+
+static int
+square (int x)
+{
+  return x * x;
+}
+
+static void
+test_submit (void)
+{
+  thread_pool_inclusive<2, 2048> pool
+    { "pool" };
+
+  auto f1 = pool.submit (square, 7);
+  auto f2 = pool.submit ([](int a, int b)
+    { return a + b;}, 3, 4);
+
+  expect (f1.get () == 49, "submit/get");
+  expect (f2.get () == 7, "submit/get args");
+}
+
+static void
+test_nested_submit (void)
+{
+  // With a single worker, a task waiting for a task it submitted
+  // deadlocks unless the inner task is executed inline.
+  thread_pool_inclusive<1, 2048> pool
+    { "nested" };
+
+  auto f = pool.submit ([&pool]()
+    {
+      auto inner = pool.submit (square, 5);
+      return inner.get () + 1;
+    });
+
+  expect (f.get () == 26, "nested submit");
+}
+
+static void
+test_shutdown (void)
+{
+  constexpr int n = 6;
+
+  int done = 0;
+  future<void> futures[n];
+    {
+      thread_pool_inclusive<1, 2048, n> pool
+        { "shutdown" };
+
+      for (int i = 0; i < n; ++i)
+        {
+          futures[i] = pool.submit ([&done]()
+            {
+              rtos::sysclock.sleep_for (2);
+
+              rtos::scheduler::critical_section scs;
+              ++done;
+            });
+        }
+
+      // The destructor runs the queued tasks before returning.
+    }
+
+  expect (done == n, "shutdown runs queued tasks");
+  for (int i = 0; i < n; ++i)
+    {
+      expect (futures[i].wait_for (std::chrono::milliseconds (0))
+                  == future_status::ready,
+              "shutdown future ready");
+    }
+}
+
+static void
+test_parallel_for (void)
+{
+  thread_pool_inclusive<2, 2048> pool
+    { "pfor" };
+
+  int values[32] =
+    { };
+  pool.parallel_for (0, 32, [&values](int i)
+    { values[i] = i;}, 4);
+
+  int sum = 0;
+  for (int i = 0; i < 32; ++i)
+    {
+      sum += values[i];
+    }
+  expect (sum == 31 * 32 / 2, "parallel_for");
+}
+
+int
+test_thread_pool (void)
+{
+  printf ("\n%s - Start.\n", test_name);
+
+  failures = 0;
+
+  test_submit ();
+  test_nested_submit ();
+  test_shutdown ();
+  test_parallel_for ();
+
+  printf ("\n%s - %s.\n", test_name, (failures == 0) ? "Done" : "Failed");
+  return failures;
+}
+
+#pragma GCC diagnostic pop
+
+// ----------------------------------------------------------------------------
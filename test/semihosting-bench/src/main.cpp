@@ -0,0 +1,281 @@
+/*
+ * This file is part of the µOS++ distribution.
+ *   (https://github.com/micro-os-plus)
+ * Copyright (c) 2017 Liviu Ionescu.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmsis-plus/rtos/os.h>
+#include <cmsis-plus/arm/semihosting.h>
+#include <cmsis-plus/arm/semihosting-buffer.h>
+#include <cmsis-plus/diag/trace.h>
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+using namespace os;
+
+// ----------------------------------------------------------------------------
+
+namespace
+{
+  constexpr std::size_t lines = 1000;
+  constexpr std::size_t chunk = 16;
+
+  const char* const file_name = "semihosting-bench.txt";
+
+  // Mode "r" and "w", as for fopen().
+  constexpr int mode_read = 0;
+  constexpr int mode_write = 4;
+
+  char storage[OS_INTEGER_SEMIHOSTING_BUFFER_SIZE];
+
+  semihosting::buffer buffer
+    { storage, sizeof(storage) };
+
+  char line[64];
+  char data[64];
+
+  // --------------------------------------------------------------------------
+
+  int
+  host_open (const char* path, int mode)
+  {
+    std::intptr_t block[3];
+    block[0] = reinterpret_cast<std::intptr_t> (path);
+    block[1] = mode;
+    block[2] = static_cast<std::intptr_t> (std::strlen (path));
+    return call_host (SEMIHOSTING_SYS_OPEN, block);
+  }
+
+  void
+  host_close (int handle)
+  {
+    std::intptr_t block[1];
+    block[0] = handle;
+    call_host (SEMIHOSTING_SYS_CLOSE, block);
+  }
+
+  void
+  host_remove (const char* path)
+  {
+    std::intptr_t block[2];
+    block[0] = reinterpret_cast<std::intptr_t> (path);
+    block[1] = static_cast<std::intptr_t> (std::strlen (path));
+    call_host (SEMIHOSTING_SYS_REMOVE, block);
+  }
+
+  // Transfer bytes with one operation, as the unbuffered
+  // read() and write() do.
+  std::size_t
+  host_transfer (int reason, int handle, void* buf, std::size_t nbyte)
+  {
+    std::intptr_t block[3];
+    block[0] = handle;
+    block[1] = reinterpret_cast<std::intptr_t> (buf);
+    block[2] = static_cast<std::intptr_t> (nbyte);
+    // Returns the number of bytes *not* transferred.
+    return nbyte - static_cast<std::size_t> (call_host (reason, block));
+  }
+
+  std::size_t
+  format_line (std::size_t n)
+  {
+    return static_cast<std::size_t> (snprintf (
+        line, sizeof(line), "line %4u: some diagnostic output\n",
+        static_cast<unsigned int> (n)));
+  }
+
+  unsigned long
+  host_calls (void)
+  {
+#if defined(__ARM_EABI__)
+    return 0;
+#else
+    return os_semihosting_host_calls;
+#endif
+  }
+
+  void
+  report (const char* name, rtos::clock::timestamp_t begin,
+          unsigned long calls)
+  {
+    rtos::clock::timestamp_t end = rtos::hrclock.now ();
+    printf ("%-24s %8lu %14lu\n", name, host_calls () - calls,
+            static_cast<unsigned long> (end - begin));
+  }
+
+  // --------------------------------------------------------------------------
+
+  void
+  bench_write (bool buffered)
+  {
+    int handle = host_open (file_name, mode_write);
+    assert(handle >= 0);
+
+    unsigned long calls = host_calls ();
+    rtos::clock::timestamp_t begin = rtos::hrclock.now ();
+
+    if (buffered)
+      {
+        buffer.bind (handle);
+      }
+    for (std::size_t n = 0; n < lines; ++n)
+      {
+        std::size_t len = format_line (n);
+        std::size_t count;
+        if (buffered)
+          {
+            count = static_cast<std::size_t> (buffer.write (line, len));
+          }
+        else
+          {
+            count = host_transfer (SEMIHOSTING_SYS_WRITE, handle, line, len);
+          }
+        assert(count == len);
+        (void) count;
+      }
+    if (buffered)
+      {
+        buffer.bind (semihosting::buffer::no_handle);
+      }
+
+    report (buffered ? "buffered write" : "write", begin, calls);
+
+    host_close (handle);
+  }
+
+  void
+  bench_read (bool buffered)
+  {
+    int handle = host_open (file_name, mode_read);
+    assert(handle >= 0);
+
+    unsigned long calls = host_calls ();
+    rtos::clock::timestamp_t begin = rtos::hrclock.now ();
+
+    if (buffered)
+      {
+        buffer.bind (handle);
+      }
+
+    // Read in small chunks, and check the content.
+    std::size_t n = 0;
+    std::size_t len = format_line (n);
+    std::size_t offset = 0;
+    for (;;)
+      {
+        std::size_t count;
+        if (buffered)
+          {
+            ssize_t res = buffer.read (data, chunk);
+            assert(res >= 0);
+            count = static_cast<std::size_t> (res);
+          }
+        else
+          {
+            count = host_transfer (SEMIHOSTING_SYS_READ, handle, data, chunk);
+          }
+        if (count == 0)
+          {
+            break;
+          }
+        for (std::size_t i = 0; i < count; ++i)
+          {
+            assert(data[i] == line[offset]);
+            if (++offset == len)
+              {
+                len = format_line (++n);
+                offset = 0;
+              }
+          }
+      }
+    assert(n == lines && offset == 0);
+
+    if (buffered)
+      {
+        buffer.bind (semihosting::buffer::no_handle);
+      }
+
+    report (buffered ? "buffered read" : "read", begin, calls);
+
+    host_close (handle);
+  }
+
+  void
+  test_debug_channel (void)
+  {
+    // The debug channel is written with a single SYS_WRITE0.
+    buffer.bind (semihosting::buffer::debug_channel);
+    unsigned long calls = host_calls ();
+    buffer.write ("debug ", 6);
+    buffer.write ("channel\n", 8);
+    buffer.flush ();
+#if !defined(__ARM_EABI__)
+    assert(host_calls () - calls == 1);
+#else
+    (void) calls;
+#endif
+    buffer.bind (semihosting::buffer::no_handle);
+  }
+
+} /* namespace */
+
+// ----------------------------------------------------------------------------
+
+/*
+ * Compare the number of semihosting operations and the duration
+ * of many small writes and reads, done with one operation each
+ * and via a `semihosting::buffer`.
+ * On Linux the operations are serviced by the host stand-in, with
+ * a modelled round trip of 20 microseconds each; on Cortex-M they
+ * go through the debugger. The durations are in `hrclock` cycles.
+ */
+int
+os_main (int argc __attribute__((unused)), char* argv[] __attribute__((unused)))
+{
+  printf ("\nSemihosting buffers benchmark.\n");
+
+#if !defined(__ARM_EABI__)
+  os_semihosting_host_call_us = 20;
+#endif
+
+  // Keep the order, the debug channel bypasses stdout.
+  fflush (stdout);
+  test_debug_channel ();
+
+  printf ("\n%-24s %8s %14s\n", "operation", "calls", "cycles");
+
+  bench_write (false);
+  bench_read (false);
+  bench_write (true);
+  bench_read (true);
+
+  host_remove (file_name);
+
+  return 0;
+}
+
+// ----------------------------------------------------------------------------